@@ -19,11 +19,16 @@ limitations under the License.
 #include "oneflow/core/job/resource_desc.h"
 #include "oneflow/core/job/env_desc.h"
 #include "oneflow/core/job/global_for.h"
+#include "oneflow/core/common/balanced_splitter.h"
 
 #ifdef PLATFORM_POSIX
 
 #include <netinet/tcp.h>
 
+#ifndef SO_ZEROCOPY
+#define SO_ZEROCOPY 60
+#endif
+
 namespace oneflow {
 
 namespace {
@@ -49,14 +54,28 @@ int SockListen(int listen_sockfd, uint16_t listen_port, int32_t total_machine_nu
   return bind_result;
 }
 
-int64_t GetMachineId(const sockaddr_in& sa) {
-  char addr[INET_ADDRSTRLEN];
-  memset(addr, '\0', sizeof(addr));
-  PCHECK(inet_ntop(AF_INET, &(sa.sin_addr), addr, INET_ADDRSTRLEN));
-  for (int64_t i = 0; i < Global<ResourceDesc, ForSession>::Get()->TotalMachineNum(); ++i) {
-    if (Global<ResourceDesc, ForSession>::Get()->machine(i).addr() == addr) { return i; }
+// the connecting side tells the accepting side who it is and which stream the socket is for
+struct StreamHandshake {
+  int64_t machine_id;
+  int64_t stream_id;
+};
+
+void WriteFully(int sockfd, const char* ptr, size_t size) {
+  while (size > 0) {
+    ssize_t n = write(sockfd, ptr, size);
+    PCHECK(n > 0);
+    ptr += n;
+    size -= n;
+  }
+}
+
+void ReadFully(int sockfd, char* ptr, size_t size) {
+  while (size > 0) {
+    ssize_t n = read(sockfd, ptr, size);
+    PCHECK(n > 0);
+    ptr += n;
+    size -= n;
   }
-  UNIMPLEMENTED();
 }
 
 std::string GenPortKey(int64_t machine_id) { return "EpollPort/" + std::to_string(machine_id); }
@@ -73,6 +92,47 @@ uint16_t PullPort(int64_t machine_id) {
 
 }  // namespace
 
+int32_t StripedPieceNum(size_t byte_size, size_t stripe_min_byte, int32_t data_stream_num) {
+  CHECK_GT(stripe_min_byte, 0U);
+  CHECK_GT(data_stream_num, 0);
+  return static_cast<int32_t>(
+      std::max<size_t>(std::min<size_t>(byte_size / stripe_min_byte, data_stream_num), 1));
+}
+
+void ForEachStripedRequestRead(
+    const RequestWriteMsg& request, size_t byte_size, size_t stripe_min_byte,
+    int32_t data_stream_num, const std::function<bool(size_t)>& IsZeroCopyPiece,
+    const std::function<void(int32_t, const RequestReadMsg&)>& Handler) {
+  const int32_t piece_num = StripedPieceNum(byte_size, stripe_min_byte, data_stream_num);
+  const BalancedSplitter bs(byte_size, piece_num);
+  int32_t part_num = piece_num;
+  FOR_RANGE(int32_t, piece_id, 0, piece_num) {
+    if (IsZeroCopyPiece(bs.At(piece_id).size())) { part_num += 1; }
+  }
+  FOR_RANGE(int32_t, piece_id, 0, piece_num) {
+    RequestReadMsg request_read;
+    request_read.src_token = request.src_token;
+    request_read.dst_token = request.dst_token;
+    request_read.read_id = request.read_id;
+    request_read.offset = bs.At(piece_id).begin();
+    request_read.byte_size = bs.At(piece_id).size();
+    request_read.part_num = part_num;
+    request_read.zero_copy = IsZeroCopyPiece(bs.At(piece_id).size());
+    Handler(piece_id, request_read);
+  }
+}
+
+bool ReadPartCounter::PartDone(void* read_id, int32_t part_num) {
+  CHECK_GT(part_num, 0);
+  if (part_num == 1) { return true; }
+  std::unique_lock<std::mutex> lck(mtx_);
+  auto it = read_id2remaining_part_num_.emplace(read_id, part_num).first;
+  it->second -= 1;
+  if (it->second > 0) { return false; }
+  read_id2remaining_part_num_.erase(it);
+  return true;
+}
+
 EpollCommNet::~EpollCommNet() {
   for (size_t i = 0; i < pollers_.size(); ++i) {
     LOG(INFO) << "CommNet Thread " << i << " finish";
@@ -91,11 +151,33 @@ void EpollCommNet::SendActorMsg(int64_t dst_machine_id, const ActorMsg& actor_ms
   SocketMsg msg;
   msg.msg_type = SocketMsgType::kActor;
   msg.actor_msg = actor_msg;
-  GetSocketHelper(dst_machine_id)->AsyncWrite(msg);
+  GetCtrlSocketHelper(dst_machine_id)->AsyncWrite(msg);
 }
 
 void EpollCommNet::SendSocketMsg(int64_t dst_machine_id, const SocketMsg& msg) {
-  GetSocketHelper(dst_machine_id)->AsyncWrite(msg);
+  GetCtrlSocketHelper(dst_machine_id)->AsyncWrite(msg);
+}
+
+void EpollCommNet::SendRequestRead(const RequestWriteMsg& request) {
+  const size_t byte_size = static_cast<const SocketMemDesc*>(request.src_token)->byte_size;
+  const int32_t data_stream_num = stream_num_per_peer_ - first_data_stream_id_;
+  const int64_t first_stream_idx =
+      data_stream_cnt_.fetch_add(StripedPieceNum(byte_size, stripe_min_byte_, data_stream_num));
+  ForEachStripedRequestRead(
+      request, byte_size, stripe_min_byte_, data_stream_num,
+      [this](size_t piece_byte_size) { return IsZeroCopyPiece(piece_byte_size); },
+      [&](int32_t piece_id, const RequestReadMsg& request_read) {
+        SocketMsg msg;
+        msg.msg_type = SocketMsgType::kRequestRead;
+        msg.request_read_msg = request_read;
+        const int32_t stream_id =
+            first_data_stream_id_ + (first_stream_idx + piece_id) % data_stream_num;
+        GetSocketHelper(request.dst_machine_id, stream_id)->AsyncWrite(msg);
+      });
+}
+
+void EpollCommNet::PartialReadDone(void* read_id, int32_t part_num) {
+  if (read_part_counter_.PartDone(read_id, part_num)) { ReadDone(read_id); }
 }
 
 SocketMemDesc* EpollCommNet::NewMemDesc(void* ptr, size_t byte_size) {
@@ -105,7 +187,14 @@ SocketMemDesc* EpollCommNet::NewMemDesc(void* ptr, size_t byte_size) {
   return mem_desc;
 }
 
-EpollCommNet::EpollCommNet(const Plan& plan) : CommNetIf(plan) {
+EpollCommNet::EpollCommNet(const Plan& plan) : CommNetIf(plan), data_stream_cnt_(0) {
+  const ResourceDesc* resource_desc = Global<ResourceDesc, ForSession>::Get();
+  stream_num_per_peer_ = resource_desc->CommNetStreamNumPerPeer();
+  CHECK_GE(stream_num_per_peer_, 1);
+  first_data_stream_id_ = stream_num_per_peer_ > 1 ? 1 : 0;
+  stripe_min_byte_ = std::max<size_t>(resource_desc->comm_net_stripe_min_byte(), 1);
+  use_zero_copy_ = resource_desc->comm_net_use_zero_copy();
+  zero_copy_min_byte_ = resource_desc->comm_net_zero_copy_min_byte();
   pollers_.resize(Global<ResourceDesc, ForSession>::Get()->CommNetWorkerNum(), nullptr);
   for (size_t i = 0; i < pollers_.size(); ++i) { pollers_[i] = new IOEventPoller; }
   InitSockets();
@@ -116,10 +205,17 @@ void EpollCommNet::InitSockets() {
   int64_t this_machine_id = Global<MachineCtx>::Get()->this_machine_id();
   auto this_machine = Global<ResourceDesc, ForSession>::Get()->machine(this_machine_id);
   int64_t total_machine_num = Global<ResourceDesc, ForSession>::Get()->TotalMachineNum();
-  machine_id2sockfd_.assign(total_machine_num, -1);
+  machine_id2sockfds_.assign(total_machine_num, std::vector<int>(stream_num_per_peer_, -1));
   sockfd2helper_.clear();
   size_t poller_idx = 0;
   auto NewSocketHelper = [&](int sockfd) {
+    if (use_zero_copy_) {
+      const int val = 1;
+      if (setsockopt(sockfd, SOL_SOCKET, SO_ZEROCOPY, (char*)&val, sizeof(int)) != 0) {
+        PLOG(WARNING) << "MSG_ZEROCOPY is not supported, register data will be copied";
+        use_zero_copy_ = false;
+      }
+    }
     IOEventPoller* poller = pollers_[poller_idx];
     poller_idx = (poller_idx + 1) % pollers_.size();
     return new SocketHelper(sockfd, poller);
@@ -127,15 +223,16 @@ void EpollCommNet::InitSockets() {
 
   // listen
   int listen_sockfd = socket(AF_INET, SOCK_STREAM, 0);
+  int32_t backlog = total_machine_num * stream_num_per_peer_;
   int32_t this_listen_port = Global<EnvDesc>::Get()->data_port();
   if (this_listen_port != -1) {
-    CHECK_EQ(SockListen(listen_sockfd, this_listen_port, total_machine_num), 0);
+    CHECK_EQ(SockListen(listen_sockfd, this_listen_port, backlog), 0);
     PushPort(this_machine_id,
              ((this_machine.data_port_agent() != -1) ? (this_machine.data_port_agent())
                                                      : (this_listen_port)));
   } else {
     for (this_listen_port = 1024; this_listen_port < GetMaxVal<uint16_t>(); ++this_listen_port) {
-      if (SockListen(listen_sockfd, this_listen_port, total_machine_num) == 0) {
+      if (SockListen(listen_sockfd, this_listen_port, backlog) == 0) {
         PushPort(this_machine_id, this_listen_port);
         break;
       }
@@ -153,36 +250,50 @@ void EpollCommNet::InitSockets() {
     uint16_t peer_port = PullPort(peer_id);
     auto peer_machine = Global<ResourceDesc, ForSession>::Get()->machine(peer_id);
     sockaddr_in peer_sockaddr = GetSockAddr(peer_machine.addr(), peer_port);
-    int sockfd = socket(AF_INET, SOCK_STREAM, 0);
-    const int val = 1;
-    PCHECK(setsockopt(sockfd, IPPROTO_TCP, TCP_NODELAY, (char*)&val, sizeof(int)) == 0);
-    PCHECK(connect(sockfd, reinterpret_cast<sockaddr*>(&peer_sockaddr), sizeof(peer_sockaddr))
-           == 0);
-    CHECK(sockfd2helper_.emplace(sockfd, NewSocketHelper(sockfd)).second);
-    machine_id2sockfd_[peer_id] = sockfd;
+    FOR_RANGE(int32_t, stream_id, 0, stream_num_per_peer_) {
+      int sockfd = socket(AF_INET, SOCK_STREAM, 0);
+      const int val = 1;
+      PCHECK(setsockopt(sockfd, IPPROTO_TCP, TCP_NODELAY, (char*)&val, sizeof(int)) == 0);
+      PCHECK(connect(sockfd, reinterpret_cast<sockaddr*>(&peer_sockaddr), sizeof(peer_sockaddr))
+             == 0);
+      StreamHandshake handshake;
+      handshake.machine_id = this_machine_id;
+      handshake.stream_id = stream_id;
+      WriteFully(sockfd, reinterpret_cast<const char*>(&handshake), sizeof(handshake));
+      CHECK(sockfd2helper_.emplace(sockfd, NewSocketHelper(sockfd)).second);
+      machine_id2sockfds_[peer_id][stream_id] = sockfd;
+    }
   }
 
   // accept
-  FOR_RANGE(int32_t, idx, 0, src_machine_count) {
+  FOR_RANGE(int32_t, idx, 0, src_machine_count * stream_num_per_peer_) {
     sockaddr_in peer_sockaddr;
     socklen_t len = sizeof(peer_sockaddr);
     int sockfd = accept(listen_sockfd, reinterpret_cast<sockaddr*>(&peer_sockaddr), &len);
     PCHECK(sockfd != -1);
+    StreamHandshake handshake;
+    ReadFully(sockfd, reinterpret_cast<char*>(&handshake), sizeof(handshake));
+    CHECK_GE(handshake.stream_id, 0);
+    CHECK_LT(handshake.stream_id, stream_num_per_peer_);
+    CHECK_EQ(machine_id2sockfds_.at(handshake.machine_id).at(handshake.stream_id), -1);
     CHECK(sockfd2helper_.emplace(sockfd, NewSocketHelper(sockfd)).second);
-    int64_t peer_machine_id = GetMachineId(peer_sockaddr);
-    machine_id2sockfd_[peer_machine_id] = sockfd;
+    machine_id2sockfds_[handshake.machine_id][handshake.stream_id] = sockfd;
   }
   PCHECK(close(listen_sockfd) == 0);
   ClearPort(this_machine_id);
 
   // useful log
   FOR_RANGE(int64_t, machine_id, 0, total_machine_num) {
-    LOG(INFO) << "machine " << machine_id << " sockfd " << machine_id2sockfd_[machine_id];
+    std::string sockfds;
+    for (int sockfd : machine_id2sockfds_[machine_id]) {
+      sockfds += (sockfds.empty() ? "" : ",") + std::to_string(sockfd);
+    }
+    LOG(INFO) << "machine " << machine_id << " sockfds " << sockfds;
   }
 }
 
-SocketHelper* EpollCommNet::GetSocketHelper(int64_t machine_id) {
-  int sockfd = machine_id2sockfd_.at(machine_id);
+SocketHelper* EpollCommNet::GetSocketHelper(int64_t machine_id, int32_t stream_id) {
+  int sockfd = machine_id2sockfds_.at(machine_id).at(stream_id);
   return sockfd2helper_.at(sockfd);
 }
 
@@ -193,7 +304,7 @@ void EpollCommNet::DoRead(void* read_id, int64_t src_machine_id, void* src_token
   msg.request_write_msg.dst_machine_id = Global<MachineCtx>::Get()->this_machine_id();
   msg.request_write_msg.dst_token = dst_token;
   msg.request_write_msg.read_id = read_id;
-  GetSocketHelper(src_machine_id)->AsyncWrite(msg);
+  GetCtrlSocketHelper(src_machine_id)->AsyncWrite(msg);
 }
 
 }  // namespace oneflow
@@ -24,6 +24,29 @@ limitations under the License.
 
 namespace oneflow {
 
+// Stripes the register of a RequestWrite into RequestReads of at least stripe_min_byte each,
+// one per data stream at most. Handler gets the index of each piece and its RequestRead.
+int32_t StripedPieceNum(size_t byte_size, size_t stripe_min_byte, int32_t data_stream_num);
+void ForEachStripedRequestRead(
+    const RequestWriteMsg& request, size_t byte_size, size_t stripe_min_byte,
+    int32_t data_stream_num, const std::function<bool(size_t)>& IsZeroCopyPiece,
+    const std::function<void(int32_t, const RequestReadMsg&)>& Handler);
+
+// counts the parts of the reads arriving in any order over any streams
+class ReadPartCounter final {
+ public:
+  OF_DISALLOW_COPY_AND_MOVE(ReadPartCounter);
+  ReadPartCounter() = default;
+  ~ReadPartCounter() = default;
+
+  // whether the part is the last of the part_num ones of read_id
+  bool PartDone(void* read_id, int32_t part_num);
+
+ private:
+  std::mutex mtx_;
+  HashMap<void*, int32_t> read_id2remaining_part_num_;
+};
+
 class EpollCommNet final : public CommNetIf<SocketMemDesc> {
  public:
   OF_DISALLOW_COPY_AND_MOVE(EpollCommNet);
@@ -35,18 +58,33 @@ class EpollCommNet final : public CommNetIf<SocketMemDesc> {
 
   void SendActorMsg(int64_t dst_machine_id, const ActorMsg& msg) override;
   void SendSocketMsg(int64_t dst_machine_id, const SocketMsg& msg);
+  // answers a RequestWrite, striping large registers over the data streams
+  void SendRequestRead(const RequestWriteMsg& request);
+  void PartialReadDone(void* read_id, int32_t part_num);
 
  private:
   SocketMemDesc* NewMemDesc(void* ptr, size_t byte_size) override;
 
   EpollCommNet(const Plan& plan);
   void InitSockets();
-  SocketHelper* GetSocketHelper(int64_t machine_id);
+  // stream 0 of every peer carries actor messages and requests, the others carry register data
+  SocketHelper* GetSocketHelper(int64_t machine_id, int32_t stream_id);
+  SocketHelper* GetCtrlSocketHelper(int64_t machine_id) { return GetSocketHelper(machine_id, 0); }
+  bool IsZeroCopyPiece(size_t byte_size) const {
+    return use_zero_copy_ && byte_size >= zero_copy_min_byte_;
+  }
   void DoRead(void* read_id, int64_t src_machine_id, void* src_token, void* dst_token) override;
 
+  int32_t stream_num_per_peer_;
+  int32_t first_data_stream_id_;
+  size_t stripe_min_byte_;
+  bool use_zero_copy_;
+  size_t zero_copy_min_byte_;
+  std::atomic<int64_t> data_stream_cnt_;
   std::vector<IOEventPoller*> pollers_;
-  std::vector<int> machine_id2sockfd_;
+  std::vector<std::vector<int>> machine_id2sockfds_;
   HashMap<int, SocketHelper*> sockfd2helper_;
+  ReadPartCounter read_part_counter_;
 };
 
 template<>
@@ -19,14 +19,28 @@ limitations under the License.
 
 namespace oneflow {
 
-SocketHelper::SocketHelper(int sockfd, IOEventPoller* poller) {
+namespace {
+
+std::string SocketIOStatToString(const SocketIOStat& stat) {
+  return std::to_string(stat.msg_cnt) + " msgs, " + std::to_string(stat.byte_cnt) + " bytes, "
+         + std::to_string(stat.syscall_cnt) + " syscalls, "
+         + std::to_string(stat.zero_copy_syscall_cnt) + " zero-copy sends ("
+         + std::to_string(stat.zero_copy_copied_cnt) + " copied)";
+}
+
+}  // namespace
+
+SocketHelper::SocketHelper(int sockfd, IOEventPoller* poller) : sockfd_(sockfd) {
   read_helper_ = new SocketReadHelper(sockfd);
   write_helper_ = new SocketWriteHelper(sockfd, poller);
   poller->AddFd(sockfd, [this]() { read_helper_->NotifyMeSocketReadable(); },
-                [this]() { write_helper_->NotifyMeSocketWriteable(); });
+                [this]() { write_helper_->NotifyMeSocketWriteable(); },
+                [this]() { write_helper_->NotifyMeSocketError(); });
 }
 
 SocketHelper::~SocketHelper() {
+  LOG(INFO) << "sockfd " << sockfd_ << " read: " << SocketIOStatToString(read_helper_->stat())
+            << "; write: " << SocketIOStatToString(write_helper_->stat());
   delete read_helper_;
   delete write_helper_;
 }
@@ -34,7 +34,11 @@ class SocketHelper final {
 
   void AsyncWrite(const SocketMsg& msg);
 
+  const SocketIOStat& read_stat() const { return read_helper_->stat(); }
+  const SocketIOStat& write_stat() const { return write_helper_->stat(); }
+
  private:
+  int sockfd_;
   SocketReadHelper* read_helper_;
   SocketWriteHelper* write_helper_;
 };
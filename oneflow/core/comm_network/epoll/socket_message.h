@@ -34,9 +34,10 @@ limitations under the License.
 
 namespace oneflow {
 
-#define SOCKET_MSG_TYPE_SEQ                         \
-  OF_PP_MAKE_TUPLE_SEQ(RequestWrite, request_write) \
-  OF_PP_MAKE_TUPLE_SEQ(RequestRead, request_read)   \
+#define SOCKET_MSG_TYPE_SEQ                          \
+  OF_PP_MAKE_TUPLE_SEQ(RequestWrite, request_write)  \
+  OF_PP_MAKE_TUPLE_SEQ(RequestRead, request_read)    \
+  OF_PP_MAKE_TUPLE_SEQ(ZeroCopyDone, zero_copy_done) \
   OF_PP_MAKE_TUPLE_SEQ(Actor, actor)
 
 enum class SocketMsgType {
@@ -56,6 +57,18 @@ struct RequestReadMsg {
   void* src_token;
   void* dst_token;
   void* read_id;
+  // a large register is striped into pieces sent over different streams, the read is done after
+  // part_num parts arrive: every piece, plus a ZeroCopyDone for every zero-copy piece
+  int64_t offset;
+  int64_t byte_size;
+  int32_t part_num;
+  bool zero_copy;
+};
+
+// sent once the kernel no longer references the pages of a piece sent with MSG_ZEROCOPY
+struct ZeroCopyDoneMsg {
+  void* read_id;
+  int32_t part_num;
 };
 
 struct SocketMsg {
@@ -69,6 +82,16 @@ struct SocketMsg {
 
 using CallBackList = std::list<std::function<void()>>;
 
+// per connection and direction, only touched by the poller thread owning the socket
+struct SocketIOStat {
+  int64_t msg_cnt = 0;
+  int64_t byte_cnt = 0;
+  int64_t syscall_cnt = 0;
+  int64_t zero_copy_syscall_cnt = 0;
+  // zero-copy sends the kernel had to fall back to copying, always the case on loopback
+  int64_t zero_copy_copied_cnt = 0;
+};
+
 }  // namespace oneflow
 
 #endif  // PLATFORM_POSIX
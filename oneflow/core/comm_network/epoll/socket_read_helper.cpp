@@ -23,46 +23,74 @@ limitations under the License.
 
 namespace oneflow {
 
+namespace {
+
+constexpr size_t kReadBufferSize = 64 * 1024;
+
+}  // namespace
+
 SocketReadHelper::~SocketReadHelper() {
   // do nothing
 }
 
 SocketReadHelper::SocketReadHelper(int sockfd) {
   sockfd_ = sockfd;
-  SwitchToMsgHeadReadHandle();
+  buf_.reset(new char[kReadBufferSize]);
+  buf_begin_ = 0;
+  buf_end_ = 0;
+  body_ptr_ = nullptr;
+  body_size_ = 0;
 }
 
 void SocketReadHelper::NotifyMeSocketReadable() { ReadUntilSocketNotReadable(); }
 
-void SocketReadHelper::SwitchToMsgHeadReadHandle() {
-  cur_read_handle_ = &SocketReadHelper::MsgHeadReadHandle;
-  read_ptr_ = reinterpret_cast<char*>(&cur_msg_);
-  read_size_ = sizeof(cur_msg_);
-}
-
 void SocketReadHelper::ReadUntilSocketNotReadable() {
-  while ((this->*cur_read_handle_)()) {}
-}
-
-bool SocketReadHelper::MsgHeadReadHandle() {
-  return DoCurRead(&SocketReadHelper::SetStatusWhenMsgHeadDone);
-}
-
-bool SocketReadHelper::MsgBodyReadHandle() {
-  return DoCurRead(&SocketReadHelper::SetStatusWhenMsgBodyDone);
+  while (true) {
+    if (body_size_ > 0) {
+      // the beginning of a body usually arrives together with its head
+      const size_t buffered_size = std::min(BufferedSize(), body_size_);
+      memcpy(body_ptr_, buf_.get() + buf_begin_, buffered_size);
+      buf_begin_ += buffered_size;
+      body_ptr_ += buffered_size;
+      body_size_ -= buffered_size;
+      if (body_size_ > 0) {
+        // the rest goes straight into the destination without passing through buf_
+        size_t read_size = 0;
+        if (!DoRead(body_ptr_, body_size_, &read_size)) { return; }
+        body_ptr_ += read_size;
+        body_size_ -= read_size;
+      }
+      if (body_size_ == 0) { SetStatusWhenMsgBodyDone(); }
+    } else if (BufferedSize() >= sizeof(SocketMsg)) {
+      memcpy(&cur_msg_, buf_.get() + buf_begin_, sizeof(SocketMsg));
+      buf_begin_ += sizeof(SocketMsg);
+      stat_.msg_cnt += 1;
+      SetStatusWhenMsgHeadDone();
+    } else {
+      if (buf_begin_ > 0) {
+        memmove(buf_.get(), buf_.get() + buf_begin_, BufferedSize());
+        buf_end_ = BufferedSize();
+        buf_begin_ = 0;
+      }
+      size_t read_size = 0;
+      if (!DoRead(buf_.get() + buf_end_, kReadBufferSize - buf_end_, &read_size)) { return; }
+      buf_end_ += read_size;
+    }
+  }
 }
 
-bool SocketReadHelper::DoCurRead(void (SocketReadHelper::*set_cur_read_done)()) {
-  ssize_t n = read(sockfd_, read_ptr_, read_size_);
+bool SocketReadHelper::DoRead(char* ptr, size_t size, size_t* read_size) {
+  ssize_t n = read(sockfd_, ptr, size);
+  stat_.syscall_cnt += 1;
   const int val = 1;
   PCHECK(setsockopt(sockfd_, IPPROTO_TCP, TCP_QUICKACK, (char*)&val, sizeof(int)) == 0);
-  if (n == read_size_) {
-    (this->*set_cur_read_done)();
-    return true;
-  } else if (n >= 0) {
-    read_ptr_ += n;
-    read_size_ -= n;
+  if (n > 0) {
+    stat_.byte_cnt += n;
+    *read_size = n;
     return true;
+  } else if (n == 0) {
+    // the peer has shut down its side, nothing more will arrive
+    return false;
   } else {
     CHECK_EQ(n, -1);
     PCHECK(errno == EAGAIN || errno == EWOULDBLOCK);
@@ -82,32 +110,33 @@ void SocketReadHelper::SetStatusWhenMsgHeadDone() {
 
 void SocketReadHelper::SetStatusWhenMsgBodyDone() {
   if (cur_msg_.msg_type == SocketMsgType::kRequestRead) {
-    Global<EpollCommNet>::Get()->ReadDone(cur_msg_.request_read_msg.read_id);
+    Global<EpollCommNet>::Get()->PartialReadDone(cur_msg_.request_read_msg.read_id,
+                                                 cur_msg_.request_read_msg.part_num);
   }
-  SwitchToMsgHeadReadHandle();
+  body_ptr_ = nullptr;
+  body_size_ = 0;
 }
 
 void SocketReadHelper::SetStatusWhenRequestWriteMsgHeadDone() {
-  SocketMsg msg_to_send;
-  msg_to_send.msg_type = SocketMsgType::kRequestRead;
-  msg_to_send.request_read_msg.src_token = cur_msg_.request_write_msg.src_token;
-  msg_to_send.request_read_msg.dst_token = cur_msg_.request_write_msg.dst_token;
-  msg_to_send.request_read_msg.read_id = cur_msg_.request_write_msg.read_id;
-  Global<EpollCommNet>::Get()->SendSocketMsg(cur_msg_.request_write_msg.dst_machine_id,
-                                             msg_to_send);
-  SwitchToMsgHeadReadHandle();
+  Global<EpollCommNet>::Get()->SendRequestRead(cur_msg_.request_write_msg);
 }
 
 void SocketReadHelper::SetStatusWhenRequestReadMsgHeadDone() {
-  auto mem_desc = static_cast<const SocketMemDesc*>(cur_msg_.request_read_msg.dst_token);
-  read_ptr_ = reinterpret_cast<char*>(mem_desc->mem_ptr);
-  read_size_ = mem_desc->byte_size;
-  cur_read_handle_ = &SocketReadHelper::MsgBodyReadHandle;
+  const RequestReadMsg& request = cur_msg_.request_read_msg;
+  auto mem_desc = static_cast<const SocketMemDesc*>(request.dst_token);
+  CHECK_LE(request.offset + request.byte_size, mem_desc->byte_size);
+  body_ptr_ = reinterpret_cast<char*>(mem_desc->mem_ptr) + request.offset;
+  body_size_ = request.byte_size;
+  if (body_size_ == 0) { SetStatusWhenMsgBodyDone(); }
+}
+
+void SocketReadHelper::SetStatusWhenZeroCopyDoneMsgHeadDone() {
+  Global<EpollCommNet>::Get()->PartialReadDone(cur_msg_.zero_copy_done_msg.read_id,
+                                               cur_msg_.zero_copy_done_msg.part_num);
 }
 
 void SocketReadHelper::SetStatusWhenActorMsgHeadDone() {
   Global<ActorMsgBus>::Get()->SendMsgWithoutCommNet(cur_msg_.actor_msg);
-  SwitchToMsgHeadReadHandle();
 }
 
 }  // namespace oneflow
@@ -32,14 +32,13 @@ class SocketReadHelper final {
 
   void NotifyMeSocketReadable();
 
+  const SocketIOStat& stat() const { return stat_; }
+
  private:
-  void SwitchToMsgHeadReadHandle();
   void ReadUntilSocketNotReadable();
+  bool DoRead(char* ptr, size_t size, size_t* read_size);
+  size_t BufferedSize() const { return buf_end_ - buf_begin_; }
 
-  bool MsgHeadReadHandle();
-  bool MsgBodyReadHandle();
-
-  bool DoCurRead(void (SocketReadHelper::*set_cur_read_done)());
   void SetStatusWhenMsgHeadDone();
   void SetStatusWhenMsgBodyDone();
 
@@ -49,10 +48,16 @@ class SocketReadHelper final {
 
   int sockfd_;
 
+  // bytes read from the socket but not parsed yet, one read may carry many messages
+  std::unique_ptr<char[]> buf_;
+  size_t buf_begin_;
+  size_t buf_end_;
+
   SocketMsg cur_msg_;
-  bool (SocketReadHelper::*cur_read_handle_)();
-  char* read_ptr_;
-  size_t read_size_;
+  char* body_ptr_;
+  size_t body_size_;
+
+  SocketIOStat stat_;
 };
 
 }  // namespace oneflow
@@ -0,0 +1,273 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include "oneflow/core/comm_network/epoll/epoll_comm_network.h"
+#include "oneflow/core/comm_network/epoll/socket_message.h"
+#include "oneflow/core/comm_network/epoll/socket_write_helper.h"
+#include "oneflow/core/common/balanced_splitter.h"
+
+#ifdef PLATFORM_POSIX
+
+#include <netinet/tcp.h>
+#include <tuple>
+
+namespace oneflow {
+
+namespace {
+
+// Moves a buffer over stream_num loopback tcp connections the way EpollCommNet stripes a register
+// over its data streams: piece i of a BalancedSplitter split goes over stream i.
+class LoopbackStreams final {
+ public:
+  OF_DISALLOW_COPY_AND_MOVE(LoopbackStreams);
+  explicit LoopbackStreams(int32_t stream_num) {
+    int listen_sockfd = socket(AF_INET, SOCK_STREAM, 0);
+    PCHECK(listen_sockfd != -1);
+    sockaddr_in sa;
+    memset(&sa, 0, sizeof(sa));
+    sa.sin_family = AF_INET;
+    sa.sin_port = 0;
+    sa.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    PCHECK(bind(listen_sockfd, reinterpret_cast<sockaddr*>(&sa), sizeof(sa)) == 0);
+    PCHECK(listen(listen_sockfd, stream_num) == 0);
+    socklen_t len = sizeof(sa);
+    PCHECK(getsockname(listen_sockfd, reinterpret_cast<sockaddr*>(&sa), &len) == 0);
+    FOR_RANGE(int32_t, i, 0, stream_num) {
+      int sockfd = socket(AF_INET, SOCK_STREAM, 0);
+      const int val = 1;
+      PCHECK(setsockopt(sockfd, IPPROTO_TCP, TCP_NODELAY, (char*)&val, sizeof(int)) == 0);
+      PCHECK(connect(sockfd, reinterpret_cast<sockaddr*>(&sa), sizeof(sa)) == 0);
+      send_sockfds_.push_back(sockfd);
+      recv_sockfds_.push_back(accept(listen_sockfd, nullptr, nullptr));
+      PCHECK(recv_sockfds_.back() != -1);
+    }
+    PCHECK(close(listen_sockfd) == 0);
+  }
+  ~LoopbackStreams() {
+    for (int sockfd : send_sockfds_) { PCHECK(close(sockfd) == 0); }
+    for (int sockfd : recv_sockfds_) { PCHECK(close(sockfd) == 0); }
+  }
+
+  void Transfer(const char* src, char* dst, size_t byte_size) {
+    const int32_t stream_num = send_sockfds_.size();
+    const BalancedSplitter bs(byte_size, stream_num);
+    std::vector<std::thread> threads;
+    FOR_RANGE(int32_t, i, 0, stream_num) {
+      const Range range = bs.At(i);
+      threads.emplace_back([this, i, range, src]() {
+        size_t offset = range.begin();
+        while (offset < range.end()) {
+          ssize_t n = write(send_sockfds_.at(i), src + offset, range.end() - offset);
+          PCHECK(n > 0);
+          offset += n;
+        }
+      });
+      threads.emplace_back([this, i, range, dst]() {
+        size_t offset = range.begin();
+        while (offset < range.end()) {
+          ssize_t n = read(recv_sockfds_.at(i), dst + offset, range.end() - offset);
+          PCHECK(n > 0);
+          offset += n;
+        }
+      });
+    }
+    for (std::thread& thread : threads) { thread.join(); }
+  }
+
+ private:
+  std::vector<int> send_sockfds_;
+  std::vector<int> recv_sockfds_;
+};
+
+// Stripes a read of src into dst and delivers the pieces in reverse order, copying each body the
+// way SocketReadHelper does. Returns the pieces.
+std::vector<RequestReadMsg> StripeAndReassemble(const std::vector<char>& src,
+                                                std::vector<char>* dst, size_t stripe_min_byte,
+                                                int32_t data_stream_num,
+                                                ReadPartCounter* counter) {
+  SocketMemDesc src_mem_desc{const_cast<char*>(src.data()), src.size()};
+  SocketMemDesc dst_mem_desc{dst->data(), dst->size()};
+  RequestWriteMsg request;
+  request.src_token = &src_mem_desc;
+  request.dst_machine_id = 1;
+  request.dst_token = &dst_mem_desc;
+  request.read_id = dst;
+  std::vector<RequestReadMsg> pieces;
+  ForEachStripedRequestRead(request, src.size(), stripe_min_byte, data_stream_num,
+                            [](size_t) { return false; },
+                            [&](int32_t piece_id, const RequestReadMsg& request_read) {
+                              CHECK_EQ(piece_id, static_cast<int32_t>(pieces.size()));
+                              pieces.push_back(request_read);
+                            });
+  int64_t done_cnt = 0;
+  for (auto it = pieces.rbegin(); it != pieces.rend(); ++it) {
+    auto src_desc = static_cast<const SocketMemDesc*>(it->src_token);
+    auto dst_desc = static_cast<const SocketMemDesc*>(it->dst_token);
+    memcpy(static_cast<char*>(dst_desc->mem_ptr) + it->offset,
+           static_cast<const char*>(src_desc->mem_ptr) + it->offset, it->byte_size);
+    if (counter->PartDone(it->read_id, it->part_num)) {
+      done_cnt += 1;
+      CHECK(it + 1 == pieces.rend());
+    }
+  }
+  CHECK_EQ(done_cnt, 1);
+  return pieces;
+}
+
+}  // namespace
+
+TEST(SocketStream, stripe_and_reassemble) {
+  const size_t stripe_min_byte = 1024 * 1024;
+  // byte size, data stream num, expected piece num
+  const std::vector<std::tuple<size_t, int32_t, int32_t>> cases{
+      std::make_tuple(100, 4, 1),
+      std::make_tuple(stripe_min_byte + 1, 4, 1),
+      std::make_tuple(2 * stripe_min_byte + 1, 4, 2),
+      std::make_tuple(10 * stripe_min_byte + 7, 3, 3),
+      std::make_tuple(10 * stripe_min_byte + 7, 1, 1),
+  };
+  ReadPartCounter counter;
+  for (const auto& c : cases) {
+    const size_t byte_size = std::get<0>(c);
+    std::vector<char> src(byte_size);
+    FOR_RANGE(size_t, i, 0, byte_size) { src[i] = static_cast<char>(i * 131 + i / 7); }
+    std::vector<char> dst(byte_size, 0);
+    const std::vector<RequestReadMsg> pieces =
+        StripeAndReassemble(src, &dst, stripe_min_byte, std::get<1>(c), &counter);
+    ASSERT_EQ(static_cast<int32_t>(pieces.size()), std::get<2>(c));
+    ASSERT_EQ(StripedPieceNum(byte_size, stripe_min_byte, std::get<1>(c)), std::get<2>(c));
+    int64_t offset = 0;
+    for (const RequestReadMsg& piece : pieces) {
+      ASSERT_EQ(piece.offset, offset);
+      ASSERT_EQ(piece.part_num, std::get<2>(c));
+      ASSERT_FALSE(piece.zero_copy);
+      if (pieces.size() > 1) { ASSERT_GE(piece.byte_size, static_cast<int64_t>(stripe_min_byte)); }
+      offset += piece.byte_size;
+    }
+    ASSERT_EQ(offset, static_cast<int64_t>(byte_size));
+    ASSERT_TRUE(src == dst);
+  }
+}
+
+TEST(SocketStream, interleaved_read_parts) {
+  ReadPartCounter counter;
+  int read_a = 0;
+  int read_b = 0;
+  ASSERT_FALSE(counter.PartDone(&read_a, 3));
+  ASSERT_FALSE(counter.PartDone(&read_b, 2));
+  ASSERT_FALSE(counter.PartDone(&read_a, 3));
+  ASSERT_TRUE(counter.PartDone(&read_b, 2));
+  ASSERT_TRUE(counter.PartDone(&read_a, 3));
+  // a read id is reused once its read is done
+  ASSERT_FALSE(counter.PartDone(&read_a, 2));
+  ASSERT_TRUE(counter.PartDone(&read_a, 2));
+  ASSERT_TRUE(counter.PartDone(&read_b, 1));
+}
+
+TEST(SocketStream, zero_copy_done_fallback) {
+  int read_id = 0;
+  SocketMsg done_msg;
+  done_msg.msg_type = SocketMsgType::kZeroCopyDone;
+  done_msg.zero_copy_done_msg.read_id = &read_id;
+  done_msg.zero_copy_done_msg.part_num = 2;
+  ZeroCopyDoneTracker tracker;
+  std::queue<SocketMsg> ready_msgs;
+  ReadPartCounter counter;
+  // the body arrives before its ZeroCopyDone
+  ASSERT_FALSE(counter.PartDone(&read_id, 2));
+  // zero-copy refused, the body was copied
+  tracker.BodySent(done_msg, &ready_msgs);
+  ASSERT_EQ(ready_msgs.size(), 1U);
+  ASSERT_EQ(tracker.pending_done_msg_num(), 0U);
+  ASSERT_TRUE(counter.PartDone(ready_msgs.front().zero_copy_done_msg.read_id,
+                               ready_msgs.front().zero_copy_done_msg.part_num));
+}
+
+TEST(SocketStream, zero_copy_done_out_of_order) {
+  std::vector<int> read_ids(4);
+  std::vector<SocketMsg> done_msgs(read_ids.size());
+  FOR_RANGE(size_t, i, 0, read_ids.size()) {
+    done_msgs.at(i).msg_type = SocketMsgType::kZeroCopyDone;
+    done_msgs.at(i).zero_copy_done_msg.read_id = &read_ids.at(i);
+    done_msgs.at(i).zero_copy_done_msg.part_num = 2;
+  }
+  ZeroCopyDoneTracker tracker;
+  std::queue<SocketMsg> ready_msgs;
+  // body 0 takes sends 0 and 1, body 1 falls back to copying after send 2, body 2 is copied and
+  // body 3 takes send 3
+  tracker.ZeroCopySent();
+  tracker.ZeroCopySent();
+  tracker.BodySent(done_msgs.at(0), &ready_msgs);
+  tracker.ZeroCopySent();
+  tracker.BodySent(done_msgs.at(1), &ready_msgs);
+  tracker.BodySent(done_msgs.at(2), &ready_msgs);
+  tracker.ZeroCopySent();
+  tracker.BodySent(done_msgs.at(3), &ready_msgs);
+  ASSERT_EQ(ready_msgs.size(), 1U);
+  ASSERT_EQ(ready_msgs.front().zero_copy_done_msg.read_id, &read_ids.at(2));
+  ready_msgs.pop();
+  ASSERT_EQ(tracker.pending_done_msg_num(), 3U);
+  // completions of later sends wait for the earlier ones
+  tracker.SendsCompleted(3, 3, &ready_msgs);
+  tracker.SendsCompleted(1, 2, &ready_msgs);
+  ASSERT_TRUE(ready_msgs.empty());
+  tracker.SendsCompleted(0, 0, &ready_msgs);
+  ASSERT_EQ(ready_msgs.size(), 3U);
+  for (int i : {0, 1, 3}) {
+    ASSERT_EQ(ready_msgs.front().zero_copy_done_msg.read_id, &read_ids.at(i));
+    ready_msgs.pop();
+  }
+  ASSERT_EQ(tracker.pending_done_msg_num(), 0U);
+  // a range reported again changes nothing
+  tracker.ZeroCopySent();
+  tracker.BodySent(done_msgs.at(0), &ready_msgs);
+  tracker.SendsCompleted(0, 3, &ready_msgs);
+  ASSERT_TRUE(ready_msgs.empty());
+  tracker.SendsCompleted(4, 4, &ready_msgs);
+  ASSERT_EQ(ready_msgs.size(), 1U);
+}
+
+TEST(SocketStream, striped_transfer) {
+  const size_t byte_size = 1 << 20;
+  std::vector<char> src(byte_size);
+  FOR_RANGE(size_t, i, 0, byte_size) { src[i] = static_cast<char>(i * 131); }
+  for (int32_t stream_num : {1, 3, 4}) {
+    std::vector<char> dst(byte_size, 0);
+    LoopbackStreams streams(stream_num);
+    streams.Transfer(src.data(), dst.data(), byte_size);
+    ASSERT_TRUE(src == dst);
+  }
+}
+
+// run with --gtest_also_run_disabled_tests --gtest_filter=SocketStream.DISABLED_benchmark
+TEST(SocketStream, DISABLED_benchmark) {
+  const size_t byte_size = 256 << 20;
+  const int64_t iter_num = 8;
+  std::vector<char> src(byte_size, 1);
+  std::vector<char> dst(byte_size, 0);
+  for (int32_t stream_num : {1, 2, 4, 8}) {
+    LoopbackStreams streams(stream_num);
+    streams.Transfer(src.data(), dst.data(), byte_size);  // warm up
+    auto start = std::chrono::steady_clock::now();
+    FOR_RANGE(int64_t, i, 0, iter_num) { streams.Transfer(src.data(), dst.data(), byte_size); }
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+    LOG(INFO) << "streams: " << stream_num << ", throughput: "
+              << byte_size * iter_num / elapsed.count() / (1 << 30) << " GB/s";
+  }
+}
+
+}  // namespace oneflow
+
+#endif  // PLATFORM_POSIX
@@ -18,10 +18,79 @@ limitations under the License.
 
 #ifdef PLATFORM_POSIX
 
+#include <limits.h>
+#include <linux/errqueue.h>
 #include <sys/eventfd.h>
 
+#ifndef MSG_ZEROCOPY
+#define MSG_ZEROCOPY 0x4000000
+#endif
+#ifndef SO_EE_ORIGIN_ZEROCOPY
+#define SO_EE_ORIGIN_ZEROCOPY 5
+#endif
+#ifndef SO_EE_CODE_ZEROCOPY_COPIED
+#define SO_EE_CODE_ZEROCOPY_COPIED 1
+#endif
+
 namespace oneflow {
 
+namespace {
+
+constexpr size_t kMaxMsgNumPerBatch = 256;
+
+void AppendIOVec(void* base, size_t len, std::vector<iovec>* iovs) {
+  if (len == 0) { return; }
+  iovec iov;
+  iov.iov_base = base;
+  iov.iov_len = len;
+  iovs->push_back(iov);
+}
+
+// whether a is before b in the wrapping sequence of zero-copy sends
+bool IsZeroCopySeqBefore(uint32_t a, uint32_t b) { return static_cast<int32_t>(a - b) < 0; }
+
+}  // namespace
+
+ZeroCopyDoneTracker::ZeroCopyDoneTracker()
+    : next_seq_(0), done_seq_(0), cur_body_used_zero_copy_(false), cur_body_last_seq_(0) {}
+
+void ZeroCopyDoneTracker::ZeroCopySent() {
+  cur_body_used_zero_copy_ = true;
+  cur_body_last_seq_ = next_seq_++;
+}
+
+void ZeroCopyDoneTracker::BodySent(const SocketMsg& done_msg,
+                                   std::queue<SocketMsg>* ready_msgs) {
+  if (cur_body_used_zero_copy_) {
+    pending_done_msgs_.emplace_back(cur_body_last_seq_, done_msg);
+  } else {
+    // every byte of the body was copied into the kernel
+    ready_msgs->push(done_msg);
+  }
+  cur_body_used_zero_copy_ = false;
+}
+
+void ZeroCopyDoneTracker::SendsCompleted(uint32_t first_seq, uint32_t last_seq,
+                                         std::queue<SocketMsg>* ready_msgs) {
+  completed_ranges_.emplace_back(first_seq, last_seq);
+  bool advanced = true;
+  while (advanced) {
+    advanced = false;
+    for (auto it = completed_ranges_.begin(); it != completed_ranges_.end(); ++it) {
+      if (IsZeroCopySeqBefore(done_seq_, it->first)) { continue; }
+      if (!IsZeroCopySeqBefore(it->second, done_seq_)) { done_seq_ = it->second + 1; }
+      completed_ranges_.erase(it);
+      advanced = true;
+      break;
+    }
+  }
+  while (!pending_done_msgs_.empty()
+         && IsZeroCopySeqBefore(pending_done_msgs_.front().first, done_seq_)) {
+    ready_msgs->push(pending_done_msgs_.front().second);
+    pending_done_msgs_.pop_front();
+  }
+}
+
 SocketWriteHelper::~SocketWriteHelper() {
   delete cur_msg_queue_;
   cur_msg_queue_ = nullptr;
@@ -40,9 +109,10 @@ SocketWriteHelper::SocketWriteHelper(int sockfd, IOEventPoller* poller) {
                                    std::bind(&SocketWriteHelper::ProcessQueueNotEmptyEvent, this));
   cur_msg_queue_ = new std::queue<SocketMsg>;
   pending_msg_queue_ = new std::queue<SocketMsg>;
-  cur_write_handle_ = &SocketWriteHelper::InitMsgWriteHandle;
-  write_ptr_ = nullptr;
-  write_size_ = 0;
+  batch_msgs_.reserve(kMaxMsgNumPerBatch);
+  batch_iovs_.reserve(2 * kMaxMsgNumPerBatch);
+  batch_iov2zero_copy_msg_idx_.reserve(2 * kMaxMsgNumPerBatch);
+  batch_iov_idx_ = 0;
 }
 
 void SocketWriteHelper::AsyncWrite(const SocketMsg& msg) {
@@ -55,6 +125,15 @@ void SocketWriteHelper::AsyncWrite(const SocketMsg& msg) {
 
 void SocketWriteHelper::NotifyMeSocketWriteable() { WriteUntilMsgQueueEmptyOrSocketNotWriteable(); }
 
+void SocketWriteHelper::NotifyMeSocketError() {
+  ProcessZeroCopyCompletions();
+  int error = 0;
+  socklen_t len = sizeof(error);
+  PCHECK(getsockopt(sockfd_, SOL_SOCKET, SO_ERROR, &error, &len) == 0);
+  CHECK_EQ(error, 0) << "sockfd " << sockfd_ << ": " << strerror(error);
+  WriteUntilMsgQueueEmptyOrSocketNotWriteable();
+}
+
 void SocketWriteHelper::SendQueueNotEmptyEvent() {
   uint64_t event_num = 1;
   PCHECK(write(queue_not_empty_fd_, &event_num, 8) == 8);
@@ -67,77 +146,138 @@ void SocketWriteHelper::ProcessQueueNotEmptyEvent() {
 }
 
 void SocketWriteHelper::WriteUntilMsgQueueEmptyOrSocketNotWriteable() {
-  while ((this->*cur_write_handle_)()) {}
+  while (true) {
+    if (batch_iov_idx_ == batch_iovs_.size() && !FillWriteBatch()) { return; }
+    if (!DoWriteBatch()) { return; }
+  }
 }
 
-bool SocketWriteHelper::InitMsgWriteHandle() {
-  if (cur_msg_queue_->empty()) {
-    {
-      std::unique_lock<std::mutex> lck(pending_msg_queue_mtx_);
-      std::swap(cur_msg_queue_, pending_msg_queue_);
+bool SocketWriteHelper::FillWriteBatch() {
+  batch_msgs_.clear();
+  batch_iovs_.clear();
+  batch_iov2zero_copy_msg_idx_.clear();
+  batch_iov_idx_ = 0;
+  while (batch_msgs_.size() < kMaxMsgNumPerBatch) {
+    if (cur_msg_queue_->empty()) {
+      {
+        std::unique_lock<std::mutex> lck(pending_msg_queue_mtx_);
+        std::swap(cur_msg_queue_, pending_msg_queue_);
+      }
+      if (cur_msg_queue_->empty()) { break; }
     }
-    if (cur_msg_queue_->empty()) { return false; }
+    batch_msgs_.push_back(cur_msg_queue_->front());
+    cur_msg_queue_->pop();
   }
-  cur_msg_ = cur_msg_queue_->front();
-  cur_msg_queue_->pop();
-  write_ptr_ = reinterpret_cast<const char*>(&cur_msg_);
-  write_size_ = sizeof(cur_msg_);
-  cur_write_handle_ = &SocketWriteHelper::MsgHeadWriteHandle;
-  return true;
-}
-
-bool SocketWriteHelper::MsgHeadWriteHandle() {
-  return DoCurWrite(&SocketWriteHelper::SetStatusWhenMsgHeadDone);
-}
-
-bool SocketWriteHelper::MsgBodyWriteHandle() {
-  return DoCurWrite(&SocketWriteHelper::SetStatusWhenMsgBodyDone);
-}
-
-bool SocketWriteHelper::DoCurWrite(void (SocketWriteHelper::*set_cur_write_done)()) {
-  ssize_t n = write(sockfd_, write_ptr_, write_size_);
-  if (n == write_size_) {
-    (this->*set_cur_write_done)();
-    return true;
-  } else if (n >= 0) {
-    write_ptr_ += n;
-    write_size_ -= n;
-    return true;
-  } else {
-    CHECK_EQ(n, -1);
-    PCHECK(errno == EAGAIN || errno == EWOULDBLOCK);
-    return false;
+  // batch_msgs_ never grows past its reserved capacity, so the head pointers stay valid
+  FOR_RANGE(int64_t, msg_idx, 0, batch_msgs_.size()) {
+    SocketMsg& msg = batch_msgs_.at(msg_idx);
+    AppendIOVec(&msg, sizeof(SocketMsg), &batch_iovs_);
+    batch_iov2zero_copy_msg_idx_.resize(batch_iovs_.size(), -1);
+    if (msg.msg_type == SocketMsgType::kRequestRead) {
+      const RequestReadMsg& request = msg.request_read_msg;
+      auto src_mem_desc = static_cast<const SocketMemDesc*>(request.src_token);
+      CHECK_LE(request.offset + request.byte_size, src_mem_desc->byte_size);
+      if (request.zero_copy && request.byte_size == 0) {
+        SetStatusWhenZeroCopyBodySent(request);
+        continue;
+      }
+      AppendIOVec(static_cast<char*>(src_mem_desc->mem_ptr) + request.offset, request.byte_size,
+                  &batch_iovs_);
+      batch_iov2zero_copy_msg_idx_.resize(batch_iovs_.size(), request.zero_copy ? msg_idx : -1);
+    }
   }
+  stat_.msg_cnt += batch_msgs_.size();
+  return !batch_msgs_.empty();
 }
 
-void SocketWriteHelper::SetStatusWhenMsgHeadDone() {
-  switch (cur_msg_.msg_type) {
-#define MAKE_ENTRY(x, y) \
-  case SocketMsgType::k##x: return SetStatusWhen##x##MsgHeadDone();
-    OF_PP_FOR_EACH_TUPLE(MAKE_ENTRY, SOCKET_MSG_TYPE_SEQ);
-#undef MAKE_ENTRY
-    default: UNIMPLEMENTED();
+bool SocketWriteHelper::DoWriteBatch() {
+  while (batch_iov_idx_ < batch_iovs_.size()) {
+    // a zero-copy body goes out alone, the heads live in batch_msgs_ and are reused right away
+    const bool zero_copy = batch_iov2zero_copy_msg_idx_.at(batch_iov_idx_) != -1;
+    size_t iov_num = 1;
+    if (!zero_copy) {
+      while (batch_iov_idx_ + iov_num < batch_iovs_.size() && iov_num < IOV_MAX
+             && batch_iov2zero_copy_msg_idx_.at(batch_iov_idx_ + iov_num) == -1) {
+        ++iov_num;
+      }
+    }
+    msghdr msg_hdr;
+    memset(&msg_hdr, 0, sizeof(msg_hdr));
+    msg_hdr.msg_iov = batch_iovs_.data() + batch_iov_idx_;
+    msg_hdr.msg_iovlen = iov_num;
+    ssize_t n = sendmsg(sockfd_, &msg_hdr, MSG_NOSIGNAL | (zero_copy ? MSG_ZEROCOPY : 0));
+    stat_.syscall_cnt += 1;
+    bool sent_by_zero_copy = zero_copy;
+    if (n == -1 && zero_copy && errno == ENOBUFS) {
+      // out of option memory for pending completions, copy this time
+      n = sendmsg(sockfd_, &msg_hdr, MSG_NOSIGNAL);
+      stat_.syscall_cnt += 1;
+      sent_by_zero_copy = false;
+    }
+    if (n == -1) {
+      PCHECK(errno == EAGAIN || errno == EWOULDBLOCK);
+      return false;
+    }
+    if (sent_by_zero_copy) {
+      stat_.zero_copy_syscall_cnt += 1;
+      zero_copy_done_tracker_.ZeroCopySent();
+    }
+    stat_.byte_cnt += n;
+    ConsumeWriteBatch(n);
   }
+  return true;
 }
 
-void SocketWriteHelper::SetStatusWhenMsgBodyDone() {
-  cur_write_handle_ = &SocketWriteHelper::InitMsgWriteHandle;
-}
-
-void SocketWriteHelper::SetStatusWhenRequestWriteMsgHeadDone() {
-  cur_write_handle_ = &SocketWriteHelper::InitMsgWriteHandle;
+void SocketWriteHelper::ConsumeWriteBatch(size_t n) {
+  while (n > 0) {
+    iovec* iov = &batch_iovs_.at(batch_iov_idx_);
+    if (n >= iov->iov_len) {
+      n -= iov->iov_len;
+      const int64_t zero_copy_msg_idx = batch_iov2zero_copy_msg_idx_.at(batch_iov_idx_);
+      if (zero_copy_msg_idx != -1) {
+        SetStatusWhenZeroCopyBodySent(batch_msgs_.at(zero_copy_msg_idx).request_read_msg);
+      }
+      ++batch_iov_idx_;
+    } else {
+      iov->iov_base = static_cast<char*>(iov->iov_base) + n;
+      iov->iov_len -= n;
+      n = 0;
+    }
+  }
 }
 
-void SocketWriteHelper::SetStatusWhenRequestReadMsgHeadDone() {
-  const void* src_token = cur_msg_.request_read_msg.src_token;
-  auto src_mem_desc = static_cast<const SocketMemDesc*>(src_token);
-  write_ptr_ = reinterpret_cast<const char*>(src_mem_desc->mem_ptr);
-  write_size_ = src_mem_desc->byte_size;
-  cur_write_handle_ = &SocketWriteHelper::MsgBodyWriteHandle;
+void SocketWriteHelper::SetStatusWhenZeroCopyBodySent(const RequestReadMsg& request) {
+  SocketMsg done_msg;
+  done_msg.msg_type = SocketMsgType::kZeroCopyDone;
+  done_msg.zero_copy_done_msg.read_id = request.read_id;
+  done_msg.zero_copy_done_msg.part_num = request.part_num;
+  zero_copy_done_tracker_.BodySent(done_msg, cur_msg_queue_);
 }
 
-void SocketWriteHelper::SetStatusWhenActorMsgHeadDone() {
-  cur_write_handle_ = &SocketWriteHelper::InitMsgWriteHandle;
+void SocketWriteHelper::ProcessZeroCopyCompletions() {
+  char control[128];
+  while (true) {
+    msghdr msg_hdr;
+    memset(&msg_hdr, 0, sizeof(msg_hdr));
+    msg_hdr.msg_control = control;
+    msg_hdr.msg_controllen = sizeof(control);
+    ssize_t n = recvmsg(sockfd_, &msg_hdr, MSG_ERRQUEUE);
+    stat_.syscall_cnt += 1;
+    if (n == -1) {
+      PCHECK(errno == EAGAIN || errno == EWOULDBLOCK);
+      break;
+    }
+    for (cmsghdr* cm = CMSG_FIRSTHDR(&msg_hdr); cm != nullptr; cm = CMSG_NXTHDR(&msg_hdr, cm)) {
+      auto serr = reinterpret_cast<const sock_extended_err*>(CMSG_DATA(cm));
+      CHECK_EQ(serr->ee_origin, SO_EE_ORIGIN_ZEROCOPY) << "sockfd " << sockfd_ << ": "
+                                                       << strerror(serr->ee_errno);
+      // [ee_info, ee_data] is a range of completed sends
+      if (serr->ee_code & SO_EE_CODE_ZEROCOPY_COPIED) {
+        stat_.zero_copy_copied_cnt += serr->ee_data - serr->ee_info + 1;
+      }
+      zero_copy_done_tracker_.SendsCompleted(serr->ee_info, serr->ee_data, cur_msg_queue_);
+    }
+  }
 }
 
 }  // namespace oneflow
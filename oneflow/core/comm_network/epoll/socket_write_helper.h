@@ -21,8 +21,40 @@ limitations under the License.
 
 #ifdef PLATFORM_POSIX
 
+#include <sys/uio.h>
+
 namespace oneflow {
 
+// The kernel numbers the successful MSG_ZEROCOPY sendmsg calls of a socket from 0 on, and reports
+// completed ranges of these numbers on the error queue, not necessarily in order. The ZeroCopyDone
+// of a body goes out once its sends and all sends before them complete, or at once if the kernel
+// refused zero-copy and copied the whole body.
+class ZeroCopyDoneTracker final {
+ public:
+  OF_DISALLOW_COPY_AND_MOVE(ZeroCopyDoneTracker);
+  ZeroCopyDoneTracker();
+  ~ZeroCopyDoneTracker() = default;
+
+  // a sendmsg with MSG_ZEROCOPY of the current body succeeded
+  void ZeroCopySent();
+  // every byte of the current body is sent
+  void BodySent(const SocketMsg& done_msg, std::queue<SocketMsg>* ready_msgs);
+  // the sends numbered [first_seq, last_seq] are complete
+  void SendsCompleted(uint32_t first_seq, uint32_t last_seq, std::queue<SocketMsg>* ready_msgs);
+
+  size_t pending_done_msg_num() const { return pending_done_msgs_.size(); }
+
+ private:
+  uint32_t next_seq_;
+  // every send before it is complete
+  uint32_t done_seq_;
+  // the completed ranges after done_seq_
+  std::vector<std::pair<uint32_t, uint32_t>> completed_ranges_;
+  bool cur_body_used_zero_copy_;
+  uint32_t cur_body_last_seq_;
+  std::deque<std::pair<uint32_t, SocketMsg>> pending_done_msgs_;
+};
+
 class SocketWriteHelper final {
  public:
   OF_DISALLOW_COPY_AND_MOVE(SocketWriteHelper);
@@ -34,23 +66,20 @@ class SocketWriteHelper final {
   void AsyncWrite(const SocketMsg& msg);
 
   void NotifyMeSocketWriteable();
+  void NotifyMeSocketError();
+
+  const SocketIOStat& stat() const { return stat_; }
 
  private:
   void SendQueueNotEmptyEvent();
   void ProcessQueueNotEmptyEvent();
 
   void WriteUntilMsgQueueEmptyOrSocketNotWriteable();
-  bool InitMsgWriteHandle();
-  bool MsgHeadWriteHandle();
-  bool MsgBodyWriteHandle();
-
-  bool DoCurWrite(void (SocketWriteHelper::*set_cur_write_done)());
-  void SetStatusWhenMsgHeadDone();
-  void SetStatusWhenMsgBodyDone();
-
-#define MAKE_ENTRY(x, y) void SetStatusWhen##x##MsgHeadDone();
-  OF_PP_FOR_EACH_TUPLE(MAKE_ENTRY, SOCKET_MSG_TYPE_SEQ);
-#undef MAKE_ENTRY
+  bool FillWriteBatch();
+  bool DoWriteBatch();
+  void ConsumeWriteBatch(size_t n);
+  void SetStatusWhenZeroCopyBodySent(const RequestReadMsg& request);
+  void ProcessZeroCopyCompletions();
 
   int sockfd_;
   int queue_not_empty_fd_;
@@ -60,10 +89,16 @@ class SocketWriteHelper final {
   std::mutex pending_msg_queue_mtx_;
   std::queue<SocketMsg>* pending_msg_queue_;
 
-  SocketMsg cur_msg_;
-  bool (SocketWriteHelper::*cur_write_handle_)();
-  const char* write_ptr_;
-  size_t write_size_;
+  // the heads and bodies of a batch of messages go out with as few sendmsg calls as possible
+  std::vector<SocketMsg> batch_msgs_;
+  std::vector<iovec> batch_iovs_;
+  // the index in batch_msgs_ of the RequestRead whose body is sent with MSG_ZEROCOPY, -1 otherwise
+  std::vector<int64_t> batch_iov2zero_copy_msg_idx_;
+  size_t batch_iov_idx_;
+
+  ZeroCopyDoneTracker zero_copy_done_tracker_;
+
+  SocketIOStat stat_;
 };
 
 }  // namespace oneflow
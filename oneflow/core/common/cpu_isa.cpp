@@ -0,0 +1,58 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include "oneflow/core/common/cpu_isa.h"
+#include <cstdlib>
+#include <string>
+#include <glog/logging.h>
+
+namespace oneflow {
+
+namespace {
+
+CpuIsa DetectCpuIsa() {
+#if OF_CPU_ISA_DISPATCH_ENABLED
+  __builtin_cpu_init();
+  if (__builtin_cpu_supports("avx512f") && __builtin_cpu_supports("avx512bw")
+      && __builtin_cpu_supports("avx512dq") && __builtin_cpu_supports("avx512vl")) {
+    return CpuIsa::kAvx512;
+  }
+  if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma")) { return CpuIsa::kAvx2; }
+#endif
+  return CpuIsa::kScalar;
+}
+
+CpuIsa CpuIsa4Name(const std::string& name) {
+  if (name == "scalar") { return CpuIsa::kScalar; }
+  if (name == "avx2") { return CpuIsa::kAvx2; }
+  if (name == "avx512") { return CpuIsa::kAvx512; }
+  LOG(FATAL) << "ONEFLOW_CPU_ISA is " << name << ", expected scalar, avx2 or avx512";
+  return CpuIsa::kScalar;
+}
+
+}  // namespace
+
+CpuIsa GetCpuIsa() {
+  static const CpuIsa isa = [] {
+    const CpuIsa detected = DetectCpuIsa();
+    const char* cap = std::getenv("ONEFLOW_CPU_ISA");
+    if (cap == nullptr) { return detected; }
+    const CpuIsa capped = CpuIsa4Name(cap);
+    return static_cast<int>(capped) < static_cast<int>(detected) ? capped : detected;
+  }();
+  return isa;
+}
+
+}  // namespace oneflow
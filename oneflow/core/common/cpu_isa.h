@@ -0,0 +1,50 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#ifndef ONEFLOW_CORE_COMMON_CPU_ISA_H_
+#define ONEFLOW_CORE_COMMON_CPU_ISA_H_
+
+namespace oneflow {
+
+// The vector instruction sets cpu kernels may specialize for, in increasing order.
+enum class CpuIsa {
+  kScalar = 0,
+  kAvx2 = 1,    // with fma
+  kAvx512 = 2,  // avx512f, avx512bw, avx512dq and avx512vl
+};
+
+// The best isa supported by both the compiler and the running cpu, detected once. The
+// ONEFLOW_CPU_ISA environment variable (scalar, avx2 or avx512) caps it, e.g. to compare a
+// vectorized kernel against its scalar fallback.
+CpuIsa GetCpuIsa();
+
+}  // namespace oneflow
+
+// Lets a function be compiled for an isa above the build's baseline, the caller checks
+// GetCpuIsa() before calling it.
+#if (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+#define OF_CPU_ISA_DISPATCH_ENABLED 1
+#define OF_CPU_TARGET_AVX2 __attribute__((target("avx2,fma")))
+#define OF_CPU_TARGET_AVX512 __attribute__((target("avx512f,avx512bw,avx512dq,avx512vl,avx2,fma")))
+// Every avx2 cpu also has the f16c half <-> float conversions, so CpuIsa::kAvx2 implies them.
+#define OF_CPU_TARGET_AVX2_F16C __attribute__((target("avx2,fma,f16c")))
+#else
+#define OF_CPU_ISA_DISPATCH_ENABLED 0
+#define OF_CPU_TARGET_AVX2
+#define OF_CPU_TARGET_AVX512
+#define OF_CPU_TARGET_AVX2_F16C
+#endif
+
+#endif  // ONEFLOW_CORE_COMMON_CPU_ISA_H_
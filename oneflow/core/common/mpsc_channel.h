@@ -0,0 +1,213 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#ifndef ONEFLOW_CORE_COMMON_MPSC_CHANNEL_H_
+#define ONEFLOW_CORE_COMMON_MPSC_CHANNEL_H_
+
+#include "oneflow/core/common/util.h"
+#include "oneflow/core/common/channel.h"
+
+namespace oneflow {
+
+inline void CpuRelax() {
+#if defined(__x86_64__) || defined(__i386__)
+  __builtin_ia32_pause();
+#elif defined(__aarch64__)
+  asm volatile("yield" ::: "memory");
+#endif
+}
+
+// Bounded lock-free multi-producer/single-consumer channel.
+//
+// Producers claim a slot with a single CAS on the enqueue position and publish it by bumping
+// the per-slot sequence number, so Send never takes a lock on the fast path. The consumer drains
+// every published slot in one ReceiveMany call. When nothing is published it spins for an
+// adaptive number of rounds before parking on a condition variable; producers only touch the
+// mutex when they observe that the consumer is parked.
+//
+// A full channel applies back pressure: Send spins (then yields) until the consumer frees a slot.
+template<typename T>
+class MpscChannel final {
+ public:
+  OF_DISALLOW_COPY_AND_MOVE(MpscChannel);
+  MpscChannel(size_t capacity, int64_t max_spin_count);
+  ~MpscChannel() = default;
+
+  ChannelStatus Send(const T& item);
+  ChannelStatus Receive(T* item);
+  ChannelStatus ReceiveMany(std::queue<T>* items);
+  void Close();
+
+  size_t capacity() const { return mask_ + 1; }
+
+ private:
+  struct Slot {
+    std::atomic<size_t> seq;
+    T item;
+  };
+  static const int64_t kCacheLineSize = 64;
+  static const int64_t kMinSpinCount = 16;
+  static const int64_t kProducerPauseCount = 64;
+
+  bool TrySend(const T& item);
+  bool HasPublished() const;
+  bool WaitForPublished();
+  void PopFront(T* item);
+  void WakeUpConsumerIfParked();
+
+  std::unique_ptr<Slot[]> slots_;
+  size_t mask_;
+  char pad0_[kCacheLineSize];
+  std::atomic<size_t> enqueue_pos_;
+  char pad1_[kCacheLineSize];
+  // the following are only touched by the consumer
+  size_t dequeue_pos_;
+  int64_t max_spin_count_;
+  int64_t spin_count_;
+  char pad2_[kCacheLineSize];
+  std::atomic<bool> is_closed_;
+  std::atomic<bool> consumer_parked_;
+  std::mutex park_mutex_;
+  std::condition_variable park_cond_;
+};
+
+template<typename T>
+MpscChannel<T>::MpscChannel(size_t capacity, int64_t max_spin_count)
+    : enqueue_pos_(0),
+      dequeue_pos_(0),
+      max_spin_count_(std::max<int64_t>(max_spin_count, 0)),
+      spin_count_(max_spin_count_),
+      is_closed_(false),
+      consumer_parked_(false) {
+  CHECK_GE(capacity, 2);
+  size_t rounded_capacity = 2;
+  while (rounded_capacity < capacity) { rounded_capacity <<= 1; }
+  mask_ = rounded_capacity - 1;
+  slots_.reset(new Slot[rounded_capacity]);
+  FOR_RANGE(size_t, i, 0, rounded_capacity) { slots_[i].seq.store(i, std::memory_order_relaxed); }
+}
+
+template<typename T>
+bool MpscChannel<T>::TrySend(const T& item) {
+  size_t pos = enqueue_pos_.load(std::memory_order_relaxed);
+  Slot* slot = nullptr;
+  while (true) {
+    slot = &slots_[pos & mask_];
+    const size_t seq = slot->seq.load(std::memory_order_acquire);
+    const int64_t diff = static_cast<int64_t>(seq) - static_cast<int64_t>(pos);
+    if (diff == 0) {
+      if (enqueue_pos_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) { break; }
+    } else if (diff < 0) {
+      return false;
+    } else {
+      pos = enqueue_pos_.load(std::memory_order_relaxed);
+    }
+  }
+  slot->item = item;
+  slot->seq.store(pos + 1, std::memory_order_release);
+  return true;
+}
+
+template<typename T>
+bool MpscChannel<T>::HasPublished() const {
+  const Slot& slot = slots_[dequeue_pos_ & mask_];
+  return slot.seq.load(std::memory_order_acquire) == dequeue_pos_ + 1;
+}
+
+template<typename T>
+void MpscChannel<T>::WakeUpConsumerIfParked() {
+  // pairs with the fence in WaitForPublished: either we see the consumer parked, or the consumer
+  // sees our published slot before it goes to sleep
+  std::atomic_thread_fence(std::memory_order_seq_cst);
+  if (consumer_parked_.load(std::memory_order_relaxed)) {
+    std::unique_lock<std::mutex> lock(park_mutex_);
+    park_cond_.notify_one();
+  }
+}
+
+template<typename T>
+ChannelStatus MpscChannel<T>::Send(const T& item) {
+  int64_t retry = 0;
+  while (!TrySend(item)) {
+    if (is_closed_.load(std::memory_order_acquire)) { return kChannelStatusErrorClosed; }
+    if (retry < kProducerPauseCount) {
+      CpuRelax();
+      ++retry;
+    } else {
+      std::this_thread::yield();
+    }
+  }
+  WakeUpConsumerIfParked();
+  return kChannelStatusSuccess;
+}
+
+template<typename T>
+bool MpscChannel<T>::WaitForPublished() {
+  if (HasPublished()) { return true; }
+  FOR_RANGE(int64_t, i, 0, spin_count_) {
+    CpuRelax();
+    if (HasPublished()) {
+      // spinning paid off, be more patient next time
+      spin_count_ = std::min(spin_count_ * 2, max_spin_count_);
+      return true;
+    }
+  }
+  const int64_t min_spin_count = kMinSpinCount;
+  spin_count_ = std::max(spin_count_ / 2, std::min(min_spin_count, max_spin_count_));
+  std::unique_lock<std::mutex> lock(park_mutex_);
+  consumer_parked_.store(true, std::memory_order_relaxed);
+  std::atomic_thread_fence(std::memory_order_seq_cst);
+  park_cond_.wait(
+      lock, [this]() { return HasPublished() || is_closed_.load(std::memory_order_acquire); });
+  consumer_parked_.store(false, std::memory_order_relaxed);
+  return HasPublished();
+}
+
+template<typename T>
+void MpscChannel<T>::PopFront(T* item) {
+  Slot* slot = &slots_[dequeue_pos_ & mask_];
+  *item = std::move(slot->item);
+  slot->seq.store(dequeue_pos_ + mask_ + 1, std::memory_order_release);
+  ++dequeue_pos_;
+}
+
+template<typename T>
+ChannelStatus MpscChannel<T>::ReceiveMany(std::queue<T>* items) {
+  if (!WaitForPublished()) { return kChannelStatusErrorClosed; }
+  T item;
+  while (HasPublished()) {
+    PopFront(&item);
+    items->push(std::move(item));
+  }
+  return kChannelStatusSuccess;
+}
+
+template<typename T>
+ChannelStatus MpscChannel<T>::Receive(T* item) {
+  if (!WaitForPublished()) { return kChannelStatusErrorClosed; }
+  PopFront(item);
+  return kChannelStatusSuccess;
+}
+
+template<typename T>
+void MpscChannel<T>::Close() {
+  is_closed_.store(true, std::memory_order_release);
+  std::unique_lock<std::mutex> lock(park_mutex_);
+  park_cond_.notify_all();
+}
+
+}  // namespace oneflow
+
+#endif  // ONEFLOW_CORE_COMMON_MPSC_CHANNEL_H_
@@ -0,0 +1,136 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include "oneflow/core/common/mpsc_channel.h"
+#include "oneflow/core/common/channel.h"
+
+namespace oneflow {
+
+namespace {
+
+int64_t EncodeItem(int64_t sender_id, int64_t seq) { return (sender_id << 32) | seq; }
+int64_t DecodeSenderId(int64_t item) { return item >> 32; }
+int64_t DecodeSeq(int64_t item) { return item & 0xffffffff; }
+
+template<typename ChannelT>
+void SendSequence(ChannelT* channel, int64_t sender_id, int64_t num) {
+  FOR_RANGE(int64_t, i, 0, num) {
+    if (channel->Send(EncodeItem(sender_id, i)) != kChannelStatusSuccess) { break; }
+  }
+}
+
+template<typename ChannelT>
+int64_t ReceiveAll(ChannelT* channel, int64_t total) {
+  std::queue<int64_t> items;
+  int64_t received = 0;
+  while (received < total) {
+    CHECK_EQ(channel->ReceiveMany(&items), kChannelStatusSuccess);
+    received += items.size();
+    std::queue<int64_t>().swap(items);
+  }
+  return received;
+}
+
+template<typename ChannelT>
+double MeasureMsgPerSec(ChannelT* channel, int64_t sender_num, int64_t num_per_sender) {
+  auto start = std::chrono::steady_clock::now();
+  std::vector<std::thread> senders;
+  FOR_RANGE(int64_t, i, 0, sender_num) {
+    senders.push_back(std::thread(SendSequence<ChannelT>, channel, i, num_per_sender));
+  }
+  const int64_t received = ReceiveAll(channel, sender_num * num_per_sender);
+  for (std::thread& sender : senders) { sender.join(); }
+  std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+  return received / elapsed.count();
+}
+
+}  // namespace
+
+TEST(MpscChannel, per_sender_fifo) {
+  MpscChannel<int64_t> channel(64, 128);
+  const int64_t sender_num = 16;
+  const int64_t num_per_sender = 20000;
+  std::vector<std::thread> senders;
+  FOR_RANGE(int64_t, i, 0, sender_num) {
+    senders.push_back(
+        std::thread(SendSequence<MpscChannel<int64_t>>, &channel, i, num_per_sender));
+  }
+  std::vector<int64_t> next_seq(sender_num, 0);
+  std::queue<int64_t> items;
+  int64_t received = 0;
+  while (received < sender_num * num_per_sender) {
+    ASSERT_EQ(channel.ReceiveMany(&items), kChannelStatusSuccess);
+    while (!items.empty()) {
+      const int64_t item = items.front();
+      items.pop();
+      ASSERT_EQ(DecodeSeq(item), next_seq.at(DecodeSenderId(item)));
+      ++next_seq.at(DecodeSenderId(item));
+      ++received;
+    }
+  }
+  for (std::thread& sender : senders) { sender.join(); }
+  for (int64_t seq : next_seq) { ASSERT_EQ(seq, num_per_sender); }
+}
+
+TEST(MpscChannel, close) {
+  MpscChannel<int64_t> channel(4, 0);
+  ASSERT_EQ(channel.Send(1), kChannelStatusSuccess);
+  ASSERT_EQ(channel.Send(2), kChannelStatusSuccess);
+  channel.Close();
+  int64_t item = 0;
+  ASSERT_EQ(channel.Receive(&item), kChannelStatusSuccess);
+  ASSERT_EQ(item, 1);
+  std::queue<int64_t> items;
+  ASSERT_EQ(channel.ReceiveMany(&items), kChannelStatusSuccess);
+  ASSERT_EQ(items.size(), 1);
+  ASSERT_EQ(channel.ReceiveMany(&items), kChannelStatusErrorClosed);
+  ASSERT_EQ(channel.Receive(&item), kChannelStatusErrorClosed);
+}
+
+TEST(MpscChannel, wake_up_parked_receiver) {
+  MpscChannel<int64_t> channel(4, 0);
+  std::thread receiver([&channel]() {
+    int64_t item = 0;
+    FOR_RANGE(int64_t, i, 0, 1000) {
+      ASSERT_EQ(channel.Receive(&item), kChannelStatusSuccess);
+      ASSERT_EQ(item, i);
+    }
+    ASSERT_EQ(channel.Receive(&item), kChannelStatusErrorClosed);
+  });
+  FOR_RANGE(int64_t, i, 0, 1000) {
+    if (i % 100 == 0) { std::this_thread::sleep_for(std::chrono::milliseconds(1)); }
+    ASSERT_EQ(channel.Send(i), kChannelStatusSuccess);
+  }
+  // the receiver may still be draining, Close must not drop what was already sent
+  channel.Close();
+  receiver.join();
+}
+
+// run with --gtest_also_run_disabled_tests --gtest_filter=MpscChannel.DISABLED_benchmark
+TEST(MpscChannel, DISABLED_benchmark) {
+  const int64_t total_num = 1 << 22;
+  for (int64_t sender_num : {1, 2, 4, 8, 16, 32, 64}) {
+    const int64_t num_per_sender = total_num / sender_num;
+    Channel<int64_t> channel;
+    MpscChannel<int64_t> mpsc_channel(65536, 4096);
+    const double channel_rate = MeasureMsgPerSec(&channel, sender_num, num_per_sender);
+    const double mpsc_rate = MeasureMsgPerSec(&mpsc_channel, sender_num, num_per_sender);
+    LOG(INFO) << "senders: " << sender_num << ", Channel: " << channel_rate / 1e6
+              << " Mmsg/s, MpscChannel: " << mpsc_rate / 1e6
+              << " Mmsg/s, speedup: " << mpsc_rate / channel_rate;
+  }
+}
+
+}  // namespace oneflow
@@ -0,0 +1,64 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include "oneflow/core/common/random_permutation.h"
+
+namespace oneflow {
+
+namespace {
+
+uint64_t SplitMix64(uint64_t x) {
+  x += 0x9e3779b97f4a7c15ULL;
+  x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ULL;
+  x = (x ^ (x >> 27)) * 0x94d049bb133111ebULL;
+  return x ^ (x >> 31);
+}
+
+}  // namespace
+
+RandomPermutation::RandomPermutation(int64_t size, uint64_t seed) : size_(size) {
+  CHECK_GE(size, 0);
+  half_bits_ = 1;
+  while ((int64_t(1) << (2 * half_bits_)) < size) { ++half_bits_; }
+  half_mask_ = (uint64_t(1) << half_bits_) - 1;
+  uint64_t key = seed;
+  FOR_RANGE(int32_t, i, 0, kRoundNum) {
+    key = SplitMix64(key);
+    round_keys_[i] = key;
+  }
+}
+
+uint64_t RandomPermutation::Encrypt(uint64_t x) const {
+  uint64_t left = x >> half_bits_;
+  uint64_t right = x & half_mask_;
+  FOR_RANGE(int32_t, i, 0, kRoundNum) {
+    const uint64_t next_right = left ^ (SplitMix64(right ^ round_keys_[i]) & half_mask_);
+    left = right;
+    right = next_right;
+  }
+  return (left << half_bits_) | right;
+}
+
+int64_t RandomPermutation::At(int64_t i) const {
+  CHECK_GE(i, 0);
+  CHECK_LT(i, size_);
+  // Encrypt is a bijection on [0, 4^half_bits_), so walking the cycle of i always comes back
+  // into [0, size_) before reaching i again
+  uint64_t x = Encrypt(i);
+  while (x >= static_cast<uint64_t>(size_)) { x = Encrypt(x); }
+  return static_cast<int64_t>(x);
+}
+
+}  // namespace oneflow
@@ -0,0 +1,50 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#ifndef ONEFLOW_CORE_COMMON_RANDOM_PERMUTATION_H_
+#define ONEFLOW_CORE_COMMON_RANDOM_PERMUTATION_H_
+
+#include "oneflow/core/common/util.h"
+
+namespace oneflow {
+
+// A seeded pseudo-random permutation of [0, size) evaluated on demand in O(1) memory.
+//
+// It runs a balanced Feistel network over the smallest even-bit power of two covering size and
+// walks the cycle until the result falls back into [0, size), which takes fewer than four rounds
+// on average. The same (size, seed) gives the same permutation on every process.
+class RandomPermutation final {
+ public:
+  OF_DISALLOW_COPY_AND_MOVE(RandomPermutation);
+  RandomPermutation(int64_t size, uint64_t seed);
+  ~RandomPermutation() = default;
+
+  int64_t size() const { return size_; }
+  int64_t At(int64_t i) const;
+
+ private:
+  static const int32_t kRoundNum = 4;
+
+  uint64_t Encrypt(uint64_t x) const;
+
+  int64_t size_;
+  int32_t half_bits_;
+  uint64_t half_mask_;
+  uint64_t round_keys_[kRoundNum];
+};
+
+}  // namespace oneflow
+
+#endif  // ONEFLOW_CORE_COMMON_RANDOM_PERMUTATION_H_
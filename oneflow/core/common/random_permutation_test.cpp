@@ -0,0 +1,51 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include "oneflow/core/common/random_permutation.h"
+
+namespace oneflow {
+
+TEST(RandomPermutation, is_permutation) {
+  for (int64_t size : {1, 2, 3, 17, 1000, 65536, 100003}) {
+    RandomPermutation permutation(size, 524287);
+    std::vector<bool> visited(size, false);
+    FOR_RANGE(int64_t, i, 0, size) {
+      const int64_t j = permutation.At(i);
+      ASSERT_GE(j, 0);
+      ASSERT_LT(j, size);
+      ASSERT_FALSE(visited.at(j));
+      visited.at(j) = true;
+    }
+  }
+}
+
+TEST(RandomPermutation, seeded) {
+  const int64_t size = 10000;
+  RandomPermutation a(size, 1);
+  RandomPermutation b(size, 1);
+  RandomPermutation c(size, 2);
+  int64_t same_as_c = 0;
+  int64_t fixed_point = 0;
+  FOR_RANGE(int64_t, i, 0, size) {
+    ASSERT_EQ(a.At(i), b.At(i));
+    if (a.At(i) == c.At(i)) { ++same_as_c; }
+    if (a.At(i) == i) { ++fixed_point; }
+  }
+  // both are about 1 for a random permutation
+  ASSERT_LT(same_as_c, 20);
+  ASSERT_LT(fixed_point, 20);
+}
+
+}  // namespace oneflow
@@ -129,6 +129,26 @@ void CtrlClient::PullKV(const std::string& k, PbMessage* msg) {
   PullKV(k, [&](const std::string& i) { msg->ParseFromString(i); });
 }
 
+void CtrlClient::PushMachineKV(int64_t machine_id, const std::string& k, const std::string& v) {
+  ClientCall<CtrlMethod::kPushKV> call;
+  call.mut_request()->set_key(k);
+  call.mut_request()->set_val(v);
+  call(stubs_.at(machine_id).get());
+}
+
+void CtrlClient::PullMachineKV(int64_t machine_id, const std::string& k, std::string* v) {
+  ClientCall<CtrlMethod::kPullKV> call;
+  call.mut_request()->set_key(k);
+  call(stubs_.at(machine_id).get());
+  *v = call.response().val();
+}
+
+void CtrlClient::ClearMachineKV(int64_t machine_id, const std::string& k) {
+  ClientCall<CtrlMethod::kClearKV> call;
+  call.mut_request()->set_key(k);
+  call(stubs_.at(machine_id).get());
+}
+
 void CtrlClient::PushActEvent(const ActEvent& act_event) {
   ClientCall<CtrlMethod::kPushActEvent> call;
   *(call.mut_request()->mutable_act_event()) = act_event;
@@ -54,6 +54,11 @@ class CtrlClient final {
     *v = oneflow_cast<T>(v_str);
   }
 
+  // on the ctrl server of machine_id rather than the one the key is hashed to
+  void PushMachineKV(int64_t machine_id, const std::string& k, const std::string& v);
+  void PullMachineKV(int64_t machine_id, const std::string& k, std::string* v);
+  void ClearMachineKV(int64_t machine_id, const std::string& k);
+
   void PushActEvent(const ActEvent&);
   void Clear();
 
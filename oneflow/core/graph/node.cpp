@@ -17,13 +17,14 @@ limitations under the License.
 
 namespace oneflow {
 
+// atomic for the graphs built concurrently, e.g. the exec graphs of the task nodes
 int64_t NewNodeId() {
-  static int64_t node_id = 0;
+  static std::atomic<int64_t> node_id(0);
   return node_id++;
 }
 
 int64_t NewEdgeId() {
-  static int64_t edge_id = 0;
+  static std::atomic<int64_t> edge_id(0);
   return edge_id++;
 }
 
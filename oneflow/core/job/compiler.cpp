@@ -18,9 +18,45 @@ limitations under the License.
 #include "oneflow/core/persistence/tee_persistent_log_stream.h"
 #include "oneflow/core/graph/op_graph.h"
 #include "oneflow/core/job_rewriter/job_completer.h"
+#include "oneflow/core/thread/thread_manager.h"
 
 namespace oneflow {
 
+namespace {
+
+// the task nodes a worker of the thread pool handles at a time
+constexpr int64_t kCompileTaskGrainSize = 32;
+
+void ParallelForEachNode(const std::vector<TaskNode*>& task_nodes,
+                         const std::function<void(TaskNode*)>& Handler) {
+  MultiThreadLoopInRange(task_nodes.size(), kCompileTaskGrainSize,
+                         [&](int64_t begin, int64_t end) {
+                           FOR_RANGE(int64_t, i, begin, end) { Handler(task_nodes.at(i)); }
+                         });
+}
+
+// Handler of a node runs after the ones of all its predecessors, the nodes of the same topo level
+// depend on none of each other and run on the thread pool
+void ParallelTopoForEachNode(const TaskGraph& task_gph,
+                             const std::function<void(TaskNode*)>& Handler) {
+  HashMap<const TaskNode*, size_t> node2level;
+  std::vector<std::vector<TaskNode*>> levels;
+  task_gph.TopoForEachNode([&](TaskNode* task_node) {
+    size_t level = 0;
+    task_node->ForEachNodeOnInEdge([&](const TaskNode* in_node) {
+      level = std::max(level, node2level.at(in_node) + 1);
+    });
+    node2level.emplace(task_node, level);
+    if (level == levels.size()) { levels.emplace_back(); }
+    levels.at(level).push_back(task_node);
+  });
+  for (const std::vector<TaskNode*>& task_nodes : levels) {
+    ParallelForEachNode(task_nodes, Handler);
+  }
+}
+
+}  // namespace
+
 void Compiler::GenNetTopo(Plan* plan) const {
   HashMap<int64_t, int64_t> rid2mid;
   HashMap<int64_t, int64_t> tid2mid;
@@ -71,25 +107,51 @@ void Compiler::Compile(Job* job, Plan* plan, bool need_job_complete) const {
     Global<OpGraph>::Get()->ToDotWithFilePath("optimized_dlnet_" + std::to_string(job_desc.job_id())
                                               + "_op_graph.dot");
   }
+  double phase_start = GetCurTime();
+  const auto LogPhaseTime = [&](const std::string& phase) {
+    const double now = GetCurTime();
+    LOG(INFO) << "compile phase " << phase << " of job " << job_desc.job_name()
+              << " time: " << (now - phase_start) / 1e6 << " ms";
+    phase_start = now;
+  };
   auto logical_gph = std::make_unique<LogicalGraph>(*job);
   auto task_gph = std::make_unique<TaskGraph>(std::move(logical_gph));
+  LogPhaseTime("TaskGraph");
   using std::placeholders::_1;
+  // serial, they allocate the regst desc ids and add consumers to the regsts of other nodes
   task_gph->ForEachNode(std::bind(&TaskNode::ProduceAllRegstsAndBindEdges, _1));
   task_gph->ForEachNode(std::bind(&TaskNode::ConsumeAllRegsts, _1));
   task_gph->ForEachNode(std::bind(&TaskNode::PinConsumedRegst, _1));
-  task_gph->TopoForEachNode(&TaskNode::Build);
+  LogPhaseTime("ProduceAndConsumeRegsts");
+  ParallelTopoForEachNode(*task_gph, &TaskNode::Build);
+  LogPhaseTime("Build");
   task_gph->RemoveEmptyRegsts();
   task_gph->AddOrderingCtrlEdgeInSameChain();
   if (job_desc.enable_inplace()) {
     auto IsReachable = Global<OpGraph>::Get()->MakePredicatorIsOpNameDataOrCtrlReachable();
     task_gph->EnableInplaceMemSharing(IsReachable);
   }
-  task_gph->TopoForEachNode(&TaskNode::InferTimeShapeIfMeaningful);
+  LogPhaseTime("OrderAndInplace");
+  ParallelTopoForEachNode(*task_gph, &TaskNode::InferTimeShapeIfMeaningful);
+  LogPhaseTime("InferTimeShape");
 
+  std::vector<TaskNode*> meaningful_task_nodes;
   task_gph->ForEachNode([&](TaskNode* task_node) {
     if (task_node->IsMeaningLess()) { return; }
-    task_node->ToProto(plan->mutable_task()->Add());
+    meaningful_task_nodes.push_back(task_node);
   });
+  // the task protos are added in advance so that they are serialized into concurrently
+  const int64_t task_proto_offset = plan->task_size();
+  plan->mutable_task()->Reserve(task_proto_offset + meaningful_task_nodes.size());
+  FOR_RANGE(size_t, i, 0, meaningful_task_nodes.size()) { plan->mutable_task()->Add(); }
+  MultiThreadLoopInRange(meaningful_task_nodes.size(), kCompileTaskGrainSize,
+                         [&](int64_t begin, int64_t end) {
+                           FOR_RANGE(int64_t, i, begin, end) {
+                             meaningful_task_nodes.at(i)->ToProto(
+                                 plan->mutable_task(task_proto_offset + i));
+                           }
+                         });
+  LogPhaseTime("ToProto");
   {
     auto* job_id2job_conf = plan->mutable_job_confs()->mutable_job_id2job_conf();
     (*job_id2job_conf)[GlobalJobDesc().job_id()] = GlobalJobDesc().job_conf();
@@ -0,0 +1,128 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include "oneflow/core/job/compiler.h"
+#include "oneflow/core/framework/user_op_conf.h"
+#include "oneflow/core/job/env_desc.h"
+#include "oneflow/core/job/global_for.h"
+#include "oneflow/core/job/id_manager.h"
+#include "oneflow/core/job/job_desc.h"
+#include "oneflow/core/job/resource_desc.h"
+#include "oneflow/core/thread/thread_pool.h"
+
+namespace oneflow {
+
+namespace {
+
+EnvProto GetEnvProto() {
+  EnvProto ret;
+  auto* machine = ret.add_machine();
+  machine->set_id(0);
+  machine->set_addr("192.168.1.0");
+  ret.set_ctrl_port(9527);
+  return ret;
+}
+
+Resource GetResource() {
+  Resource ret;
+  ret.set_machine_num(1);
+  ret.set_gpu_device_num(0);
+  ret.set_cpu_device_num(4);
+  ret.set_comm_net_worker_num(1);
+  return ret;
+}
+
+void AddCpuOp(const OperatorConf& op_conf, Job* job) {
+  OperatorConf* cpu_op_conf = job->mutable_net()->add_op();
+  *cpu_op_conf = op_conf;
+  cpu_op_conf->set_device_tag("cpu");
+  PlacementGroup* placement_group = job->mutable_placement()->add_placement_group();
+  placement_group->mutable_op_set()->add_op_name(op_conf.name());
+  placement_group->mutable_parallel_conf()->set_device_tag("cpu");
+  placement_group->mutable_parallel_conf()->add_device_name("0:0-3");
+}
+
+// a constant feeding 16 branches of a relu and an identity, which an add_n sums up. On 4 devices
+// a level of the branches has 64 task nodes, more than a worker of the compiler takes at a time.
+Job GetJob() {
+  Job job;
+  job.mutable_job_conf()->set_job_name("compiler_test");
+  job.mutable_job_conf()->mutable_predict_conf();
+  AddCpuOp(user_op::UserOpConfWrapperBuilder("constant")
+               .Op("constant")
+               .Output("out")
+               .Attr<double>("floating_value", 1.0)
+               .Attr<int64_t>("integer_value", 0)
+               .Attr<bool>("is_floating_value", true)
+               .Attr<DataType>("dtype", DataType::kFloat)
+               .Attr<Shape>("shape", Shape({64, 32}))
+               .Build()
+               .op_conf(),
+           &job);
+  user_op::UserOpConfWrapperBuilder add_n_builder("add_n");
+  add_n_builder.Op("add_n").Output("out");
+  FOR_RANGE(int64_t, i, 0, 16) {
+    const std::string relu_name = "relu-" + std::to_string(i);
+    const std::string identity_name = "identity-" + std::to_string(i);
+    AddCpuOp(user_op::UserOpConfWrapperBuilder(relu_name)
+                 .Op("relu")
+                 .Input("in", "constant/out_0")
+                 .Output("out")
+                 .Build()
+                 .op_conf(),
+             &job);
+    AddCpuOp(user_op::UserOpConfWrapperBuilder(identity_name)
+                 .Op("identity")
+                 .Input("in", relu_name + "/out_0")
+                 .Output("out")
+                 .Build()
+                 .op_conf(),
+             &job);
+    add_n_builder.Input("in", identity_name + "/out_0");
+  }
+  AddCpuOp(add_n_builder.Build().op_conf(), &job);
+  return job;
+}
+
+// compiles with a fresh IDMgr, so that both plans number their tasks and regsts from scratch
+Plan Compile(const Job& job) {
+  Global<IDMgr>::New();
+  Job job_to_compile = job;
+  Plan plan;
+  Compiler().Compile(&job_to_compile, &plan, false);
+  Global<IDMgr>::Delete();
+  return plan;
+}
+
+}  // namespace
+
+TEST(Compiler, plan_compiled_on_thread_pool_equals_serial_one) {
+  Global<EnvDesc>::New(GetEnvProto());
+  Global<ResourceDesc, ForSession>::New(GetResource());
+  const Job job = GetJob();
+  Global<JobDesc>::New(job.job_conf(), 0);
+  Global<ThreadPool>::New(4);
+  const Plan pool_plan = Compile(job);
+  Global<ThreadPool>::Delete();
+  // without a thread pool everything runs on the calling thread
+  const Plan serial_plan = Compile(job);
+  ASSERT_GT(serial_plan.task_size(), 64);
+  ASSERT_TRUE(PbMd::Equals(pool_plan, serial_plan));
+  Global<JobDesc>::Delete();
+  Global<ResourceDesc, ForSession>::Delete();
+  Global<EnvDesc>::Delete();
+}
+
+}  // namespace oneflow
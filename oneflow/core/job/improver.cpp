@@ -273,6 +273,21 @@ std::function<void(int64_t, uint64_t)> MakeSetterSetPlanRegstNum(Plan* plan) {
   };
 }
 
+std::function<const HashMap<int64_t, double>&(int64_t)> MakeGetterConsumerId2Value4RegstDescId(
+    const std::shared_ptr<HashMap<int64_t, HashMap<int64_t, double>>>&
+        regst_desc_id2consumer_id2value) {
+  auto empty = std::make_shared<const HashMap<int64_t, double>>();
+  return [regst_desc_id2consumer_id2value,
+          empty](int64_t regst_desc_id) -> const HashMap<int64_t, double>& {
+    const auto& it = regst_desc_id2consumer_id2value->find(regst_desc_id);
+    if (it == regst_desc_id2consumer_id2value->end()) {
+      return *empty;
+    } else {
+      return it->second;
+    }
+  };
+}
+
 std::function<const HashMap<int64_t, double>&(int64_t)> MakeGetterPathDurations4RegstDescId(
     const ChainActGraph& graph) {
   auto regst_desc_id2consumer_id2duration =
@@ -281,16 +296,7 @@ std::function<const HashMap<int64_t, double>&(int64_t)> MakeGetterPathDurations4
       [&](int64_t regst_desc_id, int64_t consumer_actor_id, double time) {
         (*regst_desc_id2consumer_id2duration)[regst_desc_id][consumer_actor_id] = time;
       });
-  auto empty = std::make_shared<const HashMap<int64_t, double>>();
-  return [regst_desc_id2consumer_id2duration,
-          empty](int64_t regst_desc_id) -> const HashMap<int64_t, double>& {
-    const auto& it = regst_desc_id2consumer_id2duration->find(regst_desc_id);
-    if (it == regst_desc_id2consumer_id2duration->end()) {
-      return *empty;
-    } else {
-      return it->second;
-    }
-  };
+  return MakeGetterConsumerId2Value4RegstDescId(regst_desc_id2consumer_id2duration);
 }
 
 std::function<const HashMap<int64_t, double>&(int64_t)> MakeGetterPathIIScales4RegstDescId(
@@ -301,16 +307,117 @@ std::function<const HashMap<int64_t, double>&(int64_t)> MakeGetterPathIIScales4R
       [&](int64_t regst_desc_id, int64_t consumer_actor_id, double ii_scale) {
         (*regst_desc_id2consumer_id2ii_scale)[regst_desc_id][consumer_actor_id] = ii_scale;
       });
-  auto empty = std::make_shared<const HashMap<int64_t, double>>();
-  return [regst_desc_id2consumer_id2ii_scale,
-          empty](int64_t regst_desc_id) -> const HashMap<int64_t, double>& {
-    const auto& it = regst_desc_id2consumer_id2ii_scale->find(regst_desc_id);
-    if (it == regst_desc_id2consumer_id2ii_scale->end()) {
-      return *empty;
-    } else {
-      return it->second;
+  return MakeGetterConsumerId2Value4RegstDescId(regst_desc_id2consumer_id2ii_scale);
+}
+
+// The cost model estimates the act time of a task in microseconds from the bytes its kernels read
+// and write, in place of the act events of an experiment run.
+constexpr double kCpuMemBytesPerUs = 1e4;
+constexpr double kGpuMemBytesPerUs = 3e5;
+constexpr double kCopyHdBytesPerUs = 8e3;
+constexpr double kCommNetBytesPerUs = 5e3;
+constexpr double kActOverheadUs = 2;
+constexpr double kKernelLaunchOverheadUs = 5;
+
+double EstimateActTime(const TaskProto& task,
+                       const std::function<size_t(int64_t)>& ByteSize4RegstDescId) {
+  size_t byte_size = 0;
+  for (const auto& pair : task.produced_regst_desc()) {
+    byte_size += ByteSize4RegstDescId(pair.second.regst_desc_id());
+  }
+  for (const auto& pair : task.consumed_regst_desc_id()) {
+    for (int64_t regst_desc_id : pair.second.regst_desc_id()) {
+      byte_size += ByteSize4RegstDescId(regst_desc_id);
+    }
+  }
+  double bytes_per_us = 0;
+  if (task.task_type() == TaskType::kCopyCommNet) {
+    bytes_per_us = kCommNetBytesPerUs;
+  } else if (task.task_type() == TaskType::kCopyHd) {
+    bytes_per_us = kCopyHdBytesPerUs;
+  } else if (Global<IDMgr>::Get()->GetDeviceTypeFromThrdId(task.thrd_id()) == DeviceType::kGPU) {
+    bytes_per_us = kGpuMemBytesPerUs;
+  } else {
+    bytes_per_us = kCpuMemBytesPerUs;
+  }
+  return kActOverheadUs + task.exec_sequence().exec_node_size() * kKernelLaunchOverheadUs
+         + byte_size / bytes_per_us;
+}
+
+}  // namespace
+
+void ForEachCostModelPathDuration(const Plan& plan,
+                                  const std::function<double(int64_t)>& ActTime4TaskId,
+                                  const std::function<void(int64_t, int64_t, double)>& Handler) {
+  HashMap<int64_t, int64_t> task_id2in_degree;
+  HashMap<int64_t, double> task_id2start_time;
+  HashMap<int64_t, double> task_id2finish_time;
+  for (const auto& task : plan.task()) {
+    task_id2in_degree.emplace(task.task_id(), 0);
+    task_id2start_time.emplace(task.task_id(), 0);
+  }
+  for (const auto& task : plan.task()) {
+    for (const auto& pair : task.produced_regst_desc()) {
+      for (int64_t consumer_task_id : pair.second.consumer_task_id()) {
+        task_id2in_degree.at(consumer_task_id) += 1;
+      }
+    }
+  }
+  HashMap<int64_t, const TaskProto*> task_id2task;
+  std::queue<const TaskProto*> ready_tasks;
+  for (const auto& task : plan.task()) {
+    task_id2task.emplace(task.task_id(), &task);
+    if (task_id2in_degree.at(task.task_id()) == 0) { ready_tasks.push(&task); }
+  }
+  auto Finish = [&](const TaskProto* task) {
+    const double finish_time =
+        task_id2start_time.at(task->task_id()) + ActTime4TaskId(task->task_id());
+    task_id2finish_time[task->task_id()] = finish_time;
+    for (const auto& pair : task->produced_regst_desc()) {
+      for (int64_t consumer_task_id : pair.second.consumer_task_id()) {
+        double* start_time = &task_id2start_time.at(consumer_task_id);
+        *start_time = std::max(*start_time, finish_time);
+        if (--task_id2in_degree.at(consumer_task_id) == 0) {
+          ready_tasks.push(task_id2task.at(consumer_task_id));
+        }
+      }
     }
   };
+  while (!ready_tasks.empty()) {
+    const TaskProto* task = ready_tasks.front();
+    ready_tasks.pop();
+    Finish(task);
+  }
+  // the tasks on a cycle start after the inputs from outside of it only
+  for (const auto& task : plan.task()) {
+    if (task_id2finish_time.find(task.task_id()) == task_id2finish_time.end()) {
+      task_id2finish_time[task.task_id()] =
+          task_id2start_time.at(task.task_id()) + ActTime4TaskId(task.task_id());
+    }
+  }
+  for (const auto& task : plan.task()) {
+    const double start_time = task_id2start_time.at(task.task_id());
+    for (const auto& pair : task.produced_regst_desc()) {
+      for (int64_t consumer_task_id : pair.second.consumer_task_id()) {
+        Handler(pair.second.regst_desc_id(), consumer_task_id,
+                task_id2finish_time.at(consumer_task_id) - start_time);
+      }
+    }
+  }
+}
+
+namespace {
+
+// the busiest stream bounds the ii
+double CalcCostModelBaseII(const Plan& plan, const std::function<double(int64_t)>& ActTime4TaskId) {
+  HashMap<int64_t, double> stream_id2total_act_time;
+  for (const auto& task : plan.task()) {
+    const int64_t stream_id = Global<IDMgr>::Get()->GlobalWorkStreamId4TaskId(task.task_id());
+    stream_id2total_act_time[stream_id] += ActTime4TaskId(task.task_id());
+  }
+  double base_ii = 0;
+  for (const auto& pair : stream_id2total_act_time) { base_ii = std::max(base_ii, pair.second); }
+  return base_ii;
 }
 
 void TryConnectWithMemSafeGuardCtrlRegstDesc(TaskProto* src_task_proto, TaskProto* dst_task_proto) {
@@ -567,20 +674,25 @@ Maybe<void> Improver::CheckAllZoneNotOOM(
       const auto& regst_descs = mz_regst_descs[machine_id][mem_zone_id];
       const uint64_t calc =
           CalcMemoryConsumed(regst_descs, PathDurations4RegstDescId, PathIIScales4RegstDescId, ii);
-      const uint64_t available = AvailableMemSize(machine_id, mem_zone_id);
-      if (calc >= available) {
-        const auto* id_mgr = Global<IDMgr>::Get();
-        const char* device_tag = JUST(DeviceTag4DeviceType(
-            id_mgr->IsGpuMemZone(mem_zone_id) ? DeviceType::kGPU : DeviceType::kCPU));
-        return Error::MemoryZoneOutOfMemoryError(machine_id, mem_zone_id, calc, available,
-                                                 device_tag)
-               << "OOM detected at compile time. ";
-      }
+      JUST(CheckMemZoneNotOOM(machine_id, mem_zone_id, calc));
     }
   }
   return Maybe<void>::Ok();
 }
 
+Maybe<void> Improver::CheckMemZoneNotOOM(int64_t machine_id, int64_t mem_zone_id,
+                                         uint64_t calc) const {
+  const uint64_t available = AvailableMemSize(machine_id, mem_zone_id);
+  if (calc >= available) {
+    const auto* id_mgr = Global<IDMgr>::Get();
+    const char* device_tag = JUST(DeviceTag4DeviceType(
+        id_mgr->IsGpuMemZone(mem_zone_id) ? DeviceType::kGPU : DeviceType::kCPU));
+    return Error::MemoryZoneOutOfMemoryError(machine_id, mem_zone_id, calc, available, device_tag)
+           << "OOM detected at compile time. ";
+  }
+  return Maybe<void>::Ok();
+}
+
 double Improver::CalcMaxRegstDescDuration(
     const std::function<const HashMap<int64_t, double>&(int64_t)>& PathDurations4RegstDescId,
     const MemZoneRegstDescs& mz_regst_descs) const {
@@ -652,6 +764,93 @@ Maybe<void> Improver::ForEachImprovedRegstNum(
   return Maybe<void>::Ok();
 }
 
+Maybe<double> Improver::GreedilyAllocateRegstNum(
+    const Plan& plan, double base_ii,
+    const std::function<const HashMap<int64_t, double>&(int64_t)>& PathDurations4RegstDescId,
+    const std::function<void(int64_t, uint64_t)>& Handler) const {
+  struct GrowableRegst {
+    const RegstDescProto* regst_desc;
+    std::pair<int64_t, int64_t> mem_zone;
+    uint64_t byte_size4one_regst;
+    double max_duration;
+    uint64_t regst_num;
+  };
+  auto MemSize = [](const GrowableRegst& regst, uint64_t regst_num) -> uint64_t {
+    return RoundUp(regst.byte_size4one_regst * regst_num, kCudaMemAllocAlignSize);
+  };
+  // the ii the regst num of a regst allows
+  auto II4Regst = [](const GrowableRegst& regst) -> double {
+    return regst.max_duration / regst.regst_num;
+  };
+  std::vector<GrowableRegst> growable_regsts;
+  std::map<std::pair<int64_t, int64_t>, uint64_t> mem_zone2used;
+  HashMap<int64_t, std::pair<std::pair<int64_t, int64_t>, uint64_t>> mem_block_id2zone7size;
+  for (const auto& task : plan.task()) {
+    for (const auto& pair : task.produced_regst_desc()) {
+      const RegstDescProto& regst_desc = pair.second;
+      const auto mem_zone =
+          std::make_pair(task.machine_id(), GetMemoryZoneId(regst_desc.mem_case()));
+      const RtRegstDesc rt_regst_desc(regst_desc);
+      if (regst_desc.mem_block_id() != -1) {
+        // the regsts sharing a mem block keep their regst num
+        auto* zone7size = &mem_block_id2zone7size[regst_desc.mem_block_id()];
+        zone7size->first = mem_zone;
+        zone7size->second =
+            std::max<uint64_t>(zone7size->second, rt_regst_desc.TotalMainByteSize4AllRegst()
+                                                      + regst_desc.mem_block_offset());
+      } else if (regst_desc.has_inplace_consumed_regst_desc_id()) {
+        mem_zone2used[mem_zone] +=
+            RoundUp(rt_regst_desc.TotalMainByteSize4AllRegst(), kCudaMemAllocAlignSize);
+      } else {
+        GrowableRegst regst{&regst_desc, mem_zone, rt_regst_desc.MainByteSize4OneRegst(), 0,
+                            static_cast<uint64_t>(std::max(
+                                1, std::min(regst_desc.min_register_num(),
+                                            regst_desc.max_register_num())))};
+        for (const auto& duration_pair : PathDurations4RegstDescId(regst_desc.regst_desc_id())) {
+          regst.max_duration = std::max(regst.max_duration, duration_pair.second);
+        }
+        mem_zone2used[mem_zone] += MemSize(regst, regst.regst_num);
+        growable_regsts.push_back(regst);
+      }
+    }
+  }
+  for (const auto& pair : mem_block_id2zone7size) {
+    mem_zone2used[pair.second.first] += RoundUp(pair.second.second, kCudaMemAllocAlignSize);
+  }
+  for (const auto& pair : mem_zone2used) {
+    JUST(CheckMemZoneNotOOM(pair.first.first, pair.first.second, pair.second));
+  }
+  // the regst bounding the ii gets one more regst until it is at its max register num or its
+  // zone is out of memory, no other regst num lowers the ii then
+  auto IILess = [&](int64_t lhs, int64_t rhs) {
+    return II4Regst(growable_regsts.at(lhs)) < II4Regst(growable_regsts.at(rhs));
+  };
+  std::priority_queue<int64_t, std::vector<int64_t>, decltype(IILess)> queue(IILess);
+  FOR_RANGE(int64_t, i, 0, growable_regsts.size()) { queue.push(i); }
+  double ii = base_ii;
+  while (!queue.empty()) {
+    GrowableRegst* regst = &growable_regsts.at(queue.top());
+    if (II4Regst(*regst) <= base_ii) { break; }
+    const uint64_t increased_mem_size =
+        MemSize(*regst, regst->regst_num + 1) - MemSize(*regst, regst->regst_num);
+    uint64_t* used = &mem_zone2used.at(regst->mem_zone);
+    if (regst->regst_num >= static_cast<uint64_t>(regst->regst_desc->max_register_num())
+        || *used + increased_mem_size
+               >= AvailableMemSize(regst->mem_zone.first, regst->mem_zone.second)) {
+      ii = II4Regst(*regst);
+      break;
+    }
+    queue.pop();
+    regst->regst_num += 1;
+    *used += increased_mem_size;
+    queue.push(regst - growable_regsts.data());
+  }
+  for (const GrowableRegst& regst : growable_regsts) {
+    Handler(regst.regst_desc->regst_desc_id(), regst.regst_num);
+  }
+  return ii;
+}
+
 void Improver::ForEachInferredMemBlockCriticalSection(
     const Plan& plan, const std::function<int64_t(int64_t)>& OrderInGraph4TaskId,
     const std::function<void(const std::vector<const RegstDescProto*>&)>& Handler) const {
@@ -725,6 +924,54 @@ Maybe<Plan> Improver::Improve(const AvailableMemDesc& amd, const Plan& naive_pla
   return plan;
 }
 
+Maybe<Plan> Improver::ImproveWithCostModel(const AvailableMemDesc& amd, const Plan& naive_plan) {
+  Init(amd, naive_plan);
+  HashMap<int64_t, size_t> regst_desc_id2byte_size;
+  for (const auto& task : naive_plan.task()) {
+    for (const auto& pair : task.produced_regst_desc()) {
+      regst_desc_id2byte_size.emplace(pair.second.regst_desc_id(),
+                                      RtRegstDesc(pair.second).MainByteSize4OneRegst());
+    }
+  }
+  auto ByteSize4RegstDescId = [&](int64_t regst_desc_id) -> size_t {
+    const auto it = regst_desc_id2byte_size.find(regst_desc_id);
+    return it == regst_desc_id2byte_size.end() ? 0 : it->second;
+  };
+  HashMap<int64_t, double> task_id2act_time;
+  for (const auto& task : naive_plan.task()) {
+    task_id2act_time.emplace(task.task_id(), EstimateActTime(task, ByteSize4RegstDescId));
+  }
+  auto ActTime4TaskId = [&](int64_t task_id) { return task_id2act_time.at(task_id); };
+  auto regst_desc_id2consumer_id2duration =
+      std::make_shared<HashMap<int64_t, HashMap<int64_t, double>>>();
+  auto regst_desc_id2consumer_id2ii_scale =
+      std::make_shared<HashMap<int64_t, HashMap<int64_t, double>>>();
+  ForEachCostModelPathDuration(
+      naive_plan, ActTime4TaskId,
+      [&](int64_t regst_desc_id, int64_t consumer_task_id, double duration) {
+        (*regst_desc_id2consumer_id2duration)[regst_desc_id][consumer_task_id] = duration;
+        (*regst_desc_id2consumer_id2ii_scale)[regst_desc_id][consumer_task_id] = 1;
+      });
+  auto PathDurations4RegstDescId =
+      MakeGetterConsumerId2Value4RegstDescId(regst_desc_id2consumer_id2duration);
+  auto PathIIScales4RegstDescId =
+      MakeGetterConsumerId2Value4RegstDescId(regst_desc_id2consumer_id2ii_scale);
+  const double base_ii = CalcCostModelBaseII(naive_plan, ActTime4TaskId);
+
+  Plan mem_unlimited_plan(naive_plan);
+  JUST(ForEachImprovedRegstNum(naive_plan, false, base_ii, PathDurations4RegstDescId,
+                               PathIIScales4RegstDescId,
+                               MakeSetterSetPlanRegstNum(&mem_unlimited_plan)));
+  Plan plan = GenAndInferMemBlockId(mem_unlimited_plan);
+  const double ii = JUST(GreedilyAllocateRegstNum(plan, base_ii, PathDurations4RegstDescId,
+                                                  MakeSetterSetPlanRegstNum(&plan)));
+  LOG(INFO) << "cost model base ii: " << base_ii << "us, predicted ii: " << ii << "us";
+  FixReliantCtrlRegstNum(plan, MakeGetterGetPlanRegstNum(&plan), MakeSetterSetPlanRegstNum(&plan));
+  SetUniqueMemBlockId4UnreusedMemRegst(&plan);
+  GenMemBlockAndChunk4Plan(&plan);
+  return plan;
+}
+
 Plan Improver::GenAndInferMemBlockId(const Plan& naive_plan) const {
   Plan plan(naive_plan);
   PlanTaskGraph plan_task_graph(naive_plan);
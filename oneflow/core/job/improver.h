@@ -24,6 +24,13 @@ limitations under the License.
 
 namespace oneflow {
 
+// The path duration of a regst to a consumer is the time from the producer starting to act to the
+// consumer finishing, all the tasks acting as early as their inputs allow. The tasks on a cycle
+// start after the inputs from outside of it only.
+void ForEachCostModelPathDuration(const Plan& plan,
+                                  const std::function<double(int64_t)>& ActTime4TaskId,
+                                  const std::function<void(int64_t, int64_t, double)>& Handler);
+
 class Improver final {
  public:
   OF_DISALLOW_COPY_AND_MOVE(Improver);
@@ -33,10 +40,20 @@ class Improver final {
   Maybe<Plan> Improve(const AvailableMemDesc& amd, const Plan& naive_plan,
                       const std::string& act_event_filepath);
   Maybe<Plan> GenAndInferMemBlockIdOnly(const AvailableMemDesc& amd, const Plan& naive_plan);
+  // Improves without an experiment run, the act time of each task estimated from the bytes it
+  // reads and writes, and the register nums allocated greedily within the memory of the zones
+  Maybe<Plan> ImproveWithCostModel(const AvailableMemDesc& amd, const Plan& naive_plan);
+
+  // the memory of the zones the plan is improved within, set by every Improve* method first
+  void Init(const AvailableMemDesc& amd, const Plan& naive_plan);
+  // sets the register nums of the regsts not sharing mem blocks and returns the ii they allow
+  Maybe<double> GreedilyAllocateRegstNum(
+      const Plan& plan, double base_ii,
+      const std::function<const HashMap<int64_t, double>&(int64_t)>& PathDurations4RegstDescId,
+      const std::function<void(int64_t, uint64_t)>& Handler) const;
 
  private:
   Plan GenAndInferMemBlockId(const Plan& naive_plan) const;
-  void Init(const AvailableMemDesc& amd, const Plan& naive_plan);
   Maybe<void> ForEachImprovedRegstNum(
       const Plan& plan, bool is_memory_limited, double ii,
       const std::function<const HashMap<int64_t, double>&(int64_t)>& PathDurations4RegstDescId,
@@ -53,6 +70,7 @@ class Improver final {
       const std::function<const HashMap<int64_t, double>&(int64_t)>& Duration4RegstDescId,
       const std::function<const HashMap<int64_t, double>&(int64_t)>& Ratio4RegstDescId,
       double ii) const;
+  Maybe<void> CheckMemZoneNotOOM(int64_t machine_id, int64_t mem_zone_id, uint64_t calc) const;
   Maybe<double> BinarySearchII(
       double base_ii,
       const std::function<const HashMap<int64_t, double>&(int64_t)>& Duration4RegstDescId,
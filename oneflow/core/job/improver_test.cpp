@@ -0,0 +1,218 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include "oneflow/core/job/improver.h"
+#include "oneflow/core/job/env_desc.h"
+#include "oneflow/core/job/global_for.h"
+#include "oneflow/core/job/id_manager.h"
+#include "oneflow/core/job/resource_desc.h"
+#include "oneflow/core/register/blob_desc.h"
+#include "oneflow/core/register/runtime_register_desc.h"
+
+namespace oneflow {
+
+namespace {
+
+EnvProto GetEnvProto() {
+  EnvProto ret;
+  auto* machine = ret.add_machine();
+  machine->set_id(0);
+  machine->set_addr("192.168.1.0");
+  ret.set_ctrl_port(9527);
+  return ret;
+}
+
+// a single host memory zone, all of which is available
+Resource GetResource() {
+  Resource ret;
+  ret.set_machine_num(1);
+  ret.set_gpu_device_num(0);
+  ret.set_cpu_device_num(1);
+  ret.set_comm_net_worker_num(1);
+  ret.set_reserved_host_mem_mbyte(0);
+  return ret;
+}
+
+AvailableMemDesc GetAvailableMemDesc(uint64_t zone_size) {
+  AvailableMemDesc ret;
+  ret.add_machine_amd()->add_zone_size(zone_size);
+  return ret;
+}
+
+void New() {
+  Global<EnvDesc>::New(GetEnvProto());
+  Global<ResourceDesc, ForSession>::New(GetResource());
+  Global<IDMgr>::New();
+}
+
+void Delete() {
+  Global<IDMgr>::Delete();
+  Global<ResourceDesc, ForSession>::Delete();
+  Global<EnvDesc>::Delete();
+}
+
+TaskProto* AddTask(int64_t task_id, Plan* plan) {
+  TaskProto* task = plan->add_task();
+  task->set_machine_id(0);
+  task->set_thrd_id(Global<IDMgr>::Get()->GetCpuDeviceThrdId(0));
+  task->set_task_id(task_id);
+  return task;
+}
+
+// a host regst of a 64K floats blob from producer to consumer, not sharing a mem block
+RegstDescProto* AddRegst(int64_t regst_desc_id, TaskProto* producer, int64_t consumer_task_id,
+                         int32_t max_register_num) {
+  RegstDescProto* regst_desc =
+      &(*producer->mutable_produced_regst_desc())["out_" + std::to_string(regst_desc_id)];
+  regst_desc->set_regst_desc_id(regst_desc_id);
+  regst_desc->set_producer_task_id(producer->task_id());
+  regst_desc->add_consumer_task_id(consumer_task_id);
+  regst_desc->set_min_register_num(1);
+  regst_desc->set_max_register_num(max_register_num);
+  regst_desc->set_register_num(1);
+  regst_desc->mutable_mem_case()->mutable_host_mem();
+  DataRegstDesc* data_regst_desc = regst_desc->mutable_regst_desc_type()->mutable_data_regst_desc();
+  BlobDesc(Shape({64 * 1024}), DataType::kFloat)
+      .ToProto(data_regst_desc->mutable_packed_blob_desc());
+  data_regst_desc->mutable_time_shape()->add_dim(1);
+  regst_desc->set_enable_reuse_mem(false);
+  regst_desc->set_mem_block_id(-1);
+  regst_desc->set_mem_block_offset(-1);
+  return regst_desc;
+}
+
+HashMap<std::pair<int64_t, int64_t>, double> PathDurations(
+    const Plan& plan, const HashMap<int64_t, double>& task_id2act_time) {
+  HashMap<std::pair<int64_t, int64_t>, double> regst7consumer2duration;
+  ForEachCostModelPathDuration(
+      plan, [&](int64_t task_id) { return task_id2act_time.at(task_id); },
+      [&](int64_t regst_desc_id, int64_t consumer_task_id, double duration) {
+        const auto regst7consumer = std::make_pair(regst_desc_id, consumer_task_id);
+        CHECK(regst7consumer2duration.emplace(regst7consumer, duration).second);
+      });
+  return regst7consumer2duration;
+}
+
+// tasks 0 -> 1 -> 2 with regsts 0 and 1
+Plan GetChainPlan(int32_t max_register_num0, int32_t max_register_num1) {
+  Plan plan;
+  TaskProto* task0 = AddTask(0, &plan);
+  TaskProto* task1 = AddTask(1, &plan);
+  AddTask(2, &plan);
+  AddRegst(0, task0, 1, max_register_num0);
+  AddRegst(1, task1, 2, max_register_num1);
+  return plan;
+}
+
+struct GreedyResult {
+  double ii;
+  HashMap<int64_t, uint64_t> regst_desc_id2regst_num;
+};
+
+// regst 0 spans 6us and regst 1 5us, the base ii is 1us
+GreedyResult GreedilyAllocate(const Plan& plan, uint64_t zone_size) {
+  HashMap<int64_t, HashMap<int64_t, double>> regst_desc_id2durations{{0, {{1, 6}}}, {1, {{2, 5}}}};
+  Improver improver;
+  improver.Init(GetAvailableMemDesc(zone_size), plan);
+  GreedyResult result;
+  result.ii =
+      CHECK_JUST(improver.GreedilyAllocateRegstNum(
+          plan, 1,
+          [&](int64_t regst_desc_id) -> const HashMap<int64_t, double>& {
+            return regst_desc_id2durations.at(regst_desc_id);
+          },
+          [&](int64_t regst_desc_id, uint64_t regst_num) {
+            CHECK(result.regst_desc_id2regst_num.emplace(regst_desc_id, regst_num).second);
+          }));
+  return result;
+}
+
+uint64_t MemSize(const Plan& plan, uint64_t regst_num) {
+  const RtRegstDesc rt_regst_desc(plan.task(0).produced_regst_desc().at("out_0"));
+  return RoundUp(rt_regst_desc.MainByteSize4OneRegst() * regst_num, kCudaMemAllocAlignSize);
+}
+
+}  // namespace
+
+TEST(Improver, cost_model_path_duration_of_chain) {
+  New();
+  const Plan plan = GetChainPlan(8, 8);
+  // task 0 acts in [0, 1), task 1 in [1, 5) and task 2 in [5, 6)
+  const auto durations = PathDurations(plan, {{0, 1}, {1, 4}, {2, 1}});
+  ASSERT_EQ(durations.size(), 2);
+  ASSERT_DOUBLE_EQ(durations.at(std::make_pair(0, 1)), 5);
+  ASSERT_DOUBLE_EQ(durations.at(std::make_pair(1, 2)), 5);
+  Delete();
+}
+
+TEST(Improver, cost_model_path_duration_of_diamond) {
+  New();
+  Plan plan;
+  TaskProto* task0 = AddTask(0, &plan);
+  TaskProto* task1 = AddTask(1, &plan);
+  TaskProto* task2 = AddTask(2, &plan);
+  AddTask(3, &plan);
+  AddRegst(0, task0, 1, 8);
+  AddRegst(1, task0, 2, 8);
+  AddRegst(2, task1, 3, 8);
+  AddRegst(3, task2, 3, 8);
+  // task 3 waits for the slower branch, task 1 finishing at 5
+  const auto durations = PathDurations(plan, {{0, 1}, {1, 4}, {2, 2}, {3, 1}});
+  ASSERT_EQ(durations.size(), 4);
+  ASSERT_DOUBLE_EQ(durations.at(std::make_pair(0, 1)), 5);
+  ASSERT_DOUBLE_EQ(durations.at(std::make_pair(1, 2)), 3);
+  ASSERT_DOUBLE_EQ(durations.at(std::make_pair(2, 3)), 5);
+  ASSERT_DOUBLE_EQ(durations.at(std::make_pair(3, 3)), 5);
+  Delete();
+}
+
+TEST(Improver, greedily_allocate_regst_num_in_unbounded_zone) {
+  New();
+  // enough regsts for both paths to reach the base ii
+  const GreedyResult unbounded = GreedilyAllocate(GetChainPlan(8, 8), 1LL << 40);
+  ASSERT_DOUBLE_EQ(unbounded.ii, 1);
+  ASSERT_EQ(unbounded.regst_desc_id2regst_num.at(0), 6);
+  ASSERT_EQ(unbounded.regst_desc_id2regst_num.at(1), 5);
+  // regst 1 at its max register num bounds the ii once regst 0 allows a lower one
+  const GreedyResult max_bounded = GreedilyAllocate(GetChainPlan(8, 2), 1LL << 40);
+  ASSERT_DOUBLE_EQ(max_bounded.ii, 2.5);
+  ASSERT_EQ(max_bounded.regst_desc_id2regst_num.at(0), 3);
+  ASSERT_EQ(max_bounded.regst_desc_id2regst_num.at(1), 2);
+  Delete();
+}
+
+TEST(Improver, greedily_allocate_regst_num_in_memory_bound_zone) {
+  New();
+  const Plan plan = GetChainPlan(8, 8);
+  // room for two regsts each, but not for a third one of regst 0
+  const uint64_t zone_size = 2 * MemSize(plan, 2) + MemSize(plan, 3) - MemSize(plan, 2);
+  const GreedyResult bounded = GreedilyAllocate(plan, zone_size);
+  ASSERT_DOUBLE_EQ(bounded.ii, 3);
+  ASSERT_EQ(bounded.regst_desc_id2regst_num.at(0), 2);
+  ASSERT_EQ(bounded.regst_desc_id2regst_num.at(1), 2);
+  // not even one regst each fits
+  Improver improver;
+  improver.Init(GetAvailableMemDesc(MemSize(plan, 1)), plan);
+  HashMap<int64_t, double> durations{{1, 1}};
+  ASSERT_FALSE(improver
+                   .GreedilyAllocateRegstNum(
+                       plan, 1,
+                       [&](int64_t) -> const HashMap<int64_t, double>& { return durations; },
+                       [](int64_t, uint64_t) {})
+                   .IsOk());
+  Delete();
+}
+
+}  // namespace oneflow
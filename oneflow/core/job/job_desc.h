@@ -55,6 +55,9 @@ class JobDesc final {
     return job_conf_.enable_float_compute_for_half_gemm();
   }
   bool enable_auto_mixed_precision() const { return job_conf_.enable_auto_mixed_precision(); }
+  bool enable_auto_mixed_precision_on_cpu() const {
+    return job_conf_.enable_auto_mixed_precision_on_cpu();
+  }
   bool do_parallel_cast_before_widening_type_cast() const {
     return job_conf_.do_parallel_cast_before_widening_type_cast();
   };
@@ -63,6 +66,14 @@ class JobDesc final {
   }
   bool prune_parallel_cast_ops() const { return job_conf_.prune_parallel_cast_ops(); }
   bool prune_cast_to_static_shape_ops() const { return job_conf_.prune_cast_to_static_shape_ops(); }
+  bool fuse_conv_bn_for_inference() const { return job_conf_.fuse_conv_bn_for_inference(); }
+  bool int8_quantization_for_inference() const {
+    return job_conf_.int8_quantization_for_inference();
+  }
+  bool int8_quantization_calibration() const { return job_conf_.int8_quantization_calibration(); }
+  bool int8_quantization_static_scale() const {
+    return job_conf_.int8_quantization_static_scale();
+  }
   int64_t cudnn_buf_limit_mbyte() const { return job_conf_.cudnn_buf_limit_mbyte(); }
 
   bool enable_keep_header_only() const { return job_conf_.enable_keep_header_only(); }
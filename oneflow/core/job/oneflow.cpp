@@ -24,7 +24,7 @@ limitations under the License.
 #include "oneflow/core/job/job_set.pb.h"
 #include "oneflow/core/job/machine_context.h"
 #include "oneflow/core/job/profiler.h"
-#include "oneflow/core/job/sub_plan.pb.h"
+#include "oneflow/core/job/plan_bundle.h"
 #include "oneflow/core/job/plan.pb.h"
 #include "oneflow/core/job/available_memory_desc.pb.h"
 #include "oneflow/core/persistence/tee_persistent_log_stream.h"
@@ -34,10 +34,12 @@ limitations under the License.
 #include "oneflow/core/job/model_io_job.h"
 #include "oneflow/core/job/inter_job_mem_sharing_util.h"
 #include "oneflow/core/job/plan_util.h"
+#include "oneflow/core/job/plan_cache.h"
 #include "oneflow/core/operator/interface_op_util.h"
 #include "oneflow/core/job/critical_section_desc.h"
 #include "oneflow/core/job/global_for.h"
 #include "oneflow/core/vm/oneflow_vm.h"
+#include "oneflow/core/thread/thread_manager.h"
 #include "oneflow/core/graph/plan_task_graph.h"
 #include "oneflow/core/graph/boxing/collective_boxing_util.h"
 
@@ -63,96 +65,146 @@ bool operator==(const ParallelBlobConf& lhs, const ParallelBlobConf& rhs) {
 
 namespace {
 
-std::string cluster_thrd_ids_key(const std::string& plan_name) {
-  return plan_name + "_cluster_thrd_ids";
+std::string plan_bundle_meta_key(const std::string& plan_name, const std::string& bundle_name) {
+  return plan_name + "_bundle_" + bundle_name + "_meta";
 }
 
-std::string net_topo_key(const std::string& plan_name) { return plan_name + "_net_topo"; }
-
-std::string job_id2job_conf(const std::string& plan_name) { return plan_name + "_job_id2job_conf"; }
-
-std::string GetCollectiveBoxingPlanKey(const std::string& plan_name) {
-  return plan_name + "_collective_boxing_plan";
-}
-
-std::string sub_plan_key(const std::string& plan_name, int64_t machine_id, int64_t thrd_id) {
-  return plan_name + "_" + std::to_string(machine_id) + "_" + std::to_string(thrd_id);
+std::string plan_bundle_chunk_key(const std::string& plan_name, const std::string& bundle_name,
+                                  int64_t chunk_id) {
+  return plan_name + "_bundle_" + bundle_name + "_" + std::to_string(chunk_id);
 }
 
-std::string block7chunk_key(const std::string& plan_name, int64_t machine_id) {
-  return plan_name + "_" + std::to_string(machine_id) + "_block7chunk";
-}
+// the net topo, job confs and collective boxing plan every machine needs
+const std::string kCommonPlanBundleName = "common";
 
-void PushPlan(const std::string& plan_name, const Plan& plan) {
-  HashMap<int64_t, std::set<int64_t>> machine_id2thrd_id_set;
-  HashMap<std::pair<int64_t, int64_t>, std::vector<TaskProto>> mchn_thrd_id2task_protos;
-  HashMap<int64_t, MemBlockAndChunkList> machine_id2block7chunk;
+std::string machine_plan_bundle_name(int64_t machine_id) { return std::to_string(machine_id); }
 
-  for (const auto& task : plan.task()) {
-    machine_id2thrd_id_set[task.machine_id()].insert(task.thrd_id());
-    mchn_thrd_id2task_protos[std::make_pair(task.machine_id(), task.thrd_id())].emplace_back(task);
+void PushPlanBundle(const std::string& plan_name, const std::string& bundle_name,
+                    const PlanBundleMeta& meta, const std::string& compressed) {
+  const int64_t this_machine_id = Global<MachineCtx>::Get()->this_machine_id();
+  CtrlClient* ctrl_client = Global<CtrlClient>::Get();
+  ctrl_client->PushMachineKV(this_machine_id, plan_bundle_meta_key(plan_name, bundle_name),
+                             meta.SerializeAsString());
+  FOR_RANGE(int64_t, i, 0, meta.chunk_num()) {
+    ctrl_client->PushMachineKV(this_machine_id, plan_bundle_chunk_key(plan_name, bundle_name, i),
+                               PlanBundleChunk(meta, compressed, i));
   }
+}
 
-  HashMap<int64_t, ThrdIds> machine_id2thrd_ids;
-  for (const auto& pair : machine_id2thrd_id_set) {
-    CHECK(machine_id2thrd_ids.emplace(pair.first, ThrdIds()).second);
-    std::vector<int64_t> thrd_id_vec(pair.second.begin(), pair.second.end());
-    *(machine_id2thrd_ids.at(pair.first).mutable_thrd_id()) = StdVec2PbRf(thrd_id_vec);
+// pulls a bundle chunk by chunk from the parent machine, relaying every chunk to the children
+// as soon as it arrives if relay, and decompressing it into plan if not nullptr. Returns the
+// number of chunks.
+int64_t PullPlanBundle(const std::string& plan_name, const std::string& bundle_name, bool relay,
+                       Plan* plan) {
+  const int64_t this_machine_id = Global<MachineCtx>::Get()->this_machine_id();
+  const int64_t parent = PlanDistributionParent(this_machine_id);
+  CtrlClient* ctrl_client = Global<CtrlClient>::Get();
+  std::string serialized_meta;
+  ctrl_client->PullMachineKV(parent, plan_bundle_meta_key(plan_name, bundle_name),
+                             &serialized_meta);
+  PlanBundleMeta meta;
+  CHECK(meta.ParseFromString(serialized_meta));
+  if (relay) {
+    ctrl_client->PushMachineKV(this_machine_id, plan_bundle_meta_key(plan_name, bundle_name),
+                               serialized_meta);
   }
+  std::unique_ptr<PlanBundleInflater> inflater;
+  if (plan != nullptr) { inflater.reset(new PlanBundleInflater(meta)); }
+  FOR_RANGE(int64_t, i, 0, meta.chunk_num()) {
+    const std::string chunk_key = plan_bundle_chunk_key(plan_name, bundle_name, i);
+    std::string chunk;
+    ctrl_client->PullMachineKV(parent, chunk_key, &chunk);
+    if (relay) { ctrl_client->PushMachineKV(this_machine_id, chunk_key, chunk); }
+    if (inflater) { inflater->Feed(chunk); }
+  }
+  if (inflater) { inflater->ParseTo(plan); }
+  return meta.chunk_num();
+}
 
-  ClusterThrdIds cluster_thrd_ids;
-  *(cluster_thrd_ids.mutable_machine_id2thrd_ids()) = HashMap2PbMap(machine_id2thrd_ids);
-  Global<CtrlClient>::Get()->PushKV(cluster_thrd_ids_key(plan_name), cluster_thrd_ids);
-
-  for (const auto& pair : mchn_thrd_id2task_protos) {
-    SubPlan sub_plan;
-    *(sub_plan.mutable_task()) = StdVec2PbRpf(pair.second);
-    Global<CtrlClient>::Get()->PushKV(sub_plan_key(plan_name, pair.first.first, pair.first.second),
-                                      sub_plan);
+// every machine has pulled the bundles once all have reached the barrier
+void ClearPushedPlanBundles(const std::string& plan_name,
+                            const HashMap<std::string, int64_t>& bundle_name2chunk_num) {
+  OF_BARRIER();
+  const int64_t this_machine_id = Global<MachineCtx>::Get()->this_machine_id();
+  CtrlClient* ctrl_client = Global<CtrlClient>::Get();
+  for (const auto& pair : bundle_name2chunk_num) {
+    FOR_RANGE(int64_t, i, 0, pair.second) {
+      ctrl_client->ClearMachineKV(this_machine_id, plan_bundle_chunk_key(plan_name, pair.first, i));
+    }
+    ctrl_client->ClearMachineKV(this_machine_id, plan_bundle_meta_key(plan_name, pair.first));
   }
+}
 
+// Every machine gets one compressed bundle of its own tasks and memory blocks and one of the
+// parts of the plan common to all, pulled in chunks along a tree rooted at the master, so that
+// the master serves kPlanDistributionFanOut machines only. The master still holds the compressed
+// bundles of all the machines, and a relay those of its subtree, until the barrier after the
+// distribution.
+void PushPlan(const std::string& plan_name, const Plan& plan) {
+  const int64_t machine_num = Global<ResourceDesc, ForSession>::Get()->TotalMachineNum();
+  if (machine_num == 1) { return; }
+  // the master keeps the whole plan, the last one is the common bundle
+  std::vector<Plan> bundle_plans(machine_num + 1);
+  for (const auto& task : plan.task()) { *bundle_plans.at(task.machine_id()).add_task() = task; }
   for (const auto& mem_block : plan.block_chunk_list().mem_block()) {
-    *machine_id2block7chunk[mem_block.machine_id()].add_mem_block() = mem_block;
+    *bundle_plans.at(mem_block.machine_id()).mutable_block_chunk_list()->add_mem_block() =
+        mem_block;
   }
   for (const auto& chunk : plan.block_chunk_list().chunk()) {
-    *machine_id2block7chunk[chunk.machine_id()].add_chunk() = chunk;
+    *bundle_plans.at(chunk.machine_id()).mutable_block_chunk_list()->add_chunk() = chunk;
   }
-  for (const auto& pair : machine_id2block7chunk) {
-    Global<CtrlClient>::Get()->PushKV(block7chunk_key(plan_name, pair.first), pair.second);
+  Plan* common_plan = &bundle_plans.at(machine_num);
+  *common_plan->mutable_net_topo() = plan.net_topo();
+  *common_plan->mutable_job_confs() = plan.job_confs();
+  *common_plan->mutable_collective_boxing_plan() = plan.collective_boxing_plan();
+  std::vector<std::string> bundle_names(machine_num + 1);
+  FOR_RANGE(int64_t, i, 1, machine_num) { bundle_names.at(i) = machine_plan_bundle_name(i); }
+  bundle_names.at(machine_num) = kCommonPlanBundleName;
+  std::vector<PlanBundleMeta> metas(machine_num + 1);
+  std::vector<std::string> compressed(machine_num + 1);
+  MultiThreadLoopInRange(machine_num, 1, [&](int64_t begin, int64_t end) {
+    FOR_RANGE(int64_t, i, begin + 1, end + 1) {
+      CompressPlan(bundle_plans.at(i), kPlanBundleChunkSize, &metas.at(i), &compressed.at(i));
+      Plan().Swap(&bundle_plans.at(i));
+    }
+  });
+  HashMap<std::string, int64_t> bundle_name2chunk_num;
+  int64_t raw_size = 0;
+  int64_t compressed_size = 0;
+  FOR_RANGE(int64_t, i, 1, machine_num + 1) {
+    PushPlanBundle(plan_name, bundle_names.at(i), metas.at(i), compressed.at(i));
+    bundle_name2chunk_num.emplace(bundle_names.at(i), metas.at(i).chunk_num());
+    raw_size += metas.at(i).raw_size();
+    compressed_size += compressed.at(i).size();
+    std::string().swap(compressed.at(i));
   }
-
-  Global<CtrlClient>::Get()->PushKV(net_topo_key(plan_name), plan.net_topo());
-  Global<CtrlClient>::Get()->PushKV(job_id2job_conf(plan_name), plan.job_confs());
-  Global<CtrlClient>::Get()->PushKV(GetCollectiveBoxingPlanKey(plan_name),
-                                    plan.collective_boxing_plan());
+  LOG(INFO) << plan_name << " bundles of " << raw_size << " bytes compressed to "
+            << compressed_size << " bytes";
+  ClearPushedPlanBundles(plan_name, bundle_name2chunk_num);
 }
 
 void PullPlan(const std::string& plan_name, Plan* plan) {
-  ClusterThrdIds cluster_thrd_ids;
-  Global<CtrlClient>::Get()->PullKV(cluster_thrd_ids_key(plan_name), &cluster_thrd_ids);
-  PrintProtoToTextFile(cluster_thrd_ids, JoinPath(FLAGS_log_dir, cluster_thrd_ids_key(plan_name)));
-  HashMap<int64_t, ThrdIds> machine_id2thrd_ids;
-  machine_id2thrd_ids = PbMap2HashMap(cluster_thrd_ids.machine_id2thrd_ids());
-  int64_t machine_id = Global<MachineCtx>::Get()->this_machine_id();
-  auto thrd_ids_it = machine_id2thrd_ids.find(machine_id);
-  CHECK(thrd_ids_it != machine_id2thrd_ids.end());
-  std::vector<int64_t> thrd_id_vec = PbRf2StdVec(thrd_ids_it->second.thrd_id());
-  for (auto thrd_id : thrd_id_vec) {
-    SubPlan sub_plan;
-    Global<CtrlClient>::Get()->PullKV(sub_plan_key(plan_name, machine_id, thrd_id), &sub_plan);
-    plan->mutable_task()->MergeFrom(sub_plan.task());
-  }
-  NetTopo net_topo;
-  Global<CtrlClient>::Get()->PullKV(net_topo_key(plan_name), &net_topo);
-  *(plan->mutable_net_topo()) = net_topo;
-  JobConfs job_confs;
-  Global<CtrlClient>::Get()->PullKV(job_id2job_conf(plan_name), &job_confs);
-  *(plan->mutable_job_confs()) = job_confs;
-  Global<CtrlClient>::Get()->PullKV(GetCollectiveBoxingPlanKey(plan_name),
-                                    plan->mutable_collective_boxing_plan());
-  MemBlockAndChunkList block7chunk;
-  Global<CtrlClient>::Get()->PullKV(block7chunk_key(plan_name, machine_id), &block7chunk);
-  plan->mutable_block_chunk_list()->CopyFrom(block7chunk);
+  const int64_t machine_id = Global<MachineCtx>::Get()->this_machine_id();
+  const std::vector<int64_t> descendants = PlanDistributionDescendants(
+      machine_id, Global<ResourceDesc, ForSession>::Get()->TotalMachineNum());
+  const bool relay = !descendants.empty();
+  HashMap<std::string, int64_t> relayed_bundle_name2chunk_num;
+  Plan common_plan;
+  const int64_t common_chunk_num =
+      PullPlanBundle(plan_name, kCommonPlanBundleName, relay, &common_plan);
+  if (relay) { relayed_bundle_name2chunk_num.emplace(kCommonPlanBundleName, common_chunk_num); }
+  PullPlanBundle(plan_name, machine_plan_bundle_name(machine_id), false, plan);
+  CHECK_GT(plan->task_size(), 0);
+  for (int64_t descendant : descendants) {
+    const std::string bundle_name = machine_plan_bundle_name(descendant);
+    relayed_bundle_name2chunk_num.emplace(
+        bundle_name, PullPlanBundle(plan_name, bundle_name, true, nullptr));
+  }
+  plan->mutable_block_chunk_list();
+  plan->mutable_net_topo()->Swap(common_plan.mutable_net_topo());
+  plan->mutable_job_confs()->Swap(common_plan.mutable_job_confs());
+  plan->mutable_collective_boxing_plan()->Swap(common_plan.mutable_collective_boxing_plan());
+  ClearPushedPlanBundles(plan_name, relayed_bundle_name2chunk_num);
 }
 
 bool IsCollectiveBoxingNode(const PlanTaskNode* node) {
@@ -284,6 +336,11 @@ void GenCollectiveBoxingPlan(Job* job, Plan* plan) {
   }
 }
 
+REGISTER_FUNCTION_CONFIG_DEF().Bool(
+    "enable_cost_model_improver", false,
+    "improve register nums with a static cost model instead of the plan of all register nums 1, "
+    "ignored with experiment run");
+
 Maybe<void> CompileCurJobOnMaster(Job* job, Plan* improved_plan, bool need_job_complete) {
   const JobDesc& job_desc = GlobalJobDesc();
   Plan naive_plan;
@@ -292,8 +349,13 @@ Maybe<void> CompileCurJobOnMaster(Job* job, Plan* improved_plan, bool need_job_c
   if (Global<MachineCtx>::Get()->IsThisMachineMaster()) {
     Compiler().Compile(job, &naive_plan, need_job_complete);
     LOG(INFO) << "compile time: " << GetCurTime() - start;
-    complete_plan =
-        *JUST(Improver().GenAndInferMemBlockIdOnly(*Global<AvailableMemDesc>::Get(), naive_plan));
+    if (job_desc.Bool("enable_cost_model_improver") && !job_desc.enable_experiment_run()) {
+      complete_plan =
+          *JUST(Improver().ImproveWithCostModel(*Global<AvailableMemDesc>::Get(), naive_plan));
+    } else {
+      complete_plan =
+          *JUST(Improver().GenAndInferMemBlockIdOnly(*Global<AvailableMemDesc>::Get(), naive_plan));
+    }
     if (Global<ResourceDesc, ForSession>::Get()->enable_debug_mode()) {
       TeePersistentLogStream::Create("naive_plan")->Write(naive_plan);
       TeePersistentLogStream::Create("complete_plan")->Write(complete_plan);
@@ -886,6 +948,15 @@ void MakePushJob(const std::string& job_name, const std::string& op_name,
 REGISTER_FUNCTION_CONFIG_DEF().Bool("__is_user_function__", true, "is user defined function");
 
 Maybe<void> CompileAndMergePlanOnMaster(const PbRpf<Job>& conf_jobs, Plan* plan) {
+  std::string plan_cache_fingerprint;
+  if (Global<MachineCtx>::Get()->IsThisMachineMaster() && IsPlanCacheEnabled(conf_jobs)) {
+    plan_cache_fingerprint = PlanCacheFingerprint(conf_jobs);
+    if (JUST(TryLoadCachedPlan(plan_cache_fingerprint, plan))) {
+      PushPlan("merged_plan", *plan);
+      OF_BARRIER();
+      return Maybe<void>::Ok();
+    }
+  }
   std::vector<std::shared_ptr<Job>> jobs(conf_jobs.size());
   FOR_RANGE(int, i, 0, jobs.size()) { jobs.at(i).reset(new Job(conf_jobs.Get(i))); }
   if (jobs.size() > 1) { CheckNonDistributeOptimizerAvailable(jobs); }
@@ -956,6 +1027,7 @@ Maybe<void> CompileAndMergePlanOnMaster(const PbRpf<Job>& conf_jobs, Plan* plan)
       TeePersistentLogStream::Create("merged_plan")->Write(*plan);
       PlanUtil::ToDotFile(*plan, "/dot/merged_plan.dot");
     }
+    if (!plan_cache_fingerprint.empty()) { JUST(StorePlanToCache(plan_cache_fingerprint, *plan)); }
     PushPlan("merged_plan", *plan);
   } else {
     PullPlan("merged_plan", plan);
@@ -0,0 +1,88 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include "oneflow/core/job/plan_bundle.h"
+
+namespace oneflow {
+
+int64_t PlanDistributionParent(int64_t machine_id) {
+  CHECK_GT(machine_id, 0);
+  return (machine_id - 1) / kPlanDistributionFanOut;
+}
+
+std::vector<int64_t> PlanDistributionDescendants(int64_t machine_id, int64_t machine_num) {
+  std::vector<int64_t> descendants;
+  std::vector<int64_t> parents{machine_id};
+  while (!parents.empty()) {
+    std::vector<int64_t> children;
+    for (int64_t parent : parents) {
+      FOR_RANGE(int64_t, i, 1, kPlanDistributionFanOut + 1) {
+        const int64_t child = parent * kPlanDistributionFanOut + i;
+        if (child < machine_num) { children.push_back(child); }
+      }
+    }
+    descendants.insert(descendants.end(), children.begin(), children.end());
+    parents.swap(children);
+  }
+  return descendants;
+}
+
+void CompressPlan(const Plan& plan, int64_t chunk_size, PlanBundleMeta* meta,
+                  std::string* compressed) {
+  CHECK_GT(chunk_size, 0);
+  std::string raw;
+  // partial, the bundles hold only some of the required fields of a plan
+  CHECK(plan.SerializePartialToString(&raw));
+  uLongf compressed_size = compressBound(raw.size());
+  compressed->resize(compressed_size);
+  CHECK_EQ(compress2(reinterpret_cast<Bytef*>(&compressed->at(0)), &compressed_size,
+                     reinterpret_cast<const Bytef*>(raw.data()), raw.size(), Z_BEST_SPEED),
+           Z_OK);
+  compressed->resize(compressed_size);
+  meta->set_raw_size(raw.size());
+  meta->set_chunk_num(RoundUp(compressed_size, chunk_size) / chunk_size);
+  meta->set_chunk_size(chunk_size);
+}
+
+std::string PlanBundleChunk(const PlanBundleMeta& meta, const std::string& compressed,
+                            int64_t chunk_id) {
+  CHECK_GE(chunk_id, 0);
+  CHECK_LT(chunk_id, meta.chunk_num());
+  return compressed.substr(chunk_id * meta.chunk_size(), meta.chunk_size());
+}
+
+PlanBundleInflater::PlanBundleInflater(const PlanBundleMeta& meta) : raw_(meta.raw_size(), '\0') {
+  std::memset(&stream_, 0, sizeof(stream_));
+  CHECK_EQ(inflateInit(&stream_), Z_OK);
+}
+
+PlanBundleInflater::~PlanBundleInflater() { inflateEnd(&stream_); }
+
+void PlanBundleInflater::Feed(const std::string& chunk) {
+  stream_.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(chunk.data()));
+  stream_.avail_in = chunk.size();
+  stream_.next_out = reinterpret_cast<Bytef*>(&raw_[0]) + stream_.total_out;
+  stream_.avail_out = raw_.size() - stream_.total_out;
+  const int ret = inflate(&stream_, Z_NO_FLUSH);
+  CHECK(ret == Z_OK || ret == Z_STREAM_END);
+  CHECK_EQ(stream_.avail_in, 0U);
+}
+
+void PlanBundleInflater::ParseTo(Plan* plan) {
+  CHECK_EQ(stream_.total_out, raw_.size());
+  CHECK(plan->ParsePartialFromString(raw_));
+}
+
+}  // namespace oneflow
@@ -0,0 +1,62 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#ifndef ONEFLOW_CORE_JOB_PLAN_BUNDLE_H_
+#define ONEFLOW_CORE_JOB_PLAN_BUNDLE_H_
+
+#include <zlib.h>
+#include "oneflow/core/common/util.h"
+#include "oneflow/core/job/plan.pb.h"
+#include "oneflow/core/job/plan_bundle.pb.h"
+
+namespace oneflow {
+
+// The plan is distributed as compressed bundles, one of the tasks and memory blocks of each
+// machine and one of the parts common to all, which the machines pull in chunks along a tree
+// rooted at the master.
+
+// bytes of the compressed plan bundle carried by each kv
+constexpr int64_t kPlanBundleChunkSize = 16 << 20;
+// the master sends the bundles to this many machines, each of which relays them to as many more
+constexpr int64_t kPlanDistributionFanOut = 8;
+
+// the machine machine_id pulls the bundles from, machine_id > 0
+int64_t PlanDistributionParent(int64_t machine_id);
+// the machines of the subtree of machine_id among machine_num ones, level by level
+std::vector<int64_t> PlanDistributionDescendants(int64_t machine_id, int64_t machine_num);
+
+void CompressPlan(const Plan& plan, int64_t chunk_size, PlanBundleMeta* meta,
+                  std::string* compressed);
+std::string PlanBundleChunk(const PlanBundleMeta& meta, const std::string& compressed,
+                            int64_t chunk_id);
+
+// decompresses a bundle as its chunks arrive, the compressed bundle is never held as a whole
+class PlanBundleInflater final {
+ public:
+  OF_DISALLOW_COPY_AND_MOVE(PlanBundleInflater);
+  explicit PlanBundleInflater(const PlanBundleMeta& meta);
+  ~PlanBundleInflater();
+
+  void Feed(const std::string& chunk);
+  void ParseTo(Plan* plan);
+
+ private:
+  z_stream stream_;
+  std::string raw_;
+};
+
+}  // namespace oneflow
+
+#endif  // ONEFLOW_CORE_JOB_PLAN_BUNDLE_H_
@@ -0,0 +1,108 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include "oneflow/core/job/plan_bundle.h"
+
+namespace oneflow {
+
+namespace {
+
+void TestPlanDistributionTree(int64_t machine_num) {
+  // every parent pulls before its children, at most kPlanDistributionFanOut of them
+  std::vector<int64_t> child_cnt(machine_num, 0);
+  FOR_RANGE(int64_t, i, 1, machine_num) {
+    const int64_t parent = PlanDistributionParent(i);
+    ASSERT_GE(parent, 0);
+    ASSERT_LT(parent, i);
+    child_cnt.at(parent) += 1;
+  }
+  for (int64_t cnt : child_cnt) { ASSERT_LE(cnt, kPlanDistributionFanOut); }
+  // the subtree of the master is every other machine once, and a machine relays the bundles of
+  // exactly the machines whose chain of parents reaches it
+  const std::vector<int64_t> all = PlanDistributionDescendants(0, machine_num);
+  std::vector<int64_t> relayed_cnt(machine_num, 0);
+  for (int64_t descendant : all) {
+    ASSERT_GT(descendant, 0);
+    ASSERT_LT(descendant, machine_num);
+    relayed_cnt.at(descendant) += 1;
+  }
+  FOR_RANGE(int64_t, i, 1, machine_num) { ASSERT_EQ(relayed_cnt.at(i), 1); }
+  FOR_RANGE(int64_t, i, 0, machine_num) {
+    const std::vector<int64_t> descendants = PlanDistributionDescendants(i, machine_num);
+    std::set<int64_t> descendant_set(descendants.begin(), descendants.end());
+    ASSERT_EQ(descendant_set.size(), descendants.size());
+    FOR_RANGE(int64_t, j, i + 1, machine_num) {
+      int64_t ancestor = j;
+      while (ancestor > i) { ancestor = PlanDistributionParent(ancestor); }
+      ASSERT_EQ(ancestor == i, descendant_set.find(j) != descendant_set.end());
+    }
+  }
+}
+
+Plan GenPlan(int64_t task_num) {
+  Plan plan;
+  FOR_RANGE(int64_t, i, 0, task_num) {
+    TaskProto* task = plan.add_task();
+    task->set_machine_id(i % 3);
+    task->set_thrd_id(i * 7919 % 101);
+    task->set_task_id(i * 104729);
+    task->set_job_id(i % 5);
+  }
+  return plan;
+}
+
+void TestPlanBundleRoundTrip(const Plan& plan, int64_t chunk_size) {
+  PlanBundleMeta meta;
+  std::string compressed;
+  CompressPlan(plan, chunk_size, &meta, &compressed);
+  ASSERT_EQ(meta.chunk_num(), RoundUp(compressed.size(), chunk_size) / chunk_size);
+  PlanBundleInflater inflater(meta);
+  std::string concatenated;
+  FOR_RANGE(int64_t, i, 0, meta.chunk_num()) {
+    const std::string chunk = PlanBundleChunk(meta, compressed, i);
+    concatenated += chunk;
+    inflater.Feed(chunk);
+  }
+  ASSERT_EQ(concatenated, compressed);
+  Plan inflated;
+  inflater.ParseTo(&inflated);
+  ASSERT_EQ(inflated.SerializePartialAsString(), plan.SerializePartialAsString());
+}
+
+}  // namespace
+
+TEST(PlanBundle, distribution_tree) {
+  for (int64_t machine_num : std::vector<int64_t>{1, 8, 9, 73}) {
+    TestPlanDistributionTree(machine_num);
+  }
+}
+
+TEST(PlanBundle, round_trip_in_chunks) {
+  const Plan plan = GenPlan(512);
+  PlanBundleMeta meta;
+  std::string compressed;
+  CompressPlan(plan, 64, &meta, &compressed);
+  ASSERT_GT(meta.chunk_num(), 4);
+  for (int64_t chunk_size : std::vector<int64_t>{1, 64, 1000, kPlanBundleChunkSize}) {
+    TestPlanBundleRoundTrip(plan, chunk_size);
+  }
+}
+
+TEST(PlanBundle, round_trip_empty) {
+  TestPlanBundleRoundTrip(Plan(), 64);
+  TestPlanBundleRoundTrip(Plan(), 1);
+}
+
+}  // namespace oneflow
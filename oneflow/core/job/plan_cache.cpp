@@ -0,0 +1,203 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include "oneflow/core/job/plan_cache.h"
+#include "oneflow/core/common/str_util.h"
+#include "oneflow/core/job/available_memory_desc.pb.h"
+#include "oneflow/core/job/env_desc.h"
+#include "oneflow/core/job/global_for.h"
+#include "oneflow/core/job/id_manager.h"
+#include "oneflow/core/job/inter_user_job_info.pb.h"
+#include "oneflow/core/job/job_desc.h"
+#include "oneflow/core/job/job_set.pb.h"
+#include "oneflow/core/job/plan_cache.pb.h"
+#include "oneflow/core/job/resource_desc.h"
+#include "oneflow/core/job/version.h"
+#include "oneflow/core/persistence/file_system.h"
+
+namespace oneflow {
+
+namespace {
+
+// FNV-1a, stable across processes unlike std::hash
+class Fingerprinter final {
+ public:
+  Fingerprinter() : hash_(14695981039346656037ULL) {}
+  ~Fingerprinter() = default;
+
+  void Update(const std::string& str) {
+    // the length separates the strings
+    UpdateBytes(std::to_string(str.size()) + ":");
+    UpdateBytes(str);
+  }
+  void Update(const PbMessage& msg) { Update(PbMessage2TxtString(msg)); }
+  std::string HexDigest() const {
+    char buf[17];
+    snprintf(buf, sizeof(buf), "%016llx", static_cast<unsigned long long>(hash_));
+    return buf;
+  }
+
+ private:
+  void UpdateBytes(const std::string& bytes) {
+    for (unsigned char c : bytes) {
+      hash_ ^= c;
+      hash_ *= 1099511628211ULL;
+    }
+  }
+
+  uint64_t hash_;
+};
+
+std::string PlanCacheFilePath(const std::string& fingerprint) {
+  return JoinPath(Global<ResourceDesc, ForSession>::Get()->plan_cache_dir(),
+                  "plan_" + fingerprint + ".bin");
+}
+
+int64_t MemZoneId4MemCase(const MemoryCase& mem_case) {
+  if (mem_case.has_device_cuda_mem()) {
+    return mem_case.device_cuda_mem().device_id();
+  } else {
+    return Global<ResourceDesc, ForSession>::Get()->GpuDeviceNum();
+  }
+}
+
+}  // namespace
+
+bool IsPlanFitCurrentCluster(const Plan& plan) {
+  const ResourceDesc* resource_desc = Global<ResourceDesc, ForSession>::Get();
+  const int64_t machine_num = resource_desc->TotalMachineNum();
+  const int64_t gpu_device_num = resource_desc->GpuDeviceNum();
+  const AvailableMemDesc& amd = *Global<AvailableMemDesc>::Get();
+  if (amd.machine_amd_size() != machine_num) { return false; }
+  const IDMgr* id_mgr = Global<IDMgr>::Get();
+  for (const TaskProto& task : plan.task()) {
+    if (task.machine_id() < 0 || task.machine_id() >= machine_num) { return false; }
+    if (id_mgr->GetDeviceTypeFromThrdId(task.thrd_id()) == DeviceType::kGPU
+        && id_mgr->GetGpuPhyIdFromThrdId(task.thrd_id()) >= gpu_device_num) {
+      return false;
+    }
+  }
+  std::vector<std::vector<uint64_t>> machine_id2zone_used(machine_num);
+  FOR_RANGE(int64_t, i, 0, machine_num) {
+    machine_id2zone_used.at(i).resize(amd.machine_amd(i).zone_size_size(), 0);
+  }
+  const auto Use = [&](int64_t machine_id, const MemoryCase& mem_case, int64_t mem_size) -> bool {
+    if (machine_id < 0 || machine_id >= machine_num) { return false; }
+    const int64_t zone_id = MemZoneId4MemCase(mem_case);
+    if (zone_id < 0 || zone_id >= machine_id2zone_used.at(machine_id).size()) { return false; }
+    machine_id2zone_used.at(machine_id).at(zone_id) += mem_size;
+    return true;
+  };
+  for (const MemBlockProto& mem_block : plan.block_chunk_list().mem_block()) {
+    // the chunk counts for the blocks in it
+    if (mem_block.chunk_id() != -1) { continue; }
+    if (!Use(mem_block.machine_id(), mem_block.mem_case(), mem_block.mem_size())) { return false; }
+  }
+  for (const ChunkProto& chunk : plan.block_chunk_list().chunk()) {
+    if (!Use(chunk.machine_id(), chunk.mem_case(), chunk.mem_size())) { return false; }
+  }
+  FOR_RANGE(int64_t, i, 0, machine_num) {
+    FOR_RANGE(int64_t, zone_id, 0, machine_id2zone_used.at(i).size()) {
+      if (machine_id2zone_used.at(i).at(zone_id) > amd.machine_amd(i).zone_size(zone_id)) {
+        return false;
+      }
+    }
+  }
+  return true;
+}
+
+bool IsPlanCacheEnabled(const PbRpf<Job>& conf_jobs) {
+  if (Global<ResourceDesc, ForSession>::Get()->plan_cache_dir().empty()) { return false; }
+  for (const Job& job : conf_jobs) {
+    if (job.job_conf().enable_experiment_run()) { return false; }
+  }
+  return true;
+}
+
+std::string PlanCacheFingerprint(const PbRpf<Job>& conf_jobs) {
+  Fingerprinter fingerprinter;
+#ifdef WITH_GIT_VERSION
+  fingerprinter.Update(GetOneFlowGitVersion());
+#endif  // WITH_GIT_VERSION
+  const EnvDesc* env_desc = Global<EnvDesc>::Get();
+  FOR_RANGE(int64_t, i, 0, env_desc->TotalMachineNum()) {
+    fingerprinter.Update(env_desc->machine(i));
+  }
+  // not the ports, which are picked per process on a single machine and do not affect the plan
+  fingerprinter.Update(Global<ResourceDesc, ForSession>::Get()->resource());
+  fingerprinter.Update(*Global<const IOConf>::Get());
+  for (const Job& job : conf_jobs) { fingerprinter.Update(job); }
+  return fingerprinter.HexDigest();
+}
+
+Maybe<bool> TryLoadCachedPlan(const std::string& fingerprint, Plan* plan) {
+  const std::string path = PlanCacheFilePath(fingerprint);
+  fs::FileSystem* fs = LocalFS();
+  if (!fs->FileExists(path)) {
+    LOG(INFO) << "plan cache miss: " << path;
+    return false;
+  }
+  std::string serialized(fs->GetFileSize(path), '\0');
+  {
+    std::unique_ptr<fs::RandomAccessFile> file;
+    fs->NewRandomAccessFile(path, &file);
+    file->Read(0, serialized.size(), &serialized.at(0));
+  }
+  PlanCacheEntry entry;
+  if (!entry.ParseFromString(serialized) || entry.fingerprint() != fingerprint) {
+    LOG(WARNING) << "plan cache corrupted: " << path;
+    return false;
+  }
+  if (!IsPlanFitCurrentCluster(entry.plan())) {
+    LOG(WARNING) << "plan cache stale, the plan does not fit the current cluster: " << path;
+    return false;
+  }
+  auto* job_name2job_id = Global<JobName2JobId>::Get();
+  CHECK_OR_RETURN(job_name2job_id->empty());
+  for (const auto& pair : entry.job_name2job_id()) { job_name2job_id->emplace(pair); }
+  *Global<InterUserJobInfo>::Get() = entry.inter_user_job_info();
+  plan->Swap(entry.mutable_plan());
+  LOG(INFO) << "plan cache hit: " << path;
+  return true;
+}
+
+Maybe<void> StorePlanToCache(const std::string& fingerprint, const Plan& plan) {
+  PlanCacheEntry entry;
+  entry.set_fingerprint(fingerprint);
+  *entry.mutable_plan() = plan;
+  for (const auto& pair : *Global<JobName2JobId>::Get()) {
+    (*entry.mutable_job_name2job_id())[pair.first] = pair.second;
+  }
+  *entry.mutable_inter_user_job_info() = *Global<InterUserJobInfo>::Get();
+  std::string serialized;
+  CHECK_OR_RETURN(entry.SerializeToString(&serialized));
+  fs::FileSystem* fs = LocalFS();
+  const std::string& dir = Global<ResourceDesc, ForSession>::Get()->plan_cache_dir();
+  if (!fs->IsDirectory(dir)) { fs->RecursivelyCreateDir(dir); }
+  // renamed when complete, a session never loads a partially written plan
+  const std::string path = PlanCacheFilePath(fingerprint);
+  const std::string tmp_path = path + ".tmp";
+  {
+    std::unique_ptr<fs::WritableFile> file;
+    fs->NewWritableFile(tmp_path, &file);
+    file->Append(serialized.data(), serialized.size());
+    file->Close();
+  }
+  fs->RenameFile(tmp_path, path);
+  LOG(INFO) << "plan cached: " << path;
+  return Maybe<void>::Ok();
+}
+
+}  // namespace oneflow
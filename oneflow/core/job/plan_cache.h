@@ -0,0 +1,43 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#ifndef ONEFLOW_CORE_JOB_PLAN_CACHE_H_
+#define ONEFLOW_CORE_JOB_PLAN_CACHE_H_
+
+#include "oneflow/core/common/maybe.h"
+#include "oneflow/core/common/protobuf.h"
+#include "oneflow/core/job/job.pb.h"
+#include "oneflow/core/job/plan.pb.h"
+
+namespace oneflow {
+
+// Caches the merged plan of the jobs of a session in the plan_cache_dir of the master, keyed by a
+// fingerprint of the jobs, the machines, the resource and the io conf. The jobs of an experiment
+// run depend on profiling, they are never cached.
+// Entries are never evicted: a plan_<fingerprint>.bin file, about the size of the merged plan, is
+// added for every distinct set of jobs and config and stays there until the directory is cleared.
+bool IsPlanCacheEnabled(const PbRpf<Job>& conf_jobs);
+std::string PlanCacheFingerprint(const PbRpf<Job>& conf_jobs);
+// On a hit the job name to job id map and the inter user job info are restored too. A cached
+// plan not fitting the current cluster, e.g. whose memory the devices no longer have, is a miss.
+Maybe<bool> TryLoadCachedPlan(const std::string& fingerprint, Plan* plan);
+Maybe<void> StorePlanToCache(const std::string& fingerprint, const Plan& plan);
+// Whether the tasks of plan are on the machines and devices of the current session and its memory
+// blocks and chunks fit the available memory of each zone
+bool IsPlanFitCurrentCluster(const Plan& plan);
+
+}  // namespace oneflow
+
+#endif  // ONEFLOW_CORE_JOB_PLAN_CACHE_H_
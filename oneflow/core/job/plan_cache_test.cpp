@@ -0,0 +1,165 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include "oneflow/core/job/plan_cache.h"
+#include "oneflow/core/job/available_memory_desc.pb.h"
+#include "oneflow/core/job/env_desc.h"
+#include "oneflow/core/job/global_for.h"
+#include "oneflow/core/job/id_manager.h"
+#include "oneflow/core/job/resource_desc.h"
+
+namespace oneflow {
+
+namespace {
+
+constexpr int64_t kMachineNum = 2;
+constexpr int64_t kGpuDeviceNum = 1;
+constexpr uint64_t kZoneSize = 1024;
+
+EnvProto GetEnvProto() {
+  EnvProto ret;
+  FOR_RANGE(int64_t, i, 0, kMachineNum + 1) {
+    auto* machine = ret.add_machine();
+    machine->set_id(i);
+    machine->set_addr("192.168.1." + std::to_string(i));
+  }
+  ret.set_ctrl_port(9527);
+  return ret;
+}
+
+Resource GetResource() {
+  Resource ret;
+  ret.set_machine_num(kMachineNum);
+  ret.set_gpu_device_num(kGpuDeviceNum);
+  ret.set_cpu_device_num(2);
+  ret.set_comm_net_worker_num(1);
+  return ret;
+}
+
+// a gpu zone and the host zone on every machine, kZoneSize bytes each
+AvailableMemDesc GetAvailableMemDesc(int64_t machine_num) {
+  AvailableMemDesc ret;
+  FOR_RANGE(int64_t, i, 0, machine_num) {
+    auto* machine_amd = ret.add_machine_amd();
+    FOR_RANGE(int64_t, zone_id, 0, kGpuDeviceNum + 1) { machine_amd->add_zone_size(kZoneSize); }
+  }
+  return ret;
+}
+
+void New() {
+  Global<EnvDesc>::New(GetEnvProto());
+  Global<ResourceDesc, ForSession>::New(GetResource());
+  Global<IDMgr>::New();
+  Global<AvailableMemDesc>::New();
+  *Global<AvailableMemDesc>::Get() = GetAvailableMemDesc(kMachineNum);
+}
+
+void Delete() {
+  Global<AvailableMemDesc>::Delete();
+  Global<IDMgr>::Delete();
+  Global<ResourceDesc, ForSession>::Delete();
+  Global<EnvDesc>::Delete();
+}
+
+void AddCpuTask(int64_t machine_id, Plan* plan) {
+  TaskProto* task = plan->add_task();
+  task->set_machine_id(machine_id);
+  task->set_thrd_id(Global<IDMgr>::Get()->GetCpuDeviceThrdId(0));
+}
+
+MemoryCase HostMemCase() {
+  MemoryCase mem_case;
+  mem_case.mutable_host_mem();
+  return mem_case;
+}
+
+MemoryCase GpuMemCase() {
+  MemoryCase mem_case;
+  mem_case.mutable_device_cuda_mem()->set_device_id(0);
+  return mem_case;
+}
+
+void AddMemBlock(int64_t machine_id, const MemoryCase& mem_case, int64_t mem_size, int64_t chunk_id,
+                 Plan* plan) {
+  MemBlockProto* mem_block = plan->mutable_block_chunk_list()->add_mem_block();
+  mem_block->set_machine_id(machine_id);
+  *mem_block->mutable_mem_case() = mem_case;
+  mem_block->set_mem_size(mem_size);
+  mem_block->set_chunk_id(chunk_id);
+}
+
+void AddChunk(int64_t machine_id, const MemoryCase& mem_case, int64_t mem_size, Plan* plan) {
+  ChunkProto* chunk = plan->mutable_block_chunk_list()->add_chunk();
+  chunk->set_machine_id(machine_id);
+  *chunk->mutable_mem_case() = mem_case;
+  chunk->set_mem_size(mem_size);
+}
+
+// tasks on both machines, the host zone of machine 0 taken by two blocks and the gpu zone of
+// machine 1 by a chunk with a block in it
+Plan GetFittingPlan() {
+  Plan plan;
+  AddCpuTask(0, &plan);
+  AddCpuTask(1, &plan);
+  AddMemBlock(0, HostMemCase(), kZoneSize / 2, -1, &plan);
+  AddMemBlock(0, HostMemCase(), kZoneSize / 2, -1, &plan);
+  AddChunk(1, GpuMemCase(), kZoneSize, &plan);
+  AddMemBlock(1, GpuMemCase(), kZoneSize, 0, &plan);
+  return plan;
+}
+
+}  // namespace
+
+TEST(PlanCache, plan_fitting_cluster) {
+  New();
+  ASSERT_TRUE(IsPlanFitCurrentCluster(GetFittingPlan()));
+  Delete();
+}
+
+TEST(PlanCache, plan_of_more_machines) {
+  New();
+  Plan task_plan = GetFittingPlan();
+  AddCpuTask(kMachineNum, &task_plan);
+  ASSERT_FALSE(IsPlanFitCurrentCluster(task_plan));
+  Plan chunk_plan = GetFittingPlan();
+  AddChunk(kMachineNum, HostMemCase(), 1, &chunk_plan);
+  ASSERT_FALSE(IsPlanFitCurrentCluster(chunk_plan));
+  Delete();
+}
+
+TEST(PlanCache, cluster_of_fewer_machines) {
+  New();
+  *Global<AvailableMemDesc>::Get() = GetAvailableMemDesc(kMachineNum - 1);
+  ASSERT_FALSE(IsPlanFitCurrentCluster(GetFittingPlan()));
+  Delete();
+}
+
+TEST(PlanCache, plan_of_more_zone_memory) {
+  New();
+  Plan block_plan = GetFittingPlan();
+  AddMemBlock(0, HostMemCase(), 1, -1, &block_plan);
+  ASSERT_FALSE(IsPlanFitCurrentCluster(block_plan));
+  Plan chunk_plan = GetFittingPlan();
+  AddChunk(1, GpuMemCase(), 1, &chunk_plan);
+  ASSERT_FALSE(IsPlanFitCurrentCluster(chunk_plan));
+  // the blocks in a chunk do not count twice, the zone is free on machine 0
+  Plan in_chunk_plan = GetFittingPlan();
+  AddMemBlock(1, GpuMemCase(), kZoneSize, 0, &in_chunk_plan);
+  AddChunk(0, GpuMemCase(), kZoneSize, &in_chunk_plan);
+  ASSERT_TRUE(IsPlanFitCurrentCluster(in_chunk_plan));
+  Delete();
+}
+
+}  // namespace oneflow
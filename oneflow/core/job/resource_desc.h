@@ -33,6 +33,12 @@ class ResourceDesc final {
   size_t TotalMachineNum() const;
   const Machine& machine(int32_t idx) const;
   size_t CommNetWorkerNum() const { return resource_.comm_net_worker_num(); }
+  int32_t CommNetStreamNumPerPeer() const { return resource_.comm_net_stream_num_per_peer(); }
+  size_t comm_net_stripe_min_byte() const { return resource_.comm_net_stripe_min_kbyte() * 1024; }
+  bool comm_net_use_zero_copy() const { return resource_.comm_net_use_zero_copy(); }
+  size_t comm_net_zero_copy_min_byte() const {
+    return resource_.comm_net_zero_copy_min_kbyte() * 1024;
+  }
   size_t rdma_mem_block_byte() const { return resource_.rdma_mem_block_mbyte() * kMB; }
   size_t rdma_recv_msg_buf_byte() const { return resource_.rdma_recv_msg_buf_mbyte() * kMB; }
   int32_t CpuDeviceNum() const { return resource_.cpu_device_num(); }
@@ -48,8 +54,19 @@ class ResourceDesc final {
   bool thread_enable_local_message_queue() const {
     return resource_.thread_enable_local_message_queue();
   }
+  bool thread_enable_mpsc_mailbox() const { return resource_.thread_enable_mpsc_mailbox(); }
+  size_t thread_mpsc_mailbox_capacity() const { return resource_.thread_mpsc_mailbox_capacity(); }
+  int64_t thread_mpsc_mailbox_max_spin_count() const {
+    return resource_.thread_mpsc_mailbox_max_spin_count();
+  }
   bool enable_thread_local_cache() const { return resource_.enable_thread_local_cache(); }
   size_t thread_local_cache_max_size() const { return resource_.thread_local_cache_max_size(); }
+  int32_t data_reader_worker_num() const { return resource_.data_reader_worker_num(); }
+  int32_t data_reader_max_prefetch_batch_num() const {
+    return resource_.data_reader_max_prefetch_batch_num();
+  }
+  bool data_reader_ordered() const { return resource_.data_reader_ordered(); }
+  const std::string& plan_cache_dir() const { return resource_.plan_cache_dir(); }
   int32_t ComputeThreadPoolSize() const;
   bool enable_debug_mode() const;
   CollectiveBoxingConf collective_boxing_conf() const;
@@ -13,14 +13,13 @@ WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
 See the License for the specific language governing permissions and
 limitations under the License.
 */
-
-#ifdef WITH_CUDA
-
 #include "oneflow/core/job_rewriter/auto_mixed_precision_lists.h"
 
 #include <algorithm>
 
+#ifdef WITH_CUDA
 #include "oneflow/core/device/cuda_util.h"
+#endif
 #include "oneflow/core/framework/framework.h"
 #include "oneflow/core/job_rewriter/op_graph_pass.h"
 #include "oneflow/core/job/job_desc.h"
@@ -107,10 +106,22 @@ void DfsTopoGraphTraversal(const OpGraph& graph, bool reversed,
   });
 }
 
+// cpu ops run with half only on request and only for inference, the cpu half kernels are
+// forward kernels
+bool IsAllowedToRunWithHalfOnCpu(OpNode* node) {
+  return GlobalJobDesc().enable_auto_mixed_precision_on_cpu() && !GlobalJobDesc().IsTrain()
+         && IsNodeInList(AutoMixedPrecisionLists::CpuHalfList(), node);
+}
+
 std::function<bool(OpNode*)> MakePredicatorIsAllowedToRunWithHalf(const OpGraph& op_graph) {
   auto allowed_set = std::make_shared<HashSet<OpNode*>>();
   op_graph.ForEachNode([&](OpNode* node) {
-    if (node->parallel_desc().device_type() != DeviceType::kGPU) { return; }
+    const DeviceType device_type = node->parallel_desc().device_type();
+    if (device_type == DeviceType::kCPU) {
+      if (!IsAllowedToRunWithHalfOnCpu(node)) { return; }
+    } else if (device_type != DeviceType::kGPU) {
+      return;
+    }
     for (const std::string& obn : node->op().output_bns()) {
       LogicalBlobId lbi = node->op().BnInOp2Lbi(obn);
       // TODO(niuchong): this isn't right for fw-bw-opgraph, but right for fw-opgraph
@@ -249,13 +260,16 @@ class AutoMixedPrecision final : public OpGraphPass {
 };
 
 Maybe<void> AutoMixedPrecision::Apply(const OpGraph& op_graph, JobBuilder* job_builder) const {
+#ifdef WITH_CUDA
   CHECK_GE(CUDA_VERSION, 10000);
+#endif
   CHECK(GlobalJobDesc().DefaultDataType() == DataType::kFloat);
 
   VerifyAMPList(white_list_);
   VerifyAMPList(black_list_);
   VerifyAMPList(gray_list_);
   VerifyAMPList(clear_list_);
+  VerifyAMPList(AutoMixedPrecisionLists::CpuHalfList());
 
   std::function<std::string(OpNode* const&)> OpName4Node = [](OpNode* const& node) {
     return node->op().op_name();
@@ -392,5 +406,3 @@ REGISTER_NO_CAST_REGISTRY("normalization", "beta", 0)
 }  // namespace
 
 }  // namespace oneflow
-
-#endif  // WITH_CUDA
@@ -18,7 +18,7 @@ limitations under the License.
 namespace oneflow {
 
 const AMPList& AutoMixedPrecisionLists::WhiteList() {
-  static AMPList white_list = {"matmul", "batch_matmul", "conv2d"};
+  static AMPList white_list = {"matmul", "batch_matmul", "conv1d", "conv2d", "conv3d"};
   return white_list;
 }
 
@@ -46,4 +46,10 @@ const AMPList& AutoMixedPrecisionLists::ClearList() {
   return clear_list;
 }
 
+const AMPList& AutoMixedPrecisionLists::CpuHalfList() {
+  static AMPList cpu_half_list = {"matmul", "batch_matmul", "conv1d",  "conv2d",
+                                  "conv3d", "bias_add",     "sqrt",    "reshape"};
+  return cpu_half_list;
+}
+
 }  // namespace oneflow
@@ -30,6 +30,8 @@ class AutoMixedPrecisionLists final {
   static const AMPList& BlackList();
   static const AMPList& GrayList();
   static const AMPList& ClearList();
+  // the ops of the lists above with cpu half kernels
+  static const AMPList& CpuHalfList();
 };
 
 }  // namespace oneflow
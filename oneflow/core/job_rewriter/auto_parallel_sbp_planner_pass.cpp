@@ -0,0 +1,281 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include "oneflow/core/job_rewriter/op_graph_pass.h"
+#include "oneflow/core/job_rewriter/sbp_plan_search.h"
+#include "oneflow/core/framework/config_def.h"
+#include "oneflow/core/persistence/tee_persistent_log_stream.h"
+
+namespace oneflow {
+
+REGISTER_FUNCTION_CONFIG_DEF()
+    .Bool("enable_auto_parallel_sbp_planner", false,
+          "true means that the sbp signatures of the user ops are searched over the whole job "
+          "instead of being chosen op by op")
+    .Int64("auto_parallel_sbp_planner_memory_limit_mbyte", 0,
+           "the limit of the blobs the ops output on each device, no limit if <= 0")
+    .Double("auto_parallel_sbp_planner_transfer_cost_ratio", 16,
+            "the cost of transferring a byte between devices relative to computing on it");
+
+namespace {
+
+double BlobSize(const BlobDesc& blob_desc) {
+  return blob_desc.shape().elem_cnt() * GetSizeOfDataType(blob_desc.data_type());
+}
+
+// the bytes of a blob of blob_size each device receives when the blob is boxed from src to dst
+double TransferSize(double blob_size, const SbpParallel& src, const ParallelDesc& src_parallel_desc,
+                    const SbpParallel& dst, const ParallelDesc& dst_parallel_desc) {
+  const bool is_same_placement = src_parallel_desc == dst_parallel_desc;
+  if (dst.has_partial_sum_parallel()) {
+    if (!src.has_partial_sum_parallel()) { return kSbpPlanInfeasibleCost; }
+    return is_same_placement ? 0 : blob_size;
+  }
+  const double dst_parallel_num = dst_parallel_desc.parallel_num();
+  if (!is_same_placement) {
+    const double received = dst.has_broadcast_parallel() ? blob_size : blob_size / dst_parallel_num;
+    return received + (src.has_partial_sum_parallel() ? blob_size : 0);
+  }
+  if (src == dst || src.has_broadcast_parallel()) { return 0; }
+  const double remote_ratio = (dst_parallel_num - 1) / dst_parallel_num;
+  if (src.has_split_parallel()) {
+    // all2all between splits, or all gather
+    return dst.has_split_parallel() ? blob_size * remote_ratio / dst_parallel_num
+                                    : blob_size * remote_ratio;
+  }
+  // reduce scatter, or all reduce
+  return dst.has_split_parallel() ? blob_size * remote_ratio : 2 * blob_size * remote_ratio;
+}
+
+double LocalSize(double blob_size, const SbpParallel& sbp_parallel, int64_t parallel_num) {
+  return sbp_parallel.has_split_parallel() ? blob_size / parallel_num : blob_size;
+}
+
+std::string SbpParallelToString(const SbpParallel& sbp_parallel) {
+  if (sbp_parallel.has_split_parallel()) {
+    return "S(" + std::to_string(sbp_parallel.split_parallel().axis()) + ")";
+  } else if (sbp_parallel.has_broadcast_parallel()) {
+    return "B";
+  } else {
+    return "P";
+  }
+}
+
+void ForEachInOrOutBn(const Operator& op, const std::function<void(const std::string&)>& Handler) {
+  for (const std::string& ibn : op.input_bns()) { Handler(ibn); }
+  for (const std::string& obn : op.output_bns()) { Handler(obn); }
+}
+
+std::string SbpSignatureToString(const Operator& op, const SbpSignature& sbp_signature) {
+  std::string str;
+  const auto& bn2sbp_parallel = sbp_signature.bn_in_op2sbp_parallel();
+  ForEachInOrOutBn(op, [&](const std::string& bn) {
+    const auto it = bn2sbp_parallel.find(bn);
+    if (it == bn2sbp_parallel.end()) { return; }
+    if (!str.empty()) { str += " "; }
+    str += bn + ":" + SbpParallelToString(it->second);
+  });
+  return str;
+}
+
+// the chosen signature comes first, then the other signatures of the op covering all its blobs
+Maybe<void> GetSbpSignatureCandidates(const OpNode* op_node,
+                                      std::vector<SbpSignature>* candidates) {
+  const Operator& op = op_node->op();
+  candidates->push_back(op_node->sbp_signature());
+  SbpSignatureList sbp_sig_list;
+  JUST(op.GetSbpSignaturesIf(
+      [&](const std::string& ibn) -> Maybe<const BlobDesc&> {
+        return op_node->LogicalBlobDesc4Lbi(op.BnInOp2Lbi(ibn));
+      },
+      op_node->parallel_desc(), &sbp_sig_list));
+  for (const SbpSignature& sbp_signature : sbp_sig_list.sbp_signature()) {
+    if (std::find(candidates->begin(), candidates->end(), sbp_signature) != candidates->end()) {
+      continue;
+    }
+    const auto& bn2sbp_parallel = sbp_signature.bn_in_op2sbp_parallel();
+    bool is_complete = true;
+    ForEachInOrOutBn(op, [&](const std::string& bn) {
+      is_complete = is_complete && bn2sbp_parallel.find(bn) != bn2sbp_parallel.end();
+    });
+    if (is_complete) { candidates->push_back(sbp_signature); }
+  }
+  return Maybe<void>::Ok();
+}
+
+// Searches the sbp signatures of the user ops over the whole job for the least estimated step
+// time, instead of the op by op choice of OpGraph, and writes them to the sbp signature conf of the
+// job. An op costs the bytes of its blobs, divided by the parallel num unless all of them are
+// broadcast, an edge the bytes its boxing transfers per device times the transfer cost ratio. The
+// plan has to fit the memory limit on the bytes of the outputs on each device. The ops of a sbp
+// signature conf, of identical sbp blobs or of mirrored blobs keep their signatures.
+class AutoParallelSbpPlannerPass final : public OpGraphPass {
+ public:
+  AutoParallelSbpPlannerPass() = default;
+  ~AutoParallelSbpPlannerPass() override = default;
+  bool IsEnabled() const override {
+    return GlobalJobDesc().Bool("enable_auto_parallel_sbp_planner");
+  }
+  Maybe<void> Apply(const OpGraph& op_graph, JobBuilder* job_builder) const override;
+};
+
+Maybe<void> AutoParallelSbpPlannerPass::Apply(const OpGraph& op_graph,
+                                              JobBuilder* job_builder) const {
+  const auto& op_name2sbp_sig_conf =
+      job_builder->job().job_parallel_view_conf().op_name2sbp_signature_conf();
+  HashSet<std::string> identical_sbp_op_names;
+  for (const auto& pair : job_builder->job().helper().identical_sbp_oba_pairs().pair()) {
+    identical_sbp_op_names.insert(pair.first().op_name());
+    identical_sbp_op_names.insert(pair.second().op_name());
+  }
+  const auto IsPlannable = [&](const OpNode* op_node) -> Maybe<bool> {
+    const Operator& op = op_node->op();
+    if (!op.op_conf().has_user_conf()) { return false; }
+    if (op_node->parallel_desc().parallel_num() == 1) { return false; }
+    if (op_name2sbp_sig_conf.find(op.op_name()) != op_name2sbp_sig_conf.end()) { return false; }
+    if (identical_sbp_op_names.find(op.op_name()) != identical_sbp_op_names.end()) {
+      return false;
+    }
+    for (const std::string& obn : op.output_bns()) {
+      if (JUST(op.OptMirroredParallel4BnInOp(obn))->has_mirrored_parallel()) { return false; }
+    }
+    return true;
+  };
+  const double transfer_cost_ratio =
+      GlobalJobDesc().Double("auto_parallel_sbp_planner_transfer_cost_ratio");
+  SbpPlanSearchGraph graph;
+  HashMap<const OpNode*, int64_t> op_node2id;
+  std::vector<const OpNode*> op_nodes;
+  std::vector<std::vector<SbpSignature>> candidates;
+  std::vector<std::vector<double>> compute_costs;
+  JUST(op_graph.TopoForEachNodeWithErrorCaptured([&](const OpNode* op_node) -> Maybe<void> {
+    const Operator& op = op_node->op();
+    const int64_t parallel_num = op_node->parallel_desc().parallel_num();
+    std::vector<SbpSignature> node_candidates;
+    if (JUST(IsPlannable(op_node))) {
+      JUST(GetSbpSignatureCandidates(op_node, &node_candidates));
+    } else {
+      node_candidates.push_back(op_node->sbp_signature());
+    }
+    std::vector<double> costs;
+    std::vector<double> memories;
+    for (const SbpSignature& sbp_signature : node_candidates) {
+      const auto& bn2sbp_parallel = sbp_signature.bn_in_op2sbp_parallel();
+      double blobs_size = 0;
+      double memory = 0;
+      bool is_all_broadcast = true;
+      ForEachInOrOutBn(op, [&](const std::string& bn) {
+        blobs_size += BlobSize(op_node->LogicalBlobDesc4Lbi(op.BnInOp2Lbi(bn)));
+        const auto it = bn2sbp_parallel.find(bn);
+        if (it == bn2sbp_parallel.end()) { return; }
+        is_all_broadcast = is_all_broadcast && it->second.has_broadcast_parallel();
+      });
+      for (const std::string& obn : op.output_bns()) {
+        const auto it = bn2sbp_parallel.find(obn);
+        if (it == bn2sbp_parallel.end()) { continue; }
+        memory += LocalSize(BlobSize(op_node->LogicalBlobDesc4Lbi(op.BnInOp2Lbi(obn))),
+                            it->second, parallel_num);
+      }
+      costs.push_back(is_all_broadcast ? blobs_size : blobs_size / parallel_num);
+      memories.push_back(memory);
+    }
+    const int64_t id = graph.AddNode(costs, memories);
+    for (const OpEdge* edge : op_node->in_edges()) {
+      const OpNode* producer = edge->src_node();
+      const int64_t src_id = op_node2id.at(producer);
+      const std::vector<SbpSignature>& src_candidates = candidates.at(src_id);
+      std::vector<double> edge_costs(src_candidates.size() * node_candidates.size(), 0);
+      for (const LogicalBlobId& lbi : edge->lbis()) {
+        const double blob_size = BlobSize(op_node->LogicalBlobDesc4Lbi(lbi));
+        const std::string& obn = edge->lbi2obn().at(lbi);
+        for (const std::string& ibn : edge->lbi2ibns().at(lbi)) {
+          FOR_RANGE(size_t, i, 0, src_candidates.size()) {
+            const auto& src_bn2sbp_parallel = src_candidates.at(i).bn_in_op2sbp_parallel();
+            const auto src_it = src_bn2sbp_parallel.find(obn);
+            if (src_it == src_bn2sbp_parallel.end()) { continue; }
+            FOR_RANGE(size_t, j, 0, node_candidates.size()) {
+              const auto& dst_bn2sbp_parallel = node_candidates.at(j).bn_in_op2sbp_parallel();
+              const auto dst_it = dst_bn2sbp_parallel.find(ibn);
+              if (dst_it == dst_bn2sbp_parallel.end()) { continue; }
+              edge_costs.at(i * node_candidates.size() + j) +=
+                  transfer_cost_ratio
+                  * TransferSize(blob_size, src_it->second, producer->parallel_desc(),
+                                 dst_it->second, op_node->parallel_desc());
+            }
+          }
+        }
+      }
+      graph.AddEdge(src_id, id, edge_costs);
+    }
+    op_node2id.emplace(op_node, id);
+    op_nodes.push_back(op_node);
+    candidates.push_back(std::move(node_candidates));
+    compute_costs.push_back(std::move(costs));
+    return Maybe<void>::Ok();
+  }));
+
+  // the first candidate of each op is the one OpGraph chose
+  const std::vector<int64_t> greedy_choices(graph.node_num(), 0);
+  const double memory_limit =
+      GlobalJobDesc().Int64("auto_parallel_sbp_planner_memory_limit_mbyte") * 1024.0 * 1024.0;
+  const SbpPlan greedy_plan{greedy_choices, graph.Cost(greedy_choices),
+                            graph.Memory(greedy_choices)};
+  const SbpPlan plan = SearchSbpPlan(graph, greedy_choices, memory_limit);
+  const auto ComputeCost = [&](const SbpPlan& sbp_plan) -> double {
+    double cost = 0;
+    FOR_RANGE(int64_t, i, 0, graph.node_num()) {
+      cost += compute_costs.at(i).at(sbp_plan.choices.at(i));
+    }
+    return cost;
+  };
+  const auto PlanToString = [&](const SbpPlan& sbp_plan) -> std::string {
+    const double compute_cost = ComputeCost(sbp_plan);
+    return "cost " + std::to_string(sbp_plan.cost) + " (compute " + std::to_string(compute_cost)
+           + ", transfer " + std::to_string(sbp_plan.cost - compute_cost) + "), memory "
+           + std::to_string(sbp_plan.memory / 1024 / 1024) + " MB per device";
+  };
+  int64_t changed_op_cnt = 0;
+  FOR_RANGE(int64_t, i, 0, graph.node_num()) {
+    if (plan.choices.at(i) != greedy_choices.at(i)) { changed_op_cnt += 1; }
+  }
+  const std::string& job_name = GlobalJobDesc().job_name();
+  LOG(INFO) << "auto parallel sbp plan of job " << job_name << ", greedy: "
+            << PlanToString(greedy_plan) << "; planned: " << PlanToString(plan) << "; "
+            << changed_op_cnt << " of " << graph.node_num() << " ops changed";
+  auto log_stream = TeePersistentLogStream::Create("auto_parallel_sbp_plan_"
+                                                   + std::to_string(GlobalJobDesc().job_id()));
+  (*log_stream) << "greedy: " << PlanToString(greedy_plan) << "\n";
+  (*log_stream) << "planned: " << PlanToString(plan) << "\n";
+  if (changed_op_cnt == 0) { return Maybe<void>::Ok(); }
+  (*log_stream) << "op_name\tgreedy\tplanned\n";
+  FOR_RANGE(int64_t, i, 0, graph.node_num()) {
+    // a conf for every planned op, otherwise the ones unchanged may follow changed producers
+    if (candidates.at(i).size() == 1) { continue; }
+    const Operator& op = op_nodes.at(i)->op();
+    const SbpSignature& sbp_signature = candidates.at(i).at(plan.choices.at(i));
+    job_builder->AddSbpSignature4OpName(op.op_name(), sbp_signature);
+    if (plan.choices.at(i) == greedy_choices.at(i)) { continue; }
+    (*log_stream) << op.op_name() << "\t"
+                  << SbpSignatureToString(op, candidates.at(i).at(greedy_choices.at(i))) << "\t"
+                  << SbpSignatureToString(op, sbp_signature) << "\n";
+  }
+  return Maybe<void>::Ok();
+}
+
+}  // namespace
+
+REGISTER_FUNCTION_PASS("AutoParallelSbpPlannerPass", AutoParallelSbpPlannerPass);
+
+}  // namespace oneflow
@@ -0,0 +1,242 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include "oneflow/core/job_rewriter/op_graph_pass.h"
+#include "oneflow/core/framework/framework.h"
+
+namespace oneflow {
+
+namespace {
+
+bool IsConvOp(const OperatorConf& op_conf) {
+  if (!op_conf.has_user_conf()) { return false; }
+  const std::string& op_type_name = op_conf.user_conf().op_type_name();
+  return op_type_name == "conv1d" || op_type_name == "conv2d" || op_type_name == "conv3d";
+}
+
+bool IsBiasAddOp(const OperatorConf& op_conf) {
+  return op_conf.has_user_conf() && op_conf.user_conf().op_type_name() == "bias_add";
+}
+
+bool IsInferenceNormalizationOp(const OperatorConf& op_conf) {
+  if (!op_conf.has_user_conf()) { return false; }
+  if (op_conf.user_conf().op_type_name() != "normalization") { return false; }
+  return !user_op::UserOpConfWrapper(op_conf).attr<bool>("training");
+}
+
+// Folds an inference normalization into the conv producing its input, directly or through the
+// bias_add of flow.layers.conv2d:
+//   scale = gamma / sqrt(moving_variance + epsilon)
+//   weight' = weight * scale (per output channel)
+//   bias' = (bias - moving_mean) * scale + beta, or beta - moving_mean * scale without bias
+// The variables are only known at runtime, so the folding is done by a few ops on the params,
+// which are tiny compared to the normalization over the whole feature map they replace.
+class FuseConvBnForInferencePass final : public OpGraphPass {
+ public:
+  FuseConvBnForInferencePass() = default;
+  ~FuseConvBnForInferencePass() override = default;
+  bool IsEnabled() const override {
+    return GlobalJobDesc().fuse_conv_bn_for_inference() && !GlobalJobDesc().IsTrain();
+  }
+  Maybe<void> Apply(const OpGraph& op_graph, JobBuilder* job_builder) const override;
+};
+
+Maybe<void> FuseConvBnForInferencePass::Apply(const OpGraph& op_graph,
+                                              JobBuilder* job_builder) const {
+  HashSet<std::string> ctrl_in_op_names;
+  op_graph.ForEachNode([&](const OpNode* op_node) {
+    for (const std::string& ctrl_in_op_name : op_node->op().op_conf().ctrl_in_op_name()) {
+      ctrl_in_op_names.insert(ctrl_in_op_name);
+    }
+  });
+  HashMap<std::string, OperatorConf> op_name2op_conf;
+  const auto MutOpConf4OpNode = [&](const OpNode* op_node) -> OperatorConf* {
+    const std::string& op_name = op_node->op().op_name();
+    if (op_name2op_conf.find(op_name) == op_name2op_conf.end()) {
+      op_name2op_conf[op_name] = op_node->op().op_conf();
+    }
+    return &op_name2op_conf.at(op_name);
+  };
+  HashSet<std::string> fused_conv_op_names;
+  op_graph.ForEachNode([&](const OpNode* bn_node) {
+    const OperatorConf& bn_op_conf = bn_node->op().op_conf();
+    if (!IsInferenceNormalizationOp(bn_op_conf)) { return; }
+    if (!bn_op_conf.ctrl_in_op_name().empty()) { return; }
+    if (ctrl_in_op_names.find(bn_op_conf.name()) != ctrl_in_op_names.end()) { return; }
+    const user_op::UserOpConfWrapper bn_op(bn_op_conf);
+    const LogicalBlobId x_lbi = GenLogicalBlobId(bn_op.input("x", 0));
+    // the op whose output the normalization consumers take over, the conv or its bias_add
+    const OpNode* tail_node = op_graph.OpNode4OpName(x_lbi.op_name());
+    const OpNode* bias_add_node = nullptr;
+    const OpNode* conv_node = tail_node;
+    if (IsBiasAddOp(tail_node->op().op_conf())) {
+      bias_add_node = tail_node;
+      const user_op::UserOpConfWrapper bias_add_op(bias_add_node->op().op_conf());
+      if (bias_add_op.attr<int32_t>("axis") != bn_op.attr<int32_t>("axis")) { return; }
+      conv_node = op_graph.OpNode4OpName(GenLogicalBlobId(bias_add_op.input("a", 0)).op_name());
+    }
+    const OperatorConf& conv_op_conf = conv_node->op().op_conf();
+    if (!IsConvOp(conv_op_conf)) { return; }
+    if (fused_conv_op_names.find(conv_op_conf.name()) != fused_conv_op_names.end()) { return; }
+    for (const OpNode* node : {conv_node, tail_node}) {
+      if (node->out_edges().size() != 1) { return; }
+      if (node->parallel_desc() != bn_node->parallel_desc()) { return; }
+    }
+    const user_op::UserOpConfWrapper conv_op(conv_op_conf);
+    if (bias_add_node != nullptr && conv_op.has_input("bias", 0)) { return; }
+    const int64_t num_axes = bn_node->LogicalBlobDesc4Lbi(x_lbi).shape().NumAxes();
+    const bool is_channels_first = conv_op.attr<std::string>("data_format") == "channels_first";
+    const int32_t channel_axis = is_channels_first ? 1 : num_axes - 1;
+    if (bn_op.attr<int32_t>("axis") != channel_axis) { return; }
+    std::string old_bias_lbn;
+    if (bias_add_node != nullptr) {
+      old_bias_lbn = user_op::UserOpConfWrapper(bias_add_node->op().op_conf()).input("b", 0);
+    } else if (conv_op.has_input("bias", 0)) {
+      old_bias_lbn = conv_op.input("bias", 0);
+    }
+    const BlobDesc& weight_desc =
+        conv_node->LogicalBlobDesc4Lbi(GenLogicalBlobId(conv_op.input("weight", 0)));
+    const BlobDesc& gamma_desc =
+        bn_node->LogicalBlobDesc4Lbi(GenLogicalBlobId(bn_op.input("gamma", 0)));
+    // the params of a float16 normalization are float32
+    if (weight_desc.data_type() != gamma_desc.data_type()) { return; }
+    fused_conv_op_names.insert(conv_op_conf.name());
+
+    const std::string prefix = "System-FuseConvBn-" + bn_op_conf.name();
+    std::vector<OperatorConf> new_op_confs;
+    const auto AddOp = [&](const user_op::UserOpConfWrapper& op) {
+      new_op_confs.push_back(op.op_conf());
+      if (conv_op_conf.has_scope_symbol_id()) {
+        new_op_confs.back().set_scope_symbol_id(conv_op_conf.scope_symbol_id());
+      }
+    };
+    const auto var_add_eps_op =
+        user_op::UserOpConfWrapperBuilder(prefix + "-VarianceAddEpsilon")
+            .Op("scalar_add")
+            .Input("in", bn_op.input("moving_variance", 0))
+            .Output("out")
+            .Attr<bool>("has_float_operand", true)
+            .Attr<double>("float_operand", bn_op.attr<float>("epsilon"))
+            .Attr<bool>("has_int_operand", false)
+            .Attr<int64_t>("int_operand", 0)
+            .Build();
+    AddOp(var_add_eps_op);
+    const auto var_rsqrt_op = user_op::UserOpConfWrapperBuilder(prefix + "-VarianceRsqrt")
+                                  .Op("rsqrt")
+                                  .Input("x", var_add_eps_op.output("out", 0))
+                                  .Output("y")
+                                  .Build();
+    AddOp(var_rsqrt_op);
+    const auto scale_op = user_op::UserOpConfWrapperBuilder(prefix + "-Scale")
+                              .Op("multiply")
+                              .Input("x", bn_op.input("gamma", 0))
+                              .Input("y", var_rsqrt_op.output("y", 0))
+                              .Output("out")
+                              .Build();
+    AddOp(scale_op);
+    DimVector scale_dim_vec(weight_desc.shape().NumAxes(), 1);
+    scale_dim_vec.at(0) = weight_desc.shape().At(0);
+    const auto scale_reshape_op = user_op::UserOpConfWrapperBuilder(prefix + "-ScaleReshape")
+                                      .Op("reshape")
+                                      .Input("in", scale_op.output("out", 0))
+                                      .Output("out")
+                                      .Attr<Shape>("shape", Shape(scale_dim_vec))
+                                      .Build();
+    AddOp(scale_reshape_op);
+    const auto weight_op = user_op::UserOpConfWrapperBuilder(prefix + "-Weight")
+                               .Op("broadcast_mul")
+                               .Input("x", conv_op.input("weight", 0))
+                               .Input("y", scale_reshape_op.output("out", 0))
+                               .Output("z")
+                               .Build();
+    AddOp(weight_op);
+    std::string bias_lbn;
+    if (!old_bias_lbn.empty()) {
+      const auto bias_sub_mean_op = user_op::UserOpConfWrapperBuilder(prefix + "-BiasSubMean")
+                                        .Op("broadcast_sub")
+                                        .Input("x", old_bias_lbn)
+                                        .Input("y", bn_op.input("moving_mean", 0))
+                                        .Output("z")
+                                        .Build();
+      AddOp(bias_sub_mean_op);
+      const auto bias_scale_op = user_op::UserOpConfWrapperBuilder(prefix + "-BiasScale")
+                                     .Op("multiply")
+                                     .Input("x", bias_sub_mean_op.output("z", 0))
+                                     .Input("y", scale_op.output("out", 0))
+                                     .Output("out")
+                                     .Build();
+      AddOp(bias_scale_op);
+      const auto bias_op = user_op::UserOpConfWrapperBuilder(prefix + "-Bias")
+                               .Op("broadcast_add")
+                               .Input("x", bias_scale_op.output("out", 0))
+                               .Input("y", bn_op.input("beta", 0))
+                               .Output("z")
+                               .Build();
+      AddOp(bias_op);
+      bias_lbn = bias_op.output("z", 0);
+    } else {
+      const auto mean_scale_op = user_op::UserOpConfWrapperBuilder(prefix + "-MeanScale")
+                                     .Op("multiply")
+                                     .Input("x", bn_op.input("moving_mean", 0))
+                                     .Input("y", scale_op.output("out", 0))
+                                     .Output("out")
+                                     .Build();
+      AddOp(mean_scale_op);
+      const auto bias_op = user_op::UserOpConfWrapperBuilder(prefix + "-Bias")
+                               .Op("broadcast_sub")
+                               .Input("x", bn_op.input("beta", 0))
+                               .Input("y", mean_scale_op.output("out", 0))
+                               .Output("z")
+                               .Build();
+      AddOp(bias_op);
+      bias_lbn = bias_op.output("z", 0);
+    }
+    job_builder->AddOps(conv_node->parallel_desc().parallel_conf(), new_op_confs);
+
+    UserOpConf* conv_user_conf = MutOpConf4OpNode(conv_node)->mutable_user_conf();
+    (*conv_user_conf->mutable_input())["weight"].set_s(0, weight_op.output("z", 0));
+    if (bias_add_node != nullptr) {
+      UserOpConf* bias_add_user_conf = MutOpConf4OpNode(bias_add_node)->mutable_user_conf();
+      (*bias_add_user_conf->mutable_input())["b"].set_s(0, bias_lbn);
+    } else {
+      UserOpConf::ListString* bias_list = &(*conv_user_conf->mutable_input())["bias"];
+      bias_list->clear_s();
+      bias_list->add_s(bias_lbn);
+    }
+
+    const std::string y_lbn = bn_op.output("y", 0);
+    const std::string tail_out_lbn = GenLogicalBlobName(x_lbi);
+    for (const OpEdge* out_edge : bn_node->out_edges()) {
+      const OpNode* consumer = out_edge->dst_node();
+      OperatorConf* consumer_op_conf = MutOpConf4OpNode(consumer);
+      PbMessage* conf =
+          MutableMessageInPbMessage(consumer_op_conf, consumer_op_conf->op_type_case());
+      for (const std::string& ibn : consumer->op().input_bns()) {
+        if (GenLogicalBlobName(consumer->op().BnInOp2Lbi(ibn)) == y_lbn) {
+          ReplaceInputLbnInOpCustomizedConf(conf, ibn, y_lbn, tail_out_lbn);
+        }
+      }
+    }
+    job_builder->DelOps({bn_op_conf});
+  });
+  for (const auto& pair : op_name2op_conf) { job_builder->MutOpsOnlyOnce({pair.second}); }
+  return Maybe<void>::Ok();
+}
+
+}  // namespace
+
+REGISTER_FUNCTION_PASS("FuseConvBnForInferencePass", FuseConvBnForInferencePass);
+
+}  // namespace oneflow
@@ -0,0 +1,274 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include "oneflow/core/job_rewriter/op_graph_pass.h"
+#include "oneflow/core/framework/framework.h"
+
+namespace oneflow {
+
+namespace {
+
+bool IsUserOp(const OperatorConf& op_conf, const std::string& op_type_name) {
+  return op_conf.has_user_conf() && op_conf.user_conf().op_type_name() == op_type_name;
+}
+
+// The matmul of flow.layers.dense, x * weight(T), and the conv2d without groups
+bool IsQuantizableOp(const OpNode* op_node) {
+  if (op_node->parallel_desc().device_type() != DeviceType::kCPU) { return false; }
+  const OperatorConf& op_conf = op_node->op().op_conf();
+  const bool is_matmul = IsUserOp(op_conf, "matmul");
+  if (!is_matmul && !IsUserOp(op_conf, "conv2d")) { return false; }
+  const user_op::UserOpConfWrapper op(op_conf);
+  const std::string& in_arg_name = is_matmul ? "a" : "in";
+  const BlobDesc& in_desc =
+      op_node->LogicalBlobDesc4Lbi(GenLogicalBlobId(op.input(in_arg_name, 0)));
+  if (in_desc.data_type() != DataType::kFloat) { return false; }
+  if (is_matmul) {
+    return in_desc.shape().NumAxes() == 2 && !op.attr<bool>("transpose_a")
+           && op.attr<bool>("transpose_b");
+  } else {
+    return op.attr<int32_t>("groups") == 1;
+  }
+}
+
+// The float variable of shape {1} recording the absmax of the input of a quantizable op, shared
+// by name between the calibration job and the int8 job
+OperatorConf GenInAbsMaxVariableOpConf(const OperatorConf& op_conf) {
+  OperatorConf variable_op_conf{};
+  variable_op_conf.set_name("System-Int8Quantization-" + op_conf.name() + "-InAbsMax");
+  if (op_conf.has_scope_symbol_id()) {
+    variable_op_conf.set_scope_symbol_id(op_conf.scope_symbol_id());
+  }
+  VariableOpConf* variable_conf = variable_op_conf.mutable_variable_conf();
+  variable_conf->set_out("out");
+  *variable_conf->mutable_shape()->mutable_dim()->Add() = 1;
+  variable_conf->set_data_type(DataType::kFloat);
+  variable_conf->mutable_split_axis()->clear_value();
+  variable_conf->mutable_initializer()->mutable_constant_conf()->set_value(0.f);
+  return variable_op_conf;
+}
+
+std::string InAbsMaxLbn(const OperatorConf& variable_op_conf) {
+  return GenLogicalBlobName(variable_op_conf.name(), variable_op_conf.variable_conf().out());
+}
+
+struct Int8QuantizableChain {
+  const OpNode* op_node;
+  // the last op of the chain, whose output the int8 op takes over
+  const OpNode* tail_node;
+  std::string bias_lbn;
+  bool fuse_relu;
+};
+
+// Replaces a float matmul or conv2d on cpu, together with the bias_add and relu consuming its
+// output alone, by int8_matmul or int8_conv2d:
+//   out = relu(dequantize(quantize(x) * int8_quantize_weight(weight)) + bias)
+// The weight is quantized per output channel once by the int8 kernel and kept in its state, the
+// input is quantized per tensor, and the int32 accumulation is dequantized in the tile epilogue
+// of the gemm, where the bias and relu are applied too.
+// The scale of the input is computed from each batch unless int8_quantization_static_scale is
+// set, in which case it comes from the absmax variable recorded by a float job run with
+// int8_quantization_calibration over some representative batches. Such a job only adds the
+// int8_calibrate_absmax recorders and leaves its ops as they are.
+class Int8QuantizationForInferencePass final : public OpGraphPass {
+ public:
+  Int8QuantizationForInferencePass() = default;
+  ~Int8QuantizationForInferencePass() override = default;
+  bool IsEnabled() const override {
+    return (GlobalJobDesc().int8_quantization_for_inference()
+            || GlobalJobDesc().int8_quantization_calibration())
+           && !GlobalJobDesc().IsTrain();
+  }
+  Maybe<void> Apply(const OpGraph& op_graph, JobBuilder* job_builder) const override;
+
+ private:
+  Maybe<void> ApplyCalibration(const OpGraph& op_graph, JobBuilder* job_builder) const;
+};
+
+Maybe<void> Int8QuantizationForInferencePass::ApplyCalibration(const OpGraph& op_graph,
+                                                               JobBuilder* job_builder) const {
+  op_graph.ForEachNode([&](const OpNode* op_node) {
+    if (!IsQuantizableOp(op_node)) { return; }
+    const OperatorConf& op_conf = op_node->op().op_conf();
+    const user_op::UserOpConfWrapper op(op_conf);
+    const std::string& in_lbn =
+        op.op_type_name() == "matmul" ? op.input("a", 0) : op.input("in", 0);
+    const OperatorConf variable_op_conf = GenInAbsMaxVariableOpConf(op_conf);
+    auto calibrate_op = user_op::UserOpConfWrapperBuilder(variable_op_conf.name() + "-Calibrate")
+                            .Op("int8_calibrate_absmax")
+                            .Input("in", in_lbn)
+                            .Input("absmax", InAbsMaxLbn(variable_op_conf))
+                            .Build();
+    OperatorConf calibrate_op_conf = calibrate_op.op_conf();
+    if (op_conf.has_scope_symbol_id()) {
+      calibrate_op_conf.set_scope_symbol_id(op_conf.scope_symbol_id());
+    }
+    job_builder->AddOps(op_node->parallel_desc().parallel_conf(),
+                        {variable_op_conf, calibrate_op_conf});
+  });
+  return Maybe<void>::Ok();
+}
+
+Maybe<void> Int8QuantizationForInferencePass::Apply(const OpGraph& op_graph,
+                                                    JobBuilder* job_builder) const {
+  if (GlobalJobDesc().int8_quantization_calibration()) {
+    return ApplyCalibration(op_graph, job_builder);
+  }
+  HashSet<std::string> ctrl_in_op_names;
+  op_graph.ForEachNode([&](const OpNode* op_node) {
+    for (const std::string& ctrl_in_op_name : op_node->op().op_conf().ctrl_in_op_name()) {
+      ctrl_in_op_names.insert(ctrl_in_op_name);
+    }
+  });
+  const auto IsFree = [&](const OpNode* op_node) -> bool {
+    const OperatorConf& op_conf = op_node->op().op_conf();
+    return op_conf.ctrl_in_op_name().empty()
+           && ctrl_in_op_names.find(op_conf.name()) == ctrl_in_op_names.end();
+  };
+  // the only consumer of the output of op_node if it is an op_type_name op on the same devices
+  const auto SoleConsumer = [&](const OpNode* op_node,
+                                const std::string& op_type_name) -> const OpNode* {
+    if (op_node->out_edges().size() != 1) { return nullptr; }
+    const OpNode* consumer = (*op_node->out_edges().begin())->dst_node();
+    if (!IsUserOp(consumer->op().op_conf(), op_type_name)) { return nullptr; }
+    if (consumer->parallel_desc() != op_node->parallel_desc()) { return nullptr; }
+    if (!IsFree(consumer)) { return nullptr; }
+    return consumer;
+  };
+  HashMap<std::string, OperatorConf> op_name2op_conf;
+  const auto MutOpConf4OpNode = [&](const OpNode* op_node) -> OperatorConf* {
+    const std::string& op_name = op_node->op().op_name();
+    if (op_name2op_conf.find(op_name) == op_name2op_conf.end()) {
+      op_name2op_conf[op_name] = op_node->op().op_conf();
+    }
+    return &op_name2op_conf.at(op_name);
+  };
+  std::vector<Int8QuantizableChain> chains;
+  HashSet<std::string> del_op_names;
+  // the output of a replaced chain may be the input of another one
+  HashMap<std::string, std::string> tail_lbn2int8_lbn;
+  op_graph.ForEachNode([&](const OpNode* op_node) {
+    if (!IsQuantizableOp(op_node) || !IsFree(op_node)) { return; }
+    const user_op::UserOpConfWrapper op(op_node->op().op_conf());
+    Int8QuantizableChain chain;
+    chain.op_node = op_node;
+    chain.tail_node = op_node;
+    const bool is_matmul = op.op_type_name() == "matmul";
+    const int64_t num_axes =
+        op_node->LogicalBlobDesc4Lbi(GenLogicalBlobId(op.output("out", 0))).shape().NumAxes();
+    int32_t channel_axis = num_axes - 1;
+    if (!is_matmul && op.attr<std::string>("data_format") == "channels_first") { channel_axis = 1; }
+    if (!is_matmul && op.has_input("bias", 0)) { chain.bias_lbn = op.input("bias", 0); }
+    del_op_names.insert(op_node->op().op_name());
+    const OpNode* bias_add_node = SoleConsumer(chain.tail_node, "bias_add");
+    if (bias_add_node != nullptr && chain.bias_lbn.empty()) {
+      const user_op::UserOpConfWrapper bias_add_op(bias_add_node->op().op_conf());
+      if (bias_add_op.attr<int32_t>("axis") == channel_axis) {
+        chain.bias_lbn = bias_add_op.input("b", 0);
+        chain.tail_node = bias_add_node;
+        del_op_names.insert(bias_add_node->op().op_name());
+      }
+    }
+    const OpNode* relu_node = SoleConsumer(chain.tail_node, "relu");
+    chain.fuse_relu = relu_node != nullptr;
+    if (chain.fuse_relu) {
+      chain.tail_node = relu_node;
+      del_op_names.insert(relu_node->op().op_name());
+    }
+    const std::string tail_lbn = GenLogicalBlobName(
+        chain.tail_node->op().BnInOp2Lbi(chain.tail_node->op().SoleObn()));
+    tail_lbn2int8_lbn[tail_lbn] =
+        GenLogicalBlobName("System-Int8Quantization-" + op.op_name(), GenRepeatedBn("out", 0));
+    chains.push_back(chain);
+  });
+  const auto Lbn4Input = [&](const std::string& lbn) -> const std::string& {
+    const auto it = tail_lbn2int8_lbn.find(lbn);
+    return it == tail_lbn2int8_lbn.end() ? lbn : it->second;
+  };
+
+  for (const Int8QuantizableChain& chain : chains) {
+    const OperatorConf& op_conf = chain.op_node->op().op_conf();
+    const user_op::UserOpConfWrapper op(op_conf);
+    const bool is_matmul = op.op_type_name() == "matmul";
+    const std::string prefix = "System-Int8Quantization-" + op_conf.name();
+    std::vector<OperatorConf> new_op_confs;
+    const auto AddOp = [&](const user_op::UserOpConfWrapper& new_op) {
+      new_op_confs.push_back(new_op.op_conf());
+      if (op_conf.has_scope_symbol_id()) {
+        new_op_confs.back().set_scope_symbol_id(op_conf.scope_symbol_id());
+      }
+    };
+    user_op::UserOpConfWrapperBuilder int8_op_builder(prefix);
+    if (is_matmul) {
+      int8_op_builder.Op("int8_matmul")
+          .Input("a", Lbn4Input(op.input("a", 0)))
+          .Input("b", Lbn4Input(op.input("b", 0)));
+    } else {
+      int8_op_builder.Op("int8_conv2d")
+          .Input("in", Lbn4Input(op.input("in", 0)))
+          .Input("weight", Lbn4Input(op.input("weight", 0)))
+          .Attr<int32_t>("filters", op.attr<int32_t>("filters"))
+          .Attr<std::vector<int32_t>>("padding_before",
+                                      op.attr<std::vector<int32_t>>("padding_before"))
+          .Attr<std::string>("data_format", op.attr<std::string>("data_format"))
+          .Attr<std::vector<int32_t>>("kernel_size", op.attr<std::vector<int32_t>>("kernel_size"))
+          .Attr<std::vector<int32_t>>("strides", op.attr<std::vector<int32_t>>("strides"))
+          .Attr<std::vector<int32_t>>("dilation_rate",
+                                      op.attr<std::vector<int32_t>>("dilation_rate"));
+    }
+    if (!chain.bias_lbn.empty()) { int8_op_builder.Input("bias", Lbn4Input(chain.bias_lbn)); }
+    if (GlobalJobDesc().int8_quantization_static_scale()) {
+      const OperatorConf variable_op_conf = GenInAbsMaxVariableOpConf(op_conf);
+      new_op_confs.push_back(variable_op_conf);
+      int8_op_builder.Input(is_matmul ? "a_absmax" : "in_absmax", InAbsMaxLbn(variable_op_conf));
+    }
+    const auto int8_op =
+        int8_op_builder.Output("out").Attr<bool>("fuse_relu", chain.fuse_relu).Build();
+    AddOp(int8_op);
+    job_builder->AddOps(chain.op_node->parallel_desc().parallel_conf(), new_op_confs);
+
+    const std::string tail_lbn = GenLogicalBlobName(
+        chain.tail_node->op().BnInOp2Lbi(chain.tail_node->op().SoleObn()));
+    const std::string& int8_lbn = int8_op.output("out", 0);
+    CHECK_EQ(Lbn4Input(tail_lbn), int8_lbn);
+    for (const OpEdge* out_edge : chain.tail_node->out_edges()) {
+      const OpNode* consumer = out_edge->dst_node();
+      if (del_op_names.find(consumer->op().op_name()) != del_op_names.end()) { continue; }
+      OperatorConf* consumer_op_conf = MutOpConf4OpNode(consumer);
+      PbMessage* conf =
+          MutableMessageInPbMessage(consumer_op_conf, consumer_op_conf->op_type_case());
+      for (const std::string& ibn : consumer->op().input_bns()) {
+        if (GenLogicalBlobName(consumer->op().BnInOp2Lbi(ibn)) == tail_lbn) {
+          ReplaceInputLbnInOpCustomizedConf(conf, ibn, tail_lbn, int8_lbn);
+        }
+      }
+    }
+  }
+  std::vector<OperatorConf> del_op_confs;
+  op_graph.ForEachNode([&](const OpNode* op_node) {
+    if (del_op_names.find(op_node->op().op_name()) != del_op_names.end()) {
+      del_op_confs.push_back(op_node->op().op_conf());
+    }
+  });
+  job_builder->DelOps(del_op_confs);
+  for (const auto& pair : op_name2op_conf) { job_builder->MutOpsOnlyOnce({pair.second}); }
+  return Maybe<void>::Ok();
+}
+
+}  // namespace
+
+REGISTER_FUNCTION_PASS("Int8QuantizationForInferencePass", Int8QuantizationForInferencePass);
+
+}  // namespace oneflow
@@ -0,0 +1,257 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include "oneflow/core/job_rewriter/sbp_plan_search.h"
+
+namespace oneflow {
+
+namespace {
+
+constexpr int64_t kMaxSearchRoundNum = 32;
+constexpr int64_t kMaxPenaltyDoublingNum = 64;
+// the penalty starts at this fraction of the cost per byte of memory of the unlimited plan
+constexpr double kInitPenaltyRatio = 1.0 / 64;
+
+}  // namespace
+
+int64_t SbpPlanSearchGraph::AddNode(const std::vector<double>& costs,
+                                    const std::vector<double>& memories) {
+  CHECK_GT(costs.size(), 0);
+  CHECK_EQ(costs.size(), memories.size());
+  nodes_.emplace_back();
+  nodes_.back().costs = costs;
+  nodes_.back().memories = memories;
+  return nodes_.size() - 1;
+}
+
+void SbpPlanSearchGraph::AddEdge(int64_t src, int64_t dst, const std::vector<double>& costs) {
+  CHECK_GE(src, 0);
+  CHECK_LT(src, dst);
+  CHECK_LT(dst, node_num());
+  CHECK_EQ(costs.size(), nodes_.at(src).costs.size() * nodes_.at(dst).costs.size());
+  const auto it = src_dst2edge_.find(std::make_pair(src, dst));
+  if (it != src_dst2edge_.end()) {
+    std::vector<double>* edge_costs = &edges_.at(it->second).costs;
+    FOR_RANGE(size_t, i, 0, costs.size()) { edge_costs->at(i) += costs.at(i); }
+    return;
+  }
+  const int64_t edge_id = edges_.size();
+  edges_.push_back(Edge{src, dst, costs});
+  nodes_.at(src).edges.push_back(edge_id);
+  nodes_.at(dst).edges.push_back(edge_id);
+  src_dst2edge_.emplace(std::make_pair(src, dst), edge_id);
+}
+
+double SbpPlanSearchGraph::Cost(const std::vector<int64_t>& choices) const {
+  CHECK_EQ(choices.size(), nodes_.size());
+  double cost = 0;
+  FOR_RANGE(int64_t, i, 0, node_num()) { cost += nodes_.at(i).costs.at(choices.at(i)); }
+  for (const Edge& edge : edges_) { cost += EdgeCost(edge, choices); }
+  return cost;
+}
+
+double SbpPlanSearchGraph::Memory(const std::vector<int64_t>& choices) const {
+  CHECK_EQ(choices.size(), nodes_.size());
+  double memory = 0;
+  FOR_RANGE(int64_t, i, 0, node_num()) { memory += nodes_.at(i).memories.at(choices.at(i)); }
+  return memory;
+}
+
+class SbpPlanSearcher final {
+ public:
+  OF_DISALLOW_COPY_AND_MOVE(SbpPlanSearcher);
+  explicit SbpPlanSearcher(const SbpPlanSearchGraph& graph) : graph_(graph) { InitChains(); }
+  ~SbpPlanSearcher() = default;
+
+  // lowers cost + penalty * memory of choices until a round brings no improvement
+  void Improve(double penalty, std::vector<int64_t>* choices) const;
+
+ private:
+  using Edge = SbpPlanSearchGraph::Edge;
+  using Node = SbpPlanSearchGraph::Node;
+  void InitChains();
+  double PenalizedCost(double penalty, const std::vector<int64_t>& choices) const {
+    return graph_.Cost(choices) + penalty * graph_.Memory(choices);
+  }
+  // the part of the penalized cost depending on the candidate of node, the edges to skip_node_a
+  // and skip_node_b excluded
+  double LocalCost(int64_t node_id, int64_t candidate, double penalty,
+                   const std::vector<int64_t>& choices, int64_t skip_node_a,
+                   int64_t skip_node_b) const;
+  // the best choices of a chain given the choices of all the others, by dynamic programming
+  void SolveChain(const std::vector<int64_t>& chain, double penalty,
+                  std::vector<int64_t>* choices) const;
+  // moves single nodes to their best candidates given the choices of all the others
+  void LocalSearch(double penalty, std::vector<int64_t>* choices) const;
+
+  const SbpPlanSearchGraph& graph_;
+  // every node with more than one candidate is in exactly one chain
+  std::vector<std::vector<int64_t>> chains_;
+};
+
+void SbpPlanSearcher::InitChains() {
+  const int64_t node_num = graph_.node_num();
+  std::vector<int64_t> next(node_num, -1);
+  std::vector<int64_t> prev(node_num, -1);
+  FOR_RANGE(int64_t, i, 0, node_num) {
+    if (graph_.CandidateNum(i) <= 1) { continue; }
+    int64_t out_edge_num = 0;
+    int64_t dst = -1;
+    for (int64_t edge_id : graph_.nodes_.at(i).edges) {
+      const Edge& edge = graph_.edges_.at(edge_id);
+      if (edge.src != i) { continue; }
+      out_edge_num += 1;
+      dst = edge.dst;
+    }
+    // a node consumed by its sole consumer only is linked to it, the edges of a chain are then
+    // the ones between neighbours in the chain only
+    if (out_edge_num != 1 || graph_.CandidateNum(dst) <= 1 || prev.at(dst) != -1) { continue; }
+    next.at(i) = dst;
+    prev.at(dst) = i;
+  }
+  FOR_RANGE(int64_t, i, 0, node_num) {
+    if (graph_.CandidateNum(i) <= 1 || prev.at(i) != -1) { continue; }
+    chains_.emplace_back();
+    for (int64_t node_id = i; node_id != -1; node_id = next.at(node_id)) {
+      chains_.back().push_back(node_id);
+    }
+  }
+}
+
+double SbpPlanSearcher::LocalCost(int64_t node_id, int64_t candidate, double penalty,
+                                  const std::vector<int64_t>& choices, int64_t skip_node_a,
+                                  int64_t skip_node_b) const {
+  const Node& node = graph_.nodes_.at(node_id);
+  double cost = node.costs.at(candidate) + penalty * node.memories.at(candidate);
+  for (int64_t edge_id : node.edges) {
+    const Edge& edge = graph_.edges_.at(edge_id);
+    const int64_t other = edge.src == node_id ? edge.dst : edge.src;
+    if (other == skip_node_a || other == skip_node_b) { continue; }
+    if (edge.src == node_id) {
+      cost += edge.costs.at(candidate * graph_.CandidateNum(edge.dst) + choices.at(edge.dst));
+    } else {
+      cost += edge.costs.at(choices.at(edge.src) * graph_.CandidateNum(node_id) + candidate);
+    }
+  }
+  return cost;
+}
+
+void SbpPlanSearcher::SolveChain(const std::vector<int64_t>& chain, double penalty,
+                                 std::vector<int64_t>* choices) const {
+  const int64_t len = chain.size();
+  // least cost of the chain prefix ending with each candidate, and the candidate before it
+  std::vector<std::vector<double>> prefix_costs(len);
+  std::vector<std::vector<int64_t>> prev_candidates(len);
+  FOR_RANGE(int64_t, i, 0, len) {
+    const int64_t node_id = chain.at(i);
+    const int64_t prev_id = i > 0 ? chain.at(i - 1) : -1;
+    const int64_t next_id = i + 1 < len ? chain.at(i + 1) : -1;
+    const int64_t candidate_num = graph_.CandidateNum(node_id);
+    const std::vector<double>* edge_costs = nullptr;
+    if (i > 0) {
+      const int64_t edge_id = graph_.src_dst2edge_.at(std::make_pair(prev_id, node_id));
+      edge_costs = &graph_.edges_.at(edge_id).costs;
+    }
+    prefix_costs.at(i).resize(candidate_num);
+    prev_candidates.at(i).resize(candidate_num, -1);
+    FOR_RANGE(int64_t, c, 0, candidate_num) {
+      const double cost = LocalCost(node_id, c, penalty, *choices, prev_id, next_id);
+      if (i == 0) {
+        prefix_costs.at(i).at(c) = cost;
+        continue;
+      }
+      double best = std::numeric_limits<double>::infinity();
+      FOR_RANGE(int64_t, pc, 0, graph_.CandidateNum(prev_id)) {
+        const double prefix_cost =
+            prefix_costs.at(i - 1).at(pc) + edge_costs->at(pc * candidate_num + c);
+        if (prefix_cost < best) {
+          best = prefix_cost;
+          prev_candidates.at(i).at(c) = pc;
+        }
+      }
+      prefix_costs.at(i).at(c) = best + cost;
+    }
+  }
+  const std::vector<double>& last_costs = prefix_costs.at(len - 1);
+  int64_t candidate = std::min_element(last_costs.begin(), last_costs.end()) - last_costs.begin();
+  for (int64_t i = len - 1; i >= 0; --i) {
+    choices->at(chain.at(i)) = candidate;
+    candidate = prev_candidates.at(i).at(candidate);
+  }
+}
+
+void SbpPlanSearcher::LocalSearch(double penalty, std::vector<int64_t>* choices) const {
+  FOR_RANGE(int64_t, i, 0, graph_.node_num()) {
+    if (graph_.CandidateNum(i) <= 1) { continue; }
+    double best = LocalCost(i, choices->at(i), penalty, *choices, -1, -1);
+    FOR_RANGE(int64_t, c, 0, graph_.CandidateNum(i)) {
+      const double cost = LocalCost(i, c, penalty, *choices, -1, -1);
+      if (cost < best) {
+        best = cost;
+        choices->at(i) = c;
+      }
+    }
+  }
+}
+
+void SbpPlanSearcher::Improve(double penalty, std::vector<int64_t>* choices) const {
+  double cost = PenalizedCost(penalty, *choices);
+  FOR_RANGE(int64_t, round, 0, kMaxSearchRoundNum) {
+    const std::vector<int64_t> last_choices = *choices;
+    for (const std::vector<int64_t>& chain : chains_) { SolveChain(chain, penalty, choices); }
+    LocalSearch(penalty, choices);
+    const double new_cost = PenalizedCost(penalty, *choices);
+    // a chain may move between plans of the same cost, keep the former one then
+    if (!(new_cost < cost - 1e-9 * std::abs(cost))) {
+      if (new_cost > cost) { *choices = last_choices; }
+      break;
+    }
+    cost = new_cost;
+  }
+}
+
+SbpPlan SearchSbpPlan(const SbpPlanSearchGraph& graph, const std::vector<int64_t>& init_choices,
+                      double memory_limit) {
+  CHECK_EQ(init_choices.size(), static_cast<size_t>(graph.node_num()));
+  const auto MakePlan = [&](const std::vector<int64_t>& choices) -> SbpPlan {
+    return SbpPlan{choices, graph.Cost(choices), graph.Memory(choices)};
+  };
+  const auto Fits = [&](const SbpPlan& plan) -> bool {
+    return memory_limit <= 0 || plan.memory <= memory_limit;
+  };
+  // a fitting plan is better than one not fitting, the one of less memory if neither fits
+  const auto IsBetter = [&](const SbpPlan& lhs, const SbpPlan& rhs) -> bool {
+    if (Fits(lhs) != Fits(rhs)) { return Fits(lhs); }
+    return Fits(lhs) ? lhs.cost < rhs.cost : lhs.memory < rhs.memory;
+  };
+  const SbpPlanSearcher searcher(graph);
+  SbpPlan best = MakePlan(init_choices);
+  std::vector<int64_t> choices = init_choices;
+  searcher.Improve(0, &choices);
+  SbpPlan plan = MakePlan(choices);
+  if (IsBetter(plan, best)) { best = plan; }
+  if (Fits(plan)) { return best; }
+  double penalty = kInitPenaltyRatio * std::max(plan.cost, 1.0) / std::max(plan.memory, 1.0);
+  FOR_RANGE(int64_t, i, 0, kMaxPenaltyDoublingNum) {
+    searcher.Improve(penalty, &choices);
+    plan = MakePlan(choices);
+    if (IsBetter(plan, best)) { best = plan; }
+    if (Fits(plan)) { break; }
+    penalty *= 2;
+  }
+  return best;
+}
+
+}  // namespace oneflow
@@ -0,0 +1,81 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#ifndef ONEFLOW_CORE_JOB_REWRITER_SBP_PLAN_SEARCH_H_
+#define ONEFLOW_CORE_JOB_REWRITER_SBP_PLAN_SEARCH_H_
+
+#include "oneflow/core/common/util.h"
+
+namespace oneflow {
+
+// A cost that no plan should pay, e.g. boxing into a partial sum
+const double kSbpPlanInfeasibleCost = 1e30;
+
+// Every node takes one of its candidates, the cost of a plan is the sum of the node costs of the
+// chosen candidates and of the edge costs of the chosen pairs, its memory is the sum of the node
+// memories. Edges go from a lower node id to a higher one, i.e. nodes are added in topo order.
+class SbpPlanSearchGraph final {
+ public:
+  OF_DISALLOW_COPY_AND_MOVE(SbpPlanSearchGraph);
+  SbpPlanSearchGraph() = default;
+  ~SbpPlanSearchGraph() = default;
+
+  int64_t AddNode(const std::vector<double>& costs, const std::vector<double>& memories);
+  // costs[src_candidate * CandidateNum(dst) + dst_candidate], adds up with the former costs of the
+  // same src and dst
+  void AddEdge(int64_t src, int64_t dst, const std::vector<double>& costs);
+
+  int64_t node_num() const { return nodes_.size(); }
+  int64_t CandidateNum(int64_t node) const { return nodes_.at(node).costs.size(); }
+  double Cost(const std::vector<int64_t>& choices) const;
+  double Memory(const std::vector<int64_t>& choices) const;
+
+ private:
+  friend class SbpPlanSearcher;
+  struct Edge {
+    int64_t src;
+    int64_t dst;
+    std::vector<double> costs;
+  };
+  struct Node {
+    std::vector<double> costs;
+    std::vector<double> memories;
+    std::vector<int64_t> edges;
+  };
+  double EdgeCost(const Edge& edge, const std::vector<int64_t>& choices) const {
+    return edge.costs.at(choices.at(edge.src) * CandidateNum(edge.dst) + choices.at(edge.dst));
+  }
+
+  std::vector<Node> nodes_;
+  std::vector<Edge> edges_;
+  HashMap<std::pair<int64_t, int64_t>, int64_t> src_dst2edge_;
+};
+
+struct SbpPlan {
+  std::vector<int64_t> choices;
+  double cost;
+  double memory;
+};
+
+// Starting from init_choices, searches for the plan of least cost whose memory is at most
+// memory_limit, no limit if memory_limit <= 0. Alternates dynamic programming over the chains of
+// the graph with a local search over single nodes, the memory limit is a lagrangian penalty
+// doubled until the plan fits. Never returns a plan worse than init_choices if it fits.
+SbpPlan SearchSbpPlan(const SbpPlanSearchGraph& graph, const std::vector<int64_t>& init_choices,
+                      double memory_limit);
+
+}  // namespace oneflow
+
+#endif  // ONEFLOW_CORE_JOB_REWRITER_SBP_PLAN_SEARCH_H_
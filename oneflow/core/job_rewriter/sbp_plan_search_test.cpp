@@ -0,0 +1,86 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include "oneflow/core/job_rewriter/sbp_plan_search.h"
+
+namespace oneflow {
+
+namespace {
+
+// switching between the candidates of the two ends of an edge costs switch_cost
+std::vector<double> SwitchCosts(double switch_cost) { return {0, switch_cost, switch_cost, 0}; }
+
+}  // namespace
+
+TEST(SbpPlanSearch, chain_beats_greedy) {
+  SbpPlanSearchGraph graph;
+  FOR_RANGE(int64_t, i, 0, 4) { graph.AddNode({0, 1}, {1, 1}); }
+  FOR_RANGE(int64_t, i, 0, 3) { graph.AddEdge(i, i + 1, SwitchCosts(10)); }
+  // the greedy plan starting with candidate 1 pays the compute cost at every node
+  const SbpPlan plan = SearchSbpPlan(graph, {1, 1, 1, 1}, 0);
+  ASSERT_TRUE(plan.choices == std::vector<int64_t>({0, 0, 0, 0}));
+  ASSERT_TRUE(plan.cost == 0);
+}
+
+TEST(SbpPlanSearch, fixed_node_decides_chain) {
+  SbpPlanSearchGraph graph;
+  graph.AddNode({0}, {0});
+  graph.AddNode({0, 1}, {1, 1});
+  graph.AddNode({0, 1}, {1, 1});
+  graph.AddEdge(0, 1, {100, 0});
+  graph.AddEdge(1, 2, SwitchCosts(10));
+  const SbpPlan plan = SearchSbpPlan(graph, {0, 0, 0}, 0);
+  ASSERT_TRUE(plan.choices == std::vector<int64_t>({0, 1, 1}));
+  ASSERT_TRUE(plan.cost == 2);
+}
+
+TEST(SbpPlanSearch, diamond) {
+  SbpPlanSearchGraph graph;
+  FOR_RANGE(int64_t, i, 0, 4) { graph.AddNode({0, 3}, {1, 1}); }
+  graph.AddEdge(0, 1, SwitchCosts(1));
+  graph.AddEdge(0, 2, SwitchCosts(1));
+  graph.AddEdge(1, 3, SwitchCosts(1));
+  graph.AddEdge(2, 3, SwitchCosts(1));
+  // the same edge twice adds up
+  graph.AddEdge(2, 3, SwitchCosts(1));
+  const SbpPlan plan = SearchSbpPlan(graph, {1, 1, 1, 1}, 0);
+  ASSERT_TRUE(plan.choices == std::vector<int64_t>({0, 0, 0, 0}));
+  ASSERT_TRUE(plan.cost == 0);
+}
+
+TEST(SbpPlanSearch, memory_limit) {
+  SbpPlanSearchGraph graph;
+  // candidate 0 is fast but holds the whole blob, candidate 1 holds a quarter of it
+  FOR_RANGE(int64_t, i, 0, 3) { graph.AddNode({1, 4}, {4, 1}); }
+  FOR_RANGE(int64_t, i, 0, 2) { graph.AddEdge(i, i + 1, SwitchCosts(2)); }
+  const SbpPlan unlimited_plan = SearchSbpPlan(graph, {1, 1, 1}, 0);
+  ASSERT_TRUE(unlimited_plan.choices == std::vector<int64_t>({0, 0, 0}));
+  ASSERT_TRUE(unlimited_plan.memory == 12);
+  const SbpPlan limited_plan = SearchSbpPlan(graph, {0, 0, 0}, 6);
+  ASSERT_TRUE(limited_plan.memory <= 6);
+  ASSERT_TRUE(limited_plan.cost <= 12);
+}
+
+TEST(SbpPlanSearch, keep_greedy_if_nothing_better) {
+  SbpPlanSearchGraph graph;
+  graph.AddNode({1, 1}, {1, 1});
+  graph.AddNode({1, 1}, {1, 1});
+  graph.AddEdge(0, 1, SwitchCosts(1));
+  const SbpPlan plan = SearchSbpPlan(graph, {1, 1}, 0);
+  ASSERT_TRUE(plan.choices == std::vector<int64_t>({1, 1}));
+  ASSERT_TRUE(plan.cost == 2);
+}
+
+}  // namespace oneflow
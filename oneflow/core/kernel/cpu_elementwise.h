@@ -0,0 +1,130 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#ifndef ONEFLOW_CORE_KERNEL_CPU_ELEMENTWISE_H_
+#define ONEFLOW_CORE_KERNEL_CPU_ELEMENTWISE_H_
+
+#include "oneflow/core/common/cpu_isa.h"
+#include "oneflow/core/common/util.h"
+#include "oneflow/core/kernel/cpu_half_util.h"
+#include "oneflow/core/thread/thread_manager.h"
+
+namespace oneflow {
+
+// Elements of a float16 loop widened to float at a time, small enough to stay in L1.
+constexpr int64_t kCpuHalfElementwiseBlockSize = 1024;
+
+namespace cpu_elementwise {
+
+// The same loop compiled once per isa. The functor is inlined into each copy and the compiler
+// vectorizes it for that isa wherever the functor body allows.
+#define OF_CPU_ELEMENTWISE_DEFINE_LOOP(name, target)                                          \
+  template<typename FunctorT, typename R, typename... Args>                                   \
+  target void name(FunctorT functor, int64_t begin, int64_t end, R* out, const Args*... in) { \
+    for (int64_t i = begin; i < end; ++i) { out[i] = functor(in[i]...); }                     \
+  }
+
+OF_CPU_ELEMENTWISE_DEFINE_LOOP(LoopScalar, )
+#if OF_CPU_ISA_DISPATCH_ENABLED
+OF_CPU_ELEMENTWISE_DEFINE_LOOP(LoopAvx2, OF_CPU_TARGET_AVX2)
+OF_CPU_ELEMENTWISE_DEFINE_LOOP(LoopAvx512, OF_CPU_TARGET_AVX512)
+#endif
+
+#undef OF_CPU_ELEMENTWISE_DEFINE_LOOP
+
+template<typename FunctorT, typename R, typename... Args>
+void Loop(FunctorT functor, int64_t begin, int64_t end, R* out, const Args*... in) {
+#if OF_CPU_ISA_DISPATCH_ENABLED
+  switch (GetCpuIsa()) {
+    case CpuIsa::kAvx512: return LoopAvx512(functor, begin, end, out, in...);
+    case CpuIsa::kAvx2: return LoopAvx2(functor, begin, end, out, in...);
+    default: break;
+  }
+#endif
+  LoopScalar(functor, begin, end, out, in...);
+}
+
+// Runs BlockFn(offset, len) over [0, n) in blocks of at most kCpuHalfElementwiseBlockSize,
+// split over the thread pool for large n.
+template<typename BlockFn>
+void ForEachHalfBlock(int64_t n, BlockFn block_fn) {
+  MultiThreadLoopInRange(n, kCpuParallelGrainSize, [&](int64_t begin, int64_t end) {
+    for (int64_t offset = begin; offset < end; offset += kCpuHalfElementwiseBlockSize) {
+      block_fn(offset, std::min(kCpuHalfElementwiseBlockSize, end - offset));
+    }
+  });
+}
+
+}  // namespace cpu_elementwise
+
+// out[i] = functor(in[i]...) for every i in [0, n), vectorized for the running cpu and split
+// over the thread pool for large n. out may be one of the inputs, the functor must be pure.
+template<typename FunctorT, typename R, typename... Args>
+void CpuElementwise(int64_t n, FunctorT functor, R* out, const Args*... in) {
+  if (n <= kCpuParallelGrainSize) {
+    cpu_elementwise::Loop(functor, 0, n, out, in...);
+    return;
+  }
+  MultiThreadLoopInRange(n, kCpuParallelGrainSize, [&](int64_t begin, int64_t end) {
+    cpu_elementwise::Loop(functor, begin, end, out, in...);
+  });
+}
+
+// The float16 loops take a float functor: each block of inputs is widened to float, computed with
+// the vectorized float loop and rounded back, see CpuComputeType.
+template<typename FunctorT>
+void CpuElementwise(int64_t n, FunctorT functor, float16* out, const float16* x) {
+  cpu_elementwise::ForEachHalfBlock(n, [&](int64_t offset, int64_t len) {
+    float x_buf[kCpuHalfElementwiseBlockSize];
+    float out_buf[kCpuHalfElementwiseBlockSize];
+    cpu_half_util::HalfToFloat(len, x + offset, x_buf);
+    cpu_elementwise::Loop(functor, 0, len, out_buf, x_buf);
+    cpu_half_util::FloatToHalf(len, out_buf, out + offset);
+  });
+}
+
+template<typename FunctorT>
+void CpuElementwise(int64_t n, FunctorT functor, float16* out, const float16* x,
+                    const float16* y) {
+  cpu_elementwise::ForEachHalfBlock(n, [&](int64_t offset, int64_t len) {
+    float x_buf[kCpuHalfElementwiseBlockSize];
+    float y_buf[kCpuHalfElementwiseBlockSize];
+    float out_buf[kCpuHalfElementwiseBlockSize];
+    cpu_half_util::HalfToFloat(len, x + offset, x_buf);
+    cpu_half_util::HalfToFloat(len, y + offset, y_buf);
+    cpu_elementwise::Loop(functor, 0, len, out_buf, x_buf, y_buf);
+    cpu_half_util::FloatToHalf(len, out_buf, out + offset);
+  });
+}
+
+template<typename FunctorT>
+void CpuElementwise(int64_t n, FunctorT functor, float16* out, const float16* x, const float16* y,
+                    const float16* z) {
+  cpu_elementwise::ForEachHalfBlock(n, [&](int64_t offset, int64_t len) {
+    float x_buf[kCpuHalfElementwiseBlockSize];
+    float y_buf[kCpuHalfElementwiseBlockSize];
+    float z_buf[kCpuHalfElementwiseBlockSize];
+    float out_buf[kCpuHalfElementwiseBlockSize];
+    cpu_half_util::HalfToFloat(len, x + offset, x_buf);
+    cpu_half_util::HalfToFloat(len, y + offset, y_buf);
+    cpu_half_util::HalfToFloat(len, z + offset, z_buf);
+    cpu_elementwise::Loop(functor, 0, len, out_buf, x_buf, y_buf, z_buf);
+    cpu_half_util::FloatToHalf(len, out_buf, out + offset);
+  });
+}
+
+}  // namespace oneflow
+
+#endif  // ONEFLOW_CORE_KERNEL_CPU_ELEMENTWISE_H_
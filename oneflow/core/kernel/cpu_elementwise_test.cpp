@@ -0,0 +1,72 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include "oneflow/core/kernel/cpu_elementwise.h"
+#include <gtest/gtest.h>
+
+namespace oneflow {
+
+namespace test {
+
+TEST(CpuElementwise, unary_across_grains) {
+  const int64_t n = 3 * kCpuParallelGrainSize + 5;
+  std::vector<float> x(n);
+  std::vector<float> y(n);
+  FOR_RANGE(int64_t, i, 0, n) { x[i] = static_cast<float>(i % 13) - 6.0f; }
+  CpuElementwise(n, [](float x_i) { return x_i > 0.0f ? x_i : 0.0f; }, y.data(), x.data());
+  FOR_RANGE(int64_t, i, 0, n) { ASSERT_EQ(y[i], std::max(x[i], 0.0f)); }
+}
+
+TEST(CpuElementwise, ternary_in_place) {
+  const int64_t n = 1031;
+  std::vector<int32_t> x(n);
+  std::vector<int32_t> y(n);
+  std::vector<int32_t> z(n);
+  FOR_RANGE(int64_t, i, 0, n) {
+    x[i] = i;
+    y[i] = 2 * i;
+    z[i] = 3;
+  }
+  CpuElementwise(
+      n, [](int32_t x_i, int32_t y_i, int32_t z_i) { return x_i * z_i - y_i; }, x.data(),
+      x.data(), y.data(), z.data());
+  FOR_RANGE(int64_t, i, 0, n) { ASSERT_EQ(x[i], i); }
+}
+
+TEST(CpuElementwise, float16_computes_in_float) {
+  const int64_t n = 2 * kCpuParallelGrainSize + 13;
+  std::vector<float16> x(n);
+  std::vector<float16> y(n);
+  std::vector<float16> z(n);
+  FOR_RANGE(int64_t, i, 0, n) {
+    x[i] = static_cast<float16>(static_cast<float>(i % 97) / 8.0f);
+    y[i] = static_cast<float16>(static_cast<float>(i % 5) - 2.0f);
+  }
+  CpuElementwise(
+      n, [](float x_i, float y_i) { return x_i * y_i + 0.5f; }, z.data(), x.data(), y.data());
+  FOR_RANGE(int64_t, i, 0, n) {
+    const float expected = static_cast<float>(x[i]) * static_cast<float>(y[i]) + 0.5f;
+    ASSERT_EQ(static_cast<float>(z[i]), static_cast<float>(static_cast<float16>(expected)));
+  }
+}
+
+TEST(CpuElementwise, empty) {
+  std::vector<double> x;
+  CpuElementwise(0, [](double x_i) { return x_i; }, x.data(), x.data());
+}
+
+}  // namespace test
+
+}  // namespace oneflow
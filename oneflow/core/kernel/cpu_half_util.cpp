@@ -0,0 +1,89 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include "oneflow/core/kernel/cpu_half_util.h"
+#include "oneflow/core/common/cpu_isa.h"
+#include "oneflow/core/thread/thread_manager.h"
+#if OF_CPU_ISA_DISPATCH_ENABLED
+#include <immintrin.h>
+#endif
+
+namespace oneflow {
+
+namespace {
+
+void HalfToFloatScalar(int64_t n, const float16* x, float* y) {
+  for (int64_t i = 0; i < n; ++i) { y[i] = static_cast<float>(x[i]); }
+}
+
+void FloatToHalfScalar(int64_t n, const float* x, float16* y) {
+  for (int64_t i = 0; i < n; ++i) { y[i] = static_cast<float16>(x[i]); }
+}
+
+#if OF_CPU_ISA_DISPATCH_ENABLED
+
+OF_CPU_TARGET_AVX2_F16C void HalfToFloatF16c(int64_t n, const float16* x, float* y) {
+  int64_t i = 0;
+  for (; i + 8 <= n; i += 8) {
+    const __m128i h = _mm_loadu_si128(reinterpret_cast<const __m128i*>(x + i));
+    _mm256_storeu_ps(y + i, _mm256_cvtph_ps(h));
+  }
+  HalfToFloatScalar(n - i, x + i, y + i);
+}
+
+OF_CPU_TARGET_AVX2_F16C void FloatToHalfF16c(int64_t n, const float* x, float16* y) {
+  int64_t i = 0;
+  for (; i + 8 <= n; i += 8) {
+    const __m128i h = _mm256_cvtps_ph(_mm256_loadu_ps(x + i), _MM_FROUND_TO_NEAREST_INT);
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(y + i), h);
+  }
+  FloatToHalfScalar(n - i, x + i, y + i);
+}
+
+#endif
+
+}  // namespace
+
+namespace cpu_half_util {
+
+void HalfToFloat(int64_t n, const float16* x, float* y) {
+#if OF_CPU_ISA_DISPATCH_ENABLED
+  if (GetCpuIsa() != CpuIsa::kScalar) { return HalfToFloatF16c(n, x, y); }
+#endif
+  HalfToFloatScalar(n, x, y);
+}
+
+void FloatToHalf(int64_t n, const float* x, float16* y) {
+#if OF_CPU_ISA_DISPATCH_ENABLED
+  if (GetCpuIsa() != CpuIsa::kScalar) { return FloatToHalfF16c(n, x, y); }
+#endif
+  FloatToHalfScalar(n, x, y);
+}
+
+}  // namespace cpu_half_util
+
+void CpuHalfToFloat(int64_t n, const float16* x, float* y) {
+  MultiThreadLoopInRange(n, kCpuParallelGrainSize, [&](int64_t begin, int64_t end) {
+    cpu_half_util::HalfToFloat(end - begin, x + begin, y + begin);
+  });
+}
+
+void CpuFloatToHalf(int64_t n, const float* x, float16* y) {
+  MultiThreadLoopInRange(n, kCpuParallelGrainSize, [&](int64_t begin, int64_t end) {
+    cpu_half_util::FloatToHalf(end - begin, x + begin, y + begin);
+  });
+}
+
+}  // namespace oneflow
@@ -0,0 +1,51 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#ifndef ONEFLOW_CORE_KERNEL_CPU_HALF_UTIL_H_
+#define ONEFLOW_CORE_KERNEL_CPU_HALF_UTIL_H_
+
+#include "oneflow/core/common/data_type.h"
+
+namespace oneflow {
+
+// y[i] = x[i] converted between float16 and float, with the f16c instructions when the cpu has
+// them. Float to half rounds to nearest even, the same as half_float. Split over the thread pool
+// for large n.
+void CpuHalfToFloat(int64_t n, const float16* x, float* y);
+void CpuFloatToHalf(int64_t n, const float* x, float16* y);
+
+// The type cpu kernels compute a T in: float16 has no cpu arithmetic, it is widened to float and
+// the result rounded back once.
+template<typename T>
+struct CpuComputeType {
+  typedef T type;
+};
+
+template<>
+struct CpuComputeType<float16> {
+  typedef float type;
+};
+
+namespace cpu_half_util {
+
+// The single threaded loops behind CpuHalfToFloat and CpuFloatToHalf.
+void HalfToFloat(int64_t n, const float16* x, float* y);
+void FloatToHalf(int64_t n, const float* x, float16* y);
+
+}  // namespace cpu_half_util
+
+}  // namespace oneflow
+
+#endif  // ONEFLOW_CORE_KERNEL_CPU_HALF_UTIL_H_
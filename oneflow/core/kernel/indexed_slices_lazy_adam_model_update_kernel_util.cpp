@@ -14,9 +14,50 @@ See the License for the specific language governing permissions and
 limitations under the License.
 */
 #include "oneflow/core/kernel/indexed_slices_lazy_adam_model_update_kernel_util.h"
+#include "oneflow/core/common/cpu_isa.h"
+#include "oneflow/core/thread/thread_manager.h"
 
 namespace oneflow {
 
+namespace {
+
+#define DEFINE_LAZY_ADAM_UPDATE_ROW_FUNC(suffix, target)                                          \
+  template<typename T>                                                                            \
+  target void LazyAdamUpdateRow##suffix(int64_t feature_size, T beta1, T beta2, T epsilon, T lr,  \
+                                        const T* diff, T* model, T* m, T* v) {                    \
+    for (int64_t j = 0; j < feature_size; ++j) {                                                  \
+      const T new_m = beta1 * m[j] + (1 - beta1) * diff[j];                                       \
+      const T new_v = beta2 * v[j] + (1 - beta2) * diff[j] * diff[j];                             \
+      m[j] = new_m;                                                                               \
+      v[j] = new_v;                                                                               \
+      model[j] = model[j] - lr * new_m / (std::sqrt(new_v) + epsilon);                            \
+    }                                                                                             \
+  }
+
+DEFINE_LAZY_ADAM_UPDATE_ROW_FUNC(Scalar, )
+#if OF_CPU_ISA_DISPATCH_ENABLED
+DEFINE_LAZY_ADAM_UPDATE_ROW_FUNC(Avx2, OF_CPU_TARGET_AVX2)
+DEFINE_LAZY_ADAM_UPDATE_ROW_FUNC(Avx512, OF_CPU_TARGET_AVX512)
+#endif
+#undef DEFINE_LAZY_ADAM_UPDATE_ROW_FUNC
+
+template<typename T>
+void LazyAdamUpdateRow(int64_t feature_size, T beta1, T beta2, T epsilon, T lr, const T* diff,
+                       T* model, T* m, T* v) {
+#if OF_CPU_ISA_DISPATCH_ENABLED
+  switch (GetCpuIsa()) {
+    case CpuIsa::kAvx512:
+      return LazyAdamUpdateRowAvx512(feature_size, beta1, beta2, epsilon, lr, diff, model, m, v);
+    case CpuIsa::kAvx2:
+      return LazyAdamUpdateRowAvx2(feature_size, beta1, beta2, epsilon, lr, diff, model, m, v);
+    default: break;
+  }
+#endif
+  LazyAdamUpdateRowScalar(feature_size, beta1, beta2, epsilon, lr, diff, model, m, v);
+}
+
+}  // namespace
+
 template<typename T, typename K, typename IDX>
 struct IndexedSlicesLazyAdamMdUpdateKernelUtil<DeviceType::kCPU, T, K, IDX> {
   static void Update(DeviceCtx* ctx, T beta1, T beta2, T epsilon, int64_t num_instance,
@@ -24,19 +65,20 @@ struct IndexedSlicesLazyAdamMdUpdateKernelUtil<DeviceType::kCPU, T, K, IDX> {
                      const IDX* num_unique_instance, const int64_t* train_step,
                      const float* learning_rate, const K* indices, const T* values, T* model, T* m,
                      T* v) {
-    const int64_t n = *num_unique_instance * feature_size;
-    for (int64_t i = 0; i < n; ++i) {
-      const K instance_id = indices[i / feature_size];
-      if (instance_id >= lower_bound && instance_id < upper_bound) {
-        const T diff = values[i];
-        const K model_idx = (instance_id - lower_bound) * feature_size + i % feature_size;
-        const T new_m = beta1 * m[model_idx] + (1 - beta1) * diff;
-        const T new_v = beta2 * v[model_idx] + (1 - beta2) * diff * diff;
-        m[model_idx] = new_m;
-        v[model_idx] = new_v;
-        model[model_idx] = model[model_idx] - *learning_rate * new_m / (std::sqrt(new_v) + epsilon);
+    // the indices are unique, so the rows of different tasks never overlap
+    const T lr = static_cast<T>(*learning_rate);
+    const int64_t grain =
+        std::max<int64_t>(kCpuParallelGrainSize / std::max<int64_t>(feature_size, 1), 1);
+    MultiThreadLoopInRange(*num_unique_instance, grain, [&](int64_t begin, int64_t end) {
+      FOR_RANGE(int64_t, i, begin, end) {
+        const K instance_id = indices[i];
+        if (instance_id >= lower_bound && instance_id < upper_bound) {
+          const int64_t offset = (instance_id - lower_bound) * feature_size;
+          LazyAdamUpdateRow(feature_size, beta1, beta2, epsilon, lr, values + i * feature_size,
+                            model + offset, m + offset, v + offset);
+        }
       }
-    }
+    });
   }
   static void ComputeLocalLearningRate(DeviceCtx* ctx, T beta1, T beta2, const int64_t* train_step,
                                        const float* learning_rate, float* local_learning_rate) {
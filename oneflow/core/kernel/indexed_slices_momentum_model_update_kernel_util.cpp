@@ -14,16 +14,66 @@ See the License for the specific language governing permissions and
 limitations under the License.
 */
 #include "oneflow/core/kernel/indexed_slices_momentum_model_update_kernel_util.h"
+#include "oneflow/core/common/cpu_isa.h"
+#include "oneflow/core/thread/thread_manager.h"
 
 namespace oneflow {
 
+namespace {
+
+#define DEFINE_MOMENTUM_UPDATE_ROW_FUNC(suffix, target)                                    \
+  template<typename T>                                                                     \
+  target void MomentumUpdateRow##suffix(int64_t feature_size, T beta, T lr, const T* diff, \
+                                        T* model, T* momentum) {                           \
+    for (int64_t j = 0; j < feature_size; ++j) {                                           \
+      const T next_momentum = beta * momentum[j] - lr * diff[j];                           \
+      momentum[j] = next_momentum;                                                         \
+      model[j] = model[j] + next_momentum;                                                 \
+    }                                                                                      \
+  }
+
+DEFINE_MOMENTUM_UPDATE_ROW_FUNC(Scalar, )
+#if OF_CPU_ISA_DISPATCH_ENABLED
+DEFINE_MOMENTUM_UPDATE_ROW_FUNC(Avx2, OF_CPU_TARGET_AVX2)
+DEFINE_MOMENTUM_UPDATE_ROW_FUNC(Avx512, OF_CPU_TARGET_AVX512)
+#endif
+#undef DEFINE_MOMENTUM_UPDATE_ROW_FUNC
+
+template<typename T>
+void MomentumUpdateRow(int64_t feature_size, T beta, T lr, const T* diff, T* model, T* momentum) {
+#if OF_CPU_ISA_DISPATCH_ENABLED
+  switch (GetCpuIsa()) {
+    case CpuIsa::kAvx512:
+      return MomentumUpdateRowAvx512(feature_size, beta, lr, diff, model, momentum);
+    case CpuIsa::kAvx2: return MomentumUpdateRowAvx2(feature_size, beta, lr, diff, model, momentum);
+    default: break;
+  }
+#endif
+  MomentumUpdateRowScalar(feature_size, beta, lr, diff, model, momentum);
+}
+
+}  // namespace
+
 template<typename T, typename K, typename IDX>
 struct IndexedSlicesMomentumMdUpdateKernelUtil<DeviceType::kCPU, T, K, IDX> {
   static void Update(DeviceCtx* ctx, T beta, int64_t num_instance, int64_t feature_size,
                      int64_t lower_bound, int64_t upper_bound, const IDX* num_unique_instance,
                      const int64_t* train_step, const float* learning_rate, const K* indices,
                      const T* values, T* model, T* momentum) {
-    UNIMPLEMENTED();
+    // the indices are unique, so the rows of different tasks never overlap
+    const T lr = static_cast<T>(*learning_rate);
+    const int64_t grain =
+        std::max<int64_t>(kCpuParallelGrainSize / std::max<int64_t>(feature_size, 1), 1);
+    MultiThreadLoopInRange(*num_unique_instance, grain, [&](int64_t begin, int64_t end) {
+      FOR_RANGE(int64_t, i, begin, end) {
+        const K instance_id = indices[i];
+        if (instance_id >= lower_bound && instance_id < upper_bound) {
+          const int64_t offset = (instance_id - lower_bound) * feature_size;
+          MomentumUpdateRow(feature_size, beta, lr, values + i * feature_size, model + offset,
+                            momentum + offset);
+        }
+      }
+    });
   }
 };
 
@@ -14,9 +14,42 @@ See the License for the specific language governing permissions and
 limitations under the License.
 */
 #include "oneflow/core/kernel/indexed_slices_naive_model_update_kernel_util.h"
+#include "oneflow/core/common/balanced_splitter.h"
+#include "oneflow/core/common/cpu_isa.h"
+#include "oneflow/core/thread/thread_manager.h"
+#include "oneflow/core/thread/thread_pool.h"
 
 namespace oneflow {
 
+namespace {
+
+#define DEFINE_NAIVE_UPDATE_ROW_FUNC(suffix, target)                                            \
+  template<typename T>                                                                          \
+  target void NaiveUpdateRow##suffix(int64_t feature_size, T lr, const T* diff, T* model) {     \
+    for (int64_t j = 0; j < feature_size; ++j) { model[j] -= diff[j] * lr; }                    \
+  }
+
+DEFINE_NAIVE_UPDATE_ROW_FUNC(Scalar, )
+#if OF_CPU_ISA_DISPATCH_ENABLED
+DEFINE_NAIVE_UPDATE_ROW_FUNC(Avx2, OF_CPU_TARGET_AVX2)
+DEFINE_NAIVE_UPDATE_ROW_FUNC(Avx512, OF_CPU_TARGET_AVX512)
+#endif
+#undef DEFINE_NAIVE_UPDATE_ROW_FUNC
+
+template<typename T>
+void NaiveUpdateRow(int64_t feature_size, T lr, const T* diff, T* model) {
+#if OF_CPU_ISA_DISPATCH_ENABLED
+  switch (GetCpuIsa()) {
+    case CpuIsa::kAvx512: return NaiveUpdateRowAvx512(feature_size, lr, diff, model);
+    case CpuIsa::kAvx2: return NaiveUpdateRowAvx2(feature_size, lr, diff, model);
+    default: break;
+  }
+#endif
+  NaiveUpdateRowScalar(feature_size, lr, diff, model);
+}
+
+}  // namespace
+
 template<typename T, typename K>
 struct IndexedSlicesNaiveMdUpdateKernelUtil<DeviceType::kCPU, T, K> final {
   static void Update(DeviceCtx* ctx, const K* indices, const T* values, const float* learning_rate,
@@ -29,17 +62,31 @@ void IndexedSlicesNaiveMdUpdateKernelUtil<DeviceType::kCPU, T, K>::Update(
     DeviceCtx* ctx, const K* indices, const T* values, const float* learning_rate,
     int64_t num_indices, int64_t num_features, int64_t feature_size, int64_t feature_id_offset,
     T* model) {
-  FOR_RANGE(int64_t, i, 0, num_indices) {
-    const K feature_id = indices[i];
-    CHECK_GE(feature_id, 0);
-    const K local_feature_id = feature_id - feature_id_offset;
-    if (local_feature_id >= 0 && local_feature_id < num_features) {
-      const T* from = values + i * feature_size;
-      T* to = model + local_feature_id * feature_size;
-      for (int64_t j = 0; j < feature_size; ++j) { to[j] -= from[j] * (*learning_rate); }
+  const T lr = static_cast<T>(*learning_rate);
+  // The indices may repeat. Each task owns a range of model rows and applies, in order, every
+  // index that falls into it, so no two tasks write the same row. Every task scans all the
+  // indices, which bounds the task number by the thread number.
+  const int64_t thread_num =
+      Global<ThreadPool>::Get() == nullptr ? 1 : Global<ThreadPool>::Get()->thread_num();
+  const int64_t task_num = std::max<int64_t>(
+      std::min<int64_t>(thread_num, num_indices * feature_size / kCpuParallelGrainSize), 1);
+  const BalancedSplitter bs(num_features, task_num);
+  MultiThreadLoopInRange(task_num, 1, [&](int64_t begin, int64_t end) {
+    FOR_RANGE(int64_t, task_id, begin, end) {
+      const Range rows = bs.At(task_id);
+      FOR_RANGE(int64_t, i, 0, num_indices) {
+        const K feature_id = indices[i];
+        CHECK_GE(feature_id, 0);
+        const K local_feature_id = feature_id - feature_id_offset;
+        if (local_feature_id >= rows.begin() && local_feature_id < rows.end()) {
+          NaiveUpdateRow(feature_size, lr, values + i * feature_size,
+                         model + local_feature_id * feature_size);
+        }
+      }
     }
-  }
+  });
 }
+
 #define INITIATE_INDEXED_SLICES_NAIVE_MODEL_UPDATE_KERNEL_UTIL_GPU(in_type_pair, index_type_pair) \
   template struct IndexedSlicesNaiveMdUpdateKernelUtil<                                           \
       DeviceType::kCPU, OF_PP_PAIR_FIRST(in_type_pair), OF_PP_PAIR_FIRST(index_type_pair)>;
@@ -14,6 +14,7 @@ See the License for the specific language governing permissions and
 limitations under the License.
 */
 #include "oneflow/core/kernel/kernel_util.h"
+#include "oneflow/core/kernel/cpu_elementwise.h"
 #include "oneflow/core/common/balanced_splitter.h"
 #include "oneflow/core/register/register_manager.h"
 #include "oneflow/core/kernel/kernel.h"
@@ -367,10 +368,10 @@ KU_IF_METHOD Replicate(DeviceCtx* ctx, const int64_t n, T* y, const T* x) {
   for (int64_t i = 0; i < n; ++i) { y[i] = *x; }
 }
 KU_IF_METHOD AddByScalar(DeviceCtx* ctx, const int64_t n, const T* x, const T y, T* z) {
-  for (int64_t i = 0; i < n; ++i) { z[i] = x[i] + y; }
+  CpuElementwise(n, [y](T x_i) -> T { return x_i + y; }, z, x);
 }
 KU_IF_METHOD MulByScalarPara(DeviceCtx* ctx, const int64_t n, const T* x, const T y, T* z) {
-  for (int64_t i = 0; i < n; ++i) { z[i] = x[i] * y; }
+  CpuElementwise(n, [y](T x_i) -> T { return x_i * y; }, z, x);
 }
 
 #define KU_FLOATING_METHOD \
@@ -460,28 +461,28 @@ KU_FLOATING_METHOD Powx(DeviceCtx* ctx, const int64_t n, const T* x, const float
 }
 
 KU_FLOATING_METHOD Sigmoid(DeviceCtx* ctx, const int64_t n, const T* x, T* y) {
-  T half = static_cast<T>(0.5);
-  for (int64_t i = 0; i != n; ++i) { y[i] = half * std::tanh(half * x[i]) + half; }
+  const T half = static_cast<T>(0.5);
+  CpuElementwise(n, [half](T x_i) -> T { return half * std::tanh(half * x_i) + half; }, y, x);
 }
 KU_FLOATING_METHOD SigmoidBackward(DeviceCtx* ctx, const int64_t n, const T* x, const T* y,
                                    const T* dy, T* dx) {
-  for (int64_t i = 0; i != n; ++i) { dx[i] = y[i] * (1 - y[i]) * dy[i]; }
+  CpuElementwise(n, [](T y_i, T dy_i) -> T { return y_i * (1 - y_i) * dy_i; }, dx, y, dy);
 }
 KU_FLOATING_METHOD TanH(DeviceCtx* ctx, const int64_t n, const T* x, T* y) {
-  for (int64_t i = 0; i != n; ++i) { y[i] = std::tanh(x[i]); }
+  CpuElementwise(n, [](T x_i) -> T { return std::tanh(x_i); }, y, x);
 }
 KU_FLOATING_METHOD TanHBackward(DeviceCtx* ctx, const int64_t n, const T* x, const T* y,
                                 const T* dy, T* dx) {
-  for (int64_t i = 0; i != n; ++i) { dx[i] = (1 - y[i] * y[i]) * dy[i]; }
+  CpuElementwise(n, [](T y_i, T dy_i) -> T { return (1 - y_i * y_i) * dy_i; }, dx, y, dy);
 }
 KU_FLOATING_METHOD Relu(DeviceCtx* ctx, const int64_t n, const T* x, T* y) {
-  T zero = GetZeroVal<T>();
-  for (int64_t i = 0; i != n; ++i) { y[i] = std::max(x[i], zero); }
+  const T zero = GetZeroVal<T>();
+  CpuElementwise(n, [zero](T x_i) -> T { return std::max(x_i, zero); }, y, x);
 }
 KU_FLOATING_METHOD ReluBackward(DeviceCtx* ctx, const int64_t n, const T* x, const T* y,
                                 const T* dy, T* dx) {
-  T zero = GetZeroVal<T>();
-  for (int64_t i = 0; i != n; ++i) { dx[i] = (y[i] > zero) * dy[i]; }
+  const T zero = GetZeroVal<T>();
+  CpuElementwise(n, [zero](T y_i, T dy_i) -> T { return (y_i > zero) * dy_i; }, dx, y, dy);
 }
 KU_FLOATING_METHOD Addition(DeviceCtx* ctx, const int64_t n, T* out, const T* in_0) {
   for (int64_t i = 0; i != n; ++i) { out[i] = in_0[i]; }
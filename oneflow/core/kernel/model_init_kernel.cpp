@@ -48,22 +48,8 @@ class ModelInitKernel final : public KernelIf<DeviceType::kCPU> {
                           std::function<Blob*(const std::string&)> BnInOp2Blob) const override {
     const ModelInitOpConf& conf = this->op_conf().model_init_conf();
     const int64_t num_var = conf.out_size();
-    HashMap<std::string, std::unique_ptr<SnapshotReader>> path2snapshot_reader;
-    const auto GetSnapshotReader = [&](const std::string& path) -> SnapshotReader* {
-      auto it = path2snapshot_reader.find(path);
-      if (it != path2snapshot_reader.end()) {
-        return it->second.get();
-      } else {
-        SnapshotReader* snapshot = new SnapshotReader(path);
-        path2snapshot_reader[path].reset(snapshot);
-        return snapshot;
-      }
-    };
-    const auto InitializeWithSnapshot = [&](const std::string& snapshot_path,
-                                            const std::string& key, Blob* blob) {
-      SnapshotReader* reader = GetSnapshotReader(snapshot_path);
-      reader->Read(key, blob);
-    };
+    // snapshot variables are read together afterwards, so that they load in parallel
+    HashMap<std::string, std::vector<SnapshotReadRequest>> path2snapshot_read_requests;
     FOR_RANGE(int64_t, i, 0, num_var) {
       Blob* out_i = BnInOp2Blob(GenRepeatedBn("out", i));
       const VariableOpConf& original_variable_conf = conf.original_variable_conf(i);
@@ -78,12 +64,15 @@ class ModelInitKernel final : public KernelIf<DeviceType::kCPU> {
         const std::string key = original_variable_conf.initialize_with_snapshot().has_key()
                                     ? original_variable_conf.initialize_with_snapshot().key()
                                     : var_lbn;
-        InitializeWithSnapshot(original_variable_conf.initialize_with_snapshot().path(), key,
-                               out_i);
+        path2snapshot_read_requests[original_variable_conf.initialize_with_snapshot().path()]
+            .push_back(GenSnapshotReadRequest(key, out_i));
       } else {
         UNIMPLEMENTED();
       }
     }
+    for (const auto& pair : path2snapshot_read_requests) {
+      SnapshotReader(pair.first).Read(pair.second);
+    }
   }
 };
 
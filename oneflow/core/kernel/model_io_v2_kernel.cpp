@@ -339,6 +339,8 @@ class ModelSaveV2Kernel final : public KernelIf<device_type> {
     const std::string key = is_broadcast ? var_lbn : GetTmpPartKey(var_lbn, parallel_ctx);
     writer.Write(key, in_accessor.host_blob());
     if (!is_broadcast) {
+      // the parts are read back by parallel_id 0 after the barrier
+      writer.Flush();
       const int64_t parallel_num = parallel_ctx.parallel_num();
       Global<CtrlClient>::Get()->Barrier(
           snapshot_path + "-" + var_lbn + "-Counter-" + std::to_string(*counter_), parallel_num);
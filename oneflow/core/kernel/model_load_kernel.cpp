@@ -52,13 +52,14 @@ class ModelLoadKernel final : public KernelIf<DeviceType::kCPU> {
     const Blob* path_blob = BnInOp2Blob("path");
     const std::string path(path_blob->dptr<char>(), path_blob->shape_view().elem_cnt());
     SnapshotReader reader(path);
+    std::vector<SnapshotReadRequest> read_requests;
     FOR_RANGE(int64_t, i, 0, conf.out_size()) {
       const VariableOpConf& original_variable_conf = conf.original_variable_conf(i);
       Blob* out_i = BnInOp2Blob(GenRepeatedBn("out", i));
       const std::string key =
           GenLogicalBlobName(conf.variable_op_name(i), original_variable_conf.out());
       if (reader.HasKey(key)) {
-        reader.Read(key, out_i);
+        read_requests.push_back(GenSnapshotReadRequest(key, out_i));
       } else {
         std::cout << "WARNING! CANNOT find variable path in : " << JoinPath(path, key)
                   << ". It will be initialized. \n";
@@ -70,6 +71,7 @@ class ModelLoadKernel final : public KernelIf<DeviceType::kCPU> {
                                                          random_seed_gen(), out_i);
       }
     }
+    reader.Read(read_requests);
   }
 };
 
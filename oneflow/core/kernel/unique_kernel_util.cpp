@@ -14,9 +14,291 @@ See the License for the specific language governing permissions and
 limitations under the License.
 */
 #include "oneflow/core/kernel/unique_kernel_util.h"
+#include "oneflow/core/common/balanced_splitter.h"
+#include "oneflow/core/thread/thread_manager.h"
+#include <numeric>
 
 namespace oneflow {
 
+namespace {
+
+// Inputs are radix partitioned by key hash once they reach two partitions of this many keys.
+constexpr int64_t kUniquePartitionGrainSize = 16384;
+constexpr int64_t kMaxUniquePartitionBits = 6;
+
+template<typename T>
+struct Buffer final {
+  T* ptr = nullptr;
+  size_t size_in_bytes = 0;
+};
+
+template<typename T>
+int64_t GetTempBufferSize(int64_t n) {
+  return GetCudaAlignedSize(n * sizeof(T));
+}
+
+template<typename T>
+void AliasPtr(void* origin, int64_t* offset, Buffer<T>* buffer, int64_t size) {
+  auto* ptr = reinterpret_cast<unsigned char*>(origin);
+  if (buffer != nullptr) {
+    buffer->ptr = reinterpret_cast<T*>(ptr + *offset);
+    buffer->size_in_bytes = size;
+  }
+  *offset += size;
+}
+
+template<typename KEY, typename IDX>
+struct UniqueWorkspace final {
+  // the input positions grouped by partition, later the rank of every first appearance
+  Buffer<IDX> partitioned_pos;
+  // the open addressing tables of all partitions, at most 4n slots in total
+  Buffer<IDX> slots;
+  // per partition, its unique keys, their first positions (later their global indices) and counts
+  Buffer<KEY> local_keys;
+  Buffer<IDX> local_first_pos;
+  Buffer<IDX> local_counts;
+};
+
+template<typename KEY, typename IDX>
+void UniqueAliasWorkspace(int64_t n, bool with_counts, void* workspace,
+                          int64_t* workspace_size_in_bytes, UniqueWorkspace<KEY, IDX>* buffers) {
+  int64_t offset = 0;
+  AliasPtr(workspace, &offset, buffers == nullptr ? nullptr : &buffers->partitioned_pos,
+           GetTempBufferSize<IDX>(n));
+  AliasPtr(workspace, &offset, buffers == nullptr ? nullptr : &buffers->slots,
+           GetTempBufferSize<IDX>(4 * n));
+  AliasPtr(workspace, &offset, buffers == nullptr ? nullptr : &buffers->local_keys,
+           GetTempBufferSize<KEY>(n));
+  AliasPtr(workspace, &offset, buffers == nullptr ? nullptr : &buffers->local_first_pos,
+           GetTempBufferSize<IDX>(n));
+  if (with_counts) {
+    AliasPtr(workspace, &offset, buffers == nullptr ? nullptr : &buffers->local_counts,
+             GetTempBufferSize<IDX>(n));
+  }
+  *workspace_size_in_bytes = offset;
+}
+
+// -0 and 0 compare equal, so they must hash alike
+template<typename T>
+typename std::enable_if<std::is_floating_point<T>::value, T>::type NormalizeKey(T key) {
+  return key == 0 ? T(0) : key;
+}
+
+template<typename T>
+typename std::enable_if<!std::is_floating_point<T>::value, T>::type NormalizeKey(T key) {
+  return key;
+}
+
+// the murmur3 finalizer over the bits of the key
+template<typename KEY>
+uint64_t HashKey(KEY key) {
+  const KEY normalized = NormalizeKey(key);
+  uint64_t h = 0;
+  std::memcpy(&h, &normalized, sizeof(KEY));
+  h ^= h >> 33;
+  h *= 0xff51afd7ed558ccdULL;
+  h ^= h >> 33;
+  h *= 0xc4ceb9fe1a85ec53ULL;
+  h ^= h >> 33;
+  return h;
+}
+
+int64_t UniquePartitionBits(int64_t n) {
+  int64_t bits = 0;
+  while (bits < kMaxUniquePartitionBits && (kUniquePartitionGrainSize << (bits + 1)) <= n) {
+    ++bits;
+  }
+  return bits;
+}
+
+// the high bits of the hash pick the partition, the low bits the slot in its table
+int64_t PartitionOf(uint64_t hash, int64_t partition_bits) {
+  return partition_bits == 0 ? 0 : static_cast<int64_t>(hash >> (64 - partition_bits));
+}
+
+int64_t UniqueTableCapacity(int64_t num_keys) {
+  if (num_keys == 0) { return 0; }
+  int64_t capacity = 1;
+  while (capacity < 2 * num_keys) { capacity *= 2; }
+  return capacity;
+}
+
+// A flat open addressing table with linear probing. The slots hold indices into keys, the keys
+// are numbered in the order they are inserted.
+template<typename KEY, typename IDX>
+struct UniqueTable final {
+  IDX* slots;
+  int64_t capacity;
+  KEY* keys;
+  IDX* counts;
+  IDX size;
+
+  UniqueTable(IDX* slots, int64_t capacity, KEY* keys, IDX* counts)
+      : slots(slots), capacity(capacity), keys(keys), counts(counts), size(0) {
+    std::fill(slots, slots + capacity, -1);
+  }
+
+  // returns the index of key and whether it was inserted by this call
+  std::pair<IDX, bool> FindOrInsert(const KEY key, const uint64_t hash) {
+    int64_t slot = hash & (capacity - 1);
+    while (true) {
+      const IDX id = slots[slot];
+      if (id == -1) {
+        slots[slot] = size;
+        keys[size] = key;
+        if (counts != nullptr) { counts[size] = 1; }
+        size += 1;
+        return std::make_pair(size - 1, true);
+      }
+      if (keys[id] == key) {
+        if (counts != nullptr) { counts[id] += 1; }
+        return std::make_pair(id, false);
+      }
+      slot = (slot + 1) & (capacity - 1);
+    }
+  }
+};
+
+template<typename KEY, typename IDX>
+void SerialUnique(int64_t n, const KEY* in, IDX* num_unique, KEY* unique_out, IDX* idx_out,
+                  IDX* count, const UniqueWorkspace<KEY, IDX>& ws) {
+  UniqueTable<KEY, IDX> table(ws.slots.ptr, UniqueTableCapacity(n), unique_out, count);
+  FOR_RANGE(int64_t, i, 0, n) { idx_out[i] = table.FindOrInsert(in[i], HashKey(in[i])).first; }
+  *num_unique = table.size;
+}
+
+// Radix partitions the positions by key hash, so that every key lives in a single partition and
+// the partitions are made unique independently. Within a partition the positions keep the input
+// order, and the global index of a key is the number of unique keys first appearing before it,
+// so the result is the same as the serial one.
+template<typename KEY, typename IDX>
+void PartitionedUnique(int64_t n, int64_t partition_bits, const KEY* in, IDX* num_unique,
+                       KEY* unique_out, IDX* idx_out, IDX* count,
+                       const UniqueWorkspace<KEY, IDX>& ws) {
+  const int64_t partition_num = int64_t(1) << partition_bits;
+  const int64_t chunk_num = partition_num;
+  const BalancedSplitter chunks(n, chunk_num);
+  IDX* partitioned_pos = ws.partitioned_pos.ptr;
+  IDX* local_first_pos = ws.local_first_pos.ptr;
+  IDX* local_counts = count == nullptr ? nullptr : ws.local_counts.ptr;
+
+  // the histogram of every chunk, turned into the scatter offset of every (chunk, partition)
+  std::vector<int64_t> chunk_partition_offset(chunk_num * partition_num, 0);
+  MultiThreadLoopInRange(chunk_num, 1, [&](int64_t begin, int64_t end) {
+    FOR_RANGE(int64_t, c, begin, end) {
+      int64_t* hist = chunk_partition_offset.data() + c * partition_num;
+      const Range range = chunks.At(c);
+      FOR_RANGE(int64_t, i, range.begin(), range.end()) {
+        hist[PartitionOf(HashKey(in[i]), partition_bits)] += 1;
+      }
+    }
+  });
+  std::vector<int64_t> partition_offset(partition_num + 1, 0);
+  int64_t offset = 0;
+  FOR_RANGE(int64_t, p, 0, partition_num) {
+    partition_offset[p] = offset;
+    FOR_RANGE(int64_t, c, 0, chunk_num) {
+      const int64_t cnt = chunk_partition_offset[c * partition_num + p];
+      chunk_partition_offset[c * partition_num + p] = offset;
+      offset += cnt;
+    }
+  }
+  partition_offset[partition_num] = offset;
+  MultiThreadLoopInRange(chunk_num, 1, [&](int64_t begin, int64_t end) {
+    FOR_RANGE(int64_t, c, begin, end) {
+      int64_t* pos_offset = chunk_partition_offset.data() + c * partition_num;
+      const Range range = chunks.At(c);
+      FOR_RANGE(int64_t, i, range.begin(), range.end()) {
+        partitioned_pos[pos_offset[PartitionOf(HashKey(in[i]), partition_bits)]++] = i;
+      }
+    }
+  });
+
+  // every partition owns a table and n local slots from its partition offset on, idx_out gets
+  // the partition local indices for now
+  std::vector<int64_t> slot_offset(partition_num + 1, 0);
+  FOR_RANGE(int64_t, p, 0, partition_num) {
+    slot_offset[p + 1] =
+        slot_offset[p] + UniqueTableCapacity(partition_offset[p + 1] - partition_offset[p]);
+  }
+  CHECK_LE(slot_offset[partition_num] * sizeof(IDX), ws.slots.size_in_bytes);
+  std::vector<int64_t> partition_unique_num(partition_num, 0);
+  MultiThreadLoopInRange(partition_num, 1, [&](int64_t begin, int64_t end) {
+    FOR_RANGE(int64_t, p, begin, end) {
+      const int64_t local_offset = partition_offset[p];
+      IDX* counts = local_counts == nullptr ? nullptr : local_counts + local_offset;
+      UniqueTable<KEY, IDX> table(ws.slots.ptr + slot_offset[p],
+                                  slot_offset[p + 1] - slot_offset[p],
+                                  ws.local_keys.ptr + local_offset, counts);
+      FOR_RANGE(int64_t, j, partition_offset[p], partition_offset[p + 1]) {
+        const IDX i = partitioned_pos[j];
+        const std::pair<IDX, bool> found = table.FindOrInsert(in[i], HashKey(in[i]));
+        if (found.second) { local_first_pos[local_offset + found.first] = i; }
+        idx_out[i] = found.first;
+      }
+      partition_unique_num[p] = table.size;
+    }
+  });
+
+  // partitioned_pos becomes a flag per position, set on first appearances, then their rank
+  MultiThreadLoopInRange(chunk_num, 1, [&](int64_t begin, int64_t end) {
+    FOR_RANGE(int64_t, c, begin, end) {
+      const Range range = chunks.At(c);
+      std::fill(partitioned_pos + range.begin(), partitioned_pos + range.end(), 0);
+    }
+  });
+  MultiThreadLoopInRange(partition_num, 1, [&](int64_t begin, int64_t end) {
+    FOR_RANGE(int64_t, p, begin, end) {
+      const IDX* first_pos = local_first_pos + partition_offset[p];
+      FOR_RANGE(int64_t, u, 0, partition_unique_num[p]) { partitioned_pos[first_pos[u]] = 1; }
+    }
+  });
+  std::vector<int64_t> chunk_unique_offset(chunk_num + 1, 0);
+  MultiThreadLoopInRange(chunk_num, 1, [&](int64_t begin, int64_t end) {
+    FOR_RANGE(int64_t, c, begin, end) {
+      const Range range = chunks.At(c);
+      chunk_unique_offset[c + 1] =
+          std::accumulate(partitioned_pos + range.begin(), partitioned_pos + range.end(),
+                          int64_t(0));
+    }
+  });
+  FOR_RANGE(int64_t, c, 0, chunk_num) { chunk_unique_offset[c + 1] += chunk_unique_offset[c]; }
+  MultiThreadLoopInRange(chunk_num, 1, [&](int64_t begin, int64_t end) {
+    FOR_RANGE(int64_t, c, begin, end) {
+      const Range range = chunks.At(c);
+      IDX rank = chunk_unique_offset[c];
+      FOR_RANGE(int64_t, i, range.begin(), range.end()) {
+        if (partitioned_pos[i] != 0) { partitioned_pos[i] = rank++; }
+      }
+    }
+  });
+  *num_unique = chunk_unique_offset[chunk_num];
+
+  // scatter the unique keys to their global indices and remap idx_out
+  MultiThreadLoopInRange(partition_num, 1, [&](int64_t begin, int64_t end) {
+    FOR_RANGE(int64_t, p, begin, end) {
+      const int64_t local_offset = partition_offset[p];
+      FOR_RANGE(int64_t, u, local_offset, local_offset + partition_unique_num[p]) {
+        const IDX global_id = partitioned_pos[local_first_pos[u]];
+        unique_out[global_id] = ws.local_keys.ptr[u];
+        if (count != nullptr) { count[global_id] = local_counts[u]; }
+        local_first_pos[u] = global_id;
+      }
+    }
+  });
+  MultiThreadLoopInRange(chunk_num, 1, [&](int64_t begin, int64_t end) {
+    FOR_RANGE(int64_t, c, begin, end) {
+      const Range range = chunks.At(c);
+      FOR_RANGE(int64_t, i, range.begin(), range.end()) {
+        const int64_t p = PartitionOf(HashKey(in[i]), partition_bits);
+        idx_out[i] = local_first_pos[partition_offset[p] + idx_out[i]];
+      }
+    }
+  });
+}
+
+}  // namespace
+
 template<typename KEY, typename IDX>
 struct UniqueKernelUtil<DeviceType::kCPU, KEY, IDX> {
   static void Unique(DeviceCtx* ctx, int64_t n, const KEY* in, IDX* num_unique, KEY* unique_out,
@@ -27,31 +309,29 @@ struct UniqueKernelUtil<DeviceType::kCPU, KEY, IDX> {
   static void UniqueWithCounts(DeviceCtx* ctx, int64_t n, const KEY* in, IDX* num_unique,
                                KEY* unique_out, IDX* idx_out, IDX* count, void* workspace,
                                int64_t workspace_size_in_bytes) {
-    HashMap<KEY, IDX> map;
-    FOR_RANGE(int64_t, i, 0, n) {
-      KEY in_i = in[i];
-      auto it = map.find(in_i);
-      if (it == map.end()) {
-        IDX idx = map.size();
-        if (count != nullptr) { count[idx] = 1; }
-        idx_out[i] = idx;
-        unique_out[idx] = in_i;
-        map[in_i] = idx;
-      } else {
-        IDX idx = it->second;
-        if (count != nullptr) { count[idx] += 1; }
-        idx_out[i] = idx;
-      }
+    if (n == 0) {
+      *num_unique = 0;
+      return;
+    }
+    UniqueWorkspace<KEY, IDX> ws;
+    int64_t rt_workspace_size;
+    UniqueAliasWorkspace<KEY, IDX>(n, count != nullptr, workspace, &rt_workspace_size, &ws);
+    CHECK_LE(rt_workspace_size, workspace_size_in_bytes);
+    const int64_t partition_bits = UniquePartitionBits(n);
+    if (partition_bits == 0) {
+      SerialUnique<KEY, IDX>(n, in, num_unique, unique_out, idx_out, count, ws);
+    } else {
+      PartitionedUnique<KEY, IDX>(n, partition_bits, in, num_unique, unique_out, idx_out, count,
+                                  ws);
     }
-    *num_unique = map.size();
   }
   static void GetUniqueWorkspaceSizeInBytes(DeviceCtx* ctx, int64_t n,
                                             int64_t* workspace_size_in_bytes) {
-    *workspace_size_in_bytes = 1;
+    UniqueAliasWorkspace<KEY, IDX>(n, false, nullptr, workspace_size_in_bytes, nullptr);
   }
   static void GetUniqueWithCountsWorkspaceSizeInBytes(DeviceCtx* ctx, int64_t n,
                                                       int64_t* workspace_size_in_bytes) {
-    *workspace_size_in_bytes = 1;
+    UniqueAliasWorkspace<KEY, IDX>(n, true, nullptr, workspace_size_in_bytes, nullptr);
   }
 };
 
@@ -0,0 +1,82 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include "oneflow/core/kernel/unique_kernel_util.h"
+#include <gtest/gtest.h>
+
+namespace oneflow {
+
+namespace test {
+
+namespace {
+
+template<typename KEY, typename IDX>
+void TestUniqueWithCounts(const std::vector<KEY>& in) {
+  const int64_t n = in.size();
+  int64_t workspace_size = 0;
+  UniqueKernelUtil<DeviceType::kCPU, KEY, IDX>::GetUniqueWithCountsWorkspaceSizeInBytes(
+      nullptr, n, &workspace_size);
+  std::vector<char> workspace(workspace_size);
+  std::vector<KEY> unique_out(n);
+  std::vector<IDX> idx_out(n);
+  std::vector<IDX> count(n);
+  IDX num_unique = -1;
+  UniqueKernelUtil<DeviceType::kCPU, KEY, IDX>::UniqueWithCounts(
+      nullptr, n, in.data(), &num_unique, unique_out.data(), idx_out.data(), count.data(),
+      workspace.data(), workspace_size);
+  HashMap<KEY, IDX> ref_map;
+  std::vector<IDX> ref_count;
+  FOR_RANGE(int64_t, i, 0, n) {
+    auto it = ref_map.find(in[i]);
+    if (it == ref_map.end()) {
+      it = ref_map.emplace(in[i], ref_count.size()).first;
+      ref_count.push_back(0);
+    }
+    ref_count.at(it->second) += 1;
+    ASSERT_EQ(idx_out[i], it->second);
+    ASSERT_EQ(unique_out[it->second], in[i]);
+  }
+  ASSERT_EQ(num_unique, static_cast<IDX>(ref_count.size()));
+  FOR_RANGE(int64_t, i, 0, num_unique) { ASSERT_EQ(count[i], ref_count[i]); }
+}
+
+}  // namespace
+
+TEST(UniqueKernelUtil, serial) {
+  std::vector<int32_t> in({5, 3, 5, -1, 3, 3, 7});
+  TestUniqueWithCounts<int32_t, int32_t>(in);
+}
+
+TEST(UniqueKernelUtil, partitioned_in_order_of_first_appearance) {
+  std::mt19937 gen(0);
+  std::vector<int64_t> in(1000003);
+  for (int64_t& key : in) { key = gen() % 300000; }
+  TestUniqueWithCounts<int64_t, int32_t>(in);
+}
+
+TEST(UniqueKernelUtil, float_signed_zero) {
+  std::mt19937 gen(1);
+  std::vector<float> in(100000);
+  for (float& key : in) { key = static_cast<float>(gen() % 64) - 32.0f; }
+  in[7] = -0.0f;
+  in[11] = 0.0f;
+  TestUniqueWithCounts<float, int64_t>(in);
+}
+
+TEST(UniqueKernelUtil, empty) { TestUniqueWithCounts<int64_t, int64_t>(std::vector<int64_t>()); }
+
+}  // namespace test
+
+}  // namespace oneflow
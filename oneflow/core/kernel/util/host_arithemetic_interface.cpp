@@ -14,6 +14,7 @@ See the License for the specific language governing permissions and
 limitations under the License.
 */
 #include "oneflow/core/kernel/util/host_arithemetic_interface.h"
+#include "oneflow/core/kernel/cpu_elementwise.h"
 #include "oneflow/core/register/blob.h"
 #include "oneflow/core/operator/op_conf_util.h"
 
@@ -190,7 +191,7 @@ void ArithemeticIf<DeviceType::kCPU>::InitializeWithConstConf(
 #define MUL_BY_SCALAR(T)                                                                         \
   void ArithemeticIf<DeviceType::kCPU>::MulByScalar(DeviceCtx* ctx, const int64_t n, const T* x, \
                                                     const T y, T* z) {                           \
-    for (int64_t i = 0; i < n; ++i) { z[i] = x[i] * y; }                                         \
+    CpuElementwise(n, [y](T x_i) -> T { return x_i * y; }, z, x);                                \
   }
 
 MUL_BY_SCALAR(float);
@@ -203,7 +204,8 @@ MUL_BY_SCALAR(int64_t);
 #define MUL_BY_SCALAR_PTR(T)                                                            \
   void ArithemeticIf<DeviceType::kCPU>::MulByScalarPtr(DeviceCtx* ctx, const int64_t n, \
                                                        const T* x, const T* y, T* z) {  \
-    for (int64_t i = 0; i < n; ++i) { z[i] = x[i] * y[0]; }                             \
+    const T y_0 = y[0];                                                                 \
+    CpuElementwise(n, [y_0](T x_i) -> T { return x_i * y_0; }, z, x);                   \
   }
 
 MUL_BY_SCALAR_PTR(float);
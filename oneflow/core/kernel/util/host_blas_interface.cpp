@@ -15,6 +15,7 @@ limitations under the License.
 */
 #include "oneflow/core/kernel/util/host_blas_interface.h"
 #include "oneflow/core/register/blob.h"
+#include "oneflow/core/kernel/cpu_half_util.h"
 
 namespace oneflow {
 
@@ -66,6 +67,65 @@ void BatchedGemmImpl(DeviceCtx* ctx, const enum CBLAS_ORDER order,
   }
 }
 
+// Panels of the half gemm converted to float together, the three of them fit in L2.
+constexpr int kHGemmPanelM = 64;
+constexpr int kHGemmPanelN = 256;
+constexpr int kHGemmPanelK = 128;
+
+// Widens the rows [row_begin, row_begin + row_num) and the cols [col_begin, col_begin + col_num)
+// of a row major matrix with ld columns into a dense row major panel.
+void HalfPanelToFloat(const float16* x, int ld, int row_begin, int row_num, int col_begin,
+                      int col_num, float* panel) {
+  FOR_RANGE(int, i, 0, row_num) {
+    cpu_half_util::HalfToFloat(col_num, x + static_cast<int64_t>(row_begin + i) * ld + col_begin,
+                               panel + i * col_num);
+  }
+}
+
+// c = alpha * op(a) * op(b) + beta * c, blocked so that only panels of the operands are widened
+// to float at a time.
+void HGemmWithFloatImpl(DeviceCtx* ctx, const enum CBLAS_TRANSPOSE trans_a,
+                        const enum CBLAS_TRANSPOSE trans_b, int m, int n, int k, const float alpha,
+                        const float16* a, const float16* b, const float beta, float16* c,
+                        float* buf) {
+  float* a_panel = buf;
+  float* b_panel = a_panel + kHGemmPanelM * kHGemmPanelK;
+  float* c_panel = b_panel + kHGemmPanelK * kHGemmPanelN;
+  for (int i = 0; i < m; i += kHGemmPanelM) {
+    const int mb = std::min(kHGemmPanelM, m - i);
+    for (int j = 0; j < n; j += kHGemmPanelN) {
+      const int nb = std::min(kHGemmPanelN, n - j);
+      if (beta == 0) {
+        std::fill(c_panel, c_panel + mb * nb, 0.0f);
+      } else {
+        HalfPanelToFloat(c, n, i, mb, j, nb, c_panel);
+        FOR_RANGE(int, idx, 0, mb * nb) { c_panel[idx] *= beta; }
+      }
+      for (int p = 0; p < k; p += kHGemmPanelK) {
+        const int kb = std::min(kHGemmPanelK, k - p);
+        // the panels keep the layout of the operands, the float gemm transposes them
+        if (trans_a == CblasNoTrans) {
+          HalfPanelToFloat(a, k, i, mb, p, kb, a_panel);
+        } else {
+          HalfPanelToFloat(a, m, p, kb, i, mb, a_panel);
+        }
+        if (trans_b == CblasNoTrans) {
+          HalfPanelToFloat(b, n, p, kb, j, nb, b_panel);
+        } else {
+          HalfPanelToFloat(b, k, j, nb, p, kb, b_panel);
+        }
+        cblas_gemm<float>(CblasRowMajor, trans_a, trans_b, mb, nb, kb, alpha, a_panel,
+                          trans_a == CblasNoTrans ? kb : mb, b_panel,
+                          trans_b == CblasNoTrans ? nb : kb, 1.0f, c_panel, nb);
+      }
+      FOR_RANGE(int, row, 0, mb) {
+        cpu_half_util::FloatToHalf(nb, c_panel + row * nb,
+                                   c + static_cast<int64_t>(i + row) * n + j);
+      }
+    }
+  }
+}
+
 }  // namespace
 
 void BlasIf<DeviceType::kCPU>::BlobGemm(DeviceCtx* ctx, enum CBLAS_TRANSPOSE trans_a,
@@ -94,6 +154,18 @@ void BlasIf<DeviceType::kCPU>::OFGemm(DeviceCtx* ctx, enum CBLAS_TRANSPOSE trans
   Gemm<double>(ctx, CblasRowMajor, trans_a, trans_b, m, n, k, alpha, a, b, beta, c);
 }
 
+void BlasIf<DeviceType::kCPU>::OFHGemmWithFloat(DeviceCtx* ctx, enum CBLAS_TRANSPOSE trans_a,
+                                                enum CBLAS_TRANSPOSE trans_b, const int m,
+                                                const int n, const int k, const float alpha,
+                                                const float16* a, const float16* b,
+                                                const float beta, float16* c, float* buf) {
+  HGemmWithFloatImpl(ctx, trans_a, trans_b, m, n, k, alpha, a, b, beta, c, buf);
+}
+
+int64_t BlasIf<DeviceType::kCPU>::HGemmWithFloatBufElemCnt() {
+  return kHGemmPanelM * kHGemmPanelK + kHGemmPanelK * kHGemmPanelN + kHGemmPanelM * kHGemmPanelN;
+}
+
 void BlasIf<DeviceType::kCPU>::OFBatchedGemm(DeviceCtx* ctx, enum CBLAS_TRANSPOSE trans_a,
                                              enum CBLAS_TRANSPOSE trans_b, const int batch_size,
                                              const int m, const int n, const int k,
@@ -112,6 +184,19 @@ void BlasIf<DeviceType::kCPU>::OFBatchedGemm(DeviceCtx* ctx, enum CBLAS_TRANSPOS
                           beta, c, buf);
 }
 
+void BlasIf<DeviceType::kCPU>::OFBatchedHGemmWithFloat(
+    DeviceCtx* ctx, enum CBLAS_TRANSPOSE trans_a, enum CBLAS_TRANSPOSE trans_b,
+    const int batch_size, const int m, const int n, const int k, const float alpha,
+    const float16* a, const float16* b, const float beta, float16* c, float* buf) {
+  const int64_t a_stride = static_cast<int64_t>(m) * k;
+  const int64_t b_stride = static_cast<int64_t>(k) * n;
+  const int64_t c_stride = static_cast<int64_t>(m) * n;
+  FOR_RANGE(int32_t, i, 0, batch_size) {
+    HGemmWithFloatImpl(ctx, trans_a, trans_b, m, n, k, alpha, a + i * a_stride, b + i * b_stride,
+                       beta, c + i * c_stride, buf);
+  }
+}
+
 void BlasIf<DeviceType::kCPU>::Axpy(DeviceCtx* ctx, const int n, const float alpha, const float* x,
                                     const int incx, float* y, const int incy) {
   AxpyImpl<float>(ctx, n, alpha, x, incx, y, incy);
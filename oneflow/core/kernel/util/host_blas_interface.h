@@ -36,6 +36,15 @@ struct BlasIf<DeviceType::kCPU> {
   static void OFGemm(DeviceCtx* ctx, enum CBLAS_TRANSPOSE trans_a, enum CBLAS_TRANSPOSE trans_b,
                      const int m, const int n, const int k, const double alpha, const double* a,
                      const double* b, const double beta, double* c);
+  // float16 operands with float accumulation: panels of the operands are widened to float in
+  // buf, of HGemmWithFloatBufElemCnt() floats, multiplied with the float gemm and the result
+  // rounded back once.
+  static void OFHGemmWithFloat(DeviceCtx* ctx, enum CBLAS_TRANSPOSE trans_a,
+                               enum CBLAS_TRANSPOSE trans_b, const int m, const int n, const int k,
+                               const float alpha, const float16* a, const float16* b,
+                               const float beta, float16* c, float* buf);
+  static int64_t HGemmWithFloatBufElemCnt();
+
   static void OFBatchedGemm(DeviceCtx* ctx, enum CBLAS_TRANSPOSE trans_a,
                             enum CBLAS_TRANSPOSE trans_b, const int batch_size, const int m,
                             const int n, const int k, const float alpha, const float* a,
@@ -44,6 +53,11 @@ struct BlasIf<DeviceType::kCPU> {
                             enum CBLAS_TRANSPOSE trans_b, const int batch_size, const int m,
                             const int n, const int k, const double alpha, const double* a,
                             const double* b, const double beta, double* c, double** buf);
+  static void OFBatchedHGemmWithFloat(DeviceCtx* ctx, enum CBLAS_TRANSPOSE trans_a,
+                                      enum CBLAS_TRANSPOSE trans_b, const int batch_size,
+                                      const int m, const int n, const int k, const float alpha,
+                                      const float16* a, const float16* b, const float beta,
+                                      float16* c, float* buf);
 
   static void Axpy(DeviceCtx* ctx, const int n, const float alpha, const float* x, const int incx,
                    float* y, const int incy);
@@ -14,6 +14,7 @@ See the License for the specific language governing permissions and
 limitations under the License.
 */
 #include "oneflow/core/kernel/util/host_dnn_interface.h"
+#include "oneflow/core/kernel/cpu_elementwise.h"
 
 namespace oneflow {
 
@@ -21,38 +22,38 @@ namespace {
 
 template<typename T>
 static void ReluImpl(DeviceCtx* ctx, const int64_t n, const T* x, T* y) {
-  T zero = GetZeroVal<T>();
-  for (int64_t i = 0; i != n; ++i) { y[i] = std::max(x[i], zero); }
+  const T zero = GetZeroVal<T>();
+  CpuElementwise(n, [zero](T x_i) -> T { return std::max(x_i, zero); }, y, x);
 }
 
 template<typename T>
 static void ReluBackwardImpl(DeviceCtx* ctx, const int64_t n, const T* x, const T* y, const T* dy,
                              T* dx) {
-  T zero = GetZeroVal<T>();
-  for (int64_t i = 0; i != n; ++i) { dx[i] = (y[i] > zero) * dy[i]; }
+  const T zero = GetZeroVal<T>();
+  CpuElementwise(n, [zero](T y_i, T dy_i) -> T { return (y_i > zero) * dy_i; }, dx, y, dy);
 }
 
 template<typename T>
 static void SigmoidImpl(DeviceCtx* ctx, int64_t n, const T* x, T* y) {
-  T half = static_cast<T>(0.5);
-  for (int64_t i = 0; i != n; ++i) { y[i] = half * std::tanh(half * x[i]) + half; }
+  const T half = static_cast<T>(0.5);
+  CpuElementwise(n, [half](T x_i) -> T { return half * std::tanh(half * x_i) + half; }, y, x);
 }
 
 template<typename T>
 static void SigmoidBackwardImpl(DeviceCtx* ctx, const int64_t n, const T* x, const T* y,
                                 const T* dy, T* dx) {
-  for (int64_t i = 0; i != n; ++i) { dx[i] = y[i] * (1 - y[i]) * dy[i]; }
+  CpuElementwise(n, [](T y_i, T dy_i) -> T { return y_i * (1 - y_i) * dy_i; }, dx, y, dy);
 }
 
 template<typename T>
 static void TanHImpl(DeviceCtx* ctx, int64_t n, const T* x, T* y) {
-  for (int64_t i = 0; i != n; ++i) { y[i] = std::tanh(x[i]); }
+  CpuElementwise(n, [](T x_i) -> T { return std::tanh(x_i); }, y, x);
 }
 
 template<typename T>
 static void TanHBackwardImpl(DeviceCtx* ctx, const int64_t n, const T* x, const T* y, const T* dy,
                              T* dx) {
-  for (int64_t i = 0; i != n; ++i) { dx[i] = (1 - y[i] * y[i]) * dy[i]; }
+  CpuElementwise(n, [](T y_i, T dy_i) -> T { return (1 - y_i * y_i) * dy_i; }, dx, y, dy);
 }
 
 }  // namespace
@@ -15,28 +15,281 @@ limitations under the License.
 */
 #include "oneflow/core/common/data_type.h"
 #include "oneflow/core/common/preprocessor.h"
+#include "oneflow/core/common/balanced_splitter.h"
+#include "oneflow/core/common/cpu_isa.h"
 #include "oneflow/core/ndarray/ndarray_reduce_impl.h"
 #include "oneflow/core/ndarray/binary_func.h"
+#include "oneflow/core/thread/thread_manager.h"
 
 namespace oneflow {
 
-#define SPECIALIZE_CPU_NDARRAY_REDUCE_IMPL(struct_name)                                            \
-  template<typename T, template<typename> class binary_func>                                       \
-  struct struct_name<DeviceType::kCPU, T, binary_func> final {                                     \
-    static bool Matched(const XpuVarNdarray<T>& y, const XpuVarNdarray<const T>& x) {              \
-      return false;                                                                                \
-    }                                                                                              \
-    static void Reduce(DeviceCtx* ctx, const XpuVarNdarray<T>& y, const XpuVarNdarray<const T>& x, \
-                       const XpuVarNdarray<T>& tmp_storage) {                                      \
-      UNIMPLEMENTED();                                                                             \
-    }                                                                                              \
-  }
-SPECIALIZE_CPU_NDARRAY_REDUCE_IMPL(NdarrayScalarReduce);
-SPECIALIZE_CPU_NDARRAY_REDUCE_IMPL(NdarrayMatrixRowReduce);
-SPECIALIZE_CPU_NDARRAY_REDUCE_IMPL(NdarrayMatrixColReduce);
-SPECIALIZE_CPU_NDARRAY_REDUCE_IMPL(NdarrayXYZCubeYReduce);
-SPECIALIZE_CPU_NDARRAY_REDUCE_IMPL(NdarrayXYZCubeXZReduce);
-#undef SPECIALIZE_CPU_NDARRAY_REDUCE_IMPL
+namespace {
+
+// Upper bound of the tasks a reduction is split into. The split only depends on the shapes, so
+// the results do not depend on the number of threads.
+constexpr int64_t kMaxReduceTaskNum = 64;
+// Independent accumulators of a contiguous reduction, a 512 bit vector of float.
+constexpr int64_t kReduceLaneNum = 16;
+// Columns accumulated together by a column reduction, the accumulators stay in L1.
+constexpr int64_t kReduceColBlockSize = 1024;
+
+#define DEFINE_CPU_REDUCE_LOOPS(suffix, target)                                        \
+  template<typename T, template<typename> class binary_func>                           \
+  target T ReduceContiguous##suffix(const T* x, int64_t n) {                           \
+    T lanes[kReduceLaneNum];                                                           \
+    std::fill(lanes, lanes + kReduceLaneNum, UnitOfBinaryFunc<T, binary_func>::Val()); \
+    int64_t i = 0;                                                                     \
+    for (; i + kReduceLaneNum <= n; i += kReduceLaneNum) {                             \
+      for (int64_t l = 0; l < kReduceLaneNum; ++l) {                                   \
+        lanes[l] = binary_func<T>::Invoke(lanes[l], x[i + l]);                         \
+      }                                                                                \
+    }                                                                                  \
+    T reduced = UnitOfBinaryFunc<T, binary_func>::Val();                               \
+    for (; i < n; ++i) { reduced = binary_func<T>::Invoke(reduced, x[i]); }            \
+    for (int64_t l = 0; l < kReduceLaneNum; ++l) {                                     \
+      reduced = binary_func<T>::Invoke(reduced, lanes[l]);                             \
+    }                                                                                  \
+    return reduced;                                                                    \
+  }                                                                                    \
+                                                                                       \
+  template<typename T, template<typename> class binary_func>                           \
+  target void ReduceInto##suffix(T* acc, const T* x, int64_t n) {                      \
+    for (int64_t j = 0; j < n; ++j) { acc[j] = binary_func<T>::Invoke(acc[j], x[j]); } \
+  }
+
+DEFINE_CPU_REDUCE_LOOPS(Scalar, )
+#if OF_CPU_ISA_DISPATCH_ENABLED
+DEFINE_CPU_REDUCE_LOOPS(Avx2, OF_CPU_TARGET_AVX2)
+DEFINE_CPU_REDUCE_LOOPS(Avx512, OF_CPU_TARGET_AVX512)
+#endif
+#undef DEFINE_CPU_REDUCE_LOOPS
+
+// Reduces x[0, n) into one value.
+template<typename T, template<typename> class binary_func>
+T ReduceContiguous(const T* x, int64_t n) {
+#if OF_CPU_ISA_DISPATCH_ENABLED
+  switch (GetCpuIsa()) {
+    case CpuIsa::kAvx512: return ReduceContiguousAvx512<T, binary_func>(x, n);
+    case CpuIsa::kAvx2: return ReduceContiguousAvx2<T, binary_func>(x, n);
+    default: break;
+  }
+#endif
+  return ReduceContiguousScalar<T, binary_func>(x, n);
+}
+
+// Reduces x[j] into acc[j] for every j in [0, n).
+template<typename T, template<typename> class binary_func>
+void ReduceInto(T* acc, const T* x, int64_t n) {
+#if OF_CPU_ISA_DISPATCH_ENABLED
+  switch (GetCpuIsa()) {
+    case CpuIsa::kAvx512: return ReduceIntoAvx512<T, binary_func>(acc, x, n);
+    case CpuIsa::kAvx2: return ReduceIntoAvx2<T, binary_func>(acc, x, n);
+    default: break;
+  }
+#endif
+  ReduceIntoScalar<T, binary_func>(acc, x, n);
+}
+
+int64_t ReduceTaskNum(int64_t elem_cnt) {
+  return std::min(kMaxReduceTaskNum, std::max<int64_t>(1, elem_cnt / kCpuParallelGrainSize));
+}
+
+void ForEachReduceTask(int64_t elem_cnt, int64_t task_num,
+                       const std::function<void(int64_t task_id)>& Task) {
+  if (elem_cnt <= kCpuParallelGrainSize || task_num == 1) {
+    FOR_RANGE(int64_t, i, 0, task_num) { Task(i); }
+  } else {
+    MultiThreadLoopInRange(task_num, 1, [&](int64_t begin, int64_t end) {
+      FOR_RANGE(int64_t, i, begin, end) { Task(i); }
+    });
+  }
+}
+
+// Reduces each of the partial_num rows of partials, each holding n values, into y.
+template<typename T, template<typename> class binary_func>
+void ReducePartials(const T* partials, int64_t partial_num, int64_t n, T* y) {
+  std::copy(partials, partials + n, y);
+  FOR_RANGE(int64_t, i, 1, partial_num) { ReduceInto<T, binary_func>(y, partials + i * n, n); }
+}
+
+// y[i] = Reduce_j(x[i][j]) of a [num_rows, num_cols] x. Rows long enough to feed several tasks
+// are cut into chunks whose partial results are reduced afterwards.
+template<typename T, template<typename> class binary_func>
+void CpuRowReduce(int64_t num_rows, int64_t num_cols, const T* x, T* y) {
+  if (num_rows == 0) { return; }
+  const int64_t elem_cnt = num_rows * num_cols;
+  const int64_t task_num = ReduceTaskNum(elem_cnt);
+  const int64_t col_chunk_num = std::max<int64_t>(1, task_num / num_rows);
+  if (col_chunk_num == 1) {
+    const BalancedSplitter row_splitter(num_rows, std::min(num_rows, task_num));
+    ForEachReduceTask(elem_cnt, std::min(num_rows, task_num), [&](int64_t task_id) {
+      const Range rows = row_splitter.At(task_id);
+      FOR_RANGE(int64_t, i, rows.begin(), rows.end()) {
+        y[i] = ReduceContiguous<T, binary_func>(x + i * num_cols, num_cols);
+      }
+    });
+    return;
+  }
+  const BalancedSplitter col_splitter(num_cols, col_chunk_num);
+  std::vector<T> partials(num_rows * col_chunk_num);
+  ForEachReduceTask(elem_cnt, num_rows * col_chunk_num, [&](int64_t task_id) {
+    const int64_t i = task_id / col_chunk_num;
+    const Range cols = col_splitter.At(task_id % col_chunk_num);
+    partials[task_id] =
+        ReduceContiguous<T, binary_func>(x + i * num_cols + cols.begin(), cols.size());
+  });
+  FOR_RANGE(int64_t, i, 0, num_rows) {
+    y[i] = ReduceContiguous<T, binary_func>(partials.data() + i * col_chunk_num, col_chunk_num);
+  }
+}
+
+// y[b][j] = Reduce_i(x[b][i][j]) of a [batch_num, num_rows, num_cols] x. Tasks accumulate a
+// block of columns over a chunk of rows, walking each row contiguously.
+template<typename T, template<typename> class binary_func>
+void CpuColReduce(int64_t batch_num, int64_t num_rows, int64_t num_cols, const T* x, T* y) {
+  if (batch_num == 0 || num_cols == 0) { return; }
+  if (num_rows == 0) {
+    std::fill(y, y + batch_num * num_cols, UnitOfBinaryFunc<T, binary_func>::Val());
+    return;
+  }
+  const int64_t elem_cnt = batch_num * num_rows * num_cols;
+  const int64_t col_block_num = (num_cols + kReduceColBlockSize - 1) / kReduceColBlockSize;
+  const int64_t row_chunk_num = std::min(
+      num_rows, std::max<int64_t>(1, ReduceTaskNum(elem_cnt) / (batch_num * col_block_num)));
+  const BalancedSplitter row_splitter(num_rows, row_chunk_num);
+  std::vector<T> partials(row_chunk_num > 1 ? batch_num * row_chunk_num * num_cols : 0);
+  const int64_t tasks_per_batch = row_chunk_num * col_block_num;
+  ForEachReduceTask(elem_cnt, batch_num * tasks_per_batch, [&](int64_t task_id) {
+    const int64_t b = task_id / tasks_per_batch;
+    const int64_t row_chunk = task_id % tasks_per_batch / col_block_num;
+    const int64_t col_begin = task_id % col_block_num * kReduceColBlockSize;
+    const int64_t col_num = std::min(num_cols - col_begin, kReduceColBlockSize);
+    T* acc = (row_chunk_num == 1 ? y + b * num_cols
+                                 : partials.data() + (b * row_chunk_num + row_chunk) * num_cols)
+             + col_begin;
+    std::fill(acc, acc + col_num, UnitOfBinaryFunc<T, binary_func>::Val());
+    const Range rows = row_splitter.At(row_chunk);
+    const T* x_b = x + b * num_rows * num_cols + col_begin;
+    FOR_RANGE(int64_t, i, rows.begin(), rows.end()) {
+      ReduceInto<T, binary_func>(acc, x_b + i * num_cols, col_num);
+    }
+  });
+  if (row_chunk_num == 1) { return; }
+  FOR_RANGE(int64_t, b, 0, batch_num) {
+    ReducePartials<T, binary_func>(partials.data() + b * row_chunk_num * num_cols, row_chunk_num,
+                                   num_cols, y + b * num_cols);
+  }
+}
+
+// y[j] = Reduce_{i,k}(x[i][j][k]) of a [dim_x, dim_y, dim_z] x. Tasks own a range of j and a
+// chunk of i, each x[i][j] row is reduced contiguously.
+template<typename T, template<typename> class binary_func>
+void CpuXZReduce(int64_t dim_x, int64_t dim_y, int64_t dim_z, const T* x, T* y) {
+  if (dim_y == 0) { return; }
+  if (dim_x == 0) {
+    std::fill(y, y + dim_y, UnitOfBinaryFunc<T, binary_func>::Val());
+    return;
+  }
+  const int64_t elem_cnt = dim_x * dim_y * dim_z;
+  const int64_t task_num = ReduceTaskNum(elem_cnt);
+  const int64_t y_chunk_num = std::min(dim_y, task_num);
+  const int64_t x_chunk_num = std::min(dim_x, std::max<int64_t>(1, task_num / y_chunk_num));
+  const BalancedSplitter x_splitter(dim_x, x_chunk_num);
+  const BalancedSplitter y_splitter(dim_y, y_chunk_num);
+  std::vector<T> partials(x_chunk_num > 1 ? x_chunk_num * dim_y : 0);
+  ForEachReduceTask(elem_cnt, x_chunk_num * y_chunk_num, [&](int64_t task_id) {
+    const int64_t x_chunk = task_id / y_chunk_num;
+    const Range xs = x_splitter.At(x_chunk);
+    const Range ys = y_splitter.At(task_id % y_chunk_num);
+    T* acc = x_chunk_num == 1 ? y : partials.data() + x_chunk * dim_y;
+    std::fill(acc + ys.begin(), acc + ys.end(), UnitOfBinaryFunc<T, binary_func>::Val());
+    FOR_RANGE(int64_t, i, xs.begin(), xs.end()) {
+      FOR_RANGE(int64_t, j, ys.begin(), ys.end()) {
+        acc[j] = binary_func<T>::Invoke(
+            acc[j], ReduceContiguous<T, binary_func>(x + (i * dim_y + j) * dim_z, dim_z));
+      }
+    }
+  });
+  if (x_chunk_num > 1) { ReducePartials<T, binary_func>(partials.data(), x_chunk_num, dim_y, y); }
+}
+
+}  // namespace
+
+template<typename T, template<typename> class binary_func>
+struct NdarrayScalarReduce<DeviceType::kCPU, T, binary_func> final {
+  static bool Matched(const XpuVarNdarray<T>& y, const XpuVarNdarray<const T>& x) {
+    return y.shape().ElemNum() == 1;
+  }
+
+  static void Reduce(DeviceCtx* ctx, const XpuVarNdarray<T>& y, const XpuVarNdarray<const T>& x,
+                     const XpuVarNdarray<T>& tmp_storage) {
+    CHECK(Matched(y, x));
+    CpuRowReduce<T, binary_func>(1, x.shape().ElemNum(), x.ptr(), y.ptr());
+  }
+};
+
+template<typename T, template<typename> class binary_func>
+struct NdarrayMatrixRowReduce<DeviceType::kCPU, T, binary_func> final {
+  static bool Matched(const XpuVarNdarray<T>& y, const XpuVarNdarray<const T>& x) {
+    if (x.shape().NumAxes() != 2) { return false; }
+    if (y.shape().NumAxes() != 2) { return false; }
+    return x.shape().At(0) == y.shape().At(0) && y.shape().At(1) == 1;
+  }
+
+  static void Reduce(DeviceCtx* ctx, const XpuVarNdarray<T>& y, const XpuVarNdarray<const T>& x,
+                     const XpuVarNdarray<T>& tmp_storage) {
+    CHECK(Matched(y, x));
+    CpuRowReduce<T, binary_func>(x.shape().At(0), x.shape().At(1), x.ptr(), y.ptr());
+  }
+};
+
+template<typename T, template<typename> class binary_func>
+struct NdarrayMatrixColReduce<DeviceType::kCPU, T, binary_func> final {
+  static bool Matched(const XpuVarNdarray<T>& y, const XpuVarNdarray<const T>& x) {
+    if (x.shape().NumAxes() != 2) { return false; }
+    if (y.shape().NumAxes() != 2) { return false; }
+    return y.shape().At(0) == 1 && x.shape().At(1) == y.shape().At(1);
+  }
+
+  static void Reduce(DeviceCtx* ctx, const XpuVarNdarray<T>& y, const XpuVarNdarray<const T>& x,
+                     const XpuVarNdarray<T>& tmp_storage) {
+    CHECK(Matched(y, x));
+    CpuColReduce<T, binary_func>(1, x.shape().At(0), x.shape().At(1), x.ptr(), y.ptr());
+  }
+};
+
+template<typename T, template<typename> class binary_func>
+struct NdarrayXYZCubeYReduce<DeviceType::kCPU, T, binary_func> final {
+  static bool Matched(const XpuVarNdarray<T>& y, const XpuVarNdarray<const T>& x) {
+    if (x.shape().NumAxes() != 3) { return false; }
+    if (y.shape().NumAxes() != 3) { return false; }
+    return x.shape().At(0) == y.shape().At(0) && y.shape().At(1) == 1
+           && x.shape().At(2) == y.shape().At(2);
+  }
+
+  static void Reduce(DeviceCtx* ctx, const XpuVarNdarray<T>& y, const XpuVarNdarray<const T>& x,
+                     const XpuVarNdarray<T>& tmp_storage) {
+    CHECK(Matched(y, x));
+    CpuColReduce<T, binary_func>(x.shape().At(0), x.shape().At(1), x.shape().At(2), x.ptr(),
+                                 y.ptr());
+  }
+};
+
+template<typename T, template<typename> class binary_func>
+struct NdarrayXYZCubeXZReduce<DeviceType::kCPU, T, binary_func> final {
+  static bool Matched(const XpuVarNdarray<T>& y, const XpuVarNdarray<const T>& x) {
+    if (x.shape().NumAxes() != 3) { return false; }
+    if (y.shape().NumAxes() != 3) { return false; }
+    return y.shape().At(0) == 1 && x.shape().At(1) == y.shape().At(1) && y.shape().At(2) == 1;
+  }
+
+  static void Reduce(DeviceCtx* ctx, const XpuVarNdarray<T>& y, const XpuVarNdarray<const T>& x,
+                     const XpuVarNdarray<T>& tmp_storage) {
+    CHECK(Matched(y, x));
+    CpuXZReduce<T, binary_func>(x.shape().At(0), x.shape().At(1), x.shape().At(2), x.ptr(),
+                                y.ptr());
+  }
+};
 
 #define INSTANTIATE_NDARRAY_REDUCE_IMPL(dtype, binary_func)                                       \
   template struct NdarrayScalarReduce<DeviceType::kCPU, OF_PP_PAIR_FIRST(dtype), binary_func>;    \
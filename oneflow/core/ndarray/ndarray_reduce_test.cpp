@@ -0,0 +1,80 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include "oneflow/core/ndarray/ndarray_util.h"
+#include <gtest/gtest.h>
+
+namespace oneflow {
+
+namespace test {
+
+namespace {
+
+// Sums x of x_shape over the axes where y_shape is 1 and compares with NdarrayUtil::ReduceSum.
+void TestCpuReduceSum(const DimVector& x_dim_vec, const DimVector& y_dim_vec) {
+  const Shape x_shape(x_dim_vec);
+  const Shape y_shape(y_dim_vec);
+  std::vector<int64_t> x(x_shape.elem_cnt());
+  FOR_RANGE(int64_t, i, 0, x_shape.elem_cnt()) { x[i] = i % 7 - 3; }
+  std::vector<int64_t> y(y_shape.elem_cnt());
+  std::vector<int64_t> tmp(x_shape.elem_cnt());
+  NdarrayUtil<DeviceType::kCPU, int64_t>::ReduceSum(
+      nullptr, XpuVarNdarray<int64_t>(y_shape, y.data()),
+      XpuVarNdarray<const int64_t>(x_shape, x.data()),
+      XpuVarNdarray<int64_t>(x_shape, tmp.data()));
+  std::vector<int64_t> expected(y_shape.elem_cnt(), 0);
+  FOR_RANGE(int64_t, i, 0, x_shape.elem_cnt()) {
+    int64_t x_offset = i;
+    int64_t y_offset = 0;
+    int64_t y_stride = 1;
+    for (int64_t axis = x_shape.NumAxes() - 1; axis >= 0; --axis) {
+      const int64_t coord = x_offset % x_shape.At(axis);
+      x_offset /= x_shape.At(axis);
+      if (y_shape.At(axis) != 1) { y_offset += coord * y_stride; }
+      y_stride *= y_shape.At(axis);
+    }
+    expected[y_offset] += x[i];
+  }
+  ASSERT_TRUE(y == expected);
+}
+
+}  // namespace
+
+TEST(NdarrayReduce, cpu_scalar) { TestCpuReduceSum({3, 40000}, {1, 1}); }
+
+TEST(NdarrayReduce, cpu_matrix_row) {
+  TestCpuReduceSum({37, 1000}, {37, 1});
+  TestCpuReduceSum({3, 70000}, {3, 1});
+}
+
+TEST(NdarrayReduce, cpu_matrix_col) {
+  TestCpuReduceSum({1000, 37}, {1, 37});
+  TestCpuReduceSum({20, 3000}, {1, 3000});
+}
+
+TEST(NdarrayReduce, cpu_xyz_cube_y) { TestCpuReduceSum({4, 500, 33}, {4, 1, 33}); }
+
+TEST(NdarrayReduce, cpu_xyz_cube_xz) { TestCpuReduceSum({8, 16, 25, 25}, {1, 16, 1, 1}); }
+
+TEST(NdarrayReduce, cpu_empty_reduced_axes) {
+  TestCpuReduceSum({0, 37}, {1, 37});
+  TestCpuReduceSum({4, 0, 33}, {4, 1, 33});
+  TestCpuReduceSum({0, 16, 5}, {1, 16, 1});
+  TestCpuReduceSum({3, 0}, {3, 1});
+}
+
+}  // namespace test
+
+}  // namespace oneflow
@@ -70,6 +70,9 @@ class WritableFile {
   // persisted, depending on the implementation.
   virtual void Flush() = 0;
 
+  // Flush() and make the contents durable, so that they survive an OS or machine crash.
+  virtual void Sync() = 0;
+
  private:
 };
 
@@ -85,6 +85,11 @@ class PosixWritableFile : public WritableFile {
   }
 
   void Flush() override { PCHECK(fflush(file_) == 0) << "Fail to flush file " << fname_; }
+
+  void Sync() override {
+    Flush();
+    PCHECK(fsync(fileno(file_)) == 0) << "Fail to sync file " << fname_;
+  }
 };
 
 void PosixFileSystem::NewRandomAccessFile(const std::string& fname,
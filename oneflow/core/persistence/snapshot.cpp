@@ -15,23 +15,147 @@ limitations under the License.
 */
 #include "oneflow/core/persistence/snapshot.h"
 #include "oneflow/core/common/str_util.h"
-#include "oneflow/core/persistence/persistent_in_stream.h"
+#include "oneflow/core/job/job_set.pb.h"
 #include "oneflow/core/persistence/persistent_out_stream.h"
-#include "oneflow/core/register/tensor_slice_copier.h"
-#include "oneflow/core/device/cpu_device_context.h"
+#include "oneflow/core/persistence/snapshot_flusher.h"
+#include "oneflow/core/register/blob.h"
+#include "oneflow/core/thread/thread_manager.h"
+
+#ifdef PLATFORM_POSIX
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#endif  // PLATFORM_POSIX
 
 namespace oneflow {
 
 namespace {
 
+// runs closer than this are fetched with one read, the bytes in between are dropped
+constexpr int64_t kSnapshotReadMaxGapByte = 64 * 1024;
+constexpr int64_t kSnapshotReadMaxSpanByte = 64 * 1024 * 1024;
+constexpr int64_t kSnapshotCopyGrainByte = 4 * 1024 * 1024;
+
 std::string GenDataFilePath(const std::string& root, const std::string& key) {
   return JoinPath(root, key);
 }
 
+// The bytes of a row-major logical blob covered by a slice, as run_num() runs of run_byte_size()
+// bytes: one run per index of the axes in front of the innermost partially covered axis. Runs
+// are numbered in the order they are laid out in the slice.
+class SliceRuns final {
+ public:
+  SliceRuns(const Shape& logical_blob_shape, const TensorSliceView& slice, int64_t elem_size)
+      : run_num_(1), run_byte_size_(elem_size), base_offset_(0) {
+    const int64_t num_axes = logical_blob_shape.NumAxes();
+    if (num_axes == 0) { return; }
+    int64_t axis = num_axes - 1;
+    while (axis > 0 && slice.At(axis).size() == logical_blob_shape.At(axis)) { axis -= 1; }
+    const int64_t inner_byte_size = logical_blob_shape.Count(axis + 1) * elem_size;
+    run_byte_size_ = slice.At(axis).size() * inner_byte_size;
+    base_offset_ = slice.At(axis).begin() * inner_byte_size;
+    FOR_RANGE(int64_t, i, 0, axis) {
+      outer_ranges_.push_back(slice.At(i));
+      outer_strides_.push_back(logical_blob_shape.Count(i + 1) * elem_size);
+      run_num_ *= slice.At(i).size();
+    }
+  }
+
+  int64_t run_num() const { return run_num_; }
+  int64_t run_byte_size() const { return run_byte_size_; }
+  int64_t RunOffset(int64_t run_id) const {
+    int64_t offset = base_offset_;
+    for (int64_t i = outer_ranges_.size() - 1; i >= 0; --i) {
+      const Range& range = outer_ranges_.at(i);
+      offset += (range.begin() + run_id % range.size()) * outer_strides_.at(i);
+      run_id /= range.size();
+    }
+    return offset;
+  }
+
+ private:
+  int64_t run_num_;
+  int64_t run_byte_size_;
+  int64_t base_offset_;
+  std::vector<Range> outer_ranges_;
+  std::vector<int64_t> outer_strides_;
+};
+
+// Groups neighbouring runs into spans that are fetched by one RandomAccessFile::Read each.
+void ReadRunsFromFile(const std::string& path, const SliceRuns& runs, char* dst) {
+  std::unique_ptr<fs::RandomAccessFile> file;
+  SnapshotFS()->NewRandomAccessFile(path, &file);
+  const int64_t run_byte_size = runs.run_byte_size();
+  std::vector<int64_t> span_first_run_ids = {0};
+  FOR_RANGE(int64_t, i, 1, runs.run_num()) {
+    const int64_t span_begin = runs.RunOffset(span_first_run_ids.back());
+    const int64_t gap = runs.RunOffset(i) - (runs.RunOffset(i - 1) + run_byte_size);
+    const int64_t span_size = runs.RunOffset(i) + run_byte_size - span_begin;
+    if (gap > kSnapshotReadMaxGapByte || span_size > kSnapshotReadMaxSpanByte) {
+      span_first_run_ids.push_back(i);
+    }
+  }
+  span_first_run_ids.push_back(runs.run_num());
+  MultiThreadLoopInRange(span_first_run_ids.size() - 1, 1, [&](int64_t begin, int64_t end) {
+    std::vector<char> buffer;
+    FOR_RANGE(int64_t, span_id, begin, end) {
+      const int64_t first_run_id = span_first_run_ids.at(span_id);
+      const int64_t last_run_id = span_first_run_ids.at(span_id + 1) - 1;
+      const int64_t span_begin = runs.RunOffset(first_run_id);
+      if (first_run_id == last_run_id) {
+        file->Read(span_begin, run_byte_size, dst + first_run_id * run_byte_size);
+        continue;
+      }
+      buffer.resize(runs.RunOffset(last_run_id) + run_byte_size - span_begin);
+      file->Read(span_begin, buffer.size(), buffer.data());
+      FOR_RANGE(int64_t, run_id, first_run_id, last_run_id + 1) {
+        const char* src = buffer.data() + runs.RunOffset(run_id) - span_begin;
+        std::memcpy(dst + run_id * run_byte_size, src, run_byte_size);
+      }
+    }
+  });
+}
+
+#ifdef PLATFORM_POSIX
+
+// Copies the runs straight out of a read-only mapping, only the pages they touch are read.
+void ReadRunsFromMapping(const std::string& path, const SliceRuns& runs, int64_t file_size,
+                         char* dst) {
+  int fd = open(path.c_str(), O_RDONLY);
+  PCHECK(fd != -1) << "Fail to open " << path;
+  void* addr = mmap(nullptr, file_size, PROT_READ, MAP_SHARED, fd, 0);
+  PCHECK(addr != MAP_FAILED) << "Fail to mmap " << path;
+  PCHECK(close(fd) == 0);
+  const char* src = static_cast<const char*>(addr);
+  const int64_t run_byte_size = runs.run_byte_size();
+  const int64_t grain = std::max<int64_t>(kSnapshotCopyGrainByte / run_byte_size, 1);
+  MultiThreadLoopInRange(runs.run_num(), grain, [&](int64_t begin, int64_t end) {
+    FOR_RANGE(int64_t, run_id, begin, end) {
+      std::memcpy(dst + run_id * run_byte_size, src + runs.RunOffset(run_id), run_byte_size);
+    }
+  });
+  PCHECK(munmap(addr, file_size) == 0);
+}
+
+#endif  // PLATFORM_POSIX
+
 }  // namespace
 
+SnapshotReadRequest GenSnapshotReadRequest(const std::string& key, Blob* blob) {
+  SnapshotReadRequest request;
+  request.key = key;
+  blob->shape().ToShape(&request.logical_blob_shape);
+  request.data_type = blob->data_type();
+  request.slice = TensorSliceView(request.logical_blob_shape);
+  request.dst = blob->mut_dptr<char>();
+  return request;
+}
+
 SnapshotReader::SnapshotReader(const std::string& snapshot_root_path)
-    : root_path_(snapshot_root_path) {}
+    : SnapshotReader(snapshot_root_path, true) {}
+
+SnapshotReader::SnapshotReader(const std::string& snapshot_root_path, bool mmap_local_files)
+    : root_path_(snapshot_root_path), mmap_local_files_(mmap_local_files) {}
 
 bool SnapshotReader::HasKey(const std::string& key) const {
   const std::string path = GenDataFilePath(root_path_, key);
@@ -39,9 +163,8 @@ bool SnapshotReader::HasKey(const std::string& key) const {
 }
 
 void SnapshotReader::Read(const std::string& key, Blob* blob) const {
-  Shape shape;
-  blob->shape().ToShape(&shape);
-  Read(key, shape, blob->data_type(), TensorSliceView(shape), blob->mut_dptr<char>());
+  const SnapshotReadRequest request = GenSnapshotReadRequest(key, blob);
+  Read(request.key, request.logical_blob_shape, request.data_type, request.slice, request.dst);
 }
 
 void SnapshotReader::Read(const std::string& key, const Shape& logical_blob_shape,
@@ -52,20 +175,25 @@ void SnapshotReader::Read(const std::string& key, const Shape& logical_blob_shap
   const int64_t logical_blob_size = logical_blob_shape.elem_cnt() * GetSizeOfDataType(data_type);
   CHECK_EQ(SnapshotFS()->GetFileSize(path), logical_blob_size)
       << "unexpected model snapshot size, path: " << path;
-  if (slice.shape().Count(1) == logical_blob_shape.Count(1)) {
-    PersistentInStream in_stream(
-        SnapshotFS(), path,
-        slice.At(0).begin() * slice.shape().Count(1) * GetSizeOfDataType(data_type));
-    in_stream.ReadFully(dst, slice.shape().elem_cnt() * GetSizeOfDataType(data_type));
-  } else {
-    std::vector<char> buffer(logical_blob_size);
-    PersistentInStream in_stream(SnapshotFS(), path);
-    in_stream.ReadFully(buffer.data(), logical_blob_size);
-    TensorSliceCopier copier(slice, logical_blob_slice, data_type);
-    CpuDeviceCtx device_ctx;
-    std::unique_ptr<MemoryCopier> host_memory_copier(NewDefaultMemoryCopier(DeviceType::kCPU));
-    copier.Copy(&device_ctx, *host_memory_copier, dst, buffer.data());
+  const SliceRuns runs(logical_blob_shape, slice, GetSizeOfDataType(data_type));
+  if (runs.run_num() == 0 || runs.run_byte_size() == 0) { return; }
+#ifdef PLATFORM_POSIX
+  if (mmap_local_files_ && SnapshotFS() == LocalFS()) {
+    ReadRunsFromMapping(path, runs, logical_blob_size, dst);
+    return;
   }
+#endif  // PLATFORM_POSIX
+  ReadRunsFromFile(path, runs, dst);
+}
+
+void SnapshotReader::Read(const std::vector<SnapshotReadRequest>& requests) const {
+  MultiThreadLoopInRange(requests.size(), 1, [&](int64_t begin, int64_t end) {
+    FOR_RANGE(int64_t, i, begin, end) {
+      const SnapshotReadRequest& request = requests.at(i);
+      Read(request.key, request.logical_blob_shape, request.data_type, request.slice,
+           request.dst);
+    }
+  });
 }
 
 void SnapshotReader::Read(const std::string& key, const Shape& logical_blob_shape,
@@ -88,6 +216,9 @@ SnapshotWriter::SnapshotWriter(const std::string& snapshot_root_path)
       SnapshotFS()->CreateDir(snapshot_root_path);
     }
   });
+  if (Global<SnapshotFlusher>::Get() != nullptr) {
+    Global<SnapshotFlusher>::Get()->Open(snapshot_root_path);
+  }
 }
 
 void SnapshotWriter::Write(const std::string& key, const char* data, size_t size) {
@@ -95,16 +226,49 @@ void SnapshotWriter::Write(const std::string& key, const char* data, size_t size
   const std::string dir_path = Dirname(path);
   SnapshotFS()->CreateDirIfNotExist(dir_path);
   CHECK(!SnapshotFS()->FileExists(path));
-  PersistentOutStream out_stream(SnapshotFS(), path);
-  out_stream.Write(data, size);
+  if (Global<SnapshotFlusher>::Get() != nullptr) {
+    Global<SnapshotFlusher>::Get()->Write(root_path_, path, data, size);
+  } else {
+    PersistentOutStream out_stream(SnapshotFS(), path);
+    out_stream.Write(data, size);
+  }
 }
 
 void SnapshotWriter::Write(const std::string& key, const Blob* blob) {
   Write(key, blob->dptr<char>(), blob->ByteSizeOfBlobBody());
 }
 
+void SnapshotWriter::Flush() {
+  if (Global<SnapshotFlusher>::Get() != nullptr) {
+    Global<SnapshotFlusher>::Get()->WaitFlushed(root_path_);
+  }
+}
+
 void SnapshotWriter::Close() {
-  PersistentOutStream out_stream(SnapshotFS(), JoinPath(root_path_, "snapshot_done"));
+  if (Global<SnapshotFlusher>::Get() != nullptr) {
+    Global<SnapshotFlusher>::Get()->Close(root_path_);
+  } else {
+    PersistentOutStream out_stream(SnapshotFS(), JoinPath(root_path_, "snapshot_done"));
+  }
+}
+
+bool IsSnapshotDone(const std::string& snapshot_root_path) {
+  if (Global<SnapshotFlusher>::Get() != nullptr
+      && !Global<SnapshotFlusher>::Get()->IsDone(snapshot_root_path)) {
+    return false;
+  }
+  return SnapshotFS()->FileExists(JoinPath(snapshot_root_path, "snapshot_done"));
+}
+
+void WaitForSnapshot(const std::string& snapshot_root_path) {
+  SnapshotFlusher* flusher = Global<SnapshotFlusher>::Get();
+  if (flusher == nullptr) { return; }
+  if (Global<const IOConf>::Get()->enable_model_io_v2()) {
+    // the model io v2 kernels write their variables without closing the snapshot
+    flusher->WaitFlushed(snapshot_root_path);
+  } else {
+    flusher->WaitDone(snapshot_root_path);
+  }
 }
 
 }  // namespace oneflow
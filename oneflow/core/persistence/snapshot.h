@@ -24,11 +24,25 @@ namespace oneflow {
 
 class Blob;
 
+struct SnapshotReadRequest {
+  std::string key;
+  Shape logical_blob_shape;
+  DataType data_type;
+  TensorSliceView slice;
+  char* dst;
+};
+
+// a request reading the whole blob stored under key
+SnapshotReadRequest GenSnapshotReadRequest(const std::string& key, Blob* blob);
+
 class SnapshotReader final {
  public:
   OF_DISALLOW_COPY_AND_MOVE(SnapshotReader);
   SnapshotReader() = delete;
   explicit SnapshotReader(const std::string& snapshot_root_path);
+  // the slices of a snapshot on the local file system are copied out of a read-only mapping
+  // unless mmap_local_files is false, the others are read in spans of neighbouring runs
+  SnapshotReader(const std::string& snapshot_root_path, bool mmap_local_files);
   ~SnapshotReader() = default;
 
   void Read(const std::string& key, const Shape& logical_blob_shape, DataType data_type,
@@ -36,11 +50,14 @@ class SnapshotReader final {
   void Read(const std::string& key, const Shape& logical_blob_shape, const TensorSliceView& slice,
             Blob* blob) const;
   void Read(const std::string& key, Blob* blob) const;
+  // serves the requests concurrently on the global ThreadPool
+  void Read(const std::vector<SnapshotReadRequest>& requests) const;
   bool HasKey(const std::string& key) const;
   void Close();
 
  private:
   const std::string root_path_;
+  const bool mmap_local_files_;
 };
 
 class SnapshotWriter final {
@@ -50,14 +67,25 @@ class SnapshotWriter final {
   explicit SnapshotWriter(const std::string& snapshot_root_path);
   ~SnapshotWriter() = default;
 
+  // with a global SnapshotFlusher the data is staged and written in the background, and Close
+  // returns before "snapshot_done" is written
   void Write(const std::string& key, const char* data, size_t size);
   void Write(const std::string& key, const Blob* blob);
+  // blocks until every write under the snapshot root is on the file system
+  void Flush();
   void Close();
 
  private:
   const std::string root_path_;
 };
 
+// true once the snapshot is closed and all its writes of this process are durable
+bool IsSnapshotDone(const std::string& snapshot_root_path);
+// Blocks until the writes of this process under the snapshot are durable and, unless model io v2
+// saved it, its "snapshot_done" is written. The job saving the snapshot has to have started its
+// writers already, a snapshot this process does not know of counts as done.
+void WaitForSnapshot(const std::string& snapshot_root_path);
+
 }  // namespace oneflow
 
 #endif  // ONEFLOW_CORE_PERSISTENCE_SNAPSHOT_H_
@@ -0,0 +1,190 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include "oneflow/core/persistence/snapshot_flusher.h"
+#include "oneflow/core/common/str_util.h"
+
+namespace oneflow {
+
+namespace {
+
+constexpr int64_t kSnapshotFlushBatchMaxByte = 64 * 1024 * 1024;
+constexpr size_t kSnapshotFlushBatchMaxFileNum = 64;
+
+}  // namespace
+
+SnapshotFlusher::SnapshotFlusher(fs::FileSystem* fs, int32_t thread_num, int64_t max_staging_byte)
+    : fs_(fs), max_staging_byte_(max_staging_byte), staging_byte_(0), is_closed_(false) {
+  CHECK_GT(thread_num, 0);
+  CHECK_GT(max_staging_byte, 0);
+  FOR_RANGE(int32_t, i, 0, thread_num) {
+    threads_.emplace_back(&SnapshotFlusher::FlushLoop, this);
+  }
+}
+
+SnapshotFlusher::~SnapshotFlusher() {
+  WaitAllFlushed();
+  {
+    std::unique_lock<std::mutex> lock(mutex_);
+    is_closed_ = true;
+  }
+  write_cond_.notify_all();
+  for (std::thread& thread : threads_) { thread.join(); }
+}
+
+void SnapshotFlusher::Open(const std::string& root_path) {
+  std::unique_lock<std::mutex> lock(mutex_);
+  CHECK(!root_path2state_[root_path].closed) << "snapshot " << root_path << " is already closed";
+}
+
+void SnapshotFlusher::Write(const std::string& root_path, const std::string& file_path,
+                            const char* data, size_t size) {
+  StagedWrite staged_write;
+  staged_write.root_path = root_path;
+  staged_write.file_path = file_path;
+  std::unique_lock<std::mutex> lock(mutex_);
+  // a write larger than the limit still goes through once nothing else is staged
+  flushed_cond_.wait(lock, [&]() {
+    return staging_byte_ == 0 || staging_byte_ + static_cast<int64_t>(size) <= max_staging_byte_;
+  });
+  RootState& state = root_path2state_[root_path];
+  CHECK(!state.closed) << "snapshot " << root_path << " is already closed";
+  state.pending_cnt += 1;
+  staging_byte_ += size;
+  lock.unlock();
+  staged_write.data.assign(data, size);
+  lock.lock();
+  staged_writes_.push_back(std::move(staged_write));
+  write_cond_.notify_one();
+}
+
+void SnapshotFlusher::Close(const std::string& root_path) {
+  {
+    std::unique_lock<std::mutex> lock(mutex_);
+    RootState& state = root_path2state_[root_path];
+    CHECK(!state.closed) << "snapshot " << root_path << " is already closed";
+    state.closed = true;
+    if (state.pending_cnt > 0) { return; }
+  }
+  WriteSnapshotDone(root_path);
+  {
+    std::unique_lock<std::mutex> lock(mutex_);
+    root_path2state_.erase(root_path);
+  }
+  flushed_cond_.notify_all();
+}
+
+bool SnapshotFlusher::IsIdle(const RootState& state) const {
+  return state.pending_cnt == 0 && !state.closed;
+}
+
+bool SnapshotFlusher::IsFlushed(const std::string& root_path) {
+  std::unique_lock<std::mutex> lock(mutex_);
+  auto it = root_path2state_.find(root_path);
+  return it == root_path2state_.end() || it->second.pending_cnt == 0;
+}
+
+void SnapshotFlusher::WaitFlushed(const std::string& root_path) {
+  std::unique_lock<std::mutex> lock(mutex_);
+  flushed_cond_.wait(lock, [&]() {
+    auto it = root_path2state_.find(root_path);
+    return it == root_path2state_.end() || it->second.pending_cnt == 0;
+  });
+}
+
+bool SnapshotFlusher::IsDone(const std::string& root_path) {
+  std::unique_lock<std::mutex> lock(mutex_);
+  return root_path2state_.find(root_path) == root_path2state_.end();
+}
+
+void SnapshotFlusher::WaitDone(const std::string& root_path) {
+  std::unique_lock<std::mutex> lock(mutex_);
+  flushed_cond_.wait(lock,
+                     [&]() { return root_path2state_.find(root_path) == root_path2state_.end(); });
+}
+
+void SnapshotFlusher::WaitAllFlushed() {
+  std::unique_lock<std::mutex> lock(mutex_);
+  flushed_cond_.wait(lock, [&]() {
+    for (const auto& pair : root_path2state_) {
+      if (!IsIdle(pair.second)) { return false; }
+    }
+    return true;
+  });
+}
+
+void SnapshotFlusher::FlushLoop() {
+  while (true) {
+    std::vector<StagedWrite> batch;
+    {
+      std::unique_lock<std::mutex> lock(mutex_);
+      write_cond_.wait(lock, [&]() { return is_closed_ || !staged_writes_.empty(); });
+      if (staged_writes_.empty()) { return; }
+      int64_t batch_byte = 0;
+      while (!staged_writes_.empty() && batch.size() < kSnapshotFlushBatchMaxFileNum) {
+        const int64_t byte_size = staged_writes_.front().data.size();
+        if (!batch.empty() && batch_byte + byte_size > kSnapshotFlushBatchMaxByte) { break; }
+        batch_byte += byte_size;
+        batch.push_back(std::move(staged_writes_.front()));
+        staged_writes_.pop_front();
+      }
+    }
+    FlushBatch(batch);
+    std::vector<std::string> done_root_paths;
+    {
+      std::unique_lock<std::mutex> lock(mutex_);
+      for (const StagedWrite& staged_write : batch) {
+        staging_byte_ -= staged_write.data.size();
+        auto it = root_path2state_.find(staged_write.root_path);
+        CHECK(it != root_path2state_.end());
+        it->second.pending_cnt -= 1;
+        // a snapshot not closed yet may have more writes coming, it stays tracked
+        if (it->second.pending_cnt == 0 && it->second.closed) {
+          done_root_paths.push_back(staged_write.root_path);
+        }
+      }
+    }
+    for (const std::string& root_path : done_root_paths) { WriteSnapshotDone(root_path); }
+    if (!done_root_paths.empty()) {
+      std::unique_lock<std::mutex> lock(mutex_);
+      for (const std::string& root_path : done_root_paths) { root_path2state_.erase(root_path); }
+    }
+    flushed_cond_.notify_all();
+  }
+}
+
+void SnapshotFlusher::FlushBatch(const std::vector<StagedWrite>& batch) {
+  std::vector<std::unique_ptr<fs::WritableFile>> files(batch.size());
+  FOR_RANGE(size_t, i, 0, batch.size()) {
+    fs_->NewWritableFile(batch.at(i).file_path, &files.at(i));
+    files.at(i)->Append(batch.at(i).data.data(), batch.at(i).data.size());
+    files.at(i)->Flush();
+  }
+  // sync only after every file of the batch is handed to the file system, so that their write
+  // back overlaps instead of paying one round trip to the disk per file
+  for (std::unique_ptr<fs::WritableFile>& file : files) {
+    file->Sync();
+    file->Close();
+  }
+}
+
+void SnapshotFlusher::WriteSnapshotDone(const std::string& root_path) {
+  std::unique_ptr<fs::WritableFile> file;
+  fs_->NewWritableFile(JoinPath(root_path, "snapshot_done"), &file);
+  file->Sync();
+  file->Close();
+}
+
+}  // namespace oneflow
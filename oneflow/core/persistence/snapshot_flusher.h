@@ -0,0 +1,83 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#ifndef ONEFLOW_CORE_PERSISTENCE_SNAPSHOT_FLUSHER_H_
+#define ONEFLOW_CORE_PERSISTENCE_SNAPSHOT_FLUSHER_H_
+
+#include <deque>
+#include "oneflow/core/common/util.h"
+#include "oneflow/core/persistence/file_system.h"
+
+namespace oneflow {
+
+// Writes snapshot files in the background. Write copies the data into a staging buffer and
+// returns; flush threads drain the staged writes in batches, appending every file of a batch
+// before syncing any of them. Close marks a snapshot complete, its "snapshot_done" file is written
+// once every write under the snapshot root is durable. Write blocks while the staged bytes exceed
+// max_staging_byte. A snapshot is tracked from Open or its first Write until "snapshot_done" is
+// written, so IsDone does not mistake a gap between writes for the end of the snapshot.
+class SnapshotFlusher final {
+ public:
+  OF_DISALLOW_COPY_AND_MOVE(SnapshotFlusher);
+  SnapshotFlusher() = delete;
+  SnapshotFlusher(fs::FileSystem* fs, int32_t thread_num, int64_t max_staging_byte);
+  ~SnapshotFlusher();
+
+  void Open(const std::string& root_path);
+  void Write(const std::string& root_path, const std::string& file_path, const char* data,
+             size_t size);
+  void Close(const std::string& root_path);
+  // true when nothing is staged or being flushed under root_path
+  bool IsFlushed(const std::string& root_path);
+  void WaitFlushed(const std::string& root_path);
+  // true when root_path is closed and its "snapshot_done" is durable, or was never opened
+  bool IsDone(const std::string& root_path);
+  void WaitDone(const std::string& root_path);
+  // blocks until nothing is staged or being flushed, and every closed snapshot is done
+  void WaitAllFlushed();
+
+ private:
+  struct StagedWrite {
+    std::string root_path;
+    std::string file_path;
+    std::string data;
+  };
+  struct RootState {
+    int64_t pending_cnt = 0;
+    bool closed = false;
+  };
+
+  // nothing staged, being flushed or waiting for its "snapshot_done"
+  bool IsIdle(const RootState& state) const;
+  void FlushLoop();
+  void FlushBatch(const std::vector<StagedWrite>& batch);
+  void WriteSnapshotDone(const std::string& root_path);
+
+  fs::FileSystem* fs_;
+  const int64_t max_staging_byte_;
+  std::vector<std::thread> threads_;
+
+  std::mutex mutex_;
+  std::condition_variable write_cond_;
+  std::condition_variable flushed_cond_;
+  std::deque<StagedWrite> staged_writes_;
+  HashMap<std::string, RootState> root_path2state_;
+  int64_t staging_byte_;
+  bool is_closed_;
+};
+
+}  // namespace oneflow
+
+#endif  // ONEFLOW_CORE_PERSISTENCE_SNAPSHOT_FLUSHER_H_
@@ -0,0 +1,96 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include "oneflow/core/persistence/snapshot_flusher.h"
+#include "oneflow/core/common/str_util.h"
+
+#ifdef PLATFORM_POSIX
+
+#include <unistd.h>
+
+namespace oneflow {
+
+namespace {
+
+std::string FileContent(const std::string& path) {
+  std::ifstream in(path, std::ios::binary);
+  return std::string(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+}
+
+}  // namespace
+
+TEST(SnapshotFlusher, write_and_close) {
+  const std::string root = "/tmp/snapshot_flusher_test_" + std::to_string(getpid());
+  LocalFS()->RecursivelyCreateDirIfNotExist(root);
+  const int64_t file_num = 100;
+  {
+    // a staging limit below the total size makes Write wait for the flush threads
+    SnapshotFlusher flusher(LocalFS(), 3, 1024);
+    FOR_RANGE(int64_t, i, 0, file_num) {
+      const std::string data(i * 7, static_cast<char>('a' + i % 26));
+      flusher.Write(root, JoinPath(root, std::to_string(i)), data.data(), data.size());
+    }
+    flusher.Close(root);
+    flusher.WaitDone(root);
+    ASSERT_TRUE(flusher.IsDone(root));
+    ASSERT_TRUE(flusher.IsFlushed(root));
+    ASSERT_TRUE(LocalFS()->FileExists(JoinPath(root, "snapshot_done")));
+    FOR_RANGE(int64_t, i, 0, file_num) {
+      ASSERT_EQ(FileContent(JoinPath(root, std::to_string(i))),
+                std::string(i * 7, static_cast<char>('a' + i % 26)));
+    }
+  }
+  LocalFS()->RecursivelyDeleteDir(root);
+}
+
+TEST(SnapshotFlusher, close_without_write) {
+  const std::string root = "/tmp/snapshot_flusher_empty_test_" + std::to_string(getpid());
+  LocalFS()->RecursivelyCreateDirIfNotExist(root);
+  {
+    SnapshotFlusher flusher(LocalFS(), 1, 1024);
+    flusher.Open(root);
+    ASSERT_FALSE(flusher.IsDone(root));
+    flusher.Close(root);
+    ASSERT_TRUE(flusher.IsDone(root));
+    ASSERT_TRUE(LocalFS()->FileExists(JoinPath(root, "snapshot_done")));
+  }
+  LocalFS()->RecursivelyDeleteDir(root);
+}
+
+TEST(SnapshotFlusher, not_done_before_close) {
+  const std::string root = "/tmp/snapshot_flusher_open_test_" + std::to_string(getpid());
+  LocalFS()->RecursivelyCreateDirIfNotExist(root);
+  {
+    SnapshotFlusher flusher(LocalFS(), 2, 1024);
+    flusher.Open(root);
+    const std::string data(100, 'x');
+    flusher.Write(root, JoinPath(root, "0"), data.data(), data.size());
+    // every write so far is durable, but the snapshot may get more of them
+    flusher.WaitFlushed(root);
+    ASSERT_TRUE(flusher.IsFlushed(root));
+    ASSERT_FALSE(flusher.IsDone(root));
+    ASSERT_FALSE(LocalFS()->FileExists(JoinPath(root, "snapshot_done")));
+    flusher.Write(root, JoinPath(root, "1"), data.data(), data.size());
+    flusher.Close(root);
+    flusher.WaitDone(root);
+    ASSERT_TRUE(LocalFS()->FileExists(JoinPath(root, "1")));
+    ASSERT_TRUE(LocalFS()->FileExists(JoinPath(root, "snapshot_done")));
+  }
+  LocalFS()->RecursivelyDeleteDir(root);
+}
+
+}  // namespace oneflow
+
+#endif  // PLATFORM_POSIX
@@ -0,0 +1,88 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include "oneflow/core/persistence/snapshot.h"
+#include "oneflow/core/common/str_util.h"
+#include "oneflow/core/persistence/file_system.h"
+#include "oneflow/core/job/job_set.pb.h"
+#include "oneflow/core/thread/thread_pool.h"
+#include <unistd.h>
+
+namespace oneflow {
+
+namespace {
+
+void WriteVar(const std::string& root, const std::string& key, const Shape& shape) {
+  std::vector<int32_t> data(shape.elem_cnt());
+  FOR_RANGE(int64_t, i, 0, shape.elem_cnt()) { data.at(i) = i; }
+  std::ofstream out(JoinPath(root, key), std::ios::binary);
+  out.write(reinterpret_cast<const char*>(data.data()), data.size() * sizeof(int32_t));
+}
+
+void ExpectSliceRead(const SnapshotReader& reader, const std::string& key, const Shape& shape,
+                     const std::vector<Range>& ranges) {
+  const TensorSliceView slice(ranges);
+  std::vector<int32_t> dst(slice.shape().elem_cnt(), -1);
+  reader.Read(key, shape, DataType::kInt32, slice, reinterpret_cast<char*>(dst.data()));
+  int64_t dst_idx = 0;
+  FOR_RANGE(int64_t, i, ranges.at(0).begin(), ranges.at(0).end()) {
+    FOR_RANGE(int64_t, j, ranges.at(1).begin(), ranges.at(1).end()) {
+      FOR_RANGE(int64_t, k, ranges.at(2).begin(), ranges.at(2).end()) {
+        ASSERT_EQ(dst.at(dst_idx), (i * shape.At(1) + j) * shape.At(2) + k);
+        dst_idx += 1;
+      }
+    }
+  }
+}
+
+}  // namespace
+
+TEST(SnapshotReader, read_slice) {
+  IOConf io_conf;
+  io_conf.mutable_data_fs_conf()->mutable_localfs_conf();
+  io_conf.mutable_snapshot_fs_conf()->mutable_localfs_conf();
+  Global<const IOConf>::New(io_conf);
+  Global<ThreadPool>::New(4);
+  const std::string root = "/tmp/snapshot_test_" + std::to_string(getpid());
+  SnapshotFS()->CreateDir(root);
+  const Shape shape({7, 5, 6});
+  WriteVar(root, "var", shape);
+  // rows of 80KB, so the runs of a column slice are further apart than one read spans
+  const Shape wide_shape({3, 4, 20000});
+  WriteVar(root, "wide_var", wide_shape);
+  // the mapped copy and the spanned reads of the other file systems
+  for (bool mmap_local_files : {true, false}) {
+    SnapshotReader reader(root, mmap_local_files);
+    ExpectSliceRead(reader, "var", shape, {Range(0, 7), Range(0, 5), Range(0, 6)});
+    ExpectSliceRead(reader, "var", shape, {Range(2, 5), Range(0, 5), Range(0, 6)});
+    ExpectSliceRead(reader, "var", shape, {Range(0, 7), Range(1, 3), Range(0, 6)});
+    ExpectSliceRead(reader, "var", shape, {Range(1, 6), Range(2, 5), Range(3, 5)});
+    ExpectSliceRead(reader, "var", shape, {Range(0, 7), Range(0, 5), Range(5, 6)});
+    // single run spans
+    ExpectSliceRead(reader, "wide_var", wide_shape, {Range(0, 3), Range(0, 4), Range(10, 20)});
+    // spans of several runs split where the gap grows too wide
+    ExpectSliceRead(reader, "wide_var", wide_shape,
+                    {Range(0, 3), Range(1, 4), Range(0, 19000)});
+    ExpectSliceRead(reader, "wide_var", wide_shape,
+                    {Range(1, 3), Range(0, 4), Range(2000, 20000)});
+    ExpectSliceRead(reader, "wide_var", wide_shape,
+                    {Range(0, 3), Range(0, 4), Range(0, 20000)});
+  }
+  SnapshotFS()->RecursivelyDeleteDir(root);
+  Global<ThreadPool>::Delete();
+  Global<const IOConf>::Delete();
+}
+
+}  // namespace oneflow
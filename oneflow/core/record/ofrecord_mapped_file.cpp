@@ -0,0 +1,187 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include "oneflow/core/record/ofrecord_mapped_file.h"
+
+#ifdef PLATFORM_POSIX
+
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace oneflow {
+
+namespace {
+
+constexpr int64_t kMaxRecordSize = 64 * 1024 * 1024;  // 64M, same as ReadChunk
+constexpr int64_t kRecordHeaderSize = sizeof(int64_t);
+constexpr uint64_t kIndexMagic = 0x313058444952464fULL;  // "OFRIDX01"
+
+struct IndexHeader {
+  uint64_t magic;
+  uint64_t file_size;
+  int64_t mtime_ns;
+  int64_t record_num;
+};
+
+bool ReadFullyFromFd(int fd, char* dst, size_t n) {
+  while (n > 0) {
+    ssize_t r = read(fd, dst, n);
+    if (r > 0) {
+      dst += r;
+      n -= r;
+    } else if (r < 0 && errno == EINTR) {
+      // Retry
+    } else {
+      return false;
+    }
+  }
+  return true;
+}
+
+bool WriteFullyToFd(int fd, const char* src, size_t n) {
+  while (n > 0) {
+    ssize_t r = write(fd, src, n);
+    if (r > 0) {
+      src += r;
+      n -= r;
+    } else if (r < 0 && errno == EINTR) {
+      // Retry
+    } else {
+      return false;
+    }
+  }
+  return true;
+}
+
+}  // namespace
+
+OFRecordMappedFile::OFRecordMappedFile(const std::string& path)
+    : path_(path), fd_(-1), data_(nullptr), size_(0) {
+  fd_ = open(path.c_str(), O_RDONLY);
+  PCHECK(fd_ != -1) << "Fail to open " << path;
+  struct stat st;
+  PCHECK(fstat(fd_, &st) == 0) << "Fail to stat " << path;
+  size_ = st.st_size;
+  if (size_ > 0) {
+    void* addr = mmap(nullptr, static_cast<size_t>(size_), PROT_READ, MAP_SHARED, fd_, 0);
+    PCHECK(addr != MAP_FAILED) << "Fail to mmap " << path;
+    data_ = static_cast<const char*>(addr);
+  }
+  const int64_t mtime_ns =
+      static_cast<int64_t>(st.st_mtim.tv_sec) * 1000000000LL + st.st_mtim.tv_nsec;
+  if (!LoadIndex(mtime_ns)) {
+    BuildIndex();
+    SaveIndex(mtime_ns);
+  }
+}
+
+OFRecordMappedFile::~OFRecordMappedFile() {
+  if (data_ != nullptr) { PCHECK(munmap(const_cast<char*>(data_), size_) == 0); }
+  PCHECK(close(fd_) == 0);
+}
+
+void OFRecordMappedFile::Advise(int advice) const {
+  if (data_ == nullptr) { return; }
+  PCHECK(madvise(const_cast<char*>(data_), size_, advice) == 0);
+}
+
+void OFRecordMappedFile::Prefetch(int64_t record_id) const {
+  static const int64_t page_size = sysconf(_SC_PAGESIZE);
+  const int64_t begin = record_offsets_.at(record_id) / page_size * page_size;
+  const int64_t end = record_offsets_.at(record_id + 1);
+  if (begin == end) { return; }
+  // only a hint, failing to read ahead is not an error
+  madvise(const_cast<char*>(data_) + begin, end - begin, MADV_WILLNEED);
+}
+
+bool OFRecordMappedFile::LoadIndex(int64_t mtime_ns) {
+  const std::string index_path = IndexPath(path_);
+  int fd = open(index_path.c_str(), O_RDONLY);
+  if (fd == -1) { return false; }
+  struct stat st;
+  PCHECK(fstat(fd, &st) == 0) << "Fail to stat " << index_path;
+  IndexHeader header;
+  bool ok = ReadFullyFromFd(fd, reinterpret_cast<char*>(&header), sizeof(header))
+            && header.magic == kIndexMagic && header.file_size == static_cast<uint64_t>(size_)
+            && header.mtime_ns == mtime_ns && header.record_num >= 0
+            && header.record_num <= size_ / kRecordHeaderSize
+            && st.st_size == static_cast<off_t>(sizeof(header)
+                                                + (header.record_num + 1) * sizeof(int64_t));
+  if (ok) {
+    record_offsets_.resize(header.record_num + 1);
+    ok = ReadFullyFromFd(fd, reinterpret_cast<char*>(record_offsets_.data()),
+                         record_offsets_.size() * sizeof(int64_t))
+         && record_offsets_.front() == 0 && record_offsets_.back() == size_;
+    // every record has at least its size header and ends inside the file
+    for (int64_t i = 0; ok && i < header.record_num; ++i) {
+      ok = record_offsets_.at(i + 1) >= record_offsets_.at(i) + kRecordHeaderSize
+           && record_offsets_.at(i + 1) <= size_;
+    }
+  }
+  PCHECK(close(fd) == 0);
+  if (!ok) {
+    LOG(WARNING) << "Ignore stale ofrecord index " << index_path;
+    record_offsets_.clear();
+  }
+  return ok;
+}
+
+void OFRecordMappedFile::BuildIndex() {
+  record_offsets_.clear();
+  int64_t offset = 0;
+  while (offset < size_) {
+    CHECK_LE(offset + kRecordHeaderSize, size_) << "Truncated record header in " << path_;
+    int64_t record_size = -1;
+    std::memcpy(&record_size, data_ + offset, kRecordHeaderSize);
+    CHECK_GE(record_size, 0);
+    CHECK_LE(record_size, kMaxRecordSize);
+    CHECK_LE(offset + kRecordHeaderSize + record_size, size_) << "Truncated record in " << path_;
+    record_offsets_.push_back(offset);
+    offset += kRecordHeaderSize + record_size;
+  }
+  record_offsets_.push_back(offset);
+}
+
+void OFRecordMappedFile::SaveIndex(int64_t mtime_ns) const {
+  const std::string index_path = IndexPath(path_);
+  // write to a private file first so that concurrent readers never see a partial index, the
+  // counter keeps the readers of one process apart
+  static std::atomic<int64_t> tmp_file_cnt(0);
+  const std::string tmp_path = index_path + ".tmp." + std::to_string(getpid()) + "."
+                               + std::to_string(tmp_file_cnt++);
+  int fd = open(tmp_path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+  if (fd == -1) {
+    PLOG(WARNING) << "Fail to create ofrecord index " << index_path;
+    return;
+  }
+  IndexHeader header;
+  header.magic = kIndexMagic;
+  header.file_size = size_;
+  header.mtime_ns = mtime_ns;
+  header.record_num = record_num();
+  const bool ok = WriteFullyToFd(fd, reinterpret_cast<const char*>(&header), sizeof(header))
+                  && WriteFullyToFd(fd, reinterpret_cast<const char*>(record_offsets_.data()),
+                                    record_offsets_.size() * sizeof(int64_t));
+  PCHECK(close(fd) == 0);
+  if (!ok || rename(tmp_path.c_str(), index_path.c_str()) != 0) {
+    PLOG(WARNING) << "Fail to save ofrecord index " << index_path;
+    unlink(tmp_path.c_str());
+  }
+}
+
+}  // namespace oneflow
+
+#endif  // PLATFORM_POSIX
@@ -0,0 +1,67 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#ifndef ONEFLOW_CORE_RECORD_OFRECORD_MAPPED_FILE_H_
+#define ONEFLOW_CORE_RECORD_OFRECORD_MAPPED_FILE_H_
+
+#include "oneflow/core/common/platform.h"
+#include "oneflow/core/common/util.h"
+
+#include <sys/mman.h>
+
+namespace oneflow {
+
+// A local OFRecord part file mapped read-only into memory, together with the offset of every
+// record in it. The offsets are cached in "<path>.index" so that only the first open of a part
+// has to walk through its records; a stale or unwritable cache just falls back to a scan.
+class OFRecordMappedFile final {
+ public:
+  OF_DISALLOW_COPY_AND_MOVE(OFRecordMappedFile);
+  explicit OFRecordMappedFile(const std::string& path);
+  ~OFRecordMappedFile();
+
+  int64_t record_num() const { return record_offsets_.size() - 1; }
+  // the serialized OFRecord, pointing straight into the mapping
+  const char* RecordData(int64_t record_id) const {
+    return data_ + record_offsets_.at(record_id) + sizeof(int64_t);
+  }
+  int64_t RecordSize(int64_t record_id) const {
+    return record_offsets_.at(record_id + 1) - record_offsets_.at(record_id) - sizeof(int64_t);
+  }
+  // page cache hints for the whole mapping
+  void AdviseSequential() const { Advise(MADV_SEQUENTIAL); }
+  void AdviseRandom() const { Advise(MADV_RANDOM); }
+  // starts asynchronous read-ahead of the pages holding one record
+  void Prefetch(int64_t record_id) const;
+
+  static std::string IndexPath(const std::string& path) { return path + ".index"; }
+
+ private:
+  void Advise(int advice) const;
+  bool LoadIndex(int64_t mtime_ns);
+  void BuildIndex();
+  void SaveIndex(int64_t mtime_ns) const;
+
+  std::string path_;
+  int fd_;
+  const char* data_;
+  int64_t size_;
+  // offset of the size header of each record, plus the file size as the last element
+  std::vector<int64_t> record_offsets_;
+};
+
+}  // namespace oneflow
+
+#endif  // ONEFLOW_CORE_RECORD_OFRECORD_MAPPED_FILE_H_
@@ -0,0 +1,195 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include "oneflow/core/record/ofrecord_mapped_file.h"
+#include "oneflow/core/common/data_type.h"
+#include "oneflow/core/record/ofrecord_reader.h"
+
+#ifdef PLATFORM_POSIX
+
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace oneflow {
+
+namespace {
+
+std::string RecordPayload(int64_t part_id, int64_t record_id) {
+  return std::string(static_cast<size_t>(record_id % 7), 'x') + std::to_string(part_id) + "-"
+         + std::to_string(record_id);
+}
+
+std::string WritePayloads(const std::string& name, const std::vector<std::string>& payloads) {
+  std::string path = "/tmp/" + name + "." + std::to_string(getpid());
+  std::ofstream out(path, std::ios::binary);
+  for (const std::string& payload : payloads) {
+    const int64_t size = payload.size();
+    out.write(reinterpret_cast<const char*>(&size), sizeof(size));
+    out.write(payload.data(), size);
+  }
+  return path;
+}
+
+std::string WritePartFile(const std::string& name, int64_t part_id, int64_t record_num) {
+  std::vector<std::string> payloads;
+  FOR_RANGE(int64_t, i, 0, record_num) { payloads.push_back(RecordPayload(part_id, i)); }
+  return WritePayloads(name, payloads);
+}
+
+// gives the file a modification time of its own instead of waiting for the clock to tick
+void SetMTime(const std::string& path, int64_t sec) {
+  timespec times[2];
+  times[0].tv_sec = sec;
+  times[0].tv_nsec = 0;
+  times[1] = times[0];
+  PCHECK(utimensat(AT_FDCWD, path.c_str(), times, 0) == 0);
+}
+
+void CheckRecords(const OFRecordMappedFile& file, int64_t part_id, int64_t record_num) {
+  ASSERT_EQ(file.record_num(), record_num);
+  FOR_RANGE(int64_t, i, 0, record_num) {
+    file.Prefetch(i);
+    ASSERT_EQ(std::string(file.RecordData(i), file.RecordSize(i)), RecordPayload(part_id, i));
+  }
+}
+
+}  // namespace
+
+TEST(OFRecordMappedFile, build_and_reuse_index) {
+  const std::string path = WritePartFile("ofrecord_mapped_file_test", 3, 1000);
+  unlink(OFRecordMappedFile::IndexPath(path).c_str());
+  {
+    OFRecordMappedFile file(path);
+    CheckRecords(file, 3, 1000);
+  }
+  ASSERT_EQ(access(OFRecordMappedFile::IndexPath(path).c_str(), F_OK), 0);
+  {
+    OFRecordMappedFile file(path);
+    CheckRecords(file, 3, 1000);
+  }
+  // rewriting the part file must invalidate the cached index
+  WritePartFile("ofrecord_mapped_file_test", 5, 10);
+  SetMTime(path, 1000000000);
+  {
+    OFRecordMappedFile file(path);
+    CheckRecords(file, 5, 10);
+  }
+  // same size, other record boundaries, only the mtime tells them apart
+  WritePayloads("ofrecord_mapped_file_test", {"0123", "4567"});
+  SetMTime(path, 1000000001);
+  { ASSERT_EQ(OFRecordMappedFile(path).record_num(), 2); }
+  WritePayloads("ofrecord_mapped_file_test", {"0123456789abcdef"});
+  SetMTime(path, 1000000002);
+  {
+    OFRecordMappedFile file(path);
+    ASSERT_EQ(file.record_num(), 1);
+    ASSERT_EQ(std::string(file.RecordData(0), file.RecordSize(0)), "0123456789abcdef");
+  }
+  unlink(OFRecordMappedFile::IndexPath(path).c_str());
+  unlink(path.c_str());
+}
+
+TEST(OFRecordMappedFile, reject_corrupted_index) {
+  const std::string path = WritePartFile("ofrecord_mapped_file_corrupted_test", 3, 100);
+  const std::string index_path = OFRecordMappedFile::IndexPath(path);
+  unlink(index_path.c_str());
+  { OFRecordMappedFile file(path); }
+  struct stat st;
+  PCHECK(stat(index_path.c_str(), &st) == 0);
+  const int64_t header_size = st.st_size - 101 * sizeof(int64_t);
+  const auto OverwriteOffset = [&](int64_t i, int64_t offset) {
+    int fd = open(index_path.c_str(), O_WRONLY);
+    PCHECK(fd != -1);
+    PCHECK(pwrite(fd, &offset, sizeof(offset), header_size + i * sizeof(offset))
+           == static_cast<ssize_t>(sizeof(offset)));
+    PCHECK(close(fd) == 0);
+  };
+  // a truncated index
+  PCHECK(truncate(index_path.c_str(), st.st_size - sizeof(int64_t)) == 0);
+  {
+    OFRecordMappedFile file(path);
+    CheckRecords(file, 3, 100);
+  }
+  // an offset past the end of the part file
+  OverwriteOffset(50, st.st_size * 1000);
+  {
+    OFRecordMappedFile file(path);
+    CheckRecords(file, 3, 100);
+  }
+  // offsets going backwards
+  OverwriteOffset(50, 0);
+  {
+    OFRecordMappedFile file(path);
+    CheckRecords(file, 3, 100);
+  }
+  unlink(index_path.c_str());
+  unlink(path.c_str());
+}
+
+TEST(OFRecordMappedFile, empty_file) {
+  const std::string path = WritePartFile("ofrecord_mapped_file_empty_test", 0, 0);
+  {
+    OFRecordMappedFile file(path);
+    ASSERT_EQ(file.record_num(), 0);
+  }
+  unlink(OFRecordMappedFile::IndexPath(path).c_str());
+  unlink(path.c_str());
+}
+
+TEST(MmapOFRecordReader, seek) {
+  std::vector<std::string> paths;
+  const std::vector<int64_t> part_record_nums{3, 0, 5, 1};
+  std::vector<std::pair<int64_t, int64_t>> records;
+  FOR_RANGE(int64_t, part_id, 0, part_record_nums.size()) {
+    paths.push_back(WritePartFile("mmap_ofrecord_reader_seek_test_" + std::to_string(part_id),
+                                  part_id, part_record_nums.at(part_id)));
+    FOR_RANGE(int64_t, i, 0, part_record_nums.at(part_id)) { records.emplace_back(part_id, i); }
+  }
+  {
+    MmapOFRecordReader reader(paths, GetMaxVal<size_t>(), true);
+    ASSERT_EQ(reader.record_num(), static_cast<int64_t>(records.size()));
+    const char* data = nullptr;
+    int64_t size = 0;
+    for (int64_t record_id : {4, 0, 2, 3, 8, 7}) {
+      reader.Seek(record_id);
+      // reads on from the seeked record and wraps around at the end
+      FOR_RANGE(int64_t, i, 0, records.size() + 2) {
+        const auto& record = records.at((record_id + i) % records.size());
+        ASSERT_TRUE(reader.NextRecord(&data, &size));
+        ASSERT_EQ(std::string(data, size), RecordPayload(record.first, record.second));
+      }
+    }
+  }
+  {
+    MmapOFRecordReader reader(paths, GetMaxVal<size_t>(), false);
+    const char* data = nullptr;
+    int64_t size = 0;
+    reader.Seek(reader.record_num());
+    ASSERT_FALSE(reader.NextRecord(&data, &size));
+    reader.Seek(reader.record_num() - 1);
+    ASSERT_TRUE(reader.NextRecord(&data, &size));
+    ASSERT_EQ(std::string(data, size), RecordPayload(3, 0));
+    ASSERT_FALSE(reader.NextRecord(&data, &size));
+  }
+  for (const std::string& path : paths) {
+    unlink(OFRecordMappedFile::IndexPath(path).c_str());
+    unlink(path.c_str());
+  }
+}
+
+}  // namespace oneflow
+
+#endif  // PLATFORM_POSIX
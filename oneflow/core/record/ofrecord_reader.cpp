@@ -14,9 +14,8 @@ See the License for the specific language governing permissions and
 limitations under the License.
 */
 #include "oneflow/core/record/ofrecord_reader.h"
-#include "oneflow/core/common/blocking_counter.h"
 #include "oneflow/core/thread/thread_manager.h"
-#include "oneflow/core/common/balanced_splitter.h"
+#include "oneflow/core/job/job_set.pb.h"
 
 namespace oneflow {
 
@@ -35,6 +34,16 @@ bool ReadChunk(PersistentInStream* is, OFRecordChunk* chunk) {
   return false;
 }
 
+void ParseRecordsInParallel(int64_t record_num, const std::function<void(int64_t)>& ParseRecord) {
+  ThreadPool* thread_pool = Global<ThreadPool>::Get();
+  // a few records per thread so that big records do not leave the other threads idle
+  const int64_t grain =
+      std::max<int64_t>(record_num / (std::max<int64_t>(thread_pool->thread_num(), 1) * 4), 1);
+  thread_pool->ParallelFor(0, record_num, grain, [&ParseRecord](int64_t begin, int64_t end) {
+    FOR_RANGE(int64_t, i, begin, end) { ParseRecord(i); }
+  });
+}
+
 }  // namespace
 
 NaiveOFRecordReader::NaiveOFRecordReader(PersistentInStream* in, size_t num_max_read)
@@ -52,20 +61,9 @@ size_t NaiveOFRecordReader::Read(size_t n, OFRecord* allocated_records) {
     }
   }
   if (cur_read == 0) { return 0; }
-  ThreadPool* thread_pool = Global<ThreadPool>::Get();
-  const int64_t thread_num = std::min<int64_t>(thread_pool->thread_num(), cur_read);
-  BlockingCounter bc(thread_num);
-  const BalancedSplitter bs(cur_read, thread_num);
-  FOR_RANGE(int64_t, tid, 0, thread_num) {
-    const Range thrd_range = bs.At(tid);
-    thread_pool->AddWork([thrd_range, &bc, &chunks, &allocated_records]() {
-      FOR_RANGE(int64_t, i, thrd_range.begin(), thrd_range.end()) {
-        CHECK(allocated_records[i].ParseFromArray(chunks.at(i).data.get(), chunks.at(i).size));
-      }
-      bc.Decrease();
-    });
-  }
-  bc.WaitUntilCntEqualZero();
+  ParseRecordsInParallel(cur_read, [&chunks, &allocated_records](int64_t i) {
+    CHECK(allocated_records[i].ParseFromArray(chunks.at(i).data.get(), chunks.at(i).size));
+  });
   num_read_ += cur_read;
   return cur_read;
 }
@@ -112,4 +110,96 @@ size_t RandomShuffleOFRecordReader::Read(size_t n, OFRecord* allocated_records)
   return cur_read;
 }
 
+MmapOFRecordReader::MmapOFRecordReader(const std::vector<std::string>& file_paths,
+                                       size_t num_max_read, bool cyclic)
+    : num_max_read_(num_max_read),
+      cyclic_(cyclic),
+      num_read_(0),
+      cur_part_id_(0),
+      cur_record_id_in_part_(0) {
+  part_first_record_id_.push_back(0);
+  for (const std::string& path : file_paths) {
+    files_.emplace_back(new OFRecordMappedFile(path));
+    files_.back()->AdviseSequential();
+    part_first_record_id_.push_back(part_first_record_id_.back() + files_.back()->record_num());
+  }
+}
+
+bool MmapOFRecordReader::NextRecord(const char** data, int64_t* size) {
+  while (true) {
+    if (cur_part_id_ == static_cast<int64_t>(files_.size())) {
+      if (!cyclic_ || record_num() == 0) { return false; }
+      cur_part_id_ = 0;
+      cur_record_id_in_part_ = 0;
+    }
+    const OFRecordMappedFile* file = files_.at(cur_part_id_).get();
+    if (cur_record_id_in_part_ < file->record_num()) {
+      *data = file->RecordData(cur_record_id_in_part_);
+      *size = file->RecordSize(cur_record_id_in_part_);
+      cur_record_id_in_part_ += 1;
+      return true;
+    }
+    cur_part_id_ += 1;
+    cur_record_id_in_part_ = 0;
+  }
+}
+
+void MmapOFRecordReader::LocateRecord(int64_t record_id, int64_t* part_id,
+                                      int64_t* record_id_in_part) const {
+  CHECK_GE(record_id, 0);
+  CHECK_LE(record_id, record_num());
+  // the last part starting at or before record_id, empty parts share their first id with the
+  // next one and are skipped by upper_bound
+  *part_id = std::upper_bound(part_first_record_id_.begin(), part_first_record_id_.end(),
+                              record_id)
+             - part_first_record_id_.begin() - 1;
+  *record_id_in_part = record_id - part_first_record_id_.at(*part_id);
+}
+
+void MmapOFRecordReader::Seek(int64_t record_id) {
+  LocateRecord(record_id, &cur_part_id_, &cur_record_id_in_part_);
+}
+
+void MmapOFRecordReader::RecordAt(int64_t record_id, const char** data, int64_t* size) const {
+  CHECK_LT(record_id, record_num());
+  int64_t part_id = -1;
+  int64_t record_id_in_part = -1;
+  LocateRecord(record_id, &part_id, &record_id_in_part);
+  *data = files_.at(part_id)->RecordData(record_id_in_part);
+  *size = files_.at(part_id)->RecordSize(record_id_in_part);
+}
+
+void MmapOFRecordReader::PrefetchRecord(int64_t record_id) const {
+  CHECK_LT(record_id, record_num());
+  int64_t part_id = -1;
+  int64_t record_id_in_part = -1;
+  LocateRecord(record_id, &part_id, &record_id_in_part);
+  files_.at(part_id)->Prefetch(record_id_in_part);
+}
+
+void MmapOFRecordReader::AdviseRandomAccess() const {
+  for (const auto& file : files_) { file->AdviseRandom(); }
+}
+
+size_t MmapOFRecordReader::Read(size_t n, OFRecord* allocated_records) {
+  const size_t can_read = std::min(n, num_max_read_ - num_read_);
+  std::vector<std::pair<const char*, int64_t>> records;
+  records.reserve(can_read);
+  const char* data = nullptr;
+  int64_t size = 0;
+  while (records.size() < can_read && NextRecord(&data, &size)) {
+    records.emplace_back(data, size);
+  }
+  if (records.empty()) { return 0; }
+  ParseRecordsInParallel(records.size(), [&records, &allocated_records](int64_t i) {
+    CHECK(allocated_records[i].ParseFromArray(records.at(i).first, records.at(i).second));
+  });
+  num_read_ += records.size();
+  return records.size();
+}
+
+bool EnableMmapOFRecordReader() {
+  return Global<const IOConf>::Get()->enable_mmap_ofrecord_reader() && DataFS() == LocalFS();
+}
+
 }  // namespace oneflow
@@ -19,6 +19,7 @@ limitations under the License.
 #include "oneflow/core/record/record.pb.h"
 #include "oneflow/core/common/data_type.h"
 #include "oneflow/core/persistence/persistent_in_stream.h"
+#include "oneflow/core/record/ofrecord_mapped_file.h"
 
 namespace oneflow {
 
@@ -76,6 +77,43 @@ class RandomShuffleOFRecordReader final : public OFRecordReader {
   bool is_eof_;
 };
 
+// Reads the concatenated records of local part files through OFRecordMappedFile. Records are
+// parsed straight out of the mappings, and Seek moves to any record without touching the ones
+// before it, which is what resumed and sharded epochs need.
+class MmapOFRecordReader final : public OFRecordReader {
+ public:
+  OF_DISALLOW_COPY_AND_MOVE(MmapOFRecordReader);
+  MmapOFRecordReader(const std::vector<std::string>& file_paths, size_t num_max_read,
+                     bool cyclic);
+  ~MmapOFRecordReader() override = default;
+
+  size_t Read(size_t n, OFRecord* allocated_records) override;
+  // the serialized record under the cursor, false at the end of a non-cyclic reader
+  bool NextRecord(const char** data, int64_t* size);
+  void Seek(int64_t record_id);
+  int64_t record_num() const { return part_first_record_id_.back(); }
+
+  // random access to any record, independent of the cursor
+  void RecordAt(int64_t record_id, const char** data, int64_t* size) const;
+  void PrefetchRecord(int64_t record_id) const;
+  void AdviseRandomAccess() const;
+
+ private:
+  void LocateRecord(int64_t record_id, int64_t* part_id, int64_t* record_id_in_part) const;
+
+  std::vector<std::unique_ptr<OFRecordMappedFile>> files_;
+  // id of the first record of each part, followed by record_num()
+  std::vector<int64_t> part_first_record_id_;
+  const size_t num_max_read_;
+  const bool cyclic_;
+  size_t num_read_;
+  int64_t cur_part_id_;
+  int64_t cur_record_id_in_part_;
+};
+
+// whether IOConf asks for MmapOFRecordReader and the data lives on the local file system
+bool EnableMmapOFRecordReader();
+
 }  // namespace oneflow
 
 #endif  // ONEFLOW_CORE_RECORD_OFRECORD_READER_H_
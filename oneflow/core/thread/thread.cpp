@@ -15,16 +15,30 @@ limitations under the License.
 */
 #include "oneflow/core/thread/thread.h"
 #include "oneflow/core/job/runtime_context.h"
+#include "oneflow/core/job/resource_desc.h"
 #include "oneflow/core/job/global_for.h"
 #include "oneflow/core/actor/actor.h"
 #include "oneflow/core/job/global_for.h"
 
 namespace oneflow {
 
+Thread::Thread() {
+  const ResourceDesc* resource_desc = Global<ResourceDesc, ForSession>::Get();
+  if (resource_desc->thread_enable_mpsc_mailbox()) {
+    mpsc_mailbox_.reset(new MpscChannel<ActorMsg>(
+        resource_desc->thread_mpsc_mailbox_capacity(),
+        resource_desc->thread_mpsc_mailbox_max_spin_count()));
+  }
+  // the mpsc mailbox is bounded, an actor sending to its own thread must not wait on it
+  enable_local_msg_queue_ =
+      resource_desc->thread_enable_local_message_queue() || mpsc_mailbox_ != nullptr;
+}
+
 Thread::~Thread() {
   actor_thread_.join();
   CHECK(id2task_.empty());
   msg_channel_.Close();
+  if (mpsc_mailbox_) { mpsc_mailbox_->Close(); }
 }
 
 void Thread::AddTask(const TaskProto& task) {
@@ -33,18 +47,24 @@ void Thread::AddTask(const TaskProto& task) {
 }
 
 void Thread::EnqueueActorMsg(const ActorMsg& msg) {
-  if (Global<ResourceDesc, ForSession>::Get()->thread_enable_local_message_queue()
-      && std::this_thread::get_id() == actor_thread_.get_id()) {
+  if (enable_local_msg_queue_ && std::this_thread::get_id() == actor_thread_.get_id()) {
     local_msg_queue_.push(msg);
+  } else if (mpsc_mailbox_) {
+    mpsc_mailbox_->Send(msg);
   } else {
     msg_channel_.Send(msg);
   }
 }
 
+ChannelStatus Thread::ReceiveManyMsg(std::queue<ActorMsg>* msgs) {
+  if (mpsc_mailbox_) { return mpsc_mailbox_->ReceiveMany(msgs); }
+  return msg_channel_.ReceiveMany(msgs);
+}
+
 void Thread::PollMsgChannel(const ThreadCtx& thread_ctx) {
   while (true) {
     if (local_msg_queue_.empty()) {
-      CHECK_EQ(msg_channel_.ReceiveMany(&local_msg_queue_), kChannelStatusSuccess);
+      CHECK_EQ(ReceiveManyMsg(&local_msg_queue_), kChannelStatusSuccess);
     }
     ActorMsg msg = std::move(local_msg_queue_.front());
     local_msg_queue_.pop();
@@ -44,6 +44,12 @@ class ThreadMgr final {
 
 void SingleThreadLoop(size_t num, std::function<void(size_t i)> Callback);
 void MultiThreadLoop(size_t num, std::function<void(size_t i)> Callback);
+// Calls Callback on consecutive sub-ranges of [0, num) holding at most grain elements each, on
+// the global ThreadPool if there is one and on the calling thread otherwise.
+void MultiThreadLoopInRange(int64_t num, int64_t grain,
+                            std::function<void(int64_t begin, int64_t end)> Callback);
+// The grain of memory bound cpu loops, in elements, large enough to amortize a pool task.
+constexpr int64_t kCpuParallelGrainSize = 32768;
 
 }  // namespace oneflow
 
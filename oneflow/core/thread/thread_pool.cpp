@@ -17,28 +17,145 @@ limitations under the License.
 
 namespace oneflow {
 
+namespace {
+
+thread_local const ThreadPool* tls_cur_pool = nullptr;
+thread_local int32_t tls_cur_worker_id = -1;
+
+struct ParallelForCtx {
+  ParallelForCtx(int64_t begin, int64_t end, int64_t grain,
+                 const std::function<void(int64_t, int64_t)>* fn)
+      : begin(begin),
+        end(end),
+        grain(grain),
+        chunk_num((end - begin + grain - 1) / grain),
+        fn(fn),
+        next_chunk(0),
+        remaining_chunk_cnt(chunk_num) {}
+
+  // returns after there is no chunk left to claim, fn is never touched afterwards because the
+  // caller of ParallelFor may already be gone
+  void RunChunks() {
+    while (true) {
+      const int64_t chunk_id = next_chunk.fetch_add(1, std::memory_order_relaxed);
+      if (chunk_id >= chunk_num) { break; }
+      const int64_t chunk_begin = begin + chunk_id * grain;
+      (*fn)(chunk_begin, std::min(chunk_begin + grain, end));
+      if (remaining_chunk_cnt.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+        std::unique_lock<std::mutex> lock(mutex);
+        cond.notify_all();
+      }
+    }
+  }
+
+  void WaitUntilAllChunksDone() {
+    std::unique_lock<std::mutex> lock(mutex);
+    cond.wait(lock, [this]() { return remaining_chunk_cnt.load(std::memory_order_acquire) == 0; });
+  }
+
+  const int64_t begin;
+  const int64_t end;
+  const int64_t grain;
+  const int64_t chunk_num;
+  const std::function<void(int64_t, int64_t)>* fn;
+  std::atomic<int64_t> next_chunk;
+  std::atomic<int64_t> remaining_chunk_cnt;
+  std::mutex mutex;
+  std::condition_variable cond;
+};
+
+}  // namespace
+
 ThreadPool::ThreadPool(int32_t thread_num)
-    : work_chans_(thread_num), threads_(thread_num), work_cnt_(0) {
+    : threads_(thread_num),
+      work_cnt_(0),
+      pending_work_cnt_(0),
+      idle_worker_cnt_(0),
+      is_closed_(false) {
+  FOR_RANGE(int32_t, i, 0, thread_num) { work_queues_.emplace_back(new WorkQueue); }
   FOR_RANGE(int32_t, i, 0, thread_num) {
-    Channel<std::function<void()>>* chan = &(work_chans_.at(i));
-    threads_[i] = std::thread([chan]() {
-      std::function<void()> work;
-      while (chan->Receive(&work) == kChannelStatusSuccess) { work(); }
-    });
+    threads_[i] = std::thread([this, i]() { WorkerLoop(i); });
   }
 }
 
 ThreadPool::~ThreadPool() {
-  FOR_RANGE(int32_t, i, 0, work_chans_.size()) {
-    work_chans_.at(i).Close();
-    threads_.at(i).join();
+  {
+    std::unique_lock<std::mutex> lock(idle_mutex_);
+    is_closed_ = true;
   }
+  idle_cond_.notify_all();
+  for (std::thread& thread : threads_) { thread.join(); }
 }
 
 void ThreadPool::AddWork(const std::function<void()>& work) {
-  const size_t cur_chan_idx =
-      work_cnt_.fetch_add(1, std::memory_order_relaxed) % work_chans_.size();
-  work_chans_.at(cur_chan_idx).Send(work);
+  size_t queue_idx = 0;
+  if (tls_cur_pool == this) {
+    queue_idx = tls_cur_worker_id;
+  } else {
+    queue_idx = work_cnt_.fetch_add(1, std::memory_order_relaxed) % work_queues_.size();
+  }
+  {
+    WorkQueue* queue = work_queues_.at(queue_idx).get();
+    std::unique_lock<std::mutex> lock(queue->mutex);
+    queue->works.push_back(work);
+  }
+  // pairs with WorkerLoop: either we see the idle worker, or it sees the pending work
+  pending_work_cnt_.fetch_add(1);
+  if (idle_worker_cnt_.load() > 0) {
+    std::unique_lock<std::mutex> lock(idle_mutex_);
+    idle_cond_.notify_one();
+  }
+}
+
+bool ThreadPool::PopWork(int32_t worker_id, std::function<void()>* work) {
+  const int32_t queue_num = work_queues_.size();
+  FOR_RANGE(int32_t, i, 0, queue_num) {
+    const int32_t queue_idx = (worker_id + i) % queue_num;
+    WorkQueue* queue = work_queues_.at(queue_idx).get();
+    std::unique_lock<std::mutex> lock(queue->mutex);
+    if (queue->works.empty()) { continue; }
+    if (queue_idx == worker_id) {
+      *work = std::move(queue->works.front());
+      queue->works.pop_front();
+    } else {
+      *work = std::move(queue->works.back());
+      queue->works.pop_back();
+    }
+    pending_work_cnt_.fetch_sub(1);
+    return true;
+  }
+  return false;
+}
+
+void ThreadPool::WorkerLoop(int32_t worker_id) {
+  tls_cur_pool = this;
+  tls_cur_worker_id = worker_id;
+  std::function<void()> work;
+  while (true) {
+    if (PopWork(worker_id, &work)) {
+      work();
+      work = nullptr;
+      continue;
+    }
+    std::unique_lock<std::mutex> lock(idle_mutex_);
+    idle_worker_cnt_.fetch_add(1);
+    idle_cond_.wait(lock, [this]() { return pending_work_cnt_.load() > 0 || is_closed_; });
+    idle_worker_cnt_.fetch_sub(1);
+    if (is_closed_ && pending_work_cnt_.load() == 0) { break; }
+  }
+}
+
+void ThreadPool::ParallelFor(int64_t begin, int64_t end, int64_t grain,
+                             const std::function<void(int64_t, int64_t)>& fn) {
+  if (end <= begin) { return; }
+  grain = std::max<int64_t>(grain, 1);
+  auto ctx = std::make_shared<ParallelForCtx>(begin, end, grain, &fn);
+  const int64_t helper_num = std::min<int64_t>(thread_num(), ctx->chunk_num - 1);
+  FOR_RANGE(int64_t, i, 0, helper_num) {
+    AddWork([ctx]() { ctx->RunChunks(); });
+  }
+  ctx->RunChunks();
+  ctx->WaitUntilAllChunksDone();
 }
 
 }  // namespace oneflow
@@ -16,11 +16,14 @@ limitations under the License.
 #ifndef ONEFLOW_CORE_THREAD_THREAD_POOL_H_
 #define ONEFLOW_CORE_THREAD_THREAD_POOL_H_
 
+#include <deque>
 #include "oneflow/core/common/util.h"
-#include "oneflow/core/common/channel.h"
 
 namespace oneflow {
 
+// Every worker owns a deque of works. A worker runs the works of its own deque in FIFO order and
+// steals from the tail of the other deques when its own deque runs dry, so a few long works no
+// longer hold back everything queued behind them on the same thread.
 class ThreadPool final {
  public:
   OF_DISALLOW_COPY_AND_MOVE(ThreadPool);
@@ -31,11 +34,30 @@ class ThreadPool final {
   int32_t thread_num() const { return threads_.size(); }
   void AddWork(const std::function<void()>& work);
 
+  // Calls fn on disjoint sub-ranges of [begin, end) holding at most grain elements each, and
+  // returns when all of them are done. Sub-ranges are handed out dynamically and the calling
+  // thread processes them too, so it is safe to call ParallelFor from inside a work.
+  void ParallelFor(int64_t begin, int64_t end, int64_t grain,
+                   const std::function<void(int64_t, int64_t)>& fn);
+
  private:
-  std::vector<Channel<std::function<void()>>> work_chans_;
+  struct WorkQueue {
+    std::mutex mutex;
+    std::deque<std::function<void()>> works;
+  };
+
+  void WorkerLoop(int32_t worker_id);
+  bool PopWork(int32_t worker_id, std::function<void()>* work);
+
+  std::vector<std::unique_ptr<WorkQueue>> work_queues_;
   std::vector<std::thread> threads_;
 
   std::atomic<size_t> work_cnt_;
+  std::atomic<int64_t> pending_work_cnt_;
+  std::atomic<int64_t> idle_worker_cnt_;
+  std::mutex idle_mutex_;
+  std::condition_variable idle_cond_;
+  bool is_closed_;
 };
 
 }  // namespace oneflow
@@ -0,0 +1,67 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include "oneflow/core/thread/thread_pool.h"
+#include "oneflow/core/common/blocking_counter.h"
+
+namespace oneflow {
+
+TEST(ThreadPool, add_work) {
+  ThreadPool pool(4);
+  const int64_t work_num = 1000;
+  std::atomic<int64_t> sum(0);
+  BlockingCounter bc(work_num);
+  FOR_RANGE(int64_t, i, 0, work_num) {
+    pool.AddWork([i, &sum, &bc]() {
+      sum += i;
+      bc.Decrease();
+    });
+  }
+  bc.WaitUntilCntEqualZero();
+  ASSERT_EQ(sum.load(), work_num * (work_num - 1) / 2);
+}
+
+TEST(ThreadPool, parallel_for) {
+  ThreadPool pool(4);
+  for (int64_t grain : {1, 3, 64, 1000}) {
+    std::vector<int64_t> visits(1000, 0);
+    pool.ParallelFor(0, visits.size(), grain, [&](int64_t begin, int64_t end) {
+      ASSERT_LE(end - begin, grain);
+      FOR_RANGE(int64_t, i, begin, end) { visits.at(i) += 1; }
+    });
+    for (int64_t visit : visits) { ASSERT_EQ(visit, 1); }
+  }
+}
+
+TEST(ThreadPool, nested_parallel_for) {
+  ThreadPool pool(2);
+  std::atomic<int64_t> cnt(0);
+  pool.ParallelFor(0, 16, 1, [&](int64_t, int64_t) {
+    pool.ParallelFor(0, 16, 1, [&](int64_t begin, int64_t end) { cnt += end - begin; });
+  });
+  ASSERT_EQ(cnt.load(), 16 * 16);
+}
+
+TEST(ThreadPool, skewed_parallel_for) {
+  ThreadPool pool(4);
+  std::atomic<int64_t> cnt(0);
+  pool.ParallelFor(0, 64, 1, [&](int64_t begin, int64_t) {
+    if (begin == 0) { std::this_thread::sleep_for(std::chrono::milliseconds(50)); }
+    cnt += 1;
+  });
+  ASSERT_EQ(cnt.load(), 64);
+}
+
+}  // namespace oneflow
@@ -0,0 +1,130 @@
+"""
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+"""
+# Times the cpu conv2d forward on the conv layers of ResNet-50, e.g.
+#   python3 cpu_conv_benchmark.py --algo all --data_format NHWC
+# --algo forces an algorithm through ONEFLOW_CPU_CONV_ALGO, shapes it does not apply to fall
+# back to the automatic choice.
+from __future__ import absolute_import, division, print_function
+
+import argparse
+import os
+import subprocess
+import sys
+import time
+
+parser = argparse.ArgumentParser(description="flags for cpu conv benchmark")
+parser.add_argument(
+    "--algo",
+    type=str,
+    default="auto",
+    choices=["auto", "im2col_gemm", "direct", "winograd", "all"],
+)
+parser.add_argument("--data_format", type=str, default="NCHW", choices=["NCHW", "NHWC"])
+parser.add_argument("--batch_size", type=int, default=8)
+parser.add_argument("--iter_num", type=int, default=10)
+parser.add_argument("--warmup_iter_num", type=int, default=2)
+args = parser.parse_args()
+
+# (name, in_channel, out_channel, kernel_size, stride, image_size)
+RESNET50_CONV_SHAPES = [
+    ("conv1", 3, 64, 7, 2, 224),
+    ("res2_1x1_reduce", 256, 64, 1, 1, 56),
+    ("res2_3x3", 64, 64, 3, 1, 56),
+    ("res2_1x1_expand", 64, 256, 1, 1, 56),
+    ("res3_3x3", 128, 128, 3, 1, 28),
+    ("res3_3x3_stride2", 128, 128, 3, 2, 56),
+    ("res4_3x3", 256, 256, 3, 1, 14),
+    ("res4_1x1_expand", 256, 1024, 1, 1, 14),
+    ("res5_3x3", 512, 512, 3, 1, 7),
+]
+
+
+def benchmark(name, in_channel, out_channel, kernel_size, stride, image_size):
+    import numpy as np
+    import oneflow as flow
+    import oneflow.typing as oft
+
+    flow.clear_default_session()
+    func_config = flow.FunctionConfig()
+    func_config.default_data_type(flow.float)
+    if args.data_format == "NCHW":
+        x_shape = (args.batch_size, in_channel, image_size, image_size)
+        weight_shape = (out_channel, in_channel, kernel_size, kernel_size)
+    else:
+        x_shape = (args.batch_size, image_size, image_size, in_channel)
+        weight_shape = (out_channel, kernel_size, kernel_size, in_channel)
+
+    @flow.global_function(type="predict", function_config=func_config)
+    def ConvJob(x: oft.Numpy.Placeholder(x_shape)):
+        with flow.scope.placement("cpu", "0:0"):
+            weight = flow.get_variable(
+                name="weight",
+                shape=weight_shape,
+                initializer=flow.random_uniform_initializer(),
+            )
+            return flow.nn.conv2d(
+                x, weight, strides=stride, padding="SAME", data_format=args.data_format
+            )
+
+    x = np.random.uniform(size=x_shape).astype(np.float32)
+    for _ in range(args.warmup_iter_num):
+        ConvJob(x).get()
+    start = time.time()
+    for _ in range(args.iter_num):
+        ConvJob(x).get()
+    elapsed_ms = (time.time() - start) * 1000 / args.iter_num
+    print(
+        "{:<20} {:>6.2f} ms/iter  {:>8.2f} GFLOPS".format(
+            name,
+            elapsed_ms,
+            2.0
+            * args.batch_size
+            * (image_size // stride) ** 2
+            * out_channel
+            * in_channel
+            * kernel_size ** 2
+            / elapsed_ms
+            / 1e6,
+        )
+    )
+
+
+def main():
+    if args.algo == "all":
+        for algo in ["auto", "im2col_gemm", "direct", "winograd"]:
+            print("algo: {}".format(algo))
+            sys.stdout.flush()
+            # a process per algo, as the choice is made when the kernels are created
+            subprocess.check_call(
+                [
+                    sys.executable,
+                    os.path.abspath(__file__),
+                    "--algo={}".format(algo),
+                    "--data_format={}".format(args.data_format),
+                    "--batch_size={}".format(args.batch_size),
+                    "--iter_num={}".format(args.iter_num),
+                    "--warmup_iter_num={}".format(args.warmup_iter_num),
+                ]
+            )
+        return
+    if args.algo != "auto":
+        os.environ["ONEFLOW_CPU_CONV_ALGO"] = args.algo
+    for shape in RESNET50_CONV_SHAPES:
+        benchmark(*shape)
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,80 @@
+"""
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+"""
+# Times cpu reductions over the shapes each NdarrayReduce path is taken for, e.g.
+#   python3 cpu_reduce_benchmark.py --reduce reduce_max --iter_num 20
+from __future__ import absolute_import, division, print_function
+
+import argparse
+import time
+
+parser = argparse.ArgumentParser(description="flags for cpu reduce benchmark")
+parser.add_argument(
+    "--reduce", type=str, default="reduce_sum", choices=["reduce_sum", "reduce_max"]
+)
+parser.add_argument("--iter_num", type=int, default=10)
+parser.add_argument("--warmup_iter_num", type=int, default=2)
+args = parser.parse_args()
+
+# (name, shape, axis)
+REDUCE_CASES = [
+    ("scalar", (64, 256, 1024), None),
+    ("row_softmax", (4096, 1024), [1]),
+    ("row_short", (262144, 16), [1]),
+    ("col_bias_grad", (4096, 1024), [0]),
+    ("col_narrow", (262144, 16), [0]),
+    ("cube_y_middle_axis", (32, 512, 256), [1]),
+    ("cube_xz_nchw_bn", (32, 64, 56, 56), [0, 2, 3]),
+    ("cube_xz_few_channels", (256, 3, 224, 224), [0, 2, 3]),
+    ("col_nhwc_bn", (32, 56, 56, 64), [0, 1, 2]),
+]
+
+
+def benchmark(name, shape, axis):
+    import numpy as np
+    import oneflow as flow
+    import oneflow.typing as oft
+
+    flow.clear_default_session()
+    func_config = flow.FunctionConfig()
+    func_config.default_data_type(flow.float)
+    reduce_func = getattr(flow.math, args.reduce)
+
+    @flow.global_function(type="predict", function_config=func_config)
+    def ReduceJob(x: oft.Numpy.Placeholder(shape)):
+        with flow.scope.placement("cpu", "0:0"):
+            return reduce_func(x, axis=axis, keepdims=True)
+
+    x = np.random.uniform(size=shape).astype(np.float32)
+    for _ in range(args.warmup_iter_num):
+        ReduceJob(x).get()
+    start = time.time()
+    for _ in range(args.iter_num):
+        ReduceJob(x).get()
+    elapsed_ms = (time.time() - start) * 1000 / args.iter_num
+    print(
+        "{:<22} {:>8.2f} ms/iter  {:>8.2f} GB/s".format(
+            name, elapsed_ms, x.nbytes / elapsed_ms / 1e6
+        )
+    )
+
+
+def main():
+    for case in REDUCE_CASES:
+        benchmark(*case)
+
+
+if __name__ == "__main__":
+    main()
@@ -642,3 +642,11 @@ def GetStructureGraph():
     if error.HasField("error_type"):
         raise JobBuildAndInferError(error)
     return structure_graph
+
+
+def IsSnapshotDone(snapshot_path):
+    return oneflow_internal.IsSnapshotDone(snapshot_path)
+
+
+def WaitForSnapshot(snapshot_path):
+    return oneflow_internal.WaitForSnapshot(snapshot_path)
@@ -15,8 +15,10 @@ limitations under the License.
 """
 import datetime
 import os
+import threading
 
 import numpy as np
+import oneflow.python.framework.c_api_util as c_api_util
 import oneflow.python.framework.hob as hob
 import oneflow.python.framework.job_instance as job_instance
 import oneflow.python.framework.session_context as session_ctx
@@ -62,6 +64,35 @@ class CheckPoint(object):
         assert type(path) is str
         enable_if.unique([lazy_checkpoint_load, eager_checkpoint_load])(path)
 
+    @session_ctx.try_init_default_session
+    def wait(self, path: str) -> None:
+        r"""Block until the checkpoint saved to `path` is written. `save` returns
+        once the model save job is launched, and with
+        `oneflow.config.enable_async_snapshot_writer` the files are flushed in the
+        background even after the job finished.
+
+        Args:
+            path: A `string` of path the checkpoint is saved to.
+        """
+        assert type(path) is str
+        saved_event = _snapshot_path2saved_event.get(path)
+        if saved_event is not None:
+            saved_event.wait()
+        c_api_util.WaitForSnapshot(path)
+
+    @session_ctx.try_init_default_session
+    def is_saved(self, path: str) -> bool:
+        r"""Whether the checkpoint saved to `path` is completely written.
+
+        Args:
+            path: A `string` of path the checkpoint is saved to.
+        """
+        assert type(path) is str
+        saved_event = _snapshot_path2saved_event.get(path)
+        if saved_event is not None and not saved_event.is_set():
+            return False
+        return c_api_util.IsSnapshotDone(path)
+
 
 @enable_if.condition(hob.in_normal_mode & ~hob.eager_execution_enabled)
 def lazy_checkpoint_save(path):
@@ -124,12 +155,20 @@ def _MakeModelLoadJobFunc(path):
     )
 
 
+# set once the model save job of a path finished, until then the job may not even
+# have opened the snapshot
+_snapshot_path2saved_event = {}
+
+
 def _MakeModelSaveJobFunc(path):
+    saved_event = threading.Event()
+    _snapshot_path2saved_event[path] = saved_event
+
     def push_cb(blob):
         blob.CopyFromNdarray(np.frombuffer(path.encode("ascii"), dtype=np.int8))
 
     def finish_cb():
-        pass
+        saved_event.set()
 
     sess = session_ctx.GetDefaultSession()
     return job_instance.MakeJobInstance(
@@ -118,6 +118,78 @@ def comm_net_worker_num(val):
     sess.config_proto.resource.comm_net_worker_num = val
 
 
+@oneflow_export("config.comm_net_stream_num_per_peer")
+def api_comm_net_stream_num_per_peer(val: int) -> None:
+    r"""Set up the number of tcp connections to every peer machine in epoll mode network.
+            With more than one connection, the first one carries actor messages and the
+            others carry register data.
+
+    Args:
+        val (int): number of connections per peer machine
+    """
+    return enable_if.unique([comm_net_stream_num_per_peer, do_nothing])(val)
+
+
+@enable_if.condition(hob.in_normal_mode & ~hob.session_initialized)
+def comm_net_stream_num_per_peer(val):
+    sess = session_ctx.GetDefaultSession()
+    assert type(val) is int
+    sess.config_proto.resource.comm_net_stream_num_per_peer = val
+
+
+@oneflow_export("config.comm_net_stripe_min_kbyte")
+def api_comm_net_stripe_min_kbyte(val: int) -> None:
+    r"""Set up the least size of a piece when a register is striped over the data connections
+            in epoll mode network. Registers smaller than twice of it are not striped.
+
+    Args:
+        val (int): piece size in KB
+    """
+    return enable_if.unique([comm_net_stripe_min_kbyte, do_nothing])(val)
+
+
+@enable_if.condition(hob.in_normal_mode & ~hob.session_initialized)
+def comm_net_stripe_min_kbyte(val):
+    sess = session_ctx.GetDefaultSession()
+    assert type(val) is int
+    sess.config_proto.resource.comm_net_stripe_min_kbyte = val
+
+
+@oneflow_export("config.comm_net_use_zero_copy")
+def api_comm_net_use_zero_copy(val: bool = True) -> None:
+    r"""Whether send large register data with MSG_ZEROCOPY in epoll mode network or not.
+
+    Args:
+        val (bool, optional): True or False. Defaults to True.
+    """
+    return enable_if.unique([comm_net_use_zero_copy, do_nothing])(val=val)
+
+
+@enable_if.condition(hob.in_normal_mode & ~hob.session_initialized)
+def comm_net_use_zero_copy(val=True):
+    sess = session_ctx.GetDefaultSession()
+    assert type(val) is bool
+    sess.config_proto.resource.comm_net_use_zero_copy = val
+
+
+@oneflow_export("config.comm_net_zero_copy_min_kbyte")
+def api_comm_net_zero_copy_min_kbyte(val: int) -> None:
+    r"""Set up the least size of a register piece sent with MSG_ZEROCOPY in epoll mode network.
+            Smaller pieces are copied into the kernel.
+
+    Args:
+        val (int): piece size in KB
+    """
+    return enable_if.unique([comm_net_zero_copy_min_kbyte, do_nothing])(val)
+
+
+@enable_if.condition(hob.in_normal_mode & ~hob.session_initialized)
+def comm_net_zero_copy_min_kbyte(val):
+    sess = session_ctx.GetDefaultSession()
+    assert type(val) is int
+    sess.config_proto.resource.comm_net_zero_copy_min_kbyte = val
+
+
 @oneflow_export("config.max_mdsave_worker_num")
 def api_max_mdsave_worker_num(val: int) -> None:
     r"""Set up max number of workers for mdsave process.
@@ -272,6 +344,58 @@ def thread_enable_local_message_queue(val):
     sess.config_proto.resource.thread_enable_local_message_queue = val
 
 
+@oneflow_export("config.thread_enable_mpsc_mailbox")
+def api_thread_enable_mpsc_mailbox(val: bool) -> None:
+    """Whether or not actor threads receive messages through a lock-free mailbox
+    instead of a mutex protected channel.
+
+    Args:
+        val (bool):  True or False
+    """
+    return enable_if.unique([thread_enable_mpsc_mailbox, do_nothing])(val)
+
+
+@enable_if.condition(hob.in_normal_mode & ~hob.session_initialized)
+def thread_enable_mpsc_mailbox(val):
+    sess = session_ctx.GetDefaultSession()
+    assert type(val) is bool
+    sess.config_proto.resource.thread_enable_mpsc_mailbox = val
+
+
+@oneflow_export("config.thread_mpsc_mailbox_capacity")
+def api_thread_mpsc_mailbox_capacity(val: int) -> None:
+    """Set the number of messages an actor thread mailbox can hold before senders wait.
+
+    Args:
+        val (int): capacity, rounded up to a power of 2
+    """
+    return enable_if.unique([thread_mpsc_mailbox_capacity, do_nothing])(val)
+
+
+@enable_if.condition(hob.in_normal_mode & ~hob.session_initialized)
+def thread_mpsc_mailbox_capacity(val):
+    sess = session_ctx.GetDefaultSession()
+    assert type(val) is int
+    sess.config_proto.resource.thread_mpsc_mailbox_capacity = val
+
+
+@oneflow_export("config.thread_mpsc_mailbox_max_spin_count")
+def api_thread_mpsc_mailbox_max_spin_count(val: int) -> None:
+    """Set the most times an actor thread spins on an empty mailbox before it sleeps.
+
+    Args:
+        val (int): spin count, 0 to sleep at once
+    """
+    return enable_if.unique([thread_mpsc_mailbox_max_spin_count, do_nothing])(val)
+
+
+@enable_if.condition(hob.in_normal_mode & ~hob.session_initialized)
+def thread_mpsc_mailbox_max_spin_count(val):
+    sess = session_ctx.GetDefaultSession()
+    assert type(val) is int
+    sess.config_proto.resource.thread_mpsc_mailbox_max_spin_count = val
+
+
 @oneflow_export("config.enable_debug_mode")
 def api_enable_debug_mode(val: bool) -> None:
     r"""Whether use debug mode or not.
@@ -340,6 +464,147 @@ def enable_model_io_v2(val):
     sess.config_proto.io_conf.enable_model_io_v2 = val
 
 
+@oneflow_export("config.data_reader_worker_num")
+def api_data_reader_worker_num(val: int) -> None:
+    r"""Set up the number of loader workers of each data reader.
+
+    Args:
+        val (int): e.g. 4
+    """
+    return enable_if.unique([data_reader_worker_num, do_nothing])(val)
+
+
+@enable_if.condition(hob.in_normal_mode & ~hob.session_initialized)
+def data_reader_worker_num(val):
+    sess = session_ctx.GetDefaultSession()
+    assert type(val) is int
+    sess.config_proto.resource.data_reader_worker_num = val
+
+
+@oneflow_export("config.data_reader_max_prefetch_batch_num")
+def api_data_reader_max_prefetch_batch_num(val: int) -> None:
+    r"""Set up the most batches each data reader loads ahead of the kernel. The reader starts
+            with 4 and goes deeper whenever the kernel finds no batch ready.
+
+    Args:
+        val (int): e.g. 16
+    """
+    return enable_if.unique([data_reader_max_prefetch_batch_num, do_nothing])(val)
+
+
+@enable_if.condition(hob.in_normal_mode & ~hob.session_initialized)
+def data_reader_max_prefetch_batch_num(val):
+    sess = session_ctx.GetDefaultSession()
+    assert type(val) is int
+    sess.config_proto.resource.data_reader_max_prefetch_batch_num = val
+
+
+@oneflow_export("config.data_reader_ordered")
+def api_data_reader_ordered(val: bool = True) -> None:
+    r"""Whether or not data reader workers deliver batches in load order.
+
+    Args:
+        val (bool, optional): True or False. Defaults to True.
+    """
+    return enable_if.unique([data_reader_ordered, do_nothing])(val=val)
+
+
+@enable_if.condition(hob.in_normal_mode & ~hob.session_initialized)
+def data_reader_ordered(val=True):
+    sess = session_ctx.GetDefaultSession()
+    assert type(val) is bool
+    sess.config_proto.resource.data_reader_ordered = val
+
+
+@oneflow_export("config.enable_mmap_ofrecord_reader")
+def api_enable_mmap_ofrecord_reader(val: bool = True) -> None:
+    r"""Whether or not read OFRecord part files on local file system through mmap.
+
+    Args:
+        val (bool, optional): True or False. Defaults to True.
+    """
+    return enable_if.unique([enable_mmap_ofrecord_reader, do_nothing])(val=val)
+
+
+@enable_if.condition(hob.in_normal_mode & ~hob.session_initialized)
+def enable_mmap_ofrecord_reader(val=True):
+    sess = session_ctx.GetDefaultSession()
+    assert type(val) is bool
+    sess.config_proto.io_conf.enable_mmap_ofrecord_reader = val
+
+
+@oneflow_export("config.enable_async_snapshot_writer")
+def api_enable_async_snapshot_writer(val: bool = True) -> None:
+    r"""Whether or not write checkpoints in the background. Saving returns once the variables
+    are copied to host staging buffers, use `train.CheckPoint.wait` to wait for the files.
+
+    Args:
+        val (bool, optional): True or False. Defaults to True.
+    """
+    return enable_if.unique([enable_async_snapshot_writer, do_nothing])(val=val)
+
+
+@enable_if.condition(hob.in_normal_mode & ~hob.session_initialized)
+def enable_async_snapshot_writer(val=True):
+    sess = session_ctx.GetDefaultSession()
+    assert type(val) is bool
+    sess.config_proto.io_conf.enable_async_snapshot_writer = val
+
+
+@oneflow_export("config.snapshot_flush_thread_num")
+def api_snapshot_flush_thread_num(val: int) -> None:
+    r"""Set number of threads that write checkpoints in the background.
+
+    Args:
+        val (int): number of threads
+    """
+    return enable_if.unique([snapshot_flush_thread_num, do_nothing])(val=val)
+
+
+@enable_if.condition(hob.in_normal_mode & ~hob.session_initialized)
+def snapshot_flush_thread_num(val):
+    sess = session_ctx.GetDefaultSession()
+    assert type(val) is int
+    sess.config_proto.io_conf.snapshot_flush_thread_num = val
+
+
+@oneflow_export("config.snapshot_max_staging_mbyte")
+def api_snapshot_max_staging_mbyte(val: int) -> None:
+    r"""Set the host memory (in MB) that checkpoints written in the background may stage.
+
+    Args:
+        val (int): size in MB
+    """
+    return enable_if.unique([snapshot_max_staging_mbyte, do_nothing])(val=val)
+
+
+@enable_if.condition(hob.in_normal_mode & ~hob.session_initialized)
+def snapshot_max_staging_mbyte(val):
+    sess = session_ctx.GetDefaultSession()
+    assert type(val) is int
+    sess.config_proto.io_conf.snapshot_max_staging_mbyte = val
+
+
+@oneflow_export("config.plan_cache_dir")
+def api_plan_cache_dir(val: str) -> None:
+    r"""Set up the directory the master caches the compiled plans in. A session whose jobs and
+    config are the same as a former one's loads its plan instead of compiling it. The cached
+    plans are never evicted, one is added for every distinct set of jobs and config until the
+    directory is cleared
+
+    Args:
+        val (str): path to the directory
+    """
+    return enable_if.unique([plan_cache_dir, do_nothing])(val)
+
+
+@enable_if.condition(hob.in_normal_mode & ~hob.session_initialized)
+def plan_cache_dir(val):
+    sess = session_ctx.GetDefaultSession()
+    assert type(val) is str
+    sess.config_proto.resource.plan_cache_dir = val
+
+
 @oneflow_export("config.collect_act_event")
 def api_collect_act_event(val: bool = True) -> None:
     r"""Whether or not collect active event.
@@ -574,6 +574,54 @@ def set_prune_cast_to_static_shape_ops(func_desc, value=True):
     func_desc.job_config_proto.prune_cast_to_static_shape_ops = value
 
 
+@oneflow_function_config("fuse_conv_bn_for_inference")
+def set_fuse_conv_bn_for_inference(func_desc, value=True):
+    r"""Whether or not fold inference batch normalizations into the convolutions before them.
+
+    Args:
+        func_desc ([type]): [description]
+        value (bool, optional): [description]. Defaults to True.
+    """
+    func_desc.job_config_proto.fuse_conv_bn_for_inference = value
+
+
+@oneflow_function_config("int8_quantization_for_inference")
+def set_int8_quantization_for_inference(func_desc, value=True):
+    r"""Whether or not run the float matmuls and conv2ds on cpu with int8 weights and activations,
+    together with the bias_add and relu after them.
+
+    Args:
+        func_desc ([type]): [description]
+        value (bool, optional): [description]. Defaults to True.
+    """
+    func_desc.job_config_proto.int8_quantization_for_inference = value
+
+
+@oneflow_function_config("int8_quantization_calibration")
+def set_int8_quantization_calibration(func_desc, value=True):
+    r"""Whether or not record the max absolute value of the inputs of the float matmuls and conv2ds
+    that int8_quantization_for_inference would replace. The values are kept in variables shared
+    with the jobs using int8_quantization_static_scale.
+
+    Args:
+        func_desc ([type]): [description]
+        value (bool, optional): [description]. Defaults to True.
+    """
+    func_desc.job_config_proto.int8_quantization_calibration = value
+
+
+@oneflow_function_config("int8_quantization_static_scale")
+def set_int8_quantization_static_scale(func_desc, value=True):
+    r"""Whether or not quantize the inputs of the int8 ops with the scales recorded by the jobs
+    using int8_quantization_calibration, instead of a scale computed per batch.
+
+    Args:
+        func_desc ([type]): [description]
+        value (bool, optional): [description]. Defaults to True.
+    """
+    func_desc.job_config_proto.int8_quantization_static_scale = value
+
+
 @oneflow_function_config("non_distributed_optimizer_group_size_mbyte")
 def set_non_distributed_optimizer_group_size_mbyte(func_desc, value):
     print(
@@ -630,6 +678,17 @@ def set_enable_auto_mixed_precision(func_desc, value=True):
     func_desc.job_config_proto.enable_auto_mixed_precision = value
 
 
+@oneflow_function_config("enable_auto_mixed_precision_on_cpu")
+def set_enable_auto_mixed_precision_on_cpu(func_desc, value=True):
+    r"""If true, auto mixed precision also casts the ops placed on cpu to float16 when they have cpu float16 kernels. Only inference jobs are cast.
+
+    Args:
+        func_desc ([type]): [description]
+        value (bool, optional): [description]. Defaults to True.
+    """
+    func_desc.job_config_proto.enable_auto_mixed_precision_on_cpu = value
+
+
 @oneflow_function_config("enable_keep_header_only")
 def set_enable_keep_header_only(func_desc, value=True):
     r"""Whether keep header only or not
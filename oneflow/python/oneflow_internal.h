@@ -16,6 +16,7 @@ limitations under the License.
 #include <stdint.h>
 #include "oneflow/python/oneflow_internal_helper.h"
 #include "oneflow/core/job/resource_desc.h"
+#include "oneflow/core/persistence/snapshot.h"
 
 void RegisterForeignCallbackOnlyOnce(oneflow::ForeignCallback* callback, std::string* error_str) {
   return oneflow::RegisterForeignCallbackOnlyOnce(callback).GetDataAndSerializedErrorProto(
@@ -294,3 +295,11 @@ void CacheInt8Calibration(std::string* error_str) {
 void WriteInt8Calibration(const std::string& path, std::string* error_str) {
   oneflow::WriteInt8Calibration(path).GetDataAndSerializedErrorProto(error_str);
 }
+
+bool IsSnapshotDone(const std::string& snapshot_path) {
+  return oneflow::IsSnapshotDone(snapshot_path);
+}
+
+void WaitForSnapshot(const std::string& snapshot_path) {
+  return oneflow::WaitForSnapshot(snapshot_path);
+}
@@ -288,6 +288,8 @@ def ofrecord_reader(
     random_shuffle: bool = False,
     shuffle_buffer_size: int = 1024,
     shuffle_after_epoch: bool = False,
+    global_shuffle: bool = False,
+    seed: int = -1,
     name: Optional[str] = None,
 ) -> remote_blob_util.BlobDef:
     r"""Get ofrecord object from ofrecord dataset.
@@ -301,6 +303,8 @@ def ofrecord_reader(
         random_shuffle (bool, optional): Determines records shuffled or not. Defaults to False.
         shuffle_buffer_size (int, optional): Shuffle buffer size. Defaults to 1024.
         shuffle_after_epoch (bool, optional): Shuffled or not after each epoch. Defaults to False.
+        global_shuffle (bool, optional): Read every epoch in the order of a seeded permutation over all records of all parts, instead of a buffered shuffle. Needs the dataset on local file system. Defaults to False.
+        seed (int, optional): Seed of the global shuffle permutation, -1 means a fixed default seed. Defaults to -1.
         name (Optional[str], optional): Optional name. Defaults to None.
         
     Returns:
@@ -320,6 +324,8 @@ def ofrecord_reader(
         .Attr("random_shuffle", random_shuffle)
         .Attr("shuffle_buffer_size", shuffle_buffer_size)
         .Attr("shuffle_after_epoch", shuffle_after_epoch)
+        .Attr("global_shuffle", global_shuffle)
+        .Attr("seed", seed)
         .Attr("part_name_suffix_length", part_name_suffix_length)
         .Build()
         .InferAndTryRun()
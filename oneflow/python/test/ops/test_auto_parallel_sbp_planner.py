@@ -0,0 +1,83 @@
+"""
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+"""
+import os
+
+import numpy as np
+import oneflow as flow
+import oneflow.python.framework.c_api_util as c_api_util
+import oneflow.python.framework.env_util as env_util
+import oneflow.typing as oft
+
+
+def _plan_report(job_name):
+    # the job id is the index of the job in the job set, the report is in the log dir
+    job_set = c_api_util.GetJobSet()
+    job_names = [job.job_conf.job_name for job in job_set.job]
+    job = job_set.job[job_names.index(job_name)]
+    report_path = os.path.join(
+        env_util.default_env_proto.cpp_logging_conf.log_dir,
+        "auto_parallel_sbp_plan_{}".format(job_names.index(job_name)),
+    )
+    with open(report_path) as f:
+        lines = f.read().splitlines()
+    # greedy: cost 123.000000 (compute ...
+    costs = {}
+    for line in lines[:2]:
+        name, rest = line.split(": cost ")
+        costs[name] = float(rest.split(" ")[0])
+    changed_op_names = [line.split("\t")[0] for line in lines[3:] if line]
+    return job, costs, changed_op_names
+
+
+def _run_dense_chain(x, enable_planner):
+    flow.clear_default_session()
+    flow.config.cpu_device_num(2)
+    func_config = flow.FunctionConfig()
+    func_config.default_data_type(flow.float)
+    func_config.enable_auto_parallel_sbp_planner(enable_planner)
+
+    @flow.global_function(type="predict", function_config=func_config)
+    def DenseChainJob(x: oft.Numpy.Placeholder(x.shape)):
+        with flow.scope.placement("cpu", "0:0-1"):
+            out = x
+            for i, units in enumerate([256, 8, 256]):
+                out = flow.layers.dense(
+                    out,
+                    units=units,
+                    activation=flow.math.relu,
+                    kernel_initializer=flow.constant_initializer(0.01 * (i + 1)),
+                    bias_initializer=flow.constant_initializer(0.1),
+                    name="dense{}".format(i),
+                )
+            return out
+
+    check_point = flow.train.CheckPoint()
+    check_point.init()
+    return DenseChainJob(x).get().numpy()
+
+
+def test_auto_parallel_sbp_planner(test_case):
+    x = np.random.uniform(low=-1, high=1, size=(4, 512)).astype(np.float32)
+    greedy_out = _run_dense_chain(x, False)
+    planned_out = _run_dense_chain(x, True)
+    test_case.assertTrue(np.allclose(greedy_out, planned_out, rtol=1e-4, atol=1e-5))
+
+    job, costs, changed_op_names = _plan_report("DenseChainJob")
+    test_case.assertGreater(len(changed_op_names), 0)
+    test_case.assertLessEqual(costs["planned"], costs["greedy"])
+    sbp_signature_conf = job.job_parallel_view_conf.op_name2sbp_signature_conf
+    for op_name in changed_op_names:
+        test_case.assertIn(op_name, sbp_signature_conf)
@@ -416,3 +416,60 @@ def test_batchnorm_fp16(test_case):
             x_diff_rtol=1e-3,
             x_diff_atol=1e-3
         )
+
+
+def CompareConvBnFusedWithUnfused(device_type, data_format, use_bias):
+    flow.clear_default_session()
+    x = np.random.uniform(low=-1, high=1, size=(2, 3, 9, 9)).astype(np.float32)
+    if data_format == "NHWC":
+        x = np.transpose(x, (0, 2, 3, 1))
+    axis = 1 if data_format == "NCHW" else 3
+
+    def MakeJob(fuse_conv_bn):
+        func_config = flow.FunctionConfig()
+        func_config.default_data_type(flow.float)
+        func_config.fuse_conv_bn_for_inference(fuse_conv_bn)
+
+        @flow.global_function(type="predict", function_config=func_config)
+        def ConvBnJob(x: oft.Numpy.Placeholder(x.shape)):
+            with flow.scope.placement(device_type, "0:0"):
+                uniform = flow.random_uniform_initializer(minval=0.5, maxval=2)
+                y = flow.layers.conv2d(
+                    x,
+                    filters=4,
+                    kernel_size=3,
+                    data_format=data_format,
+                    use_bias=use_bias,
+                    kernel_initializer=flow.random_uniform_initializer(),
+                    bias_initializer=flow.random_uniform_initializer(),
+                    name="conv",
+                )
+                return flow.layers.batch_normalization(
+                    y,
+                    axis=axis,
+                    beta_initializer=uniform,
+                    gamma_initializer=uniform,
+                    moving_mean_initializer=flow.random_uniform_initializer(),
+                    moving_variance_initializer=uniform,
+                    training=False,
+                    name="bn",
+                )
+
+        return ConvBnJob
+
+    unfused_job = MakeJob(False)
+    fused_job = MakeJob(True)
+    check_point = flow.train.CheckPoint()
+    check_point.init()
+    assert np.allclose(
+        unfused_job(x).get().numpy(), fused_job(x).get().numpy(), rtol=1e-4, atol=1e-4
+    )
+
+
+def test_fuse_conv_bn_for_inference(test_case):
+    arg_dict = OrderedDict()
+    arg_dict["device_type"] = ["cpu", "gpu"]
+    arg_dict["data_format"] = ["NCHW", "NHWC"]
+    arg_dict["use_bias"] = [True, False]
+    for arg in GenArgDict(arg_dict):
+        CompareConvBnFusedWithUnfused(**arg)
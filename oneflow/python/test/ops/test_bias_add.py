@@ -127,3 +127,38 @@ def test_bias_add_nhwc(test_case):
     arg_dict["op_args"] = [Args(["NHWC"])]
     for arg in GenArgDict(arg_dict):
         CompareBiasAddWithTensorFlow(**arg)
+
+
+def compare_half_bias_add_on_cpu(value_shape, bias_shape, data_format):
+    flow.clear_default_session()
+    func_config = flow.FunctionConfig()
+    func_config.default_data_type(flow.float)
+
+    @flow.global_function(function_config=func_config)
+    def FlowJob(
+        value: oft.Numpy.Placeholder(value_shape),
+        bias: oft.Numpy.Placeholder(bias_shape),
+    ):
+        with flow.scope.placement("cpu", "0:0"):
+            y = flow.nn.bias_add(
+                flow.cast(value, flow.float16), flow.cast(bias, flow.float16), data_format
+            )
+            return flow.cast(y, flow.float)
+
+    value = np.random.uniform(low=-10, high=10, size=value_shape).astype(np.float32)
+    bias = np.random.uniform(low=-10, high=10, size=bias_shape).astype(np.float32)
+    of_y = FlowJob(value, bias).get().numpy()
+    # the sum of the half inputs is computed in float and rounded to half once
+    bias_axis = 1 if data_format == "NCHW" else len(value_shape) - 1
+    broadcast_shape = [1] * len(value_shape)
+    broadcast_shape[bias_axis] = bias_shape[0]
+    np_y = value.astype(np.float16).astype(np.float32) + bias.astype(np.float16).astype(
+        np.float32
+    ).reshape(broadcast_shape)
+    assert np.array_equal(of_y, np_y.astype(np.float16).astype(np.float32))
+
+
+def test_half_bias_add_on_cpu(test_case):
+    compare_half_bias_add_on_cpu((1, 20, 1, 11), (20,), "NCHW")
+    compare_half_bias_add_on_cpu((30, 20, 5, 10), (10,), "NHWC")
+    compare_half_bias_add_on_cpu((2, 4096, 3), (4096,), "NCHW")
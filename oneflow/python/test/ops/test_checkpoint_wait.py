@@ -0,0 +1,74 @@
+"""
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+"""
+import os
+import shutil
+import tempfile
+
+import numpy as np
+import oneflow as flow
+import oneflow.typing as tp
+
+
+def _make_train_func(shape):
+    @flow.global_function(type="train")
+    def train(x: tp.Numpy.Placeholder(shape=shape)) -> tp.Numpy:
+        var = flow.get_variable(
+            name="var",
+            shape=shape,
+            dtype=flow.float32,
+            initializer=flow.random_uniform_initializer(),
+        )
+        y = var + x
+        flow.optimizer.SGD(
+            flow.optimizer.PiecewiseConstantScheduler([], [1e-2]), momentum=0
+        ).minimize(y)
+        return var
+
+    return train
+
+
+def _test_checkpoint_wait(test_case, enable_async_snapshot_writer):
+    flow.clear_default_session()
+    flow.config.enable_async_snapshot_writer(enable_async_snapshot_writer)
+    shape = (64, 1024)
+    train = _make_train_func(shape)
+    check_point = flow.train.CheckPoint()
+    check_point.init()
+    tmp_dir = tempfile.mkdtemp()
+    try:
+        saved_vars = []
+        for i in range(4):
+            # the variable before the step, so the one the previous save wrote
+            var = train(np.random.rand(*shape).astype(np.float32))
+            if i > 0:
+                test_case.assertTrue(np.array_equal(saved_vars[-1], var))
+            path = os.path.join(tmp_dir, "snapshot-{}".format(i))
+            check_point.save(path)
+            check_point.wait(path)
+            test_case.assertTrue(check_point.is_saved(path))
+            var_path = os.path.join(path, "var", "out")
+            saved_vars.append(np.fromfile(var_path, dtype=np.float32).reshape(shape))
+    finally:
+        flow.clear_default_session()
+        shutil.rmtree(tmp_dir)
+
+
+def test_checkpoint_wait(test_case):
+    _test_checkpoint_wait(test_case, False)
+
+
+def test_checkpoint_wait_async_snapshot_writer(test_case):
+    _test_checkpoint_wait(test_case, True)
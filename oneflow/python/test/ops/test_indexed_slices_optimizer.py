@@ -0,0 +1,112 @@
+"""
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+"""
+import numpy as np
+import oneflow as flow
+import oneflow.typing as oft
+
+num_rows = 64
+feature_size = 8
+num_indices = 32
+lr = 0.1
+
+
+def _np_update(optimizer, model, states, indices, values, step):
+    grad = {}
+    for i, row in enumerate(indices):
+        grad[row] = grad.get(row, 0) + values[i]
+    for row, diff in grad.items():
+        if optimizer == "naive":
+            model[row] -= lr * diff
+        elif optimizer == "momentum":
+            states[0][row] = 0.9 * states[0][row] - lr * diff
+            model[row] += states[0][row]
+        else:
+            beta1, beta2, epsilon = 0.9, 0.999, 1e-8
+            beta1_t, beta2_t = beta1 ** (step + 1), beta2 ** (step + 1)
+            bias_correction = np.sqrt(1 - beta2_t) / (1 - beta1_t)
+            states[0][row] = beta1 * states[0][row] + (1 - beta1) * diff
+            states[1][row] = beta2 * states[1][row] + (1 - beta2) * diff * diff
+            denom = np.sqrt(states[1][row]) + epsilon
+            model[row] -= lr * bias_correction * states[0][row] / denom
+
+
+def _run_test(test_case, optimizer):
+    flow.clear_default_session()
+
+    def Embedding():
+        return flow.get_variable(
+            "embedding",
+            shape=(num_rows, feature_size),
+            dtype=flow.float32,
+            initializer=flow.random_uniform_initializer(),
+        )
+
+    func_config = flow.FunctionConfig()
+    func_config.default_data_type(flow.float)
+    func_config.default_logical_view(flow.scope.consistent_view())
+    func_config.indexed_slices_optimizer_conf(
+        dict(include_op_names=dict(op_name=["embedding"]))
+    )
+
+    @flow.global_function(type="train", function_config=func_config)
+    def TrainJob(
+        indices: oft.Numpy.Placeholder((num_indices,), dtype=flow.int32),
+        values: oft.Numpy.Placeholder((num_indices, feature_size)),
+    ):
+        with flow.scope.placement("cpu", "0:0"):
+            loss = flow.gather(Embedding(), indices) * values
+            lr_scheduler = flow.optimizer.PiecewiseConstantScheduler([], [lr])
+            if optimizer == "naive":
+                flow.optimizer.SGD(lr_scheduler, momentum=0).minimize(loss)
+            elif optimizer == "momentum":
+                flow.optimizer.SGD(lr_scheduler, momentum=0.9).minimize(loss)
+            else:
+                flow.optimizer.LazyAdam(lr_scheduler).minimize(loss)
+
+    eval_config = flow.FunctionConfig()
+    eval_config.default_logical_view(flow.scope.consistent_view())
+
+    @flow.global_function(function_config=eval_config)
+    def EvalJob():
+        with flow.scope.placement("cpu", "0:0"):
+            return Embedding()
+
+    check_point = flow.train.CheckPoint()
+    check_point.init()
+    init = EvalJob().get().numpy()
+
+    model = init.copy()
+    states = [np.zeros_like(init), np.zeros_like(init)]
+    for step in range(3):
+        # repeated indices, and rows touched in one step but not the next
+        indices = np.random.randint(0, num_rows, num_indices).astype(np.int32)
+        values = np.random.rand(num_indices, feature_size).astype(np.float32)
+        TrainJob(indices, values).wait()
+        _np_update(optimizer, model, states, indices, values, step)
+    of_model = EvalJob().get().numpy()
+    test_case.assertTrue(np.allclose(of_model, model, rtol=1e-4, atol=1e-5))
+
+
+def test_indexed_slices_naive_optimizer_cpu(test_case):
+    _run_test(test_case, "naive")
+
+
+def test_indexed_slices_momentum_optimizer_cpu(test_case):
+    _run_test(test_case, "momentum")
+
+
+def test_indexed_slices_lazy_adam_optimizer_cpu(test_case):
+    _run_test(test_case, "lazy_adam")
@@ -0,0 +1,272 @@
+"""
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+"""
+import os
+import shutil
+import tempfile
+from collections import OrderedDict
+
+import numpy as np
+import oneflow as flow
+import oneflow.python.framework.c_api_util as c_api_util
+from test_util import GenArgDict
+import oneflow.typing as oft
+
+
+def _op_type_names(job_name):
+    for job in c_api_util.GetJobSet().job:
+        if job.job_conf.job_name == job_name:
+            return [
+                op.user_conf.op_type_name
+                for op in job.net.op
+                if op.HasField("user_conf")
+            ]
+    raise ValueError("no job named " + job_name)
+
+
+def _compare_int8_with_float(make_job, x, op_type_name):
+    float_job = make_job(False)
+    int8_job = make_job(True)
+    check_point = flow.train.CheckPoint()
+    check_point.init()
+    float_out = float_job(x).get().numpy()
+    int8_out = int8_job(x).get().numpy()
+    float_op_type_names = _op_type_names(float_job.__name__)
+    int8_op_type_names = _op_type_names(int8_job.__name__)
+    assert op_type_name in float_op_type_names
+    assert "int8_" + op_type_name not in float_op_type_names
+    assert op_type_name not in int8_op_type_names
+    assert "int8_" + op_type_name in int8_op_type_names
+    # per channel int8 weights and per tensor int8 activations
+    atol = 0.03 * np.max(np.abs(float_out))
+    assert np.allclose(float_out, int8_out, rtol=0, atol=atol)
+
+
+def CompareDenseInt8WithFloat(use_bias):
+    flow.clear_default_session()
+    x = np.random.uniform(low=-1, high=1, size=(5, 37)).astype(np.float32)
+
+    def MakeJob(int8_quantization):
+        func_config = flow.FunctionConfig()
+        func_config.default_data_type(flow.float)
+        func_config.int8_quantization_for_inference(int8_quantization)
+
+        def DenseJob(x: oft.Numpy.Placeholder(x.shape)):
+            with flow.scope.placement("cpu", "0:0"):
+                hidden = flow.layers.dense(
+                    x,
+                    units=70,
+                    activation=flow.math.relu,
+                    use_bias=use_bias,
+                    kernel_initializer=flow.random_uniform_initializer(),
+                    bias_initializer=flow.random_uniform_initializer(),
+                    name="dense1",
+                )
+                return flow.layers.dense(
+                    hidden,
+                    units=9,
+                    use_bias=use_bias,
+                    kernel_initializer=flow.random_uniform_initializer(),
+                    bias_initializer=flow.random_uniform_initializer(),
+                    name="dense2",
+                )
+
+        DenseJob.__name__ = "DenseInt8Job" if int8_quantization else "DenseFloatJob"
+        return flow.global_function(type="predict", function_config=func_config)(
+            DenseJob
+        )
+
+    _compare_int8_with_float(MakeJob, x, "matmul")
+
+
+def CompareConv2dInt8WithFloat(data_format, use_bias, kernel_size):
+    flow.clear_default_session()
+    x = np.random.uniform(low=-1, high=1, size=(2, 3, 9, 9)).astype(np.float32)
+    if data_format == "NHWC":
+        x = np.transpose(x, (0, 2, 3, 1))
+
+    def MakeJob(int8_quantization):
+        func_config = flow.FunctionConfig()
+        func_config.default_data_type(flow.float)
+        func_config.int8_quantization_for_inference(int8_quantization)
+
+        def Conv2dJob(x: oft.Numpy.Placeholder(x.shape)):
+            with flow.scope.placement("cpu", "0:0"):
+                return flow.layers.conv2d(
+                    x,
+                    filters=6,
+                    kernel_size=kernel_size,
+                    padding="SAME",
+                    data_format=data_format,
+                    activation=flow.math.relu,
+                    use_bias=use_bias,
+                    kernel_initializer=flow.random_uniform_initializer(),
+                    bias_initializer=flow.random_uniform_initializer(),
+                    name="conv",
+                )
+
+        Conv2dJob.__name__ = "Conv2dInt8Job" if int8_quantization else "Conv2dFloatJob"
+        return flow.global_function(type="predict", function_config=func_config)(
+            Conv2dJob
+        )
+
+    _compare_int8_with_float(MakeJob, x, "conv2d")
+
+
+def _int8_quantize(x, scale):
+    # rounds half away from zero and clamps like Int8Quantize
+    v = np.clip(x * (np.float32(1) / scale), -127, 127)
+    return np.trunc(np.where(v < 0, v - 0.5, v + 0.5)).astype(np.int32)
+
+
+def _int8_dense_reference(x, w, b, x_absmax):
+    x_scale = np.float32(x_absmax) / np.float32(127)
+    w_scale = np.max(np.abs(w), axis=1).astype(np.float32) / np.float32(127)
+    acc = np.matmul(_int8_quantize(x, x_scale), _int8_quantize(w, w_scale[:, None]).T)
+    return acc.astype(np.float32) * (x_scale * w_scale) + b
+
+
+def test_int8_quantization_calibration(test_case):
+    flow.clear_default_session()
+    batch_shape = (6, 29)
+    units = 11
+
+    def Dense(x):
+        with flow.scope.placement("cpu", "0:0"):
+            w = flow.get_variable(
+                "calibrated_weight",
+                shape=(units, batch_shape[1]),
+                initializer=flow.random_uniform_initializer(),
+            )
+            b = flow.get_variable(
+                "calibrated_bias",
+                shape=(units,),
+                initializer=flow.random_uniform_initializer(),
+            )
+            return flow.nn.bias_add(flow.matmul(x, w, transpose_b=True), b), w, b
+
+    calibrate_config = flow.FunctionConfig()
+    calibrate_config.default_data_type(flow.float)
+    calibrate_config.int8_quantization_calibration(True)
+
+    @flow.global_function(type="predict", function_config=calibrate_config)
+    def CalibrateJob(x: oft.Numpy.Placeholder(batch_shape)):
+        return Dense(x)
+
+    int8_config = flow.FunctionConfig()
+    int8_config.default_data_type(flow.float)
+    int8_config.int8_quantization_for_inference(True)
+    int8_config.int8_quantization_static_scale(True)
+
+    @flow.global_function(type="predict", function_config=int8_config)
+    def StaticScaleInt8Job(x: oft.Numpy.Placeholder(batch_shape)):
+        return Dense(x)[0]
+
+    check_point = flow.train.CheckPoint()
+    check_point.init()
+    x_absmax = 0
+    for _ in range(3):
+        x = np.random.uniform(low=-1, high=1, size=batch_shape).astype(np.float32)
+        x_absmax = max(x_absmax, np.max(np.abs(x)))
+        _, w, b = CalibrateJob(x).get()
+    w = w.numpy()
+    b = b.numpy()
+    calibrate_op_type_names = _op_type_names("CalibrateJob")
+    test_case.assertEqual(calibrate_op_type_names.count("int8_calibrate_absmax"), 1)
+    test_case.assertIn("matmul", calibrate_op_type_names)
+    int8_op_type_names = _op_type_names("StaticScaleInt8Job")
+    test_case.assertIn("int8_matmul", int8_op_type_names)
+    test_case.assertNotIn("matmul", int8_op_type_names)
+
+    # beyond the calibrated range, so the values clamped by the static scale tell it
+    # from the scale of the batch
+    x = np.random.uniform(low=-2, high=2, size=batch_shape).astype(np.float32)
+    x[0, 0] = 2
+    int8_out = StaticScaleInt8Job(x).get().numpy()
+    static_out = _int8_dense_reference(x, w, b, x_absmax)
+    dynamic_out = _int8_dense_reference(x, w, b, np.max(np.abs(x)))
+    atol = 1e-5 * np.max(np.abs(static_out))
+    test_case.assertTrue(np.allclose(int8_out, static_out, rtol=1e-5, atol=atol))
+    test_case.assertFalse(np.allclose(int8_out, dynamic_out, rtol=1e-5, atol=atol))
+
+
+def test_int8_quantization_after_model_load(test_case):
+    # a model init or load rewrites the weight of the int8 matmul in place, the next
+    # predict step has to quantize the new one
+    flow.clear_default_session()
+    batch_shape = (6, 29)
+    units = 11
+    int8_config = flow.FunctionConfig()
+    int8_config.default_data_type(flow.float)
+    int8_config.int8_quantization_for_inference(True)
+
+    @flow.global_function(type="predict", function_config=int8_config)
+    def Int8Job(x: oft.Numpy.Placeholder(batch_shape)):
+        with flow.scope.placement("cpu", "0:0"):
+            w = flow.get_variable(
+                "loaded_weight",
+                shape=(units, batch_shape[1]),
+                initializer=flow.random_uniform_initializer(),
+            )
+            b = flow.get_variable(
+                "loaded_bias",
+                shape=(units,),
+                initializer=flow.random_uniform_initializer(),
+            )
+            return flow.nn.bias_add(flow.matmul(x, w, transpose_b=True), b), w, b
+
+    def CheckPredict(x):
+        int8_out, w, b = Int8Job(x).get()
+        w = w.numpy()
+        b = b.numpy()
+        ref_out = _int8_dense_reference(x, w, b, np.max(np.abs(x)))
+        atol = 1e-5 * np.max(np.abs(ref_out))
+        test_case.assertTrue(
+            np.allclose(int8_out.numpy(), ref_out, rtol=1e-5, atol=atol)
+        )
+        return w
+
+    check_point = flow.train.CheckPoint()
+    check_point.init()
+    x = np.random.uniform(low=-1, high=1, size=batch_shape).astype(np.float32)
+    tmp_dir = tempfile.mkdtemp()
+    try:
+        initial_w = CheckPredict(x)
+        snapshot_path = os.path.join(tmp_dir, "snapshot")
+        check_point.save(snapshot_path)
+        check_point.wait(snapshot_path)
+        check_point.init()
+        reinitialized_w = CheckPredict(x)
+        test_case.assertFalse(np.array_equal(reinitialized_w, initial_w))
+        check_point.load(snapshot_path)
+        loaded_w = CheckPredict(x)
+        test_case.assertTrue(np.array_equal(loaded_w, initial_w))
+    finally:
+        shutil.rmtree(tmp_dir)
+    test_case.assertIn("int8_matmul", _op_type_names("Int8Job"))
+
+
+def test_int8_quantization_dense(test_case):
+    for use_bias in [True, False]:
+        CompareDenseInt8WithFloat(use_bias)
+
+
+def test_int8_quantization_conv2d(test_case):
+    arg_dict = OrderedDict()
+    arg_dict["data_format"] = ["NCHW", "NHWC"]
+    arg_dict["use_bias"] = [True, False]
+    arg_dict["kernel_size"] = [1, 3]
+    for arg in GenArgDict(arg_dict):
+        CompareConv2dInt8WithFloat(**arg)
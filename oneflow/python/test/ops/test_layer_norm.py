@@ -31,6 +31,7 @@ for gpu in gpus:
 def test_layer_norm(_):
     confs = [
         {"x_shape": (4, 5, 2, 6), "begin_norm_axis": -1, "begin_params_axis": -1},
+        {"x_shape": (8, 3, 1029), "begin_norm_axis": -1, "begin_params_axis": -1},
     ]
     arg_dict = OrderedDict()
     arg_dict["device_type"] = ["cpu", "gpu"]
@@ -21,6 +21,7 @@ import oneflow as flow
 import tensorflow as tf
 import test_global_storage
 from test_util import GenArgList
+import oneflow.typing as oft
 
 gpus = tf.config.experimental.list_physical_devices("GPU")
 for gpu in gpus:
@@ -126,3 +127,42 @@ def gen_arg_list():
 def test_matmul(test_case):
     for arg in gen_arg_list():
         compare_with_tensorflow(*arg)
+
+
+def compare_half_matmul_on_cpu(a_shape, b_shape, transpose_a, transpose_b):
+    flow.clear_default_session()
+    func_config = flow.FunctionConfig()
+    func_config.default_data_type(flow.float)
+    func_config.enable_auto_mixed_precision(True)
+    func_config.enable_auto_mixed_precision_on_cpu(True)
+
+    @flow.global_function(function_config=func_config)
+    def MatmulJob(
+        a: oft.Numpy.Placeholder(a_shape), b: oft.Numpy.Placeholder(b_shape)
+    ):
+        with flow.scope.placement("cpu", "0:0"):
+            return flow.matmul(a, b, transpose_a, transpose_b)
+
+    a = np.random.uniform(low=-1, high=1, size=a_shape).astype(np.float32)
+    b = np.random.uniform(low=-1, high=1, size=b_shape).astype(np.float32)
+    of_out = MatmulJob(a, b).get().numpy()
+    # the inputs are rounded to half, the products accumulate in float
+    a_half = a.astype(np.float16).astype(np.float32)
+    b_half = b.astype(np.float16).astype(np.float32)
+    if transpose_a:
+        a_half = np.swapaxes(a_half, -1, -2)
+    if transpose_b:
+        b_half = np.swapaxes(b_half, -1, -2)
+    np_out = np.matmul(a_half, b_half)
+    assert np.allclose(of_out, np_out, rtol=1e-2, atol=1e-2), np.max(
+        np.abs(of_out - np_out)
+    )
+
+
+def test_half_matmul_on_cpu(test_case):
+    compare_half_matmul_on_cpu((64, 256), (256, 128), False, False)
+    compare_half_matmul_on_cpu((256, 64), (128, 256), True, True)
+    compare_half_matmul_on_cpu((4, 32, 64), (4, 64, 16), False, False)
+    # several panels along every dimension
+    compare_half_matmul_on_cpu((130, 300), (260, 300), False, True)
+    compare_half_matmul_on_cpu((300, 130), (300, 260), True, False)
@@ -14,10 +14,13 @@ See the License for the specific language governing permissions and
 limitations under the License.
 """
 import os
+import shutil
+import tempfile
 from collections import OrderedDict
 
 import numpy as np
 import oneflow as flow
+import oneflow.typing as oft
 import tensorflow as tf
 import test_global_storage
 from test_util import GenArgList
@@ -208,6 +211,221 @@ def test_cpu3(test_case):
         compare_with_tensorflow(*arg)
 
 
+def compare_cpu_conv_algo(algo, x_shape, filters, data_format, padding):
+    old_algo = os.environ.get("ONEFLOW_CPU_CONV_ALGO")
+    os.environ["ONEFLOW_CPU_CONV_ALGO"] = algo
+    try:
+        compare_with_tensorflow(
+            "cpu", x_shape, filters, 3, 1, data_format=data_format, padding=padding
+        )
+    finally:
+        if old_algo is None:
+            del os.environ["ONEFLOW_CPU_CONV_ALGO"]
+        else:
+            os.environ["ONEFLOW_CPU_CONV_ALGO"] = old_algo
+
+
+def test_cpu_winograd(test_case):
+    arg_dict = OrderedDict()
+    arg_dict["algo"] = ["winograd"]
+    arg_dict["x_shape"] = [(2, 128, 14, 14)]
+    arg_dict["filters"] = [128, 160]
+    arg_dict["data_format"] = ["NCHW"]
+    arg_dict["padding"] = ["SAME", "VALID"]
+    for arg in GenArgList(arg_dict):
+        compare_cpu_conv_algo(*arg)
+    arg_dict["x_shape"] = [(2, 14, 14, 128)]
+    arg_dict["data_format"] = ["NHWC"]
+    for arg in GenArgList(arg_dict):
+        compare_cpu_conv_algo(*arg)
+
+
+def test_cpu_direct(test_case):
+    arg_dict = OrderedDict()
+    arg_dict["algo"] = ["direct"]
+    arg_dict["x_shape"] = [(2, 128, 14, 14)]
+    arg_dict["filters"] = [128, 160]
+    arg_dict["data_format"] = ["NCHW"]
+    arg_dict["padding"] = ["SAME", "VALID"]
+    for arg in GenArgList(arg_dict):
+        compare_cpu_conv_algo(*arg)
+    arg_dict["x_shape"] = [(2, 14, 14, 128)]
+    arg_dict["data_format"] = ["NHWC"]
+    for arg in GenArgList(arg_dict):
+        compare_cpu_conv_algo(*arg)
+
+
+def compare_cpu_conv_predict_after_weight_update(test_case, algo, half):
+    # a train job and a model load rewrite the weight the predict job convolves with in
+    # place, the predict output has to follow it. With half the predict job convolves in
+    # float16, the train job always in float.
+    old_algo = os.environ.get("ONEFLOW_CPU_CONV_ALGO")
+    os.environ["ONEFLOW_CPU_CONV_ALGO"] = algo
+    tmp_dir = tempfile.mkdtemp()
+    try:
+        flow.clear_default_session()
+        x_shape = (2, 64, 14, 14)
+        weight_shape = (64, 64, 3, 3)
+
+        def ConvWithWeight(x, half):
+            weight = flow.get_variable(
+                "conv-weight",
+                shape=weight_shape,
+                dtype=flow.float,
+                initializer=flow.random_uniform_initializer(minval=-1, maxval=1),
+            )
+            if not half:
+                y = flow.nn.conv2d(
+                    x, weight, strides=[1, 1], padding="SAME", data_format="NCHW"
+                )
+                return y, weight
+            y = flow.nn.conv2d(
+                flow.cast(x, flow.float16),
+                flow.cast(weight, flow.float16),
+                strides=[1, 1],
+                padding="SAME",
+                data_format="NCHW",
+            )
+            return flow.cast(y, flow.float), weight
+
+        @flow.global_function(type="train")
+        def TrainJob(x: oft.Numpy.Placeholder(x_shape)):
+            with flow.scope.placement("cpu", "0:0"):
+                y, _ = ConvWithWeight(x, False)
+                loss = flow.math.reduce_mean(y)
+                flow.optimizer.SGD(
+                    flow.optimizer.PiecewiseConstantScheduler([], [10.0]), momentum=0
+                ).minimize(loss)
+                return loss
+
+        @flow.global_function(type="predict")
+        def PredictJob(x: oft.Numpy.Placeholder(x_shape)):
+            with flow.scope.placement("cpu", "0:0"):
+                y, weight = ConvWithWeight(x, half)
+                flow.watch(weight, test_global_storage.Setter("weight"))
+                return y
+
+        def CheckPredict(x):
+            of_out = PredictJob(x).get().numpy()
+            weight = test_global_storage.Get("weight")
+            dtype = np.float16 if half else np.float32
+            tol = 1e-2 if half else 1e-4
+            tf_out = tf.nn.conv2d(
+                x.astype(dtype).astype(np.float32).transpose(0, 2, 3, 1),
+                weight.astype(dtype).astype(np.float32).transpose(2, 3, 1, 0),
+                strides=[1, 1, 1, 1],
+                padding="SAME",
+                data_format="NHWC",
+            ).numpy()
+            test_case.assertTrue(
+                np.allclose(of_out.transpose(0, 2, 3, 1), tf_out, rtol=tol, atol=tol)
+            )
+            return weight
+
+        check_point = flow.train.CheckPoint()
+        check_point.init()
+        x = np.random.uniform(-1, 1, x_shape).astype(np.float32)
+        initial_weight = CheckPredict(x)
+        CheckPredict(x)
+        snapshot_path = os.path.join(tmp_dir, "snapshot")
+        check_point.save(snapshot_path)
+        check_point.wait(snapshot_path)
+        TrainJob(x).get()
+        trained_weight = CheckPredict(x)
+        test_case.assertFalse(np.allclose(trained_weight, initial_weight))
+        check_point.load(snapshot_path)
+        loaded_weight = CheckPredict(x)
+        test_case.assertTrue(np.array_equal(loaded_weight, initial_weight))
+    finally:
+        flow.clear_default_session()
+        shutil.rmtree(tmp_dir)
+        if old_algo is None:
+            del os.environ["ONEFLOW_CPU_CONV_ALGO"]
+        else:
+            os.environ["ONEFLOW_CPU_CONV_ALGO"] = old_algo
+
+
+def test_cpu_conv_predict_after_weight_update(test_case):
+    for algo in ["winograd", "direct"]:
+        for half in [False, True]:
+            compare_cpu_conv_predict_after_weight_update(test_case, algo, half)
+
+
+def compare_half_conv2d_on_cpu(x_shape, filters, data_format):
+    flow.clear_default_session()
+    func_config = flow.FunctionConfig()
+    func_config.default_data_type(flow.float)
+    channel_axis = 1 if data_format == "NCHW" else 3
+    if data_format == "NCHW":
+        weight_shape = (filters, x_shape[1], 3, 3)
+    else:
+        weight_shape = (filters, 3, 3, x_shape[3])
+
+    @flow.global_function(function_config=func_config)
+    def ConvJob(x: oft.Numpy.Placeholder(x_shape)):
+        with flow.scope.placement("cpu", "0:0"):
+            weight = flow.get_variable(
+                "conv-weight",
+                shape=weight_shape,
+                dtype=flow.float,
+                initializer=flow.random_uniform_initializer(minval=-1, maxval=1),
+            )
+            bias = flow.get_variable(
+                "conv-bias",
+                shape=(filters,),
+                dtype=flow.float,
+                initializer=flow.random_uniform_initializer(minval=-1, maxval=1),
+            )
+            flow.watch(weight, test_global_storage.Setter("weight"))
+            flow.watch(bias, test_global_storage.Setter("bias"))
+            y = flow.nn.conv2d(
+                flow.cast(x, flow.float16),
+                flow.cast(weight, flow.float16),
+                strides=[1, 1],
+                padding="SAME",
+                data_format=data_format,
+            )
+            y = flow.nn.bias_add(y, flow.cast(bias, flow.float16), data_format)
+            return flow.cast(y, flow.float)
+
+    check_point = flow.train.CheckPoint()
+    check_point.init()
+    if data_format == "NCHW":
+        xy_data_transpose = (0, 2, 3, 1)
+        weight_data_transpose = (2, 3, 1, 0)
+    else:
+        xy_data_transpose = (0, 1, 2, 3)
+        weight_data_transpose = (1, 2, 3, 0)
+    # twice, the second run widens the weight into the buffer of the first
+    for _ in range(2):
+        x = np.random.uniform(-1, 1, x_shape).astype(np.float32)
+        of_out = ConvJob(x).get().numpy()
+        # the inputs are rounded to half, the products accumulate in float
+        weight = test_global_storage.Get("weight").astype(np.float16).astype(np.float32)
+        bias = test_global_storage.Get("bias").astype(np.float16).astype(np.float32)
+        tf_out = tf.nn.bias_add(
+            tf.nn.conv2d(
+                x.astype(np.float16).astype(np.float32).transpose(xy_data_transpose),
+                weight.transpose(weight_data_transpose),
+                strides=[1, 1, 1, 1],
+                padding="SAME",
+                data_format="NHWC",
+            ),
+            bias,
+        ).numpy()
+        assert of_out.shape[channel_axis] == filters
+        assert np.allclose(
+            of_out.transpose(xy_data_transpose), tf_out, rtol=1e-2, atol=1e-2
+        ), np.max(np.abs(of_out.transpose(xy_data_transpose) - tf_out))
+
+
+def test_half_conv2d_on_cpu(test_case):
+    # 40 images take several chunks of the images widened to float
+    compare_half_conv2d_on_cpu((40, 32, 16, 16), 32, "NCHW")
+    compare_half_conv2d_on_cpu((40, 16, 16, 32), 32, "NHWC")
+    compare_half_conv2d_on_cpu((2, 128, 14, 14), 128, "NCHW")
+
+
 def test_conv1(test_case):
     arg_dict = OrderedDict()
     arg_dict["device_type"] = ["gpu"]
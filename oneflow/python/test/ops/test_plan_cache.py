@@ -0,0 +1,101 @@
+"""
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+"""
+import os
+import shutil
+import subprocess
+import sys
+import tempfile
+
+import numpy as np
+
+# The plan cache serves new processes running the same jobs. Each run is a process of
+# its own, the names of the generated ops depend on what a process has run before.
+_RUN_JOB_SCRIPT = """
+import sys
+
+import numpy as np
+import oneflow as flow
+import oneflow.typing as oft
+
+cache_dir, out_path, enable_inplace = sys.argv[1], sys.argv[2], sys.argv[3] == "1"
+flow.config.plan_cache_dir(cache_dir)
+func_config = flow.FunctionConfig()
+func_config.default_data_type(flow.float)
+func_config.enable_inplace(enable_inplace)
+
+
+@flow.global_function(type="predict", function_config=func_config)
+def PlanCacheJob(x: oft.Numpy.Placeholder((4, 16))):
+    with flow.scope.placement("cpu", "0:0"):
+        hidden = flow.layers.dense(
+            x,
+            units=8,
+            activation=flow.math.relu,
+            kernel_initializer=flow.constant_initializer(0.1),
+            bias_initializer=flow.constant_initializer(0.2),
+            name="dense",
+        )
+        return flow.math.reduce_sum(hidden, axis=[1])
+
+
+check_point = flow.train.CheckPoint()
+check_point.init()
+x = np.arange(64, dtype=np.float32).reshape(4, 16) / 64
+np.save(out_path, PlanCacheJob(x).get().numpy())
+"""
+
+
+def _run_job(tmp_dir, cache_dir, enable_inplace):
+    script_path = os.path.join(tmp_dir, "run_job.py")
+    with open(script_path, "w") as f:
+        f.write(_RUN_JOB_SCRIPT)
+    out_path = os.path.join(tmp_dir, "out.npy")
+    enable_inplace_arg = "1" if enable_inplace else "0"
+    subprocess.check_call(
+        [sys.executable, script_path, cache_dir, out_path, enable_inplace_arg]
+    )
+    return np.load(out_path)
+
+
+def _cached_plan_paths(cache_dir):
+    return sorted(
+        os.path.join(cache_dir, name)
+        for name in os.listdir(cache_dir)
+        if name.startswith("plan_") and name.endswith(".bin")
+    )
+
+
+def test_plan_cache(test_case):
+    tmp_dir = tempfile.mkdtemp()
+    cache_dir = os.path.join(tmp_dir, "plan_cache")
+    try:
+        first_out = _run_job(tmp_dir, cache_dir, True)
+        cached_plan_paths = _cached_plan_paths(cache_dir)
+        test_case.assertEqual(len(cached_plan_paths), 1)
+        mtime = os.stat(cached_plan_paths[0]).st_mtime_ns
+
+        # a hit loads the plan and does not store it again
+        second_out = _run_job(tmp_dir, cache_dir, True)
+        test_case.assertEqual(_cached_plan_paths(cache_dir), cached_plan_paths)
+        test_case.assertEqual(os.stat(cached_plan_paths[0]).st_mtime_ns, mtime)
+        test_case.assertTrue(np.array_equal(first_out, second_out))
+
+        # another function config is another fingerprint
+        third_out = _run_job(tmp_dir, cache_dir, False)
+        test_case.assertEqual(len(_cached_plan_paths(cache_dir)), 2)
+        test_case.assertTrue(np.allclose(first_out, third_out))
+    finally:
+        shutil.rmtree(tmp_dir)
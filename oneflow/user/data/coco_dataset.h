@@ -28,6 +28,11 @@ struct COCOImage {
   int64_t id;
   int32_t height;
   int32_t width;
+  // annotations, filled by COCOParser::Prepare
+  TensorBuffer bbox;
+  TensorBuffer label;
+  TensorBuffer segm;
+  TensorBuffer segm_index;
 };
 
 class COCOMeta;
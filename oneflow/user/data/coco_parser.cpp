@@ -20,7 +20,22 @@ limitations under the License.
 namespace oneflow {
 namespace data {
 
-void COCOParser::Parse(std::shared_ptr<LoadTargetShdPtrVec> batch_data,
+std::unique_ptr<PreparedBatch> COCOParser::Prepare(LoadTargetShdPtrVec* batch_data) const {
+  for (const auto& image : *batch_data) {
+    const auto& bbox_vec = meta_->GetBboxVec<float>(image->index);
+    CHECK_EQ(bbox_vec.size() % 4, 0);
+    int64_t num_bboxes = bbox_vec.size() / 4;
+    image->bbox.Resize(Shape({num_bboxes, 4}), DataType::kFloat);
+    std::copy(bbox_vec.begin(), bbox_vec.end(), image->bbox.mut_data<float>());
+    const auto& label_vec = meta_->GetLabelVec<int32_t>(image->index);
+    image->label.Resize(Shape({static_cast<int64_t>(label_vec.size())}), DataType::kInt32);
+    std::copy(label_vec.begin(), label_vec.end(), image->label.mut_data<int32_t>());
+    meta_->ReadSegmentationsToTensorBuffer<float>(image->index, &image->segm, &image->segm_index);
+  }
+  return nullptr;
+}
+
+void COCOParser::Parse(std::shared_ptr<LoadTargetShdPtrVec> batch_data, PreparedBatch* prepared,
                        user_op::KernelComputeContext* ctx) {
   user_op::Tensor* image_tensor = ctx->Tensor4ArgNameAndIndex("image", 0);
   CHECK_NOTNULL(image_tensor);
@@ -46,22 +61,17 @@ void COCOParser::Parse(std::shared_ptr<LoadTargetShdPtrVec> batch_data,
     }
     if (bbox_tensor) {
       TensorBuffer* bbox_buffer = bbox_tensor->mut_dptr<TensorBuffer>() + i;
-      const auto& bbox_vec = meta_->GetBboxVec<float>(image->index);
-      CHECK_EQ(bbox_vec.size() % 4, 0);
-      int64_t num_bboxes = bbox_vec.size() / 4;
-      bbox_buffer->Resize(Shape({num_bboxes, 4}), DataType::kFloat);
-      std::copy(bbox_vec.begin(), bbox_vec.end(), bbox_buffer->mut_data<float>());
+      bbox_buffer->Swap(&image->bbox);
     }
     if (label_tensor) {
       TensorBuffer* label_buffer = label_tensor->mut_dptr<TensorBuffer>() + i;
-      const auto& label_vec = meta_->GetLabelVec<int32_t>(image->index);
-      label_buffer->Resize(Shape({static_cast<int64_t>(label_vec.size())}), DataType::kInt32);
-      std::copy(label_vec.begin(), label_vec.end(), label_buffer->mut_data<int32_t>());
+      label_buffer->Swap(&image->label);
     }
     if (segm_tensor && segm_index_tensor) {
       TensorBuffer* segm_buffer = segm_tensor->mut_dptr<TensorBuffer>() + i;
       TensorBuffer* segm_index_buffer = segm_index_tensor->mut_dptr<TensorBuffer>() + i;
-      meta_->ReadSegmentationsToTensorBuffer<float>(image->index, segm_buffer, segm_index_buffer);
+      segm_buffer->Swap(&image->segm);
+      segm_index_buffer->Swap(&image->segm_index);
     }
   });
   // dynamic batch size
@@ -32,7 +32,8 @@ class COCOParser final : public Parser<COCOImage> {
   COCOParser(const std::shared_ptr<const COCOMeta>& meta) : meta_(meta){};
   ~COCOParser() = default;
 
-  void Parse(std::shared_ptr<LoadTargetShdPtrVec> batch_data,
+  std::unique_ptr<PreparedBatch> Prepare(LoadTargetShdPtrVec* batch_data) const override;
+  void Parse(std::shared_ptr<LoadTargetShdPtrVec> batch_data, PreparedBatch* prepared,
              user_op::KernelComputeContext* ctx) override;
 
  private:
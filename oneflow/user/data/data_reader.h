@@ -16,73 +16,189 @@ limitations under the License.
 #ifndef ONEFLOW_USER_DATA_DATA_READER_H_
 #define ONEFLOW_USER_DATA_DATA_READER_H_
 
-#include "oneflow/core/common/buffer.h"
 #include "oneflow/core/framework/op_kernel.h"
+#include "oneflow/core/job/global_for.h"
+#include "oneflow/core/job/resource_desc.h"
 #include "oneflow/user/data/dataset.h"
 #include "oneflow/user/data/parser.h"
 
 namespace oneflow {
 namespace data {
 
+// initial number of batches loaded ahead of Read, it grows up to
+// resource.data_reader_max_prefetch_batch_num whenever Read finds nothing prefetched
 static const int32_t kDataReaderBatchBufferSize = 4;
 
+struct DataReaderStat {
+  int64_t batch_num = 0;
+  int64_t load_ns = 0;     // Dataset::Next, serialized between the workers
+  int64_t prepare_ns = 0;  // Parser::Prepare, in parallel on the workers
+  int64_t wait_ns = 0;     // Read blocked on an empty prefetch queue
+  int64_t parse_ns = 0;    // Parser::Parse inside Read
+  int32_t prefetch_depth = 0;
+};
+
+inline std::string DataReaderStatToString(const DataReaderStat& stat) {
+  const double batch_num = std::max<int64_t>(stat.batch_num, 1);
+  std::ostringstream ss;
+  ss << "batches: " << stat.batch_num << ", per batch load: " << stat.load_ns / batch_num / 1e6
+     << " ms, prepare: " << stat.prepare_ns / batch_num / 1e6
+     << " ms, parse: " << stat.parse_ns / batch_num / 1e6
+     << " ms, wait: " << stat.wait_ns / batch_num / 1e6
+     << " ms, prefetch depth: " << stat.prefetch_depth;
+  return ss.str();
+}
+
+// Loads batches ahead of the kernel on resource.data_reader_worker_num workers. A worker takes
+// the next batch from loader_ (one worker at a time, datasets are not thread safe), runs
+// Parser::Prepare on it concurrently with the other workers, and queues it for Read. Batches
+// are queued in load order unless resource.data_reader_ordered is false. Decoding belongs in
+// Prepare, Next only reads the serialized samples; OFRecordImageClassificationDataset decodes
+// on threads of its own instead.
 template<typename LoadTarget>
 class DataReader {
  public:
   using LoadTargetPtr = std::shared_ptr<LoadTarget>;
   using LoadTargetPtrList = std::vector<LoadTargetPtr>;
   DataReader(user_op::KernelInitContext* ctx)
-      : is_closed_(false), batch_buffer_(kDataReaderBatchBufferSize) {}
+      : is_closed_(false),
+        next_load_seq_(0),
+        next_queue_seq_(0),
+        prefetch_depth_(kDataReaderBatchBufferSize),
+        batch_num_(0),
+        load_ns_(0),
+        prepare_ns_(0),
+        wait_ns_(0),
+        parse_ns_(0) {
+    const ResourceDesc* resource_desc = Global<ResourceDesc, ForSession>::Get();
+    worker_num_ = std::max<int32_t>(resource_desc->data_reader_worker_num(), 1);
+    max_prefetch_depth_ =
+        std::max<int32_t>(resource_desc->data_reader_max_prefetch_batch_num(),
+                          kDataReaderBatchBufferSize);
+    ordered_ = resource_desc->data_reader_ordered();
+  }
   virtual ~DataReader() {
     Close();
-    if (load_thrd_.joinable()) { load_thrd_.join(); }
+    for (std::thread& worker : workers_) { worker.join(); }
+    if (batch_num_ > 0) { LOG(INFO) << "data reader " << DataReaderStatToString(stat()); }
   }
 
   void Read(user_op::KernelComputeContext* ctx) {
-    CHECK(load_thrd_.joinable()) << "You should call StartLoadThread before read data";
-    auto batch_data = FetchBatchData();
-    parser_->Parse(batch_data, ctx);
+    CHECK(!workers_.empty()) << "You should call StartLoadThread before read data";
+    const auto start = std::chrono::steady_clock::now();
+    Batch batch = FetchBatch();
+    const auto fetched = std::chrono::steady_clock::now();
+    parser_->Parse(batch.data, batch.prepared.get(), ctx);
+    wait_ns_ += ElapsedNs(start, fetched);
+    parse_ns_ += ElapsedNs(fetched, std::chrono::steady_clock::now());
+    batch_num_ += 1;
   }
 
   void Close() {
+    std::unique_lock<std::mutex> lock(queue_mutex_);
     is_closed_.store(true);
-    bool buffer_drained = false;
-    while (!buffer_drained) {
-      std::shared_ptr<LoadTargetPtrList> abandoned_batch_data(nullptr);
-      auto status = batch_buffer_.TryReceive(&abandoned_batch_data);
-      CHECK_NE(status, BufferStatus::kBufferStatusErrorClosed);
-      buffer_drained = (status == BufferStatus::kBufferStatusEmpty);
-    }
-    batch_buffer_.Close();
+    batch_queue_.clear();
+    queue_cond_.notify_all();
+  }
+
+  DataReaderStat stat() const {
+    DataReaderStat stat;
+    stat.batch_num = batch_num_;
+    stat.load_ns = load_ns_;
+    stat.prepare_ns = prepare_ns_;
+    stat.wait_ns = wait_ns_;
+    stat.parse_ns = parse_ns_;
+    stat.prefetch_depth = prefetch_depth_;
+    return stat;
   }
 
  protected:
   void StartLoadThread() {
-    if (load_thrd_.joinable()) { return; }
-    load_thrd_ = std::thread([this] {
-      while (!is_closed_.load() && LoadBatch()) {}
-    });
+    if (!workers_.empty()) { return; }
+    FOR_RANGE(int32_t, i, 0, worker_num_) {
+      workers_.emplace_back([this] {
+        while (LoadBatch()) {}
+      });
+    }
   }
 
   std::unique_ptr<Dataset<LoadTarget>> loader_;
   std::unique_ptr<Parser<LoadTarget>> parser_;
 
  private:
-  std::shared_ptr<LoadTargetPtrList> FetchBatchData() {
-    std::shared_ptr<LoadTargetPtrList> batch_data(nullptr);
-    CHECK_EQ(batch_buffer_.Receive(&batch_data), BufferStatus::kBufferStatusSuccess);
-    return batch_data;
+  // a loaded batch and what Parser::Prepare made of it
+  struct Batch {
+    std::shared_ptr<LoadTargetPtrList> data;
+    std::unique_ptr<PreparedBatch> prepared;
+  };
+
+  static int64_t ElapsedNs(std::chrono::steady_clock::time_point begin,
+                           std::chrono::steady_clock::time_point end) {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(end - begin).count();
+  }
+
+  Batch FetchBatch() {
+    std::unique_lock<std::mutex> lock(queue_mutex_);
+    if (batch_queue_.empty() && batch_num_ > 0 && prefetch_depth_ < max_prefetch_depth_) {
+      // the workers fell behind, let them run further ahead to absorb slow batches
+      prefetch_depth_ += 1;
+      queue_cond_.notify_all();
+    }
+    queue_cond_.wait(lock, [this]() { return !batch_queue_.empty() || is_closed_.load(); });
+    CHECK(!batch_queue_.empty()) << "data reader is closed";
+    Batch batch = std::move(batch_queue_.front());
+    batch_queue_.pop_front();
+    queue_cond_.notify_all();
+    return batch;
   }
 
   bool LoadBatch() {
-    std::shared_ptr<LoadTargetPtrList> batch_data =
-        std::make_shared<LoadTargetPtrList>(std::move(loader_->Next()));
-    return batch_buffer_.Send(batch_data) == BufferStatus::kBufferStatusSuccess;
+    int64_t seq = -1;
+    Batch batch;
+    {
+      std::unique_lock<std::mutex> lock(loader_mutex_);
+      if (is_closed_.load()) { return false; }
+      const auto start = std::chrono::steady_clock::now();
+      seq = next_load_seq_++;
+      batch.data = std::make_shared<LoadTargetPtrList>(loader_->Next());
+      load_ns_ += ElapsedNs(start, std::chrono::steady_clock::now());
+    }
+    const auto start = std::chrono::steady_clock::now();
+    batch.prepared = parser_->Prepare(batch.data.get());
+    prepare_ns_ += ElapsedNs(start, std::chrono::steady_clock::now());
+    std::unique_lock<std::mutex> lock(queue_mutex_);
+    queue_cond_.wait(lock, [this, seq]() {
+      return is_closed_.load()
+             || (static_cast<int32_t>(batch_queue_.size()) < prefetch_depth_
+                 && (!ordered_ || seq == next_queue_seq_));
+    });
+    if (is_closed_.load()) { return false; }
+    batch_queue_.push_back(std::move(batch));
+    next_queue_seq_ += 1;
+    queue_cond_.notify_all();
+    return true;
   }
 
+  int32_t worker_num_;
+  int32_t max_prefetch_depth_;
+  bool ordered_;
   std::atomic<bool> is_closed_;
-  Buffer<std::shared_ptr<LoadTargetPtrList>> batch_buffer_;
-  std::thread load_thrd_;
+  std::vector<std::thread> workers_;
+
+  std::mutex loader_mutex_;
+  int64_t next_load_seq_;
+
+  std::mutex queue_mutex_;
+  std::condition_variable queue_cond_;
+  std::deque<Batch> batch_queue_;
+  int64_t next_queue_seq_;
+  std::atomic<int32_t> prefetch_depth_;
+
+  std::atomic<int64_t> batch_num_;
+  std::atomic<int64_t> load_ns_;
+  std::atomic<int64_t> prepare_ns_;
+  std::atomic<int64_t> wait_ns_;
+  std::atomic<int64_t> parse_ns_;
 };
 
 }  // namespace data
@@ -0,0 +1,118 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#ifndef ONEFLOW_USER_DATA_GLOBAL_SHUFFLE_OFRECORD_DATASET_H_
+#define ONEFLOW_USER_DATA_GLOBAL_SHUFFLE_OFRECORD_DATASET_H_
+
+#include "oneflow/user/data/dataset.h"
+#include "oneflow/core/common/balanced_splitter.h"
+#include "oneflow/core/common/random_permutation.h"
+#include "oneflow/core/common/str_util.h"
+#include "oneflow/core/framework/op_kernel.h"
+#include "oneflow/core/record/ofrecord_reader.h"
+
+namespace oneflow {
+namespace data {
+
+static const int64_t kGlobalShuffleReadAheadNum = 128;
+
+// Every epoch draws one seeded permutation over the records of all parts, and each rank reads
+// its balanced share of it by random access into the mapped parts. The permutation is evaluated
+// on demand, so the shuffle state does not grow with the dataset; the next
+// kGlobalShuffleReadAheadNum records are prefetched to hide the page faults of random reads.
+class GlobalShuffleOFRecordDataset final : public Dataset<TensorBuffer> {
+ public:
+  using LoadTargetPtr = std::shared_ptr<TensorBuffer>;
+  using LoadTargetPtrList = std::vector<LoadTargetPtr>;
+  OF_DISALLOW_COPY_AND_MOVE(GlobalShuffleOFRecordDataset);
+  GlobalShuffleOFRecordDataset(user_op::KernelInitContext* ctx)
+      : GlobalShuffleOFRecordDataset(DataFilePaths(ctx), ctx->Attr<int64_t>("seed"),
+                                     ctx->parallel_ctx().parallel_num(),
+                                     ctx->parallel_ctx().parallel_id()) {}
+  GlobalShuffleOFRecordDataset(const std::vector<std::string>& data_file_paths, int64_t seed,
+                               int64_t parallel_num, int64_t parallel_id)
+      : epoch_(0) {
+    reader_.reset(new MmapOFRecordReader(data_file_paths, GetMaxVal<size_t>(), false));
+    reader_->AdviseRandomAccess();
+    CHECK_GT(reader_->record_num(), 0);
+
+    // every rank has to draw the same permutation, so there is no per-rank random seed
+    seed_ = seed;
+    if (seed_ == -1) { seed_ = kOneflowDatasetSeed; }
+    CHECK_LE(parallel_num, reader_->record_num());
+    range_ = BalancedSplitter(reader_->record_num(), parallel_num).At(parallel_id);
+    StartEpoch();
+  }
+  ~GlobalShuffleOFRecordDataset() = default;
+
+  LoadTargetPtrList Next() override {
+    if (cur_pos_ == range_.end()) {
+      epoch_ += 1;
+      StartEpoch();
+    }
+    const int64_t read_ahead_end = std::min(cur_pos_ + kGlobalShuffleReadAheadNum, range_.end());
+    for (; read_ahead_pos_ < read_ahead_end; ++read_ahead_pos_) {
+      reader_->PrefetchRecord(permutation_->At(read_ahead_pos_));
+    }
+    const char* data = nullptr;
+    int64_t OFRecord_size = -1;
+    reader_->RecordAt(permutation_->At(cur_pos_), &data, &OFRecord_size);
+    cur_pos_ += 1;
+    CHECK_GT(OFRecord_size, 0);
+    LoadTargetPtrList ret;
+    LoadTargetPtr sample_ptr(new TensorBuffer());
+    sample_ptr->Resize(Shape({OFRecord_size}), DataType::kChar);
+    std::memcpy(sample_ptr->mut_data<char>(), data, OFRecord_size);
+    ret.push_back(std::move(sample_ptr));
+    return ret;
+  }
+
+ private:
+  static std::vector<std::string> DataFilePaths(user_op::KernelInitContext* ctx) {
+    CHECK(DataFS() == LocalFS()) << "global shuffle needs the data on the local file system";
+    const int32_t data_part_num = ctx->Attr<int32_t>("data_part_num");
+    const std::string data_dir = ctx->Attr<std::string>("data_dir");
+    const std::string part_name_prefix = ctx->Attr<std::string>("part_name_prefix");
+    const int32_t part_name_suffix_length = ctx->Attr<int32_t>("part_name_suffix_length");
+    std::vector<std::string> data_file_paths;
+    for (int i = 0; i < data_part_num; ++i) {
+      std::string num = std::to_string(i);
+      int32_t zero_count =
+          std::max(part_name_suffix_length - static_cast<int32_t>(num.length()), 0);
+      data_file_paths.push_back(
+          JoinPath(data_dir, part_name_prefix + std::string(zero_count, '0') + num));
+    }
+    return data_file_paths;
+  }
+
+  void StartEpoch() {
+    permutation_.reset(new RandomPermutation(reader_->record_num(), seed_ + epoch_));
+    cur_pos_ = range_.begin();
+    read_ahead_pos_ = range_.begin();
+  }
+
+  std::unique_ptr<MmapOFRecordReader> reader_;
+  std::unique_ptr<RandomPermutation> permutation_;
+  int64_t seed_;
+  int64_t epoch_;
+  Range range_;
+  int64_t cur_pos_;
+  int64_t read_ahead_pos_;
+};
+
+}  // namespace data
+}  // namespace oneflow
+
+#endif  // ONEFLOW_USER_DATA_GLOBAL_SHUFFLE_OFRECORD_DATASET_H_
@@ -0,0 +1,95 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include "oneflow/user/data/global_shuffle_ofrecord_dataset.h"
+
+#ifdef PLATFORM_POSIX
+
+#include <unistd.h>
+
+namespace oneflow {
+namespace data {
+
+namespace {
+
+std::string WritePartFile(int64_t part_id, int64_t record_num) {
+  const std::string path = "/tmp/global_shuffle_ofrecord_dataset_test." + std::to_string(part_id)
+                           + "." + std::to_string(getpid());
+  std::ofstream out(path, std::ios::binary);
+  FOR_RANGE(int64_t, i, 0, record_num) {
+    const std::string payload = std::to_string(part_id) + "-" + std::to_string(i);
+    const int64_t size = payload.size();
+    out.write(reinterpret_cast<const char*>(&size), sizeof(size));
+    out.write(payload.data(), size);
+  }
+  return path;
+}
+
+std::vector<std::string> ReadEpoch(GlobalShuffleOFRecordDataset* dataset, int64_t record_num) {
+  std::vector<std::string> payloads;
+  FOR_RANGE(int64_t, i, 0, record_num) {
+    const auto samples = dataset->Next();
+    CHECK_EQ(samples.size(), 1);
+    const TensorBuffer& sample = *samples.at(0);
+    payloads.emplace_back(sample.data<char>(), sample.shape().elem_cnt());
+  }
+  return payloads;
+}
+
+}  // namespace
+
+TEST(GlobalShuffleOFRecordDataset, disjoint_shares_reshuffled_every_epoch) {
+  // an empty part in between, 20 records in all
+  const std::vector<int64_t> part_record_nums{7, 0, 9, 4};
+  std::vector<std::string> paths;
+  std::set<std::string> all_payloads;
+  FOR_RANGE(int64_t, part_id, 0, part_record_nums.size()) {
+    paths.push_back(WritePartFile(part_id, part_record_nums.at(part_id)));
+    FOR_RANGE(int64_t, i, 0, part_record_nums.at(part_id)) {
+      all_payloads.insert(std::to_string(part_id) + "-" + std::to_string(i));
+    }
+  }
+  const int64_t record_num = all_payloads.size();
+  const int64_t epoch_num = 3;
+  for (int64_t parallel_num : std::vector<int64_t>{2, 3}) {
+    const BalancedSplitter splitter(record_num, parallel_num);
+    // the records of every epoch in the order of the ranks
+    std::vector<std::vector<std::string>> epoch2payloads(epoch_num);
+    FOR_RANGE(int64_t, parallel_id, 0, parallel_num) {
+      GlobalShuffleOFRecordDataset dataset(paths, 1234, parallel_num, parallel_id);
+      FOR_RANGE(int64_t, epoch, 0, epoch_num) {
+        const std::vector<std::string> share =
+            ReadEpoch(&dataset, splitter.At(parallel_id).size());
+        epoch2payloads.at(epoch).insert(epoch2payloads.at(epoch).end(), share.begin(),
+                                        share.end());
+      }
+    }
+    FOR_RANGE(int64_t, epoch, 0, epoch_num) {
+      const std::vector<std::string>& payloads = epoch2payloads.at(epoch);
+      ASSERT_EQ(payloads.size(), record_num);
+      ASSERT_EQ(std::set<std::string>(payloads.begin(), payloads.end()), all_payloads);
+      if (epoch > 0) { ASSERT_NE(payloads, epoch2payloads.at(epoch - 1)); }
+    }
+  }
+  for (const std::string& path : paths) {
+    unlink(OFRecordMappedFile::IndexPath(path).c_str());
+    unlink(path.c_str());
+  }
+}
+
+}  // namespace data
+}  // namespace oneflow
+
+#endif  // PLATFORM_POSIX
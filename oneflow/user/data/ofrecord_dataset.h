@@ -21,6 +21,7 @@ limitations under the License.
 #include "oneflow/core/common/str_util.h"
 #include "oneflow/core/framework/op_kernel.h"
 #include "oneflow/core/persistence/persistent_in_stream.h"
+#include "oneflow/core/record/ofrecord_reader.h"
 #include "oneflow/core/job/job_set.pb.h"
 
 namespace oneflow {
@@ -56,8 +57,8 @@ class OFRecordDataset final : public Dataset<TensorBuffer> {
     range_ = bs.At(parallel_id_);
     std::vector<std::string> local_file_paths = GetLocalFilePaths();
     save_to_local_ = Global<const IOConf>::Get()->save_downloaded_file_to_local_fs();
-    in_stream_.reset(
-        new PersistentInStream(DataFS(), local_file_paths, !shuffle_after_epoch_, save_to_local_));
+    use_mmap_ = EnableMmapOFRecordReader();
+    ResetReader(local_file_paths, !shuffle_after_epoch_);
   }
   ~OFRecordDataset() = default;
 
@@ -71,6 +72,10 @@ class OFRecordDataset final : public Dataset<TensorBuffer> {
 
  private:
   void ReadSample(TensorBuffer& tensor) {
+    if (use_mmap_) {
+      ReadMappedSample(tensor);
+      return;
+    }
     int64_t OFRecord_size = -1;
     char* size_ptr = reinterpret_cast<char*>(&OFRecord_size);
     if (in_stream_->ReadFully(size_ptr, sizeof(int64_t)) != 0) {
@@ -82,13 +87,33 @@ class OFRecordDataset final : public Dataset<TensorBuffer> {
     CHECK_EQ(in_stream_->ReadFully(tensor.mut_data<char>(), OFRecord_size), 0);
   }
 
+  void ReadMappedSample(TensorBuffer& tensor) {
+    const char* data = nullptr;
+    int64_t OFRecord_size = -1;
+    if (!mmap_reader_->NextRecord(&data, &OFRecord_size)) {
+      ShuffleAfterEpoch();
+      CHECK(mmap_reader_->NextRecord(&data, &OFRecord_size));
+    }
+    CHECK_GT(OFRecord_size, 0);
+    tensor.Resize(Shape({OFRecord_size}), DataType::kChar);
+    std::memcpy(tensor.mut_data<char>(), data, OFRecord_size);
+  }
+
+  void ResetReader(const std::vector<std::string>& local_file_paths, bool cyclic) {
+    if (use_mmap_) {
+      mmap_reader_.reset(new MmapOFRecordReader(local_file_paths, GetMaxVal<size_t>(), cyclic));
+    } else {
+      in_stream_.reset(new PersistentInStream(DataFS(), local_file_paths, cyclic, save_to_local_));
+    }
+  }
+
   void ShuffleAfterEpoch() {
     CHECK(shuffle_after_epoch_);
     current_epoch_++;  // move to next epoch
     std::mt19937 g(kOneflowDatasetSeed + current_epoch_);
     std::shuffle(data_file_paths_.begin(), data_file_paths_.end(), g);
     std::vector<std::string> local_file_paths = GetLocalFilePaths();
-    in_stream_.reset(new PersistentInStream(DataFS(), local_file_paths, false, save_to_local_));
+    ResetReader(local_file_paths, false);
   }
 
   std::vector<std::string> GetLocalFilePaths() {
@@ -106,7 +131,9 @@ class OFRecordDataset final : public Dataset<TensorBuffer> {
   Range range_;
   std::vector<std::string> data_file_paths_;
   bool save_to_local_;
+  bool use_mmap_;
   std::unique_ptr<PersistentInStream> in_stream_;
+  std::unique_ptr<MmapOFRecordReader> mmap_reader_;
 };
 
 }  // namespace data
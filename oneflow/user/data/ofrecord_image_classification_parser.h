@@ -33,7 +33,7 @@ class OFRecordImageClassificationParser final : public Parser<ImageClassificatio
   OFRecordImageClassificationParser() = default;
   ~OFRecordImageClassificationParser() override = default;
 
-  void Parse(std::shared_ptr<LoadTargetPtrList> batch_data,
+  void Parse(std::shared_ptr<LoadTargetPtrList> batch_data, PreparedBatch* prepared,
              user_op::KernelComputeContext* ctx) override {
     const int64_t batch_size = batch_data->size();
     user_op::Tensor* image_tensor = ctx->Tensor4ArgNameAndIndex("image", 0);
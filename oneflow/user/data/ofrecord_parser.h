@@ -31,19 +31,43 @@ class OFRecordParser final : public Parser<TensorBuffer> {
   OFRecordParser() = default;
   ~OFRecordParser() = default;
 
-  void Parse(std::shared_ptr<LoadTargetPtrList> batch_data,
+  // decodes the records on the loader workers, Parse only swaps them into the output
+  std::unique_ptr<PreparedBatch> Prepare(LoadTargetPtrList* batch_data) const override {
+    std::unique_ptr<OFRecordBatch> records(new OFRecordBatch(batch_data->size()));
+    FOR_RANGE(size_t, i, 0, batch_data->size()) {
+      TensorBuffer* buffer = batch_data->at(i).get();
+      CHECK(records->at(i).ParseFromArray(buffer->data<char>(), buffer->shape().elem_cnt()));
+      buffer->reset();
+    }
+    return std::move(records);
+  }
+
+  void Parse(std::shared_ptr<LoadTargetPtrList> batch_data, PreparedBatch* prepared,
              user_op::KernelComputeContext* ctx) override {
     user_op::Tensor* out_tensor = ctx->Tensor4ArgNameAndIndex("out", 0);
     OFRecord* dptr = out_tensor->mut_dptr<OFRecord>();
-    MultiThreadLoop(batch_data->size(), [&](size_t i) {
-      TensorBuffer* buffer = batch_data->at(i).get();
-      CHECK(dptr[i].ParseFromArray(buffer->data<char>(), buffer->shape().elem_cnt()));
-    });
+    OFRecordBatch* records = dynamic_cast<OFRecordBatch*>(prepared);
+    CHECK_NOTNULL(records);
+    CHECK_EQ(records->size(), batch_data->size());
+    MultiThreadLoop(batch_data->size(), [&](size_t i) { dptr[i].Swap(&records->at(i)); });
     if (batch_data->size() != out_tensor->shape().elem_cnt()) {
       CHECK_EQ(out_tensor->mut_shape()->NumAxes(), 1);
       out_tensor->mut_shape()->Set(0, batch_data->size());
     }
   }
+
+ private:
+  class OFRecordBatch final : public PreparedBatch {
+   public:
+    explicit OFRecordBatch(size_t size) : records_(size) {}
+    ~OFRecordBatch() override = default;
+
+    size_t size() const { return records_.size(); }
+    OFRecord& at(size_t i) { return records_.at(i); }
+
+   private:
+    std::vector<OFRecord> records_;
+  };
 };
 
 }  // namespace data
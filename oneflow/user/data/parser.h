@@ -22,6 +22,13 @@ limitations under the License.
 namespace oneflow {
 namespace data {
 
+// what Parser::Prepare leaves for the Parse of the same batch
+class PreparedBatch {
+ public:
+  PreparedBatch() = default;
+  virtual ~PreparedBatch() = default;
+};
+
 template<typename LoadTarget>
 class Parser {
  public:
@@ -30,7 +37,14 @@ class Parser {
   Parser() = default;
   virtual ~Parser() = default;
 
-  virtual void Parse(std::shared_ptr<LoadTargetPtrList> batch_data,
+  // Work on a loaded batch that does not need the output tensors. DataReader runs it on its
+  // loader workers, ahead of Parse and in parallel with other batches, and queues what it returns
+  // with the batch.
+  virtual std::unique_ptr<PreparedBatch> Prepare(LoadTargetPtrList* batch_data) const {
+    return nullptr;
+  }
+  // prepared is what Prepare returned for batch_data
+  virtual void Parse(std::shared_ptr<LoadTargetPtrList> batch_data, PreparedBatch* prepared,
                      user_op::KernelComputeContext* ctx) = 0;
 };
 
@@ -16,9 +16,27 @@ limitations under the License.
 #include "oneflow/user/kernels/bias_add_kernel.h"
 #include "oneflow/core/framework/framework.h"
 #include "oneflow/core/ndarray/ndarray_util.h"
+#include "oneflow/core/kernel/cpu_elementwise.h"
 
 namespace oneflow {
 
+namespace {
+
+// y[i] = x[i] + bias[i * bias_step] computed in float, bias_step is 0 for a single bias value or 1
+// for one bias value per element.
+void AddBiasHalf(int64_t n, const float16* x, const float* bias, int64_t bias_step, float16* y) {
+  float buf[kCpuHalfElementwiseBlockSize];
+  for (int64_t offset = 0; offset < n; offset += kCpuHalfElementwiseBlockSize) {
+    const int64_t len = std::min(kCpuHalfElementwiseBlockSize, n - offset);
+    const float* bias_block = bias + offset * bias_step;
+    cpu_half_util::HalfToFloat(len, x + offset, buf);
+    FOR_RANGE(int64_t, i, 0, len) { buf[i] += bias_block[i * bias_step]; }
+    cpu_half_util::FloatToHalf(len, buf, y + offset);
+  }
+}
+
+}  // namespace
+
 template<typename T, typename Index>
 struct BiasAddCalculation<DeviceType::kCPU, T, Index> {
   static void Invoke(DeviceCtx* ctx, int64_t outer_size, int64_t bias_size, int64_t inner_size,
@@ -31,6 +49,32 @@ struct BiasAddCalculation<DeviceType::kCPU, T, Index> {
   }
 };
 
+template<typename Index>
+struct BiasAddCalculation<DeviceType::kCPU, float16, Index> {
+  static void Invoke(DeviceCtx* ctx, int64_t outer_size, int64_t bias_size, int64_t inner_size,
+                     const float16* x, const float16* bias, float16* y) {
+    std::vector<float> bias_float(bias_size);
+    CpuHalfToFloat(bias_size, bias, bias_float.data());
+    if (inner_size == 1) {
+      const int64_t grain = std::max<int64_t>(kCpuParallelGrainSize / bias_size, 1);
+      MultiThreadLoopInRange(outer_size, grain, [&](int64_t begin, int64_t end) {
+        FOR_RANGE(int64_t, i, begin, end) {
+          AddBiasHalf(bias_size, x + i * bias_size, bias_float.data(), 1, y + i * bias_size);
+        }
+      });
+    } else {
+      const int64_t grain = std::max<int64_t>(kCpuParallelGrainSize / inner_size, 1);
+      MultiThreadLoopInRange(outer_size * bias_size, grain, [&](int64_t begin, int64_t end) {
+        FOR_RANGE(int64_t, i, begin, end) {
+          AddBiasHalf(inner_size, x + i * inner_size, bias_float.data() + i % bias_size, 0,
+                      y + i * inner_size);
+        }
+      });
+    }
+  }
+};
+
+REGISTER_BIAS_ADD_USER_KERNEL(CPU, float16)
 REGISTER_BIAS_ADD_USER_KERNEL(CPU, float)
 REGISTER_BIAS_ADD_USER_KERNEL(CPU, double)
 REGISTER_BIAS_ADD_USER_KERNEL(CPU, int8_t)
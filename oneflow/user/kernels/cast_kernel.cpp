@@ -15,6 +15,7 @@ limitations under the License.
 */
 #include "oneflow/core/framework/framework.h"
 #include "oneflow/core/kernel/kernel_util.h"
+#include "oneflow/core/kernel/cpu_half_util.h"
 
 namespace oneflow {
 
@@ -32,6 +33,20 @@ struct CopyTensor<DeviceType::kCPU, T, U> {
   }
 };
 
+template<>
+struct CopyTensor<DeviceType::kCPU, float, float16> {
+  static void Call(DeviceCtx* ctx, const Tensor* src, Tensor* dst) {
+    CpuFloatToHalf(src->shape().elem_cnt(), src->dptr<float>(), dst->mut_dptr<float16>());
+  }
+};
+
+template<>
+struct CopyTensor<DeviceType::kCPU, float16, float> {
+  static void Call(DeviceCtx* ctx, const Tensor* src, Tensor* dst) {
+    CpuHalfToFloat(src->shape().elem_cnt(), src->dptr<float16>(), dst->mut_dptr<float>());
+  }
+};
+
 template<typename T, typename U>
 struct CopyTensor<DeviceType::kGPU, T, U> {
   static void Call(DeviceCtx* ctx, const Tensor* src, Tensor* dst) {
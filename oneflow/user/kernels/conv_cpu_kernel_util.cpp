@@ -0,0 +1,469 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include "oneflow/user/kernels/conv_cpu_kernel_util.h"
+#include "oneflow/core/common/blas.h"
+#include "oneflow/core/thread/thread_manager.h"
+
+namespace oneflow {
+
+namespace {
+
+// tiles transformed together, so that the 16 gemms of a block have a reasonable width
+constexpr int64_t kWinogradTileBlockSize = 32;
+// with fewer channels the transforms cost more than the multiplications they save
+constexpr int64_t kWinogradMinChannel = 128;
+// narrower output rows or fewer input channels make the gemms of the direct algo too small, a
+// single im2col gemm over the whole image is faster then
+constexpr int64_t kDirectMinOutWidth = 8;
+constexpr int64_t kDirectMinInChannel = 16;
+
+// [begin, end) of the outputs along a dim reading valid inputs at kernel position k
+void ValidOutRange(int64_t in_size, int64_t out_size, int64_t k, int32_t stride,
+                   int32_t dilation_rate, int32_t padding_before, int64_t* begin, int64_t* end) {
+  const int64_t offset = k * dilation_rate - padding_before;
+  *begin = offset >= 0 ? 0 : (-offset + stride - 1) / stride;
+  *end = in_size - offset > 0 ? std::min(out_size, (in_size - offset - 1) / stride + 1) : 0;
+  *begin = std::min(*begin, *end);
+}
+
+template<typename T>
+void DirectForwardChannelsLast(const ConvCpuGeometry& geo, const T* in, const T* weight, T* out) {
+  const int64_t in_c = geo.in_channel;
+  const int64_t out_c = geo.out_channel;
+  const int64_t row_num = geo.batch_num * geo.out[0] * geo.out[1];
+  const int64_t row_size = geo.out[2] * out_c;
+  MultiThreadLoopInRange(
+      row_num, std::max<int64_t>(kCpuParallelGrainSize / row_size, 1),
+      [&](int64_t begin, int64_t end) {
+        FOR_RANGE(int64_t, row, begin, end) {
+          const int64_t n = row / (geo.out[0] * geo.out[1]);
+          const int64_t od = row / geo.out[1] % geo.out[0];
+          const int64_t oh = row % geo.out[1];
+          T* out_row = out + row * row_size;
+          std::fill(out_row, out_row + row_size, static_cast<T>(0));
+          FOR_RANGE(int64_t, kd, 0, geo.kernel[0]) {
+            const int64_t id =
+                od * geo.strides[0] + kd * geo.dilation_rate[0] - geo.padding_before[0];
+            if (id < 0 || id >= geo.in[0]) { continue; }
+            FOR_RANGE(int64_t, kh, 0, geo.kernel[1]) {
+              const int64_t ih =
+                  oh * geo.strides[1] + kh * geo.dilation_rate[1] - geo.padding_before[1];
+              if (ih < 0 || ih >= geo.in[1]) { continue; }
+              FOR_RANGE(int64_t, kw, 0, geo.kernel[2]) {
+                int64_t ow_begin = 0;
+                int64_t ow_end = 0;
+                ValidOutRange(geo.in[2], geo.out[2], kw, geo.strides[2], geo.dilation_rate[2],
+                              geo.padding_before[2], &ow_begin, &ow_end);
+                if (ow_begin == ow_end) { continue; }
+                const int64_t iw =
+                    ow_begin * geo.strides[2] + kw * geo.dilation_rate[2] - geo.padding_before[2];
+                const int64_t pos = (kd * geo.kernel[1] + kh) * geo.kernel[2] + kw;
+                const T* in_ptr =
+                    in + (((n * geo.in[0] + id) * geo.in[1] + ih) * geo.in[2] + iw) * in_c;
+                const T* weight_ptr = weight + pos * in_c;
+                // out[ow, :] += in[iw, :] * weight[:, kd, kh, kw, :]^T
+                cblas_gemm<T>(CblasRowMajor, CblasNoTrans, CblasTrans, ow_end - ow_begin, out_c,
+                              in_c, static_cast<T>(1), in_ptr, geo.strides[2] * in_c, weight_ptr,
+                              geo.kernel_volume() * in_c, static_cast<T>(1),
+                              out_row + ow_begin * out_c, out_c);
+              }
+            }
+          }
+        }
+      });
+}
+
+// [kernel_volume, out_channel, in_channel], a row major matrix per kernel position
+template<typename T>
+void PackDirectWeightChannelsFirst(const ConvCpuGeometry& geo, const T* weight, T* packed_weight) {
+  const int64_t in_c = geo.in_channel;
+  const int64_t out_c = geo.out_channel;
+  const int64_t kernel_volume = geo.kernel_volume();
+  FOR_RANGE(int64_t, k, 0, out_c) {
+    FOR_RANGE(int64_t, c, 0, in_c) {
+      FOR_RANGE(int64_t, pos, 0, kernel_volume) {
+        packed_weight[(pos * out_c + k) * in_c + c] = weight[(k * in_c + c) * kernel_volume + pos];
+      }
+    }
+  }
+}
+
+// needs stride 1 along w, so that the input rows are contiguous, the weight is packed by
+// PackDirectWeightChannelsFirst
+template<typename T>
+void DirectForwardChannelsFirst(const ConvCpuGeometry& geo, const T* in, const T* packed_weight,
+                                T* out) {
+  const int64_t in_c = geo.in_channel;
+  const int64_t out_c = geo.out_channel;
+  const int64_t in_plane = geo.in[0] * geo.in[1] * geo.in[2];
+  const int64_t out_plane = geo.out[0] * geo.out[1] * geo.out[2];
+  const int64_t row_num = geo.batch_num * geo.out[0] * geo.out[1];
+  MultiThreadLoopInRange(
+      row_num, std::max<int64_t>(kCpuParallelGrainSize / (geo.out[2] * out_c), 1),
+      [&](int64_t begin, int64_t end) {
+        FOR_RANGE(int64_t, row, begin, end) {
+          const int64_t n = row / (geo.out[0] * geo.out[1]);
+          const int64_t od = row / geo.out[1] % geo.out[0];
+          const int64_t oh = row % geo.out[1];
+          T* out_row = out + n * out_c * out_plane + (od * geo.out[1] + oh) * geo.out[2];
+          FOR_RANGE(int64_t, k, 0, out_c) {
+            std::fill(out_row + k * out_plane, out_row + k * out_plane + geo.out[2],
+                      static_cast<T>(0));
+          }
+          FOR_RANGE(int64_t, kd, 0, geo.kernel[0]) {
+            const int64_t id =
+                od * geo.strides[0] + kd * geo.dilation_rate[0] - geo.padding_before[0];
+            if (id < 0 || id >= geo.in[0]) { continue; }
+            FOR_RANGE(int64_t, kh, 0, geo.kernel[1]) {
+              const int64_t ih =
+                  oh * geo.strides[1] + kh * geo.dilation_rate[1] - geo.padding_before[1];
+              if (ih < 0 || ih >= geo.in[1]) { continue; }
+              FOR_RANGE(int64_t, kw, 0, geo.kernel[2]) {
+                int64_t ow_begin = 0;
+                int64_t ow_end = 0;
+                ValidOutRange(geo.in[2], geo.out[2], kw, 1, geo.dilation_rate[2],
+                              geo.padding_before[2], &ow_begin, &ow_end);
+                if (ow_begin == ow_end) { continue; }
+                const int64_t iw = ow_begin + kw * geo.dilation_rate[2] - geo.padding_before[2];
+                const int64_t pos = (kd * geo.kernel[1] + kh) * geo.kernel[2] + kw;
+                const T* in_ptr =
+                    in + n * in_c * in_plane + (id * geo.in[1] + ih) * geo.in[2] + iw;
+                // out[:, ow] += weight[:, :, kd, kh, kw] * in[:, iw]
+                cblas_gemm<T>(CblasRowMajor, CblasNoTrans, CblasNoTrans, out_c, ow_end - ow_begin,
+                              in_c, static_cast<T>(1), packed_weight + pos * out_c * in_c,
+                              in_c, in_ptr, in_plane, static_cast<T>(1), out_row + ow_begin,
+                              out_plane);
+              }
+            }
+          }
+        }
+      });
+}
+
+int64_t WinogradTileNum(const ConvCpuGeometry& geo) {
+  return ((geo.out[1] + 1) / 2) * ((geo.out[2] + 1) / 2);
+}
+
+int64_t WinogradTaskNum(const ConvCpuGeometry& geo) {
+  return geo.batch_num * (RoundUp(WinogradTileNum(geo), kWinogradTileBlockSize)
+                          / kWinogradTileBlockSize);
+}
+
+// U = G g G^T: [16, out_channel, in_channel]
+template<typename T>
+void TransformWinogradWeight(const ConvCpuGeometry& geo, const T* weight, T* transformed_weight) {
+  const int64_t in_c = geo.in_channel;
+  const int64_t out_c = geo.out_channel;
+  MultiThreadLoopInRange(out_c, 1, [&](int64_t begin, int64_t end) {
+    FOR_RANGE(int64_t, k, begin, end) {
+      FOR_RANGE(int64_t, c, 0, in_c) {
+        T g[3][3];
+        FOR_RANGE(int64_t, i, 0, 3) {
+          FOR_RANGE(int64_t, j, 0, 3) {
+            g[i][j] = geo.channels_first ? weight[((k * in_c + c) * 3 + i) * 3 + j]
+                                         : weight[((k * 3 + i) * 3 + j) * in_c + c];
+          }
+        }
+        T gg[4][3];
+        FOR_RANGE(int64_t, j, 0, 3) {
+          gg[0][j] = g[0][j];
+          gg[1][j] = (g[0][j] + g[1][j] + g[2][j]) * static_cast<T>(0.5);
+          gg[2][j] = (g[0][j] - g[1][j] + g[2][j]) * static_cast<T>(0.5);
+          gg[3][j] = g[2][j];
+        }
+        FOR_RANGE(int64_t, i, 0, 4) {
+          T u[4];
+          u[0] = gg[i][0];
+          u[1] = (gg[i][0] + gg[i][1] + gg[i][2]) * static_cast<T>(0.5);
+          u[2] = (gg[i][0] - gg[i][1] + gg[i][2]) * static_cast<T>(0.5);
+          u[3] = gg[i][2];
+          FOR_RANGE(int64_t, j, 0, 4) {
+            transformed_weight[((i * 4 + j) * out_c + k) * in_c + c] = u[j];
+          }
+        }
+      }
+    }
+  });
+}
+
+// Winograd F(2x2, 3x3), with the transforms of Lavin & Gray:
+//   U = G g G^T, V = B^T d B, Y = A^T [U . V] A
+// The elementwise products of a tile block are 16 gemms over the channels. The weight is U.
+template<typename T>
+void WinogradForward(const ConvCpuGeometry& geo, const T* in, const T* transformed_weight,
+                     T* scratch, int64_t scratch_elem_cnt, T* out) {
+  const int64_t in_c = geo.in_channel;
+  const int64_t out_c = geo.out_channel;
+  const int64_t ih_num = geo.in[1];
+  const int64_t iw_num = geo.in[2];
+  const int64_t oh_num = geo.out[1];
+  const int64_t ow_num = geo.out[2];
+  // element strides of the image along c, h and w
+  const int64_t in_c_stride = geo.channels_first ? ih_num * iw_num : 1;
+  const int64_t in_h_stride = geo.channels_first ? iw_num : iw_num * in_c;
+  const int64_t in_w_stride = geo.channels_first ? 1 : in_c;
+  const int64_t out_c_stride = geo.channels_first ? oh_num * ow_num : 1;
+  const int64_t out_h_stride = geo.channels_first ? ow_num : ow_num * out_c;
+  const int64_t out_w_stride = geo.channels_first ? 1 : out_c;
+
+  const int64_t tile_w_num = (ow_num + 1) / 2;
+  const int64_t tile_num = WinogradTileNum(geo);
+  const int64_t task_num = WinogradTaskNum(geo);
+  const int64_t block_num = task_num / geo.batch_num;
+  const int64_t slot_elem_cnt = ConvCpuScratchElemCnt(ConvCpuAlgo::kWinograd, geo);
+  const int64_t slot_num = scratch_elem_cnt / slot_elem_cnt;
+  ConvCpuLoopInSlots(task_num, slot_num, [&](int64_t begin, int64_t end, int64_t slot) {
+    constexpr int64_t kBlock = kWinogradTileBlockSize;
+    // V: [16, in_channel, kBlock], M: [16, out_channel, kBlock]
+    T* transformed_in = scratch + slot * slot_elem_cnt;
+    T* transformed_out = transformed_in + 16 * in_c * kBlock;
+    FOR_RANGE(int64_t, task, begin, end) {
+      const int64_t n = task / block_num;
+      const int64_t tile_begin = task % block_num * kBlock;
+      const int64_t tile_cnt = std::min(kBlock, tile_num - tile_begin);
+      const T* in_img = in + n * geo.in_img_elem_cnt();
+      T* out_img = out + n * geo.out_img_elem_cnt();
+      const auto TransformInput = [&](int64_t t, int64_t c) {
+        const int64_t h0 = (tile_begin + t) / tile_w_num * 2 - geo.padding_before[1];
+        const int64_t w0 = (tile_begin + t) % tile_w_num * 2 - geo.padding_before[2];
+        const bool is_inner = h0 >= 0 && h0 + 4 <= ih_num && w0 >= 0 && w0 + 4 <= iw_num;
+        const T* in_ptr = in_img + c * in_c_stride;
+        T d[4][4];
+        FOR_RANGE(int64_t, i, 0, 4) {
+          FOR_RANGE(int64_t, j, 0, 4) {
+            const int64_t h = h0 + i;
+            const int64_t w = w0 + j;
+            d[i][j] = (is_inner || (h >= 0 && h < ih_num && w >= 0 && w < iw_num))
+                          ? in_ptr[h * in_h_stride + w * in_w_stride]
+                          : static_cast<T>(0);
+          }
+        }
+        T bd[4][4];
+        FOR_RANGE(int64_t, j, 0, 4) {
+          bd[0][j] = d[0][j] - d[2][j];
+          bd[1][j] = d[1][j] + d[2][j];
+          bd[2][j] = d[2][j] - d[1][j];
+          bd[3][j] = d[1][j] - d[3][j];
+        }
+        FOR_RANGE(int64_t, i, 0, 4) {
+          T* v = transformed_in + (i * 4 * in_c + c) * kBlock + t;
+          v[0 * in_c * kBlock] = bd[i][0] - bd[i][2];
+          v[1 * in_c * kBlock] = bd[i][1] + bd[i][2];
+          v[2 * in_c * kBlock] = bd[i][2] - bd[i][1];
+          v[3 * in_c * kBlock] = bd[i][1] - bd[i][3];
+        }
+      };
+      const auto TransformOutput = [&](int64_t t, int64_t k) {
+        const int64_t oh = (tile_begin + t) / tile_w_num * 2;
+        const int64_t ow = (tile_begin + t) % tile_w_num * 2;
+        T m[4][4];
+        FOR_RANGE(int64_t, i, 0, 4) {
+          FOR_RANGE(int64_t, j, 0, 4) {
+            m[i][j] = transformed_out[((i * 4 + j) * out_c + k) * kBlock + t];
+          }
+        }
+        T am[2][4];
+        FOR_RANGE(int64_t, j, 0, 4) {
+          am[0][j] = m[0][j] + m[1][j] + m[2][j];
+          am[1][j] = m[1][j] - m[2][j] - m[3][j];
+        }
+        FOR_RANGE(int64_t, i, 0, 2) {
+          if (oh + i >= oh_num) { break; }
+          T* y = out_img + k * out_c_stride + (oh + i) * out_h_stride + ow * out_w_stride;
+          y[0] = am[i][0] + am[i][1] + am[i][2];
+          if (ow + 1 < ow_num) { y[out_w_stride] = am[i][1] - am[i][2] - am[i][3]; }
+        }
+      };
+      // the loop over the dim contiguous in the image is the inner one
+      if (geo.channels_first) {
+        FOR_RANGE(int64_t, c, 0, in_c) {
+          FOR_RANGE(int64_t, t, 0, tile_cnt) { TransformInput(t, c); }
+        }
+      } else {
+        FOR_RANGE(int64_t, t, 0, tile_cnt) {
+          FOR_RANGE(int64_t, c, 0, in_c) { TransformInput(t, c); }
+        }
+      }
+      FOR_RANGE(int64_t, p, 0, 16) {
+        cblas_gemm<T>(CblasRowMajor, CblasNoTrans, CblasNoTrans, out_c, tile_cnt, in_c,
+                      static_cast<T>(1), transformed_weight + p * out_c * in_c, in_c,
+                      transformed_in + p * in_c * kBlock, kBlock, static_cast<T>(0),
+                      transformed_out + p * out_c * kBlock, kBlock);
+      }
+      if (geo.channels_first) {
+        FOR_RANGE(int64_t, k, 0, out_c) {
+          FOR_RANGE(int64_t, t, 0, tile_cnt) { TransformOutput(t, k); }
+        }
+      } else {
+        FOR_RANGE(int64_t, t, 0, tile_cnt) {
+          FOR_RANGE(int64_t, k, 0, out_c) { TransformOutput(t, k); }
+        }
+      }
+    }
+  });
+}
+
+}  // namespace
+
+bool ConvCpuGeometry::IsPointwise() const {
+  FOR_RANGE(int32_t, i, 0, 3) {
+    if (kernel[i] != 1 || strides[i] != 1 || padding_before[i] != 0) { return false; }
+  }
+  return true;
+}
+
+bool ConvCpuGeometry::IsDirectApplicable() const {
+  return (!channels_first || strides[2] == 1) && out[2] >= kDirectMinOutWidth;
+}
+
+bool ConvCpuGeometry::IsWinogradApplicable() const {
+  if (kernel[0] != 1 || in[0] != 1 || out[0] != 1) { return false; }
+  FOR_RANGE(int32_t, i, 1, 3) {
+    if (kernel[i] != 3 || strides[i] != 1 || dilation_rate[i] != 1) { return false; }
+  }
+  return true;
+}
+
+ConvCpuAlgo InferConvCpuAlgo(const ConvCpuGeometry& geo) {
+  const char* algo_name = std::getenv("ONEFLOW_CPU_CONV_ALGO");
+  if (algo_name != nullptr) {
+    const std::string name(algo_name);
+    if (name == "winograd" && geo.IsWinogradApplicable()) { return ConvCpuAlgo::kWinograd; }
+    if (name == "direct" && geo.IsDirectApplicable()) { return ConvCpuAlgo::kDirect; }
+    if (name == "im2col_gemm") { return ConvCpuAlgo::kIm2ColGemm; }
+  }
+  if (geo.IsPointwise()) { return ConvCpuAlgo::kIm2ColGemm; }
+  if (geo.IsWinogradApplicable() && geo.in_channel >= kWinogradMinChannel
+      && geo.out_channel >= kWinogradMinChannel) {
+    return ConvCpuAlgo::kWinograd;
+  }
+  if (geo.IsDirectApplicable() && geo.in_channel >= kDirectMinInChannel) {
+    return ConvCpuAlgo::kDirect;
+  }
+  return ConvCpuAlgo::kIm2ColGemm;
+}
+
+int64_t ConvCpuScratchElemCnt(ConvCpuAlgo algo, const ConvCpuGeometry& geo) {
+  if (algo == ConvCpuAlgo::kIm2ColGemm) {
+    return geo.IsPointwise()
+               ? 0
+               : geo.in_channel * geo.kernel_volume() * geo.out[0] * geo.out[1] * geo.out[2];
+  } else if (algo == ConvCpuAlgo::kWinograd) {
+    return 16 * (geo.in_channel + geo.out_channel) * kWinogradTileBlockSize;
+  } else {
+    return 0;
+  }
+}
+
+int64_t ConvCpuSlotNum() {
+  // the calling thread takes chunks too
+  return Global<ThreadPool>::Get() == nullptr ? 1 : Global<ThreadPool>::Get()->thread_num() + 1;
+}
+
+int64_t ConvCpuTmpBufferElemCnt(const ConvCpuGeometry& geo) {
+  const int64_t slot_num = ConvCpuSlotNum();
+  int64_t elem_cnt = ConvCpuScratchElemCnt(ConvCpuAlgo::kIm2ColGemm, geo)
+                     * std::min(geo.batch_num, slot_num);
+  if (geo.IsWinogradApplicable()) {
+    elem_cnt = std::max(elem_cnt, ConvCpuScratchElemCnt(ConvCpuAlgo::kWinograd, geo)
+                                      * std::min(WinogradTaskNum(geo), slot_num));
+  }
+  return elem_cnt;
+}
+
+void ConvCpuLoopInSlots(int64_t num, int64_t slot_num,
+                        const std::function<void(int64_t, int64_t, int64_t)>& Callback) {
+  if (num <= 0) { return; }
+  CHECK_GT(slot_num, 0) << "tmp_buffer too small";
+  const int64_t chunk_num = std::min(num, slot_num);
+  const int64_t grain = (num + chunk_num - 1) / chunk_num;
+  MultiThreadLoopInRange(num, grain,
+                         [&](int64_t begin, int64_t end) { Callback(begin, end, begin / grain); });
+}
+
+template<typename T>
+int64_t ConvCpuKernelUtil<T>::TransformedWeightElemCnt(ConvCpuAlgo algo,
+                                                       const ConvCpuGeometry& geo) {
+  if (algo == ConvCpuAlgo::kWinograd) {
+    return 16 * geo.out_channel * geo.in_channel;
+  } else if (algo == ConvCpuAlgo::kDirect && geo.channels_first) {
+    return geo.kernel_volume() * geo.out_channel * geo.in_channel;
+  } else {
+    return 0;
+  }
+}
+
+template<typename T>
+void ConvCpuKernelUtil<T>::TransformWeight(ConvCpuAlgo algo, const ConvCpuGeometry& geo,
+                                           const T* weight, T* transformed_weight) {
+  if (algo == ConvCpuAlgo::kWinograd) {
+    TransformWinogradWeight(geo, weight, transformed_weight);
+  } else if (algo == ConvCpuAlgo::kDirect && geo.channels_first) {
+    PackDirectWeightChannelsFirst(geo, weight, transformed_weight);
+  } else {
+    UNIMPLEMENTED();
+  }
+}
+
+template<typename T>
+void ConvCpuKernelUtil<T>::Forward(ConvCpuAlgo algo, const ConvCpuGeometry& geo, const T* in,
+                                   const T* weight, T* scratch, int64_t scratch_elem_cnt,
+                                   T* out) {
+  if (algo == ConvCpuAlgo::kWinograd) {
+    CHECK(geo.IsWinogradApplicable());
+    WinogradForward(geo, in, weight, scratch, scratch_elem_cnt, out);
+  } else if (algo == ConvCpuAlgo::kDirect) {
+    CHECK(geo.IsDirectApplicable());
+    if (geo.channels_first) {
+      DirectForwardChannelsFirst(geo, in, weight, out);
+    } else {
+      DirectForwardChannelsLast(geo, in, weight, out);
+    }
+  } else {
+    UNIMPLEMENTED();
+  }
+}
+
+template<typename T>
+void ConvCpuKernelUtil<T>::AddBias(const ConvCpuGeometry& geo, const T* bias, T* out) {
+  const int64_t out_c = geo.out_channel;
+  const int64_t spatial_size = geo.out[0] * geo.out[1] * geo.out[2];
+  if (geo.channels_first) {
+    MultiThreadLoopInRange(geo.batch_num * out_c,
+                           std::max<int64_t>(kCpuParallelGrainSize / spatial_size, 1),
+                           [&](int64_t begin, int64_t end) {
+                             FOR_RANGE(int64_t, i, begin, end) {
+                               const T b = bias[i % out_c];
+                               T* out_i = out + i * spatial_size;
+                               for (int64_t j = 0; j < spatial_size; ++j) { out_i[j] += b; }
+                             }
+                           });
+  } else {
+    MultiThreadLoopInRange(geo.batch_num * spatial_size,
+                           std::max<int64_t>(kCpuParallelGrainSize / out_c, 1),
+                           [&](int64_t begin, int64_t end) {
+                             FOR_RANGE(int64_t, i, begin, end) {
+                               T* out_i = out + i * out_c;
+                               for (int64_t k = 0; k < out_c; ++k) { out_i[k] += bias[k]; }
+                             }
+                           });
+  }
+}
+
+template struct ConvCpuKernelUtil<float>;
+template struct ConvCpuKernelUtil<double>;
+
+}  // namespace oneflow
@@ -0,0 +1,85 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#ifndef ONEFLOW_USER_KERNELS_CONV_CPU_KERNEL_UTIL_H_
+#define ONEFLOW_USER_KERNELS_CONV_CPU_KERNEL_UTIL_H_
+
+#include "oneflow/core/common/util.h"
+
+namespace oneflow {
+
+enum class ConvCpuAlgo {
+  // im2col per image then one gemm, the fallback for every shape
+  kIm2ColGemm = 0,
+  // one gemm per output row and kernel position straight from the input, no col buffer
+  kDirect = 1,
+  // F(2x2, 3x3) for 2d 3x3 convs of stride and dilation 1
+  kWinograd = 2,
+};
+
+// Conv1d and conv2d are described as conv3d with leading spatial dims of 1. The image is
+// [C, D, H, W] for channels first and [D, H, W, C] for channels last, the weight is
+// [out_channel, in_channel, KD, KH, KW] and [out_channel, KD, KH, KW, in_channel] respectively.
+struct ConvCpuGeometry {
+  bool channels_first;
+  int64_t batch_num;
+  int64_t in_channel;
+  int64_t out_channel;
+  int64_t in[3];
+  int64_t out[3];
+  int64_t kernel[3];
+  int32_t strides[3];
+  int32_t dilation_rate[3];
+  int32_t padding_before[3];
+
+  int64_t in_img_elem_cnt() const { return in_channel * in[0] * in[1] * in[2]; }
+  int64_t out_img_elem_cnt() const { return out_channel * out[0] * out[1] * out[2]; }
+  int64_t kernel_volume() const { return kernel[0] * kernel[1] * kernel[2]; }
+  // the input image itself is the im2col buffer
+  bool IsPointwise() const;
+  bool IsDirectApplicable() const;
+  bool IsWinogradApplicable() const;
+};
+
+// The algo for geo, which may be overridden by the ONEFLOW_CPU_CONV_ALGO environment variable
+// (im2col_gemm, direct or winograd) wherever the given algo is applicable.
+ConvCpuAlgo InferConvCpuAlgo(const ConvCpuGeometry& geo);
+
+// The parallel loop of an algo runs in chunks, each with a slot of ConvCpuScratchElemCnt elements
+// of scratch space out of the tmp_buffer of the kernel. A smaller tmp_buffer only means fewer
+// chunks, ConvCpuTmpBufferElemCnt is enough for every thread of the pool to take one.
+int64_t ConvCpuScratchElemCnt(ConvCpuAlgo algo, const ConvCpuGeometry& geo);
+// The chunks that run in parallel, one per thread of the pool and one for the calling thread
+int64_t ConvCpuSlotNum();
+int64_t ConvCpuTmpBufferElemCnt(const ConvCpuGeometry& geo);
+// Calls Callback(begin, end, slot) on chunks of [0, num), at most slot_num of them
+void ConvCpuLoopInSlots(int64_t num, int64_t slot_num,
+                        const std::function<void(int64_t, int64_t, int64_t)>& Callback);
+
+template<typename T>
+struct ConvCpuKernelUtil {
+  // the weight rearranged for algo, 0 elements if algo reads the weight as it is
+  static int64_t TransformedWeightElemCnt(ConvCpuAlgo algo, const ConvCpuGeometry& geo);
+  static void TransformWeight(ConvCpuAlgo algo, const ConvCpuGeometry& geo, const T* weight,
+                              T* transformed_weight);
+  // algo is kDirect or kWinograd, weight is transformed for algo, out is overwritten
+  static void Forward(ConvCpuAlgo algo, const ConvCpuGeometry& geo, const T* in, const T* weight,
+                      T* scratch, int64_t scratch_elem_cnt, T* out);
+  static void AddBias(const ConvCpuGeometry& geo, const T* bias, T* out);
+};
+
+}  // namespace oneflow
+
+#endif  // ONEFLOW_USER_KERNELS_CONV_CPU_KERNEL_UTIL_H_
@@ -16,6 +16,9 @@ limitations under the License.
 #include "oneflow/core/framework/framework.h"
 #include "oneflow/user/ops/nn_util.h"
 #include "oneflow/core/kernel/new_kernel_util.h"
+#include "oneflow/core/thread/thread_manager.h"
+#include "oneflow/core/kernel/cpu_half_util.h"
+#include "oneflow/user/kernels/conv_cpu_kernel_util.h"
 
 namespace oneflow {
 
@@ -307,6 +310,16 @@ struct ConvOpKernelState final : public user_op::OpKernelState {
   enum CBLAS_TRANSPOSE is_out_diff_need_trans_;
   int32_t idx_offset_;
   bool is_dynamic_;
+  // only chosen by the forward kernel
+  ConvCpuAlgo algo_ = ConvCpuAlgo::kIm2ColGemm;
+  // the buffer the forward kernel transforms the weight into for transformed_weight_algo_. The
+  // variables of a session change in place, be it by a train job or a model load, and a weight
+  // may be computed, so every Compute transforms it again.
+  std::vector<T> transformed_weight_;
+  ConvCpuAlgo transformed_weight_algo_ = ConvCpuAlgo::kIm2ColGemm;
+  // the float16 weight and bias widened by the half forward kernel, again on every Compute
+  std::vector<T> widened_weight_;
+  std::vector<T> widened_bias_;
 
   void Update(const ShapeView& x_shape, const ShapeView& out_shape) {
     auto Gen5DShape = [](const ShapeView& shape, int32_t idx_offset) -> Shape {
@@ -380,11 +393,143 @@ std::shared_ptr<user_op::OpKernelState> CreateConvOpKernelState(user_op::KernelI
   return std::move(state);
 }
 
+template<typename T>
+ConvCpuGeometry GenConvCpuGeometry(const ConvOpKernelState<T>& state, int64_t batch_num) {
+  ConvCpuGeometry geo;
+  geo.channels_first = state.idx_offset_ == 2;
+  geo.batch_num = batch_num;
+  geo.in_channel = state.in_5d_shape_.At(geo.channels_first ? 1 : 4);
+  geo.out_channel = state.weight_5d_shape_.At(0);
+  FOR_RANGE(int32_t, i, 0, 3) {
+    geo.in[i] = state.in_5d_shape_.At(state.idx_offset_ + i);
+    geo.out[i] = state.out_5d_shape_.At(state.idx_offset_ + i);
+    geo.kernel[i] = state.weight_5d_shape_.At(state.idx_offset_ + i);
+    geo.strides[i] = state.strides_3d_.at(i);
+    geo.dilation_rate[i] = state.dilation_rate_3d_.at(i);
+    geo.padding_before[i] = state.padding_before_3d_.at(i);
+  }
+  return geo;
+}
+
+// the geometry of the static shapes, which bounds the dynamic ones
+ConvCpuGeometry GenConvCpuGeometry(user_op::InferContext* ctx) {
+  const Shape& in_shape = ctx->TensorDesc4ArgNameAndIndex("in", 0)->shape();
+  const Shape& out_shape = ctx->TensorDesc4ArgNameAndIndex("out", 0)->shape();
+  const Shape& weight_shape = ctx->TensorDesc4ArgNameAndIndex("weight", 0)->shape();
+  const auto& strides = ctx->Attr<std::vector<int32_t>>("strides");
+  const auto& dilation_rate = ctx->Attr<std::vector<int32_t>>("dilation_rate");
+  const auto& padding_before = ctx->Attr<std::vector<int32_t>>("padding_before");
+  const int32_t idx_offset = IdxOffset(ctx->Attr<std::string>("data_format"));
+  const int32_t ndims = in_shape.NumAxes() - 2;
+  ConvCpuGeometry geo;
+  geo.channels_first = idx_offset == 2;
+  geo.batch_num = in_shape.At(0);
+  geo.in_channel = in_shape.At(geo.channels_first ? 1 : ndims + 1);
+  geo.out_channel = weight_shape.At(0);
+  FOR_RANGE(int32_t, i, 0, 3) {
+    const int32_t dim = i - (3 - ndims);
+    geo.in[i] = dim < 0 ? 1 : in_shape.At(idx_offset + dim);
+    geo.out[i] = dim < 0 ? 1 : out_shape.At(idx_offset + dim);
+    geo.kernel[i] = dim < 0 ? 1 : weight_shape.At(idx_offset + dim);
+    geo.strides[i] = dim < 0 ? 1 : strides.at(dim);
+    geo.dilation_rate[i] = dim < 0 ? 1 : dilation_rate.at(dim);
+    geo.padding_before[i] = dim < 0 ? 0 : padding_before.at(dim);
+  }
+  return geo;
+}
+
 template<typename T>
 void InitBiasMulBuf(T* dptr, int64_t num) {
   for (int64_t i = 0; i < num; ++i) { dptr[i] = 1; }
 }
 
+// images are independent, so every chunk takes whole images with a col buffer of its own
+template<typename T>
+void Im2ColGemmForward(const ConvOpKernelState<T>& conv_state, const ConvCpuGeometry& geo,
+                       const T* in, const T* weight, T* scratch, int64_t scratch_elem_cnt,
+                       T* out) {
+  const int32_t idx_offset = conv_state.idx_offset_;
+  const int64_t in_img_size = conv_state.in_5d_shape_.Count(1);
+  const int64_t out_img_size = conv_state.out_5d_shape_.Count(1);
+  const int64_t out_spatial_size = conv_state.out_5d_shape_.Count(idx_offset, idx_offset + 3);
+  const int64_t col_buf_elem_cnt = ConvCpuScratchElemCnt(ConvCpuAlgo::kIm2ColGemm, geo);
+  const int64_t slot_num =
+      col_buf_elem_cnt == 0 ? geo.batch_num : scratch_elem_cnt / col_buf_elem_cnt;
+  ConvCpuLoopInSlots(geo.batch_num, slot_num, [&](int64_t begin, int64_t end, int64_t slot) {
+    T* col_buf = scratch + slot * col_buf_elem_cnt;
+    FOR_RANGE(int64_t, i, begin, end) {
+      const T* in_img = in + i * in_img_size;
+      T* out_img = out + i * out_img_size;
+      if (geo.IsPointwise() && !geo.channels_first) {
+        // out = in * weight(T), the image is the transposed col buffer
+        NewKernelUtil<DeviceType::kCPU>::OFGemm(nullptr, CblasNoTrans, CblasTrans,
+                                                out_spatial_size, geo.out_channel, geo.in_channel,
+                                                static_cast<T>(1), in_img, weight,
+                                                static_cast<T>(0), out_img);
+        continue;
+      }
+      const T* col_buf_dptr = in_img;
+      if (!geo.IsPointwise()) {
+        conv_state.im2col_func_(in_img, ShapeView(conv_state.in_5d_shape_),
+                                ShapeView(conv_state.weight_5d_shape_),
+                                ShapeView(conv_state.out_5d_shape_), conv_state.strides_3d_.data(),
+                                conv_state.dilation_rate_3d_.data(),
+                                conv_state.padding_before_3d_.data(), col_buf);
+        col_buf_dptr = col_buf;
+      }
+      // channels first: out = weight * col_buf
+      // channels last:  out = (weight * col_buf)(T)
+      conv_state.forward_func_(CblasNoTrans, CblasNoTrans,
+                               conv_state.weight_5d_shape_.At(0),     // filter
+                               out_spatial_size,                      // od * oh * ow
+                               conv_state.weight_5d_shape_.Count(1),  // ci * kd * kh * kw
+                               static_cast<T>(1), weight, col_buf_dptr, static_cast<T>(0),
+                               out_img);
+    }
+  });
+}
+
+// bias may be nullptr, scratch holds ConvCpuTmpBufferElemCnt elements of the static geometry.
+// The weight is transformed for the algo unless is_weight_transformed tells that an earlier call
+// of the same Compute transformed it for the same algo.
+template<typename T>
+void ConvCpuForward(ConvOpKernelState<T>* conv_state, const ShapeView& in_shape,
+                    const ShapeView& out_shape, const T* in, const T* weight, const T* bias,
+                    bool is_weight_transformed, T* scratch, int64_t scratch_elem_cnt, T* out) {
+  conv_state->Update(in_shape, out_shape);
+  const ConvCpuGeometry geo = GenConvCpuGeometry(*conv_state, in_shape.At(0));
+  if (conv_state->is_dynamic_) { conv_state->algo_ = InferConvCpuAlgo(geo); }
+  const ConvCpuAlgo algo = conv_state->algo_;
+  if (algo == ConvCpuAlgo::kIm2ColGemm) {
+    Im2ColGemmForward(*conv_state, geo, in, weight, scratch, scratch_elem_cnt, out);
+  } else {
+    const int64_t transformed_elem_cnt =
+        ConvCpuKernelUtil<T>::TransformedWeightElemCnt(algo, geo);
+    if (transformed_elem_cnt > 0) {
+      if (!is_weight_transformed || conv_state->transformed_weight_algo_ != algo) {
+        conv_state->transformed_weight_.resize(transformed_elem_cnt);
+        ConvCpuKernelUtil<T>::TransformWeight(algo, geo, weight,
+                                              conv_state->transformed_weight_.data());
+        conv_state->transformed_weight_algo_ = algo;
+      }
+      weight = conv_state->transformed_weight_.data();
+    }
+    ConvCpuKernelUtil<T>::Forward(algo, geo, in, weight, scratch, scratch_elem_cnt, out);
+  }
+  if (bias != nullptr) { ConvCpuKernelUtil<T>::AddBias(geo, bias, out); }
+}
+
+template<typename T>
+std::shared_ptr<user_op::OpKernelState> CreateConvForwardOpKernelState(
+    user_op::KernelInitContext* ctx) {
+  std::shared_ptr<user_op::OpKernelState> state =
+      CreateConvOpKernelState<T>(ctx, "in", "out", "weight");
+  auto* conv_state = dynamic_cast<ConvOpKernelState<T>*>(state.get());
+  conv_state->algo_ = InferConvCpuAlgo(
+      GenConvCpuGeometry(*conv_state, ctx->TensorDesc4ArgNameAndIndex("in", 0)->shape().At(0)));
+  return state;
+}
+
 template<typename T, size_t NDims>
 class ConvCpuKernel final : public user_op::OpKernel {
  public:
@@ -395,88 +540,119 @@ class ConvCpuKernel final : public user_op::OpKernel {
 
   std::shared_ptr<user_op::OpKernelState> CreateOpKernelState(
       user_op::KernelInitContext* ctx) const {
-    return CreateConvOpKernelState<T>(ctx, "in", "out", "weight");
+    return CreateConvForwardOpKernelState<T>(ctx);
   }
 
  private:
   void Compute(user_op::KernelComputeContext* ctx, user_op::OpKernelState* state) const override {
     const user_op::Tensor* in = ctx->Tensor4ArgNameAndIndex("in", 0);
     const user_op::Tensor* weight = ctx->Tensor4ArgNameAndIndex("weight", 0);
-    user_op::Tensor* tmp_buffer = ctx->Tensor4ArgNameAndIndex("tmp_buffer", 0);
+    const user_op::Tensor* bias = ctx->Tensor4ArgNameAndIndex("bias", 0);
     user_op::Tensor* out = ctx->Tensor4ArgNameAndIndex("out", 0);
+    user_op::Tensor* tmp_buffer = ctx->Tensor4ArgNameAndIndex("tmp_buffer", 0);
 
-    T* col_buf_dptr = tmp_buffer->mut_dptr<T>();
+    // empty for pointwise convs
+    T* scratch = tmp_buffer == nullptr ? nullptr : tmp_buffer->mut_dptr<T>();
+    const int64_t scratch_elem_cnt =
+        tmp_buffer == nullptr ? 0 : tmp_buffer->shape().elem_cnt() / sizeof(T);
 
     auto* conv_state = dynamic_cast<ConvOpKernelState<T>*>(state);
-    conv_state->Update(in->shape(), out->shape());
     CHECK_NOTNULL(conv_state);
-    bool is_bias_mul_inited = false;
-    for (int64_t i = 0; i < in->shape().At(0); ++i) {
-      conv_state->im2col_func_(GetImgDptr<T>(in, i), ShapeView(conv_state->in_5d_shape_),
-                               ShapeView(conv_state->weight_5d_shape_),
-                               ShapeView(conv_state->out_5d_shape_), conv_state->strides_3d_.data(),
-                               conv_state->dilation_rate_3d_.data(),
-                               conv_state->padding_before_3d_.data(), col_buf_dptr);
+    ConvCpuForward<T>(conv_state, in->shape(), out->shape(), in->dptr<T>(), weight->dptr<T>(),
+                      bias == nullptr ? nullptr : bias->dptr<T>(), false, scratch,
+                      scratch_elem_cnt, out->mut_dptr<T>());
+  }
+};
 
-      // channels first: out = weight * col_buf
-      // channels last:  out = (weight * col_buf)(T)
-      int32_t idx_offset = conv_state->idx_offset_;
-      conv_state->forward_func_(
-          CblasNoTrans, CblasNoTrans,
-          conv_state->weight_5d_shape_.At(0),                           // filter
-          conv_state->out_5d_shape_.Count(idx_offset, idx_offset + 3),  // od * oh * ow
-          conv_state->weight_5d_shape_.Count(1),                        // ci * kd * kh * kw
-          static_cast<T>(1), weight->dptr<T>(), col_buf_dptr, static_cast<T>(0),
-          GetImgMutDptr<T>(out, i));
-
-      const user_op::Tensor* bias = ctx->Tensor4ArgNameAndIndex("bias", 0);
-      if (bias != nullptr) {
-        int64_t num_of_col_buf = CalcElemNumOfColBuf(out->shape(), weight->shape(), idx_offset);
-        int64_t num_of_bias_mul = tmp_buffer->shape().elem_cnt() - num_of_col_buf;
-        CHECK_GT(num_of_bias_mul, 0);
-        T* bias_mul_dptr = col_buf_dptr + num_of_col_buf * sizeof(T);
-        if (!is_bias_mul_inited) {
-          InitBiasMulBuf(bias_mul_dptr, num_of_bias_mul);
-          is_bias_mul_inited = true;
-        }
+// Images of a half conv widened to float at a time, the input and output of a chunk stay in L2
+// unless every thread needs a whole image of its own.
+constexpr int64_t kConvCpuHalfChunkElemCnt = 256 * 1024;
 
-        // channels first:  out += bias * bias_mul
-        // channels last:   out += (bias * bias_mul)(T)
-        conv_state->forward_func_(
-            CblasNoTrans, CblasNoTrans,
-            conv_state->weight_5d_shape_.At(0),                           // filter
-            conv_state->out_5d_shape_.Count(idx_offset, idx_offset + 3),  // od * oh * ow
-            1,                                                            // 1
-            static_cast<T>(1), bias->dptr<T>(), bias_mul_dptr, static_cast<T>(1),
-            GetImgMutDptr<T>(out, i));
-      }
+int64_t ConvCpuHalfChunkImgNum(const ConvCpuGeometry& geo) {
+  const int64_t img_elem_cnt =
+      std::max<int64_t>(1, geo.in_img_elem_cnt() + geo.out_img_elem_cnt());
+  const int64_t img_num = std::max(ConvCpuSlotNum(), kConvCpuHalfChunkElemCnt / img_elem_cnt);
+  return std::max<int64_t>(1, std::min(geo.batch_num, img_num));
+}
+
+// Runs the float convolution on chunks of images widened to float in tmp_buffer, so the products
+// accumulate in float and the output is rounded once. The weight and bias are widened into buffers
+// of the kernel state by every Compute.
+template<size_t NDims>
+class ConvCpuHalfKernel final : public user_op::OpKernel {
+ public:
+  ConvCpuHalfKernel() = default;
+  ~ConvCpuHalfKernel() = default;
+
+  bool AlwaysComputeWhenAllOutputsEmpty() const override { return false; }
+
+  std::shared_ptr<user_op::OpKernelState> CreateOpKernelState(
+      user_op::KernelInitContext* ctx) const {
+    return CreateConvForwardOpKernelState<float>(ctx);
+  }
+
+ private:
+  void Compute(user_op::KernelComputeContext* ctx, user_op::OpKernelState* state) const override {
+    const user_op::Tensor* in = ctx->Tensor4ArgNameAndIndex("in", 0);
+    const user_op::Tensor* weight = ctx->Tensor4ArgNameAndIndex("weight", 0);
+    const user_op::Tensor* bias = ctx->Tensor4ArgNameAndIndex("bias", 0);
+    user_op::Tensor* out = ctx->Tensor4ArgNameAndIndex("out", 0);
+    user_op::Tensor* tmp_buffer = ctx->Tensor4ArgNameAndIndex("tmp_buffer", 0);
+
+    auto* conv_state = dynamic_cast<ConvOpKernelState<float>*>(state);
+    CHECK_NOTNULL(conv_state);
+    conv_state->widened_weight_.resize(weight->shape().elem_cnt());
+    CpuHalfToFloat(weight->shape().elem_cnt(), weight->dptr<float16>(),
+                   conv_state->widened_weight_.data());
+    const float* bias_float = nullptr;
+    if (bias != nullptr) {
+      conv_state->widened_bias_.resize(bias->shape().elem_cnt());
+      CpuHalfToFloat(bias->shape().elem_cnt(), bias->dptr<float16>(),
+                     conv_state->widened_bias_.data());
+      bias_float = conv_state->widened_bias_.data();
+    }
+
+    conv_state->Update(in->shape(), out->shape());
+    const ConvCpuGeometry geo = GenConvCpuGeometry(*conv_state, in->shape().At(0));
+    const int64_t in_img_elem_cnt = geo.in_img_elem_cnt();
+    const int64_t out_img_elem_cnt = geo.out_img_elem_cnt();
+    const int64_t chunk_img_num = ConvCpuHalfChunkImgNum(geo);
+    float* in_float = tmp_buffer->mut_dptr<float>();
+    float* out_float = in_float + chunk_img_num * in_img_elem_cnt;
+    float* scratch = out_float + chunk_img_num * out_img_elem_cnt;
+    const int64_t scratch_elem_cnt =
+        tmp_buffer->mut_dptr<float>() + tmp_buffer->shape().elem_cnt() / sizeof(float) - scratch;
+    DimVector in_chunk_dim_vec;
+    DimVector out_chunk_dim_vec;
+    in->shape().ToDimVector(&in_chunk_dim_vec);
+    out->shape().ToDimVector(&out_chunk_dim_vec);
+    for (int64_t i = 0; i < geo.batch_num; i += chunk_img_num) {
+      const int64_t img_num = std::min(chunk_img_num, geo.batch_num - i);
+      in_chunk_dim_vec[0] = img_num;
+      out_chunk_dim_vec[0] = img_num;
+      const Shape in_chunk_shape(in_chunk_dim_vec);
+      const Shape out_chunk_shape(out_chunk_dim_vec);
+      CpuHalfToFloat(img_num * in_img_elem_cnt, in->dptr<float16>() + i * in_img_elem_cnt,
+                     in_float);
+      // the first chunk transforms the weight, the later ones reuse it
+      ConvCpuForward<float>(conv_state, ShapeView(in_chunk_shape), ShapeView(out_chunk_shape),
+                            in_float, conv_state->widened_weight_.data(), bias_float, i > 0,
+                            scratch, scratch_elem_cnt, out_float);
+      CpuFloatToHalf(img_num * out_img_elem_cnt, out_float,
+                     out->mut_dptr<float16>() + i * out_img_elem_cnt);
     }
   }
 };
 
-#define REGISTER_CONV_KERNEL(op_name, dtype, ndims)                                         \
-  REGISTER_USER_KERNEL(#op_name)                                                            \
-      .SetCreateFn<ConvCpuKernel<dtype, ndims>>()                                           \
-      .SetIsMatchedHob((user_op::HobDeviceTag() == "cpu")                                   \
-                       & (user_op::HobAttr<int32_t>("groups") == 1)                         \
-                       & (user_op::HobDataType("in", 0) == GetDataType<dtype>::value))      \
-      .SetInferTmpSizeFn([](user_op::InferContext* ctx) -> size_t {                         \
-        size_t tmp_buffer_size = 0;                                                         \
-        const auto& out_shape = ctx->TensorDesc4ArgNameAndIndex("out", 0)->shape();         \
-        const auto& weight_shape = ctx->TensorDesc4ArgNameAndIndex("weight", 0)->shape();   \
-                                                                                            \
-        int64_t idx_offset = IdxOffset(ctx->Attr<std::string>("data_format"));              \
-        tmp_buffer_size +=                                                                  \
-            CalcElemNumOfColBuf(out_shape, weight_shape, idx_offset) * sizeof(dtype);       \
-                                                                                            \
-        const auto* bias = ctx->TensorDesc4ArgNameAndIndex("bias", 0);                      \
-        if (bias != nullptr) {                                                              \
-          int64_t bias_mul_cnt = 1;                                                         \
-          for (int i = 0; i < ndims; ++i) { bias_mul_cnt *= out_shape.At(idx_offset + i); } \
-          tmp_buffer_size += bias_mul_cnt * sizeof(dtype);                                  \
-        }                                                                                   \
-        return tmp_buffer_size;                                                             \
-      })
+#define REGISTER_CONV_KERNEL(op_name, dtype, ndims)                                    \
+  REGISTER_USER_KERNEL(#op_name)                                                       \
+      .SetCreateFn<ConvCpuKernel<dtype, ndims>>()                                      \
+      .SetIsMatchedHob((user_op::HobDeviceTag() == "cpu")                              \
+                       & (user_op::HobAttr<int32_t>("groups") == 1)                    \
+                       & (user_op::HobDataType("in", 0) == GetDataType<dtype>::value)) \
+      .SetInferTmpSizeFn([](user_op::InferContext* ctx) -> size_t {                    \
+        return ConvCpuTmpBufferElemCnt(GenConvCpuGeometry(ctx)) * sizeof(dtype);       \
+      });
 
 REGISTER_CONV_KERNEL(conv1d, float, 1);
 REGISTER_CONV_KERNEL(conv2d, float, 2);
@@ -485,6 +661,24 @@ REGISTER_CONV_KERNEL(conv1d, double, 1);
 REGISTER_CONV_KERNEL(conv2d, double, 2);
 REGISTER_CONV_KERNEL(conv3d, double, 3);
 
+#define REGISTER_CONV_HALF_KERNEL(op_name, ndims)                                            \
+  REGISTER_USER_KERNEL(#op_name)                                                             \
+      .SetCreateFn<ConvCpuHalfKernel<ndims>>()                                               \
+      .SetIsMatchedHob((user_op::HobDeviceTag() == "cpu")                                    \
+                       & (user_op::HobAttr<int32_t>("groups") == 1)                          \
+                       & (user_op::HobDataType("in", 0) == DataType::kFloat16))              \
+      .SetInferTmpSizeFn([](user_op::InferContext* ctx) -> size_t {                          \
+        const ConvCpuGeometry geo = GenConvCpuGeometry(ctx);                                 \
+        const int64_t elem_cnt =                                                             \
+            ConvCpuHalfChunkImgNum(geo) * (geo.in_img_elem_cnt() + geo.out_img_elem_cnt())   \
+            + ConvCpuTmpBufferElemCnt(geo);                                                  \
+        return elem_cnt * sizeof(float);                                                     \
+      });
+
+REGISTER_CONV_HALF_KERNEL(conv1d, 1);
+REGISTER_CONV_HALF_KERNEL(conv2d, 2);
+REGISTER_CONV_HALF_KERNEL(conv3d, 3);
+
 template<typename T>
 class ConvDataGradCpuKernel final : public user_op::OpKernel {
  public:
@@ -0,0 +1,121 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include "oneflow/user/kernels/int8_gemm_util.h"
+#include <cmath>
+#include "oneflow/core/common/cpu_isa.h"
+#include "oneflow/core/thread/thread_manager.h"
+
+namespace oneflow {
+
+namespace {
+
+using int8_gemm_util::kColTile;
+
+// RowNum rows of a times 4 rows of b: each loaded element is used RowNum or 4 times, and the
+// compiler vectorizes the 4 * RowNum dot products along k with multiply-add instructions.
+#define DEFINE_INT8_GEMM_TILE_FUNCS(suffix, target)                                              \
+  template<int RowNum>                                                                           \
+  target void MicroKernel##suffix(int64_t k, const int16_t* a, const int16_t* b, int32_t* acc) { \
+    int32_t sum[RowNum][4] = {};                                                                 \
+    for (int64_t p = 0; p < k; ++p) {                                                            \
+      for (int r = 0; r < RowNum; ++r) {                                                         \
+        const int32_t a_val = a[r * k + p];                                                      \
+        for (int c = 0; c < 4; ++c) { sum[r][c] += a_val * static_cast<int32_t>(b[c * k + p]); } \
+      }                                                                                          \
+    }                                                                                            \
+    for (int r = 0; r < RowNum; ++r) {                                                           \
+      for (int c = 0; c < 4; ++c) { acc[r * kColTile + c] = sum[r][c]; }                         \
+    }                                                                                            \
+  }                                                                                              \
+                                                                                                 \
+  target void GemmTile##suffix(int64_t row_cnt, int64_t col_cnt, int64_t k, const int16_t* a,    \
+                               const int16_t* b, int32_t* acc) {                                 \
+    int64_t i = 0;                                                                               \
+    for (; i + 4 <= row_cnt; i += 4) {                                                           \
+      for (int64_t j = 0; j < col_cnt; j += 4) {                                                 \
+        MicroKernel##suffix<4>(k, a + i * k, b + j * k, acc + i * kColTile + j);                 \
+      }                                                                                          \
+    }                                                                                            \
+    for (; i < row_cnt; ++i) {                                                                   \
+      for (int64_t j = 0; j < col_cnt; j += 4) {                                                 \
+        MicroKernel##suffix<1>(k, a + i * k, b + j * k, acc + i * kColTile + j);                 \
+      }                                                                                          \
+    }                                                                                            \
+  }
+
+DEFINE_INT8_GEMM_TILE_FUNCS(Scalar, )
+#if OF_CPU_ISA_DISPATCH_ENABLED
+DEFINE_INT8_GEMM_TILE_FUNCS(Avx2, OF_CPU_TARGET_AVX2)
+DEFINE_INT8_GEMM_TILE_FUNCS(Avx512, OF_CPU_TARGET_AVX512)
+#endif
+
+#undef DEFINE_INT8_GEMM_TILE_FUNCS
+
+float MaxAbs(int64_t n, const float* x) {
+  float max_abs = 0;
+  FOR_RANGE(int64_t, i, 0, n) { max_abs = std::max(max_abs, std::abs(x[i])); }
+  return max_abs;
+}
+
+void QuantizeRange(int64_t n, const float* x, float inv_scale, int8_t* q) {
+  FOR_RANGE(int64_t, i, 0, n) {
+    const float v = std::min(std::max(x[i] * inv_scale, -kInt8QuantizeMax), kInt8QuantizeMax);
+    q[i] = static_cast<int8_t>(v < 0 ? v - 0.5f : v + 0.5f);
+  }
+}
+
+}  // namespace
+
+namespace int8_gemm_util {
+
+void GemmTile(int64_t row_cnt, int64_t col_cnt, int64_t k, const int16_t* a, const int16_t* b,
+              int32_t* acc) {
+  CHECK_EQ(col_cnt % 4, 0);
+#if OF_CPU_ISA_DISPATCH_ENABLED
+  switch (GetCpuIsa()) {
+    case CpuIsa::kAvx512: return GemmTileAvx512(row_cnt, col_cnt, k, a, b, acc);
+    case CpuIsa::kAvx2: return GemmTileAvx2(row_cnt, col_cnt, k, a, b, acc);
+    default: break;
+  }
+#endif
+  GemmTileScalar(row_cnt, col_cnt, k, a, b, acc);
+}
+
+}  // namespace int8_gemm_util
+
+float Int8MaxAbsOf(int64_t n, const float* x) {
+  std::mutex mutex;
+  float max_abs = 0;
+  MultiThreadLoopInRange(n, kCpuParallelGrainSize, [&](int64_t begin, int64_t end) {
+    const float part_max_abs = MaxAbs(end - begin, x + begin);
+    std::unique_lock<std::mutex> lock(mutex);
+    max_abs = std::max(max_abs, part_max_abs);
+  });
+  return max_abs;
+}
+
+float Int8ScaleOfMaxAbs(float max_abs) { return max_abs > 0 ? max_abs / kInt8QuantizeMax : 1.0f; }
+
+float Int8ScaleOf(int64_t n, const float* x) { return Int8ScaleOfMaxAbs(Int8MaxAbsOf(n, x)); }
+
+void Int8Quantize(int64_t n, const float* x, float scale, int8_t* q) {
+  const float inv_scale = 1.0f / scale;
+  MultiThreadLoopInRange(n, kCpuParallelGrainSize, [&](int64_t begin, int64_t end) {
+    QuantizeRange(end - begin, x + begin, inv_scale, q + begin);
+  });
+}
+
+}  // namespace oneflow
@@ -0,0 +1,108 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#ifndef ONEFLOW_USER_KERNELS_INT8_GEMM_UTIL_H_
+#define ONEFLOW_USER_KERNELS_INT8_GEMM_UTIL_H_
+
+#include "oneflow/core/common/util.h"
+
+namespace oneflow {
+
+// Symmetric int8 quantization, x ~ q * scale with q = round(x / scale) in [-127, 127]. Zero maps to
+// zero, so a quantized tensor can be zero padded as is.
+constexpr float kInt8QuantizeMax = 127.0f;
+
+// max|x| of the n values x. This and Int8Quantize run on the calling thread for up to
+// kCpuParallelGrainSize values.
+float Int8MaxAbsOf(int64_t n, const float* x);
+// The scale of values bounded by max_abs, max_abs / 127, or 1 when max_abs is 0.
+float Int8ScaleOfMaxAbs(float max_abs);
+// The scale of the n values x, Int8ScaleOfMaxAbs(Int8MaxAbsOf(n, x)).
+float Int8ScaleOf(int64_t n, const float* x);
+// Quantizes the n values x with scale, the values beyond 127 * scale are clamped.
+void Int8Quantize(int64_t n, const float* x, float scale, int8_t* q);
+
+namespace int8_gemm_util {
+
+constexpr int64_t kRowTile = 16;
+constexpr int64_t kColTile = 64;
+
+// acc[i * kColTile + j] = sum_p a[i * k + p] * b[j * k + p] for i < row_cnt and j < col_cnt, where
+// col_cnt is a multiple of 4. The operands are int8 values widened to int16, which lets the
+// products be summed pairwise by the multiply-add instructions.
+void GemmTile(int64_t row_cnt, int64_t col_cnt, int64_t k, const int16_t* a, const int16_t* b,
+              int32_t* acc);
+
+inline void Widen(int64_t n, const int8_t* x, int16_t* y) {
+  FOR_RANGE(int64_t, i, 0, n) { y[i] = x[i]; }
+}
+
+}  // namespace int8_gemm_util
+
+// c = a * b(T) with int32 accumulation, a is [m, k] and b is [n, k], both row major. The result is
+// produced tile by tile: epilogue(row_begin, row_cnt, col_begin, col_cnt, acc) gets each tile as
+// int32 rows of int8_gemm_util::kColTile elements, so requantization runs while the tile is in
+// cache. Single threaded, callers split the rows of a.
+template<typename EpilogueFn>
+void Int8GemmNT(int64_t m, int64_t n, int64_t k, const int8_t* a, const int8_t* b,
+                const EpilogueFn& epilogue) {
+  using namespace int8_gemm_util;
+  // the b panel is padded with zero rows to a multiple of 4 columns
+  std::vector<int16_t> b_panel(kColTile * k, 0);
+  std::vector<int16_t> a_tile(kRowTile * k);
+  int32_t acc[kRowTile * kColTile];
+  for (int64_t col_begin = 0; col_begin < n; col_begin += kColTile) {
+    const int64_t col_cnt = std::min(kColTile, n - col_begin);
+    const int64_t padded_col_cnt = RoundUp(col_cnt, 4);
+    Widen(col_cnt * k, b + col_begin * k, b_panel.data());
+    std::fill(b_panel.begin() + col_cnt * k, b_panel.begin() + padded_col_cnt * k, 0);
+    for (int64_t row_begin = 0; row_begin < m; row_begin += kRowTile) {
+      const int64_t row_cnt = std::min(kRowTile, m - row_begin);
+      Widen(row_cnt * k, a + row_begin * k, a_tile.data());
+      GemmTile(row_cnt, padded_col_cnt, k, a_tile.data(), b_panel.data(), acc);
+      epilogue(row_begin, row_cnt, col_begin, col_cnt, acc);
+    }
+  }
+}
+
+// The epilogue of the int8 kernels: out[row * row_stride + col * col_stride] =
+// acc * scale[col] + bias[col], followed by relu when fuse_relu. scale is the product of the
+// activation scale and the per output channel weight scale, bias may be nullptr.
+struct Int8DequantizeEpilogue {
+  const float* scale;
+  const float* bias;
+  bool fuse_relu;
+  float* out;
+  int64_t row_stride;
+  int64_t col_stride;
+
+  void operator()(int64_t row_begin, int64_t row_cnt, int64_t col_begin, int64_t col_cnt,
+                  const int32_t* acc) const {
+    FOR_RANGE(int64_t, i, 0, row_cnt) {
+      float* out_row = out + (row_begin + i) * row_stride + col_begin * col_stride;
+      const int32_t* acc_row = acc + i * int8_gemm_util::kColTile;
+      FOR_RANGE(int64_t, j, 0, col_cnt) {
+        float y = static_cast<float>(acc_row[j]) * scale[col_begin + j];
+        if (bias != nullptr) { y += bias[col_begin + j]; }
+        if (fuse_relu) { y = std::max(y, 0.0f); }
+        out_row[j * col_stride] = y;
+      }
+    }
+  }
+};
+
+}  // namespace oneflow
+
+#endif  // ONEFLOW_USER_KERNELS_INT8_GEMM_UTIL_H_
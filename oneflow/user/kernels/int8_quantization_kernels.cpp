@@ -0,0 +1,312 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include "oneflow/core/framework/framework.h"
+#include "oneflow/core/thread/thread_manager.h"
+#include "oneflow/user/kernels/conv_cpu_kernel_util.h"
+#include "oneflow/user/kernels/int8_gemm_util.h"
+
+namespace oneflow {
+
+namespace {
+
+// multiply-adds per task of the threaded gemm
+constexpr int64_t kInt8GemmGrainMacs = 1 << 20;
+
+// Splits the rows of a among the threads, or the columns of b when a has too few rows to keep
+// them busy, which is the case of the small batches of online inference.
+void ParallelInt8GemmNT(int64_t m, int64_t n, int64_t k, const int8_t* a, const int8_t* b,
+                        const Int8DequantizeEpilogue& epilogue) {
+  using int8_gemm_util::kColTile;
+  using int8_gemm_util::kRowTile;
+  const int64_t row_grain = std::max<int64_t>(kInt8GemmGrainMacs / std::max<int64_t>(n * k, 1), 1);
+  if (m > row_grain || n <= kColTile) {
+    MultiThreadLoopInRange(m, RoundUp(row_grain, kRowTile), [&](int64_t begin, int64_t end) {
+      Int8DequantizeEpilogue part = epilogue;
+      part.out += begin * epilogue.row_stride;
+      Int8GemmNT(end - begin, n, k, a + begin * k, b, part);
+    });
+  } else {
+    const int64_t col_tile_num = RoundUp(n, kColTile) / kColTile;
+    MultiThreadLoopInRange(col_tile_num, 1, [&](int64_t begin, int64_t end) {
+      const int64_t col_begin = begin * kColTile;
+      const int64_t col_end = std::min(end * kColTile, n);
+      Int8DequantizeEpilogue part = epilogue;
+      part.scale += col_begin;
+      if (part.bias != nullptr) { part.bias += col_begin; }
+      part.out += col_begin * epilogue.col_stride;
+      Int8GemmNT(m, col_end - col_begin, k, a, b + col_begin * k, part);
+    });
+  }
+}
+
+// The weight quantized per output channel by the kernel of the int8 op. A model load or a train
+// job of the session rewrites a variable in place, and the weight may also be computed, so every
+// Compute quantizes it again into these buffers.
+struct Int8WeightKernelState final : public user_op::OpKernelState {
+  std::vector<int8_t> weight;
+  std::vector<float> scale;
+};
+
+void QuantizeWeight(const user_op::Tensor* weight, Int8WeightKernelState* state) {
+  const int64_t num_channels = weight->shape().At(0);
+  const int64_t channel_size = weight->shape().Count(1);
+  state->weight.resize(num_channels * channel_size);
+  state->scale.resize(num_channels);
+  const auto QuantizeChannels = [&](int64_t begin, int64_t end) {
+    FOR_RANGE(int64_t, i, begin, end) {
+      const float* w = weight->dptr<float>() + i * channel_size;
+      const float channel_scale = Int8ScaleOf(channel_size, w);
+      Int8Quantize(channel_size, w, channel_scale, state->weight.data() + i * channel_size);
+      state->scale.at(i) = channel_scale;
+    }
+  };
+  // large channels are threaded inside, small ones are threaded over
+  if (channel_size > kCpuParallelGrainSize) {
+    QuantizeChannels(0, num_channels);
+  } else {
+    const int64_t grain = kCpuParallelGrainSize / std::max<int64_t>(channel_size, 1);
+    MultiThreadLoopInRange(num_channels, grain, QuantizeChannels);
+  }
+}
+
+// The scale of the input x, from the calibrated absmax when it is given and has been recorded
+float InputScale(const user_op::Tensor* absmax, const user_op::Tensor* x) {
+  if (absmax != nullptr && *absmax->dptr<float>() > 0) {
+    return Int8ScaleOfMaxAbs(*absmax->dptr<float>());
+  }
+  return Int8ScaleOf(x->shape().elem_cnt(), x->dptr<float>());
+}
+
+// scale[i] = in_scale * weight_scale[i]
+void MulScale(int64_t n, float in_scale, const float* weight_scale, float* scale) {
+  FOR_RANGE(int64_t, i, 0, n) { scale[i] = in_scale * weight_scale[i]; }
+}
+
+ConvCpuGeometry GenInt8Conv2dGeometry(user_op::KernelComputeContext* ctx, const Shape& in_shape,
+                                      const Shape& out_shape) {
+  ConvCpuGeometry geo;
+  geo.channels_first = ctx->Attr<std::string>("data_format") == "channels_first";
+  const int64_t c_dim = geo.channels_first ? 1 : 3;
+  const int64_t idx_offset = geo.channels_first ? 2 : 1;
+  geo.batch_num = in_shape.At(0);
+  geo.in_channel = in_shape.At(c_dim);
+  geo.out_channel = out_shape.At(c_dim);
+  geo.in[0] = 1;
+  geo.out[0] = 1;
+  geo.kernel[0] = 1;
+  geo.strides[0] = 1;
+  geo.dilation_rate[0] = 1;
+  geo.padding_before[0] = 0;
+  FOR_RANGE(int32_t, i, 0, 2) {
+    geo.in[i + 1] = in_shape.At(idx_offset + i);
+    geo.out[i + 1] = out_shape.At(idx_offset + i);
+    geo.kernel[i + 1] = ctx->Attr<std::vector<int32_t>>("kernel_size").at(i);
+    geo.strides[i + 1] = ctx->Attr<std::vector<int32_t>>("strides").at(i);
+    geo.dilation_rate[i + 1] = ctx->Attr<std::vector<int32_t>>("dilation_rate").at(i);
+    geo.padding_before[i + 1] = ctx->Attr<std::vector<int32_t>>("padding_before").at(i);
+  }
+  return geo;
+}
+
+// The transposed im2col of a quantized image: col is [out_h * out_w, K] in the element order of a
+// weight row, (kh, kw, c) for channels last and (c, kh, kw) for channels first. Padding is 0,
+// which is exact for the symmetric quantization.
+void Int8Im2ColT(const ConvCpuGeometry& geo, const int8_t* img, int8_t* col) {
+  const int64_t in_h = geo.in[1];
+  const int64_t in_w = geo.in[2];
+  const int64_t out_w = geo.out[2];
+  const int64_t kernel_h = geo.kernel[1];
+  const int64_t kernel_w = geo.kernel[2];
+  const int64_t c = geo.in_channel;
+  const int64_t col_row_size = c * kernel_h * kernel_w;
+  const int64_t row_num = geo.out[1] * out_w;
+  MultiThreadLoopInRange(
+      row_num, std::max<int64_t>(kCpuParallelGrainSize / col_row_size, 1),
+      [&](int64_t begin, int64_t end) {
+        FOR_RANGE(int64_t, row, begin, end) {
+          const int64_t oh = row / out_w;
+          const int64_t ow = row % out_w;
+          int8_t* col_row = col + row * col_row_size;
+          FOR_RANGE(int64_t, kh, 0, kernel_h) {
+            const int64_t ih = oh * geo.strides[1] + kh * geo.dilation_rate[1]
+                               - geo.padding_before[1];
+            FOR_RANGE(int64_t, kw, 0, kernel_w) {
+              const int64_t iw = ow * geo.strides[2] + kw * geo.dilation_rate[2]
+                                 - geo.padding_before[2];
+              const bool is_valid = ih >= 0 && ih < in_h && iw >= 0 && iw < in_w;
+              if (geo.channels_first) {
+                int8_t* dst = col_row + kh * kernel_w + kw;
+                FOR_RANGE(int64_t, ic, 0, c) {
+                  dst[ic * kernel_h * kernel_w] =
+                      is_valid ? img[(ic * in_h + ih) * in_w + iw] : static_cast<int8_t>(0);
+                }
+              } else {
+                int8_t* dst = col_row + (kh * kernel_w + kw) * c;
+                if (is_valid) {
+                  std::memcpy(dst, img + (ih * in_w + iw) * c, c);
+                } else {
+                  std::memset(dst, 0, c);
+                }
+              }
+            }
+          }
+        }
+      });
+}
+
+}  // namespace
+
+class Int8CalibrateAbsMaxCpuKernel final : public user_op::OpKernel {
+ public:
+  Int8CalibrateAbsMaxCpuKernel() = default;
+  ~Int8CalibrateAbsMaxCpuKernel() = default;
+
+  bool AlwaysComputeWhenAllOutputsEmpty() const override { return true; }
+
+ private:
+  void Compute(user_op::KernelComputeContext* ctx) const override {
+    const user_op::Tensor* in = ctx->Tensor4ArgNameAndIndex("in", 0);
+    user_op::Tensor* absmax = ctx->Tensor4ArgNameAndIndex("absmax", 0);
+    float* absmax_ptr = absmax->mut_dptr<float>();
+    *absmax_ptr = std::max(*absmax_ptr, Int8MaxAbsOf(in->shape().elem_cnt(), in->dptr<float>()));
+  }
+};
+
+REGISTER_USER_KERNEL("int8_calibrate_absmax")
+    .SetCreateFn<Int8CalibrateAbsMaxCpuKernel>()
+    .SetIsMatchedHob((user_op::HobDeviceTag() == "cpu")
+                     & (user_op::HobDataType("in", 0) == DataType::kFloat));
+
+class Int8MatmulCpuKernel final : public user_op::OpKernel {
+ public:
+  Int8MatmulCpuKernel() = default;
+  ~Int8MatmulCpuKernel() = default;
+
+  bool AlwaysComputeWhenAllOutputsEmpty() const override { return false; }
+
+  std::shared_ptr<user_op::OpKernelState> CreateOpKernelState(
+      user_op::KernelInitContext* ctx) const override {
+    return std::make_shared<Int8WeightKernelState>();
+  }
+
+ private:
+  void Compute(user_op::KernelComputeContext* ctx, user_op::OpKernelState* state) const override {
+    const user_op::Tensor* a = ctx->Tensor4ArgNameAndIndex("a", 0);
+    const user_op::Tensor* b = ctx->Tensor4ArgNameAndIndex("b", 0);
+    const user_op::Tensor* bias = ctx->Tensor4ArgNameAndIndex("bias", 0);
+    const user_op::Tensor* a_absmax = ctx->Tensor4ArgNameAndIndex("a_absmax", 0);
+    user_op::Tensor* out = ctx->Tensor4ArgNameAndIndex("out", 0);
+    user_op::Tensor* tmp_buffer = ctx->Tensor4ArgNameAndIndex("tmp_buffer", 0);
+    const int64_t m = a->shape().At(0);
+    const int64_t k = a->shape().At(1);
+    const int64_t n = b->shape().At(0);
+
+    auto* weight_state = dynamic_cast<Int8WeightKernelState*>(state);
+    CHECK_NOTNULL(weight_state);
+    QuantizeWeight(b, weight_state);
+    float* scale = tmp_buffer->mut_dptr<float>();
+    int8_t* a_int8 = reinterpret_cast<int8_t*>(scale + n);
+    const float a_scale = InputScale(a_absmax, a);
+    Int8Quantize(m * k, a->dptr<float>(), a_scale, a_int8);
+    MulScale(n, a_scale, weight_state->scale.data(), scale);
+    const Int8DequantizeEpilogue epilogue{scale,
+                                          bias == nullptr ? nullptr : bias->dptr<float>(),
+                                          ctx->Attr<bool>("fuse_relu"),
+                                          out->mut_dptr<float>(),
+                                          n,
+                                          1};
+    ParallelInt8GemmNT(m, n, k, a_int8, weight_state->weight.data(), epilogue);
+  }
+};
+
+REGISTER_USER_KERNEL("int8_matmul")
+    .SetCreateFn<Int8MatmulCpuKernel>()
+    .SetIsMatchedHob((user_op::HobDeviceTag() == "cpu")
+                     & (user_op::HobDataType("a", 0) == DataType::kFloat))
+    .SetInferTmpSizeFn([](user_op::InferContext* ctx) -> size_t {
+      return ctx->TensorDesc4ArgNameAndIndex("b", 0)->shape().At(0) * sizeof(float)
+             + ctx->TensorDesc4ArgNameAndIndex("a", 0)->shape().elem_cnt() * sizeof(int8_t);
+    });
+
+// Per image, one int8 gemm of the transposed im2col buffer [out_h * out_w, K] and the weight
+// [out_channel, K]. The tile epilogue writes channels last images row by row and channels first
+// images column by column.
+class Int8Conv2dCpuKernel final : public user_op::OpKernel {
+ public:
+  Int8Conv2dCpuKernel() = default;
+  ~Int8Conv2dCpuKernel() = default;
+
+  bool AlwaysComputeWhenAllOutputsEmpty() const override { return false; }
+
+  std::shared_ptr<user_op::OpKernelState> CreateOpKernelState(
+      user_op::KernelInitContext* ctx) const override {
+    return std::make_shared<Int8WeightKernelState>();
+  }
+
+ private:
+  void Compute(user_op::KernelComputeContext* ctx, user_op::OpKernelState* state) const override {
+    const user_op::Tensor* in = ctx->Tensor4ArgNameAndIndex("in", 0);
+    const user_op::Tensor* weight = ctx->Tensor4ArgNameAndIndex("weight", 0);
+    const user_op::Tensor* bias = ctx->Tensor4ArgNameAndIndex("bias", 0);
+    const user_op::Tensor* in_absmax = ctx->Tensor4ArgNameAndIndex("in_absmax", 0);
+    user_op::Tensor* out = ctx->Tensor4ArgNameAndIndex("out", 0);
+    user_op::Tensor* tmp_buffer = ctx->Tensor4ArgNameAndIndex("tmp_buffer", 0);
+    const ConvCpuGeometry geo = GenInt8Conv2dGeometry(ctx, in->shape(), out->shape());
+    const int64_t out_channel = geo.out_channel;
+    const int64_t spatial_size = geo.out[1] * geo.out[2];
+    const int64_t col_row_size = geo.in_channel * geo.kernel_volume();
+
+    auto* weight_state = dynamic_cast<Int8WeightKernelState*>(state);
+    CHECK_NOTNULL(weight_state);
+    QuantizeWeight(weight, weight_state);
+    float* scale = tmp_buffer->mut_dptr<float>();
+    int8_t* in_int8 = reinterpret_cast<int8_t*>(scale + out_channel);
+    int8_t* col = in_int8 + in->shape().elem_cnt();
+    const float in_scale = InputScale(in_absmax, in);
+    Int8Quantize(in->shape().elem_cnt(), in->dptr<float>(), in_scale, in_int8);
+    MulScale(out_channel, in_scale, weight_state->scale.data(), scale);
+    // a channels last image already is the transposed im2col buffer of a pointwise conv
+    const bool is_col_img = !geo.channels_first && geo.IsPointwise();
+    FOR_RANGE(int64_t, i, 0, geo.batch_num) {
+      const int8_t* img = in_int8 + i * geo.in_img_elem_cnt();
+      if (!is_col_img) { Int8Im2ColT(geo, img, col); }
+      const Int8DequantizeEpilogue epilogue{
+          scale,
+          bias == nullptr ? nullptr : bias->dptr<float>(),
+          ctx->Attr<bool>("fuse_relu"),
+          out->mut_dptr<float>() + i * geo.out_img_elem_cnt(),
+          geo.channels_first ? 1 : out_channel,
+          geo.channels_first ? spatial_size : 1};
+      ParallelInt8GemmNT(spatial_size, out_channel, col_row_size, is_col_img ? img : col,
+                         weight_state->weight.data(), epilogue);
+    }
+  }
+};
+
+REGISTER_USER_KERNEL("int8_conv2d")
+    .SetCreateFn<Int8Conv2dCpuKernel>()
+    .SetIsMatchedHob((user_op::HobDeviceTag() == "cpu")
+                     & (user_op::HobDataType("in", 0) == DataType::kFloat))
+    .SetInferTmpSizeFn([](user_op::InferContext* ctx) -> size_t {
+      const Shape& weight_shape = ctx->TensorDesc4ArgNameAndIndex("weight", 0)->shape();
+      const Shape& out_shape = ctx->TensorDesc4ArgNameAndIndex("out", 0)->shape();
+      const int64_t spatial_size = out_shape.Count(1) / weight_shape.At(0);
+      return weight_shape.At(0) * sizeof(float)
+             + ctx->TensorDesc4ArgNameAndIndex("in", 0)->shape().elem_cnt() * sizeof(int8_t)
+             + spatial_size * weight_shape.Count(1) * sizeof(int8_t);
+    });
+
+}  // namespace oneflow
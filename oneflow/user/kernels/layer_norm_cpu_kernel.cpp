@@ -14,9 +14,189 @@ See the License for the specific language governing permissions and
 limitations under the License.
 */
 #include "oneflow/core/framework/framework.h"
+#include "oneflow/core/common/balanced_splitter.h"
+#include "oneflow/core/thread/thread_manager.h"
+#include "oneflow/user/kernels/welford_util.h"
 
 namespace oneflow {
 
+namespace {
+
+// sums keep this many independent partial results so that their loops vectorize
+constexpr int64_t kLaneNum = kWelfordLaneNum;
+
+int64_t RowGrain(int64_t row_size) {
+  return std::max<int64_t>(kCpuParallelGrainSize / std::max<int64_t>(row_size, 1), 1);
+}
+
+// calls fn(elem_offset, param_offset, len) on the pieces of a row within which the broadcast
+// params are contiguous
+template<typename Fn>
+void ForEachParamPiece(int64_t row_id, int64_t row_size, int64_t param_size, const Fn& fn) {
+  int64_t param_offset = (row_id * row_size) % param_size;
+  int64_t offset = 0;
+  while (offset < row_size) {
+    const int64_t len = std::min(row_size - offset, param_size - param_offset);
+    fn(offset, param_offset, len);
+    offset += len;
+    param_offset = 0;
+  }
+}
+
+template<typename T, bool scale, bool center>
+void LayerNormForward(const T* x, const T* gamma, const T* beta, int64_t num_instances,
+                      int64_t norm_size, int64_t param_size, double epsilon, T* mean,
+                      T* inv_variance, T* normalized, T* y) {
+  MultiThreadLoopInRange(num_instances, RowGrain(norm_size), [&](int64_t begin, int64_t end) {
+    FOR_RANGE(int64_t, i, begin, end) {
+      const T* x_i = x + i * norm_size;
+      WelfordState<T> state;
+      WelfordUpdate(x_i, norm_size, &state);
+      mean[i] = state.mean;
+      inv_variance[i] =
+          static_cast<T>(1) / std::sqrt(state.m2 / state.count + static_cast<T>(epsilon));
+      const T row_mean = mean[i];
+      const T row_inv_variance = inv_variance[i];
+      T* normalized_i = normalized + i * norm_size;
+      T* y_i = y + i * norm_size;
+      ForEachParamPiece(i, norm_size, param_size, [&](int64_t offset, int64_t param_offset,
+                                                       int64_t len) {
+        const T* x_p = x_i + offset;
+        const T* gamma_p = gamma + param_offset;
+        const T* beta_p = beta + param_offset;
+        T* normalized_p = normalized_i + offset;
+        T* y_p = y_i + offset;
+        for (int64_t j = 0; j < len; ++j) {
+          const T normalized_val = (x_p[j] - row_mean) * row_inv_variance;
+          T y_val = normalized_val;
+          if (scale) {
+            normalized_p[j] = normalized_val;
+            y_val *= gamma_p[j];
+          }
+          if (center) { y_val += beta_p[j]; }
+          y_p[j] = y_val;
+        }
+      });
+    }
+  });
+}
+
+template<typename T>
+void LayerNormBackward(const T* dy, const T* x, const T* mean, const T* inv_variance,
+                       int64_t num_instances, int64_t norm_size, T* dx) {
+  MultiThreadLoopInRange(num_instances, RowGrain(norm_size), [&](int64_t begin, int64_t end) {
+    FOR_RANGE(int64_t, i, begin, end) {
+      const T* dy_i = dy + i * norm_size;
+      const T* x_i = x + i * norm_size;
+      T* dx_i = dx + i * norm_size;
+      const T row_mean = mean[i];
+      const T row_inv_variance = inv_variance[i];
+      T lane_sum_dy[kLaneNum] = {0};
+      T lane_sum_dy_x[kLaneNum] = {0};
+      const int64_t lane_end = norm_size / kLaneNum * kLaneNum;
+      for (int64_t j = 0; j < lane_end; j += kLaneNum) {
+        for (int64_t l = 0; l < kLaneNum; ++l) {
+          lane_sum_dy[l] += dy_i[j + l];
+          lane_sum_dy_x[l] += dy_i[j + l] * (x_i[j + l] - row_mean);
+        }
+      }
+      T sum_dy = 0;
+      T sum_dy_x = 0;
+      for (int64_t l = 0; l < kLaneNum; ++l) {
+        sum_dy += lane_sum_dy[l];
+        sum_dy_x += lane_sum_dy_x[l];
+      }
+      for (int64_t j = lane_end; j < norm_size; ++j) {
+        sum_dy += dy_i[j];
+        sum_dy_x += dy_i[j] * (x_i[j] - row_mean);
+      }
+      // dx = inv_variance * (dy - mean(dy) - normalized * mean(dy * normalized))
+      const T inv_n = static_cast<T>(1) / static_cast<T>(norm_size);
+      const T mean_dy = sum_dy * inv_n;
+      const T x_coeff = sum_dy_x * inv_n * row_inv_variance * row_inv_variance;
+      for (int64_t j = 0; j < norm_size; ++j) {
+        dx_i[j] = row_inv_variance * (dy_i[j] - mean_dy - (x_i[j] - row_mean) * x_coeff);
+      }
+    }
+  });
+}
+
+// beta_diff and gamma_diff are column sums over the n rows of dy and dy * normalized; they are
+// accumulated in one pass together with normalized_diff, which needs the same reads
+template<typename T>
+void LayerNormParamBackward(const T* dy, const T* normalized, const T* gamma, int64_t n, int64_t m,
+                            T* beta_diff, T* gamma_diff, T* normalized_diff, T* reduce_buf) {
+  const auto AccumulateRows = [&](int64_t row_begin, int64_t row_end, int64_t col_begin,
+                                  int64_t col_end, T* beta_sum, T* gamma_sum) {
+    const int64_t col_num = col_end - col_begin;
+    if (beta_sum != nullptr) { std::fill(beta_sum, beta_sum + col_num, static_cast<T>(0)); }
+    if (gamma_sum != nullptr) { std::fill(gamma_sum, gamma_sum + col_num, static_cast<T>(0)); }
+    FOR_RANGE(int64_t, i, row_begin, row_end) {
+      const int64_t offset = i * m + col_begin;
+      const T* dy_i = dy + offset;
+      if (beta_sum != nullptr) {
+        for (int64_t j = 0; j < col_num; ++j) { beta_sum[j] += dy_i[j]; }
+      }
+      if (gamma_sum != nullptr) {
+        const T* normalized_i = normalized + offset;
+        for (int64_t j = 0; j < col_num; ++j) { gamma_sum[j] += dy_i[j] * normalized_i[j]; }
+      }
+      if (normalized_diff != nullptr) {
+        T* normalized_diff_i = normalized_diff + offset;
+        if (gamma != nullptr) {
+          const T* gamma_p = gamma + col_begin;
+          for (int64_t j = 0; j < col_num; ++j) { normalized_diff_i[j] = dy_i[j] * gamma_p[j]; }
+        } else {
+          std::copy(dy_i, dy_i + col_num, normalized_diff_i);
+        }
+      }
+    }
+  };
+  const int64_t thread_num =
+      Global<ThreadPool>::Get() == nullptr ? 1 : Global<ThreadPool>::Get()->thread_num();
+  const int64_t sum_num = (beta_diff != nullptr ? 1 : 0) + (gamma_diff != nullptr ? 1 : 0);
+  // row blocks keep their partial sums in reduce_buf, which holds n * m elements
+  const int64_t block_num = sum_num == 0 ? 1 : std::min(thread_num, n / sum_num);
+  if (block_num <= 1 || m >= kCpuParallelGrainSize || reduce_buf == nullptr) {
+    MultiThreadLoopInRange(m, std::max<int64_t>(kCpuParallelGrainSize / n, 1),
+                           [&](int64_t begin, int64_t end) {
+                             AccumulateRows(0, n, begin, end,
+                                            beta_diff == nullptr ? nullptr : beta_diff + begin,
+                                            gamma_diff == nullptr ? nullptr : gamma_diff + begin);
+                           });
+    return;
+  }
+  T* beta_partial = beta_diff == nullptr ? nullptr : reduce_buf;
+  T* gamma_partial =
+      gamma_diff == nullptr ? nullptr : reduce_buf + (beta_diff == nullptr ? 0 : block_num * m);
+  const BalancedSplitter bs(n, block_num);
+  MultiThreadLoopInRange(block_num, 1, [&](int64_t begin, int64_t end) {
+    FOR_RANGE(int64_t, b, begin, end) {
+      AccumulateRows(bs.At(b).begin(), bs.At(b).end(), 0, m,
+                     beta_partial == nullptr ? nullptr : beta_partial + b * m,
+                     gamma_partial == nullptr ? nullptr : gamma_partial + b * m);
+    }
+  });
+  const auto SumBlocks = [&](const T* partial, T* sum, int64_t begin, int64_t end) {
+    std::copy(partial + begin, partial + end, sum + begin);
+    FOR_RANGE(int64_t, b, 1, block_num) {
+      const T* partial_b = partial + b * m;
+      for (int64_t j = begin; j < end; ++j) { sum[j] += partial_b[j]; }
+    }
+  };
+  MultiThreadLoopInRange(m, std::max<int64_t>(kCpuParallelGrainSize / block_num, 1),
+                         [&](int64_t begin, int64_t end) {
+                           if (beta_diff != nullptr) {
+                             SumBlocks(beta_partial, beta_diff, begin, end);
+                           }
+                           if (gamma_diff != nullptr) {
+                             SumBlocks(gamma_partial, gamma_diff, begin, end);
+                           }
+                         });
+}
+
+}  // namespace
+
 template<typename T>
 class LayerNormCpuKernel final : public user_op::OpKernel {
  public:
@@ -25,7 +205,46 @@ class LayerNormCpuKernel final : public user_op::OpKernel {
 
  private:
   bool AlwaysComputeWhenAllOutputsEmpty() const override { return false; }
-  void Compute(user_op::KernelComputeContext* ctx) const override { TODO(); };
+  void Compute(user_op::KernelComputeContext* ctx) const override {
+    const user_op::Tensor* x = ctx->Tensor4ArgNameAndIndex("x", 0);
+    user_op::Tensor* y = ctx->Tensor4ArgNameAndIndex("y", 0);
+    user_op::Tensor* mean = ctx->Tensor4ArgNameAndIndex("mean", 0);
+    user_op::Tensor* inv_variance = ctx->Tensor4ArgNameAndIndex("inv_variance", 0);
+    const bool scale = ctx->Attr<bool>("scale");
+    const bool center = ctx->Attr<bool>("center");
+    user_op::Tensor* normalized = scale ? ctx->Tensor4ArgNameAndIndex("normalized", 0) : y;
+    const user_op::Tensor* gamma = scale ? ctx->Tensor4ArgNameAndIndex("gamma", 0) : nullptr;
+    const user_op::Tensor* beta = center ? ctx->Tensor4ArgNameAndIndex("beta", 0) : nullptr;
+    const double epsilon = ctx->Attr<double>("epsilon");
+    const int64_t num_instances = mean->shape().elem_cnt();
+    const int64_t elem_cnt = x->shape().elem_cnt();
+    if (num_instances == 0 || elem_cnt == 0) { return; }
+    CHECK_EQ(elem_cnt % num_instances, 0);
+    const int64_t norm_size = elem_cnt / num_instances;
+    int64_t param_size = 1;
+    if (scale) {
+      param_size = gamma->shape().elem_cnt();
+    } else if (center) {
+      param_size = beta->shape().elem_cnt();
+    }
+    CHECK_EQ(elem_cnt % param_size, 0);
+    const T* gamma_ptr = scale ? gamma->dptr<T>() : nullptr;
+    const T* beta_ptr = center ? beta->dptr<T>() : nullptr;
+#define LAYER_NORM_FORWARD(scale_val, center_val)                                                 \
+  LayerNormForward<T, scale_val, center_val>(                                                     \
+      x->dptr<T>(), gamma_ptr, beta_ptr, num_instances, norm_size, param_size, epsilon,           \
+      mean->mut_dptr<T>(), inv_variance->mut_dptr<T>(), normalized->mut_dptr<T>(), y->mut_dptr<T>())
+    if (scale && center) {
+      LAYER_NORM_FORWARD(true, true);
+    } else if (scale) {
+      LAYER_NORM_FORWARD(true, false);
+    } else if (center) {
+      LAYER_NORM_FORWARD(false, true);
+    } else {
+      LAYER_NORM_FORWARD(false, false);
+    }
+#undef LAYER_NORM_FORWARD
+  };
 };
 
 #define REGISTER_LAYER_NORM_CPU_KERNEL(dtype)             \
@@ -45,7 +264,19 @@ class LayerNormGradCpuKernel final : public user_op::OpKernel {
 
  private:
   bool AlwaysComputeWhenAllOutputsEmpty() const override { return false; }
-  void Compute(user_op::KernelComputeContext* ctx) const override { TODO(); };
+  void Compute(user_op::KernelComputeContext* ctx) const override {
+    const user_op::Tensor* dy = ctx->Tensor4ArgNameAndIndex("dy", 0);
+    const user_op::Tensor* x = ctx->Tensor4ArgNameAndIndex("x", 0);
+    const user_op::Tensor* mean = ctx->Tensor4ArgNameAndIndex("mean", 0);
+    const user_op::Tensor* inv_variance = ctx->Tensor4ArgNameAndIndex("inv_variance", 0);
+    user_op::Tensor* dx = ctx->Tensor4ArgNameAndIndex("dx", 0);
+    const int64_t num_instances = mean->shape().elem_cnt();
+    const int64_t elem_cnt = x->shape().elem_cnt();
+    if (num_instances == 0 || elem_cnt == 0) { return; }
+    CHECK_EQ(elem_cnt % num_instances, 0);
+    LayerNormBackward<T>(dy->dptr<T>(), x->dptr<T>(), mean->dptr<T>(), inv_variance->dptr<T>(),
+                         num_instances, elem_cnt / num_instances, dx->mut_dptr<T>());
+  };
 };
 
 #define REGISTER_LAYER_NORM_GRAD_CPU_KERNEL(dtype)        \
@@ -65,7 +296,40 @@ class LayerNormParamGradCpuKernel final : public user_op::OpKernel {
 
  private:
   bool AlwaysComputeWhenAllOutputsEmpty() const override { return false; }
-  void Compute(user_op::KernelComputeContext* ctx) const override { TODO(); };
+  void Compute(user_op::KernelComputeContext* ctx) const override {
+    const user_op::Tensor* dy = ctx->Tensor4ArgNameAndIndex("dy", 0);
+    user_op::Tensor* beta_diff = ctx->Tensor4ArgNameAndIndex("beta_diff", 0);
+    user_op::Tensor* gamma_diff = ctx->Tensor4ArgNameAndIndex("gamma_diff", 0);
+    user_op::Tensor* normalized_diff = ctx->Tensor4ArgNameAndIndex("normalized_diff", 0);
+    const user_op::Tensor* gamma = ctx->Tensor4ArgNameAndIndex("gamma", 0);
+    const user_op::Tensor* normalized = ctx->Tensor4ArgNameAndIndex("normalized", 0);
+    user_op::Tensor* reduce_buf = ctx->Tensor4ArgNameAndIndex("reduce_buf", 0);
+    int64_t m = 0;
+    if (beta_diff != nullptr) {
+      m = beta_diff->shape().elem_cnt();
+    } else if (gamma_diff != nullptr) {
+      m = gamma_diff->shape().elem_cnt();
+    } else if (gamma != nullptr) {
+      m = gamma->shape().elem_cnt();
+    } else {
+      // normalized_diff is a plain copy of dy
+      if (normalized_diff != nullptr) {
+        std::copy(dy->dptr<T>(), dy->dptr<T>() + dy->shape().elem_cnt(),
+                  normalized_diff->mut_dptr<T>());
+      }
+      return;
+    }
+    const int64_t elem_cnt = dy->shape().elem_cnt();
+    if (m == 0 || elem_cnt == 0) { return; }
+    CHECK_EQ(elem_cnt % m, 0);
+    LayerNormParamBackward<T>(
+        dy->dptr<T>(), gamma_diff == nullptr ? nullptr : normalized->dptr<T>(),
+        gamma == nullptr ? nullptr : gamma->dptr<T>(), elem_cnt / m, m,
+        beta_diff == nullptr ? nullptr : beta_diff->mut_dptr<T>(),
+        gamma_diff == nullptr ? nullptr : gamma_diff->mut_dptr<T>(),
+        normalized_diff == nullptr ? nullptr : normalized_diff->mut_dptr<T>(),
+        reduce_buf == nullptr ? nullptr : reduce_buf->mut_dptr<T>());
+  };
 };
 
 #define REGISTER_LAYER_NORM_PARAM_GRAD_CPU_KERNEL(dtype)  \
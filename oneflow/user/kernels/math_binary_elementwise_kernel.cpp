@@ -14,6 +14,7 @@ See the License for the specific language governing permissions and
 limitations under the License.
 */
 #include "oneflow/core/framework/framework.h"
+#include "oneflow/core/kernel/cpu_elementwise.h"
 #include "oneflow/user/kernels/math_binary_elementwise_func.h"
 
 namespace oneflow {
@@ -29,12 +30,11 @@ class MathBinaryElementwiseCpuKernel final : public user_op::OpKernel {
     const user_op::Tensor* tensor_x = ctx->Tensor4ArgNameAndIndex("x", 0);
     const user_op::Tensor* tensor_y = ctx->Tensor4ArgNameAndIndex("y", 0);
     user_op::Tensor* tensor_z = ctx->Tensor4ArgNameAndIndex("z", 0);
-    const T* x = tensor_x->dptr<T>();
-    const T* y = tensor_y->dptr<T>();
-    T* z = tensor_z->mut_dptr<T>();
-    int64_t n = tensor_x->shape().elem_cnt();
-    CHECK_LE(n, GetMaxVal<int32_t>() / 2);
-    for (int32_t i = 0; i < n; ++i) { z[i] = BinaryFunctor<T>::Forward(x[i], y[i]); }
+    using ComputeT = typename CpuComputeType<T>::type;
+    CpuElementwise(
+        tensor_x->shape().elem_cnt(),
+        [](ComputeT x, ComputeT y) { return BinaryFunctor<ComputeT>::Forward(x, y); },
+        tensor_z->mut_dptr<T>(), tensor_x->dptr<T>(), tensor_y->dptr<T>());
   }
   bool AlwaysComputeWhenAllOutputsEmpty() const override { return false; }
 };
@@ -51,14 +51,13 @@ class MathBinaryElementwiseXGradCpuKernel final : public user_op::OpKernel {
     const user_op::Tensor* tensor_y = ctx->Tensor4ArgNameAndIndex("y", 0);
     const user_op::Tensor* tensor_dz = ctx->Tensor4ArgNameAndIndex("dz", 0);
     user_op::Tensor* tensor_dx = ctx->Tensor4ArgNameAndIndex("dx", 0);
-
-    const T* x = tensor_x->dptr<T>();
-    const T* y = tensor_y->dptr<T>();
-    const T* dz = tensor_dz->dptr<T>();
-    T* dx = tensor_dx->mut_dptr<T>();
-    int64_t n = tensor_x->shape().elem_cnt();
-    CHECK_LE(n, GetMaxVal<int32_t>() / 2);
-    for (int32_t i = 0; i < n; ++i) { dx[i] = BinaryFunctor<T>::BackwardXGrad(x[i], y[i], dz[i]); }
+    using ComputeT = typename CpuComputeType<T>::type;
+    CpuElementwise(
+        tensor_x->shape().elem_cnt(),
+        [](ComputeT x, ComputeT y, ComputeT dz) {
+          return BinaryFunctor<ComputeT>::BackwardXGrad(x, y, dz);
+        },
+        tensor_dx->mut_dptr<T>(), tensor_x->dptr<T>(), tensor_y->dptr<T>(), tensor_dz->dptr<T>());
   }
   bool AlwaysComputeWhenAllOutputsEmpty() const override { return false; }
 };
@@ -75,14 +74,13 @@ class MathBinaryElementwiseYGradCpuKernel final : public user_op::OpKernel {
     const user_op::Tensor* tensor_y = ctx->Tensor4ArgNameAndIndex("y", 0);
     const user_op::Tensor* tensor_dz = ctx->Tensor4ArgNameAndIndex("dz", 0);
     user_op::Tensor* tensor_dy = ctx->Tensor4ArgNameAndIndex("dy", 0);
-
-    const T* x = tensor_x->dptr<T>();
-    const T* y = tensor_y->dptr<T>();
-    const T* dz = tensor_dz->dptr<T>();
-    T* dy = tensor_dy->mut_dptr<T>();
-    int64_t n = tensor_x->shape().elem_cnt();
-    CHECK_LE(n, GetMaxVal<int32_t>() / 2);
-    for (int32_t i = 0; i < n; ++i) { dy[i] = BinaryFunctor<T>::BackwardYGrad(x[i], y[i], dz[i]); }
+    using ComputeT = typename CpuComputeType<T>::type;
+    CpuElementwise(
+        tensor_x->shape().elem_cnt(),
+        [](ComputeT x, ComputeT y, ComputeT dz) {
+          return BinaryFunctor<ComputeT>::BackwardYGrad(x, y, dz);
+        },
+        tensor_dy->mut_dptr<T>(), tensor_x->dptr<T>(), tensor_y->dptr<T>(), tensor_dz->dptr<T>());
   }
   bool AlwaysComputeWhenAllOutputsEmpty() const override { return false; }
 };
@@ -109,6 +107,7 @@ class MathBinaryElementwiseYGradCpuKernel final : public user_op::OpKernel {
                        & (user_op::HobDataType("x", 0) == OF_PP_PAIR_SECOND(data_type_pair)));
 
 OF_PP_SEQ_PRODUCT_FOR_EACH_TUPLE(REGISTER_MATH_BINARY_ELEMENTWISE_CPU_KERNEL_AND_GRAD,
-                                 MATH_BINARY_ELEMENTWISE_FUNC_SEQ, FLOATING_DATA_TYPE_SEQ)
+                                 MATH_BINARY_ELEMENTWISE_FUNC_SEQ,
+                                 FLOATING_DATA_TYPE_SEQ FLOAT16_DATA_TYPE_SEQ)
 
 }  // namespace oneflow
@@ -14,6 +14,7 @@ See the License for the specific language governing permissions and
 limitations under the License.
 */
 #include "oneflow/core/framework/framework.h"
+#include "oneflow/core/kernel/cpu_elementwise.h"
 #include "oneflow/user/kernels/math_unary_elementwise_func.h"
 
 namespace oneflow {
@@ -28,11 +29,10 @@ class MathUnaryElementwiseCpuKernel final : public user_op::OpKernel {
   void Compute(user_op::KernelComputeContext* ctx) const override {
     const user_op::Tensor* tensor_x = ctx->Tensor4ArgNameAndIndex("x", 0);
     user_op::Tensor* tensor_y = ctx->Tensor4ArgNameAndIndex("y", 0);
-    const T* x = tensor_x->dptr<T>();
-    T* y = tensor_y->mut_dptr<T>();
-    int64_t n = tensor_x->shape().elem_cnt();
-    CHECK_LE(n, GetMaxVal<int32_t>() / 2);
-    for (int32_t i = 0; i < n; ++i) { y[i] = UnaryFunctor<T>::Forward(x[i]); }
+    using ComputeT = typename CpuComputeType<T>::type;
+    CpuElementwise(
+        tensor_x->shape().elem_cnt(), [](ComputeT x) { return UnaryFunctor<ComputeT>::Forward(x); },
+        tensor_y->mut_dptr<T>(), tensor_x->dptr<T>());
   }
   bool AlwaysComputeWhenAllOutputsEmpty() const override { return false; }
 };
@@ -48,13 +48,11 @@ class MathUnaryElementwiseGradCpuKernel final : public user_op::OpKernel {
     const user_op::Tensor* tensor_x = ctx->Tensor4ArgNameAndIndex("x", 0);
     const user_op::Tensor* tensor_dy = ctx->Tensor4ArgNameAndIndex("dy", 0);
     user_op::Tensor* tensor_dx = ctx->Tensor4ArgNameAndIndex("dx", 0);
-
-    const T* x = tensor_x->dptr<T>();
-    const T* dy = tensor_dy->dptr<T>();
-    T* dx = tensor_dx->mut_dptr<T>();
-    int64_t n = tensor_x->shape().elem_cnt();
-    CHECK_LE(n, GetMaxVal<int32_t>() / 2);
-    for (int32_t i = 0; i < n; ++i) { dx[i] = UnaryFunctor<T>::Backward(x[i], dy[i]); }
+    using ComputeT = typename CpuComputeType<T>::type;
+    CpuElementwise(
+        tensor_x->shape().elem_cnt(),
+        [](ComputeT x, ComputeT dy) { return UnaryFunctor<ComputeT>::Backward(x, dy); },
+        tensor_dx->mut_dptr<T>(), tensor_x->dptr<T>(), tensor_dy->dptr<T>());
   }
   bool AlwaysComputeWhenAllOutputsEmpty() const override { return false; }
 };
@@ -76,6 +74,7 @@ class MathUnaryElementwiseGradCpuKernel final : public user_op::OpKernel {
                        & (user_op::HobDataType("x", 0) == OF_PP_PAIR_SECOND(data_type_pair)));
 
 OF_PP_SEQ_PRODUCT_FOR_EACH_TUPLE(REGISTER_MATH_UNARY_ELEMENTWISE_CPU_KERNEL_AND_GRAD,
-                                 MATH_UNARY_ELEMENTWISE_FUNC_SEQ, FLOATING_DATA_TYPE_SEQ)
+                                 MATH_UNARY_ELEMENTWISE_FUNC_SEQ,
+                                 FLOATING_DATA_TYPE_SEQ FLOAT16_DATA_TYPE_SEQ)
 
 }  // namespace oneflow
@@ -31,6 +31,10 @@ std::tuple<int32_t, int32_t, int32_t> CalcMNK(const ShapeView& a_shape, const Sh
   return std::make_tuple(m, n, k);
 }
 
+size_t InferCpuHalfGemmTmpSize(user_op::InferContext* ctx) {
+  return NewKernelUtil<DeviceType::kCPU>::HGemmWithFloatBufElemCnt() * sizeof(float);
+}
+
 }  // namespace
 
 REGISTER_FUNCTION_CONFIG_DEF().Bool(
@@ -75,6 +79,39 @@ REGISTER_MATMUL_KERNEL(DeviceType::kGPU, float);
 REGISTER_MATMUL_KERNEL(DeviceType::kGPU, double);
 #endif
 
+// The cpu has no half arithmetic, so half matmul always accumulates in float.
+class MatmulCpuHalfKernel final : public user_op::OpKernel {
+ public:
+  MatmulCpuHalfKernel() = default;
+  ~MatmulCpuHalfKernel() = default;
+
+  bool AlwaysComputeWhenAllOutputsEmpty() const override { return false; }
+
+ private:
+  void Compute(user_op::KernelComputeContext* ctx) const override {
+    CBLAS_TRANSPOSE trans_a = ctx->Attr<bool>("transpose_a") ? CblasTrans : CblasNoTrans;
+    CBLAS_TRANSPOSE trans_b = ctx->Attr<bool>("transpose_b") ? CblasTrans : CblasNoTrans;
+    const user_op::Tensor* a = ctx->Tensor4ArgNameAndIndex("a", 0);
+    const user_op::Tensor* b = ctx->Tensor4ArgNameAndIndex("b", 0);
+    user_op::Tensor* out = ctx->Tensor4ArgNameAndIndex("out", 0);
+    CHECK_EQ(2, a->shape().NumAxes());
+
+    int32_t m = 0, n = 0, k = 0;
+    std::tie(m, n, k) = CalcMNK(a->shape(), out->shape(), trans_a);
+    user_op::Tensor* tmp_buffer = ctx->Tensor4ArgNameAndIndex("tmp_buffer", 0);
+    NewKernelUtil<DeviceType::kCPU>::OFHGemmWithFloat(
+        ctx->device_ctx(), trans_a, trans_b, m, n, k, GetOneVal<float>(), a->dptr<float16>(),
+        b->dptr<float16>(), GetZeroVal<float>(), out->mut_dptr<float16>(),
+        tmp_buffer->mut_dptr<float>());
+  }
+};
+
+REGISTER_USER_KERNEL("matmul")
+    .SetCreateFn<MatmulCpuHalfKernel>()
+    .SetIsMatchedHob((user_op::HobDeviceTag() == "cpu")
+                     & (user_op::HobDataType("a", 0) == DataType::kFloat16))
+    .SetInferTmpSizeFn(InferCpuHalfGemmTmpSize);
+
 #ifdef WITH_CUDA
 class MatmulGpuHalfKernel final : public user_op::OpKernel {
  public:
@@ -162,6 +199,41 @@ REGISTER_BATCH_MATMUL_KERNEL(DeviceType::kGPU, float);
 REGISTER_BATCH_MATMUL_KERNEL(DeviceType::kGPU, double);
 #endif
 
+class BatchMatmulCpuHalfKernel final : public user_op::OpKernel {
+ public:
+  BatchMatmulCpuHalfKernel() = default;
+  ~BatchMatmulCpuHalfKernel() = default;
+
+  bool AlwaysComputeWhenAllOutputsEmpty() const override { return false; }
+
+ private:
+  void Compute(user_op::KernelComputeContext* ctx) const override {
+    CBLAS_TRANSPOSE trans_a = ctx->Attr<bool>("transpose_a") ? CblasTrans : CblasNoTrans;
+    CBLAS_TRANSPOSE trans_b = ctx->Attr<bool>("transpose_b") ? CblasTrans : CblasNoTrans;
+    const user_op::Tensor* a = ctx->Tensor4ArgNameAndIndex("a", 0);
+    const user_op::Tensor* b = ctx->Tensor4ArgNameAndIndex("b", 0);
+    user_op::Tensor* out = ctx->Tensor4ArgNameAndIndex("out", 0);
+    int32_t num_axes = a->shape().NumAxes();
+    CHECK_GT(num_axes, 2);
+
+    int32_t m = 0, n = 0, k = 0;
+    std::tie(m, n, k) = CalcMNK(a->shape(), out->shape(), trans_a);
+
+    size_t batch_size = a->shape().Count(0, num_axes - 2);
+    user_op::Tensor* tmp_buffer = ctx->Tensor4ArgNameAndIndex("tmp_buffer", 0);
+    NewKernelUtil<DeviceType::kCPU>::OFBatchedHGemmWithFloat(
+        ctx->device_ctx(), trans_a, trans_b, batch_size, m, n, k, GetOneVal<float>(),
+        a->dptr<float16>(), b->dptr<float16>(), GetZeroVal<float>(), out->mut_dptr<float16>(),
+        tmp_buffer->mut_dptr<float>());
+  }
+};
+
+REGISTER_USER_KERNEL("batch_matmul")
+    .SetCreateFn<BatchMatmulCpuHalfKernel>()
+    .SetIsMatchedHob((user_op::HobDeviceTag() == "cpu")
+                     & (user_op::HobDataType("a", 0) == DataType::kFloat16))
+    .SetInferTmpSizeFn(InferCpuHalfGemmTmpSize);
+
 #ifdef WITH_CUDA
 class BatchMatmulGpuHalfKernel final : public user_op::OpKernel {
  public:
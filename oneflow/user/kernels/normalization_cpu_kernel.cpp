@@ -0,0 +1,402 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include "oneflow/core/framework/framework.h"
+#include "oneflow/core/common/balanced_splitter.h"
+#include "oneflow/core/thread/thread_manager.h"
+#include "oneflow/user/kernels/welford_util.h"
+
+namespace oneflow {
+
+namespace {
+
+// the batch is reduced in at most this many blocks, each keeping per channel partial results
+constexpr int64_t kBnCpuMaxBlockNum = 32;
+
+// x is viewed as [outer, channel, inner]; inner is 1 for NHWC
+struct BnCpuDims {
+  BnCpuDims(const ShapeView& x_shape, int32_t axis) {
+    CHECK_GE(axis, 0);
+    CHECK_LT(axis, x_shape.NumAxes());
+    outer = x_shape.Count(0, axis);
+    channel = x_shape.At(axis);
+    inner = x_shape.Count(axis + 1);
+  }
+  int64_t elem_cnt() const { return outer * channel * inner; }
+  int64_t outer;
+  int64_t channel;
+  int64_t inner;
+};
+
+size_t InferBnCpuTmpSize(const Shape& x_shape, int32_t axis, DataType data_type) {
+  return kBnCpuMaxBlockNum * 2 * x_shape.At(axis) * GetSizeOfDataType(data_type);
+}
+
+int64_t ReduceBlockNum(const BnCpuDims& dims) {
+  const int64_t thread_num =
+      Global<ThreadPool>::Get() == nullptr ? 1 : Global<ThreadPool>::Get()->thread_num();
+  return std::max<int64_t>(std::min({kBnCpuMaxBlockNum, thread_num, dims.outer}), 1);
+}
+
+int64_t ChannelGrain(const BnCpuDims& dims, int64_t outer_num) {
+  return std::max<int64_t>(kCpuParallelGrainSize / std::max<int64_t>(outer_num * dims.inner, 1), 1);
+}
+
+// The batch is split into blocks along outer and every block reduces its channels in parallel
+// too, into block_a[c] and block_b[c] of its own; Merge(c, block_a, block_b, block_outer_num) then
+// folds the blocks of a channel together.
+template<typename T, typename BlockFn, typename MergeFn>
+void ReduceChannels(const BnCpuDims& dims, T* tmp, const BlockFn& Block, const MergeFn& Merge) {
+  const int64_t block_num = ReduceBlockNum(dims);
+  const BalancedSplitter bs(dims.outer, block_num);
+  MultiThreadLoopInRange(block_num, 1, [&](int64_t block_begin, int64_t block_end) {
+    FOR_RANGE(int64_t, b, block_begin, block_end) {
+      const Range outer_range = bs.At(b);
+      T* block_a = tmp + b * 2 * dims.channel;
+      T* block_b = block_a + dims.channel;
+      MultiThreadLoopInRange(dims.channel, ChannelGrain(dims, outer_range.size()),
+                             [&](int64_t c_begin, int64_t c_end) {
+                               Block(outer_range, c_begin, c_end, block_a, block_b);
+                             });
+    }
+  });
+  MultiThreadLoopInRange(
+      dims.channel, std::max<int64_t>(kCpuParallelGrainSize / block_num, 1),
+      [&](int64_t c_begin, int64_t c_end) {
+        FOR_RANGE(int64_t, c, c_begin, c_end) {
+          FOR_RANGE(int64_t, b, 0, block_num) {
+            const T* block_a = tmp + b * 2 * dims.channel;
+            Merge(c, block_a[c], block_a[dims.channel + c], bs.At(b).size());
+          }
+        }
+      });
+}
+
+template<typename T>
+void ComputeMeanAndVariance(const BnCpuDims& dims, const T* x, T* tmp, T* mean, T* variance) {
+  std::vector<WelfordState<T>> states(dims.channel);
+  ReduceChannels<T>(
+      dims, tmp,
+      [&](const Range& outer_range, int64_t c_begin, int64_t c_end, T* block_mean, T* block_m2) {
+        if (dims.inner == 1) {
+          WelfordUpdateColumns(x + outer_range.begin() * dims.channel + c_begin,
+                               outer_range.size(), c_end - c_begin, dims.channel,
+                               block_mean + c_begin, block_m2 + c_begin);
+        } else {
+          FOR_RANGE(int64_t, c, c_begin, c_end) {
+            WelfordState<T> state;
+            FOR_RANGE(int64_t, n, outer_range.begin(), outer_range.end()) {
+              WelfordUpdate(x + (n * dims.channel + c) * dims.inner, dims.inner, &state);
+            }
+            block_mean[c] = state.mean;
+            block_m2[c] = state.m2;
+          }
+        }
+      },
+      [&](int64_t c, T block_mean, T block_m2, int64_t block_outer_num) {
+        states.at(c).Merge(block_mean, block_m2, static_cast<T>(block_outer_num * dims.inner));
+      });
+  FOR_RANGE(int64_t, c, 0, dims.channel) {
+    mean[c] = states.at(c).mean;
+    variance[c] = states.at(c).m2 / states.at(c).count;
+  }
+}
+
+// y = x * scale[c] + shift[c]
+template<typename T>
+void ScaleAndShift(const BnCpuDims& dims, const T* x, const T* scale, const T* shift, T* y) {
+  if (dims.inner == 1) {
+    MultiThreadLoopInRange(
+        dims.outer, std::max<int64_t>(kCpuParallelGrainSize / dims.channel, 1),
+        [&](int64_t begin, int64_t end) {
+          FOR_RANGE(int64_t, n, begin, end) {
+            const T* x_n = x + n * dims.channel;
+            T* y_n = y + n * dims.channel;
+            for (int64_t c = 0; c < dims.channel; ++c) { y_n[c] = x_n[c] * scale[c] + shift[c]; }
+          }
+        });
+  } else {
+    MultiThreadLoopInRange(dims.outer * dims.channel,
+                           std::max<int64_t>(kCpuParallelGrainSize / dims.inner, 1),
+                           [&](int64_t begin, int64_t end) {
+                             FOR_RANGE(int64_t, i, begin, end) {
+                               const T a = scale[i % dims.channel];
+                               const T b = shift[i % dims.channel];
+                               const T* x_i = x + i * dims.inner;
+                               T* y_i = y + i * dims.inner;
+                               for (int64_t j = 0; j < dims.inner; ++j) { y_i[j] = x_i[j] * a + b; }
+                             }
+                           });
+  }
+}
+
+template<typename T>
+void BnCpuForwardTraining(const BnCpuDims& dims, const T* x, const T* gamma, const T* beta,
+                          float epsilon, float momentum, T* tmp, T* moving_mean,
+                          T* moving_variance, T* mean, T* inv_variance, T* y) {
+  std::vector<T> variance(dims.channel);
+  ComputeMeanAndVariance(dims, x, tmp, mean, variance.data());
+  const int64_t reduce_cnt = dims.outer * dims.inner;
+  // the moving variance is unbiased, like cudnn's
+  const T unbias = reduce_cnt > 1 ? static_cast<T>(reduce_cnt) / (reduce_cnt - 1) : 1;
+  std::vector<T> scale(dims.channel);
+  std::vector<T> shift(dims.channel);
+  FOR_RANGE(int64_t, c, 0, dims.channel) {
+    inv_variance[c] = static_cast<T>(1) / std::sqrt(variance.at(c) + static_cast<T>(epsilon));
+    moving_mean[c] = moving_mean[c] * momentum + mean[c] * (1 - momentum);
+    moving_variance[c] = moving_variance[c] * momentum + variance.at(c) * unbias * (1 - momentum);
+    scale.at(c) = gamma[c] * inv_variance[c];
+    shift.at(c) = beta[c] - mean[c] * scale.at(c);
+  }
+  ScaleAndShift(dims, x, scale.data(), shift.data(), y);
+}
+
+template<typename T>
+void BnCpuForwardInference(const BnCpuDims& dims, const T* x, const T* gamma, const T* beta,
+                           const T* moving_mean, const T* moving_variance, float epsilon, T* y) {
+  std::vector<T> scale(dims.channel);
+  std::vector<T> shift(dims.channel);
+  FOR_RANGE(int64_t, c, 0, dims.channel) {
+    scale.at(c) = gamma[c] / std::sqrt(moving_variance[c] + static_cast<T>(epsilon));
+    shift.at(c) = beta[c] - moving_mean[c] * scale.at(c);
+  }
+  ScaleAndShift(dims, x, scale.data(), shift.data(), y);
+}
+
+// beta_diff = sum(dy), gamma_diff = sum(dy * normalized) and
+// dx = gamma * inv_variance * (dy - beta_diff / m - normalized * gamma_diff / m)
+template<typename T>
+void BnCpuBackward(const BnCpuDims& dims, const T* x, const T* dy, const T* gamma, const T* mean,
+                   const T* inv_variance, T* tmp, T* gamma_diff, T* beta_diff, T* dx) {
+  std::fill(beta_diff, beta_diff + dims.channel, static_cast<T>(0));
+  // sum(dy * (x - mean)) first, it is scaled by inv_variance below
+  std::fill(gamma_diff, gamma_diff + dims.channel, static_cast<T>(0));
+  ReduceChannels<T>(
+      dims, tmp,
+      [&](const Range& outer_range, int64_t c_begin, int64_t c_end, T* sum_dy, T* sum_dy_x) {
+        if (dims.inner == 1) {
+          std::fill(sum_dy + c_begin, sum_dy + c_end, static_cast<T>(0));
+          std::fill(sum_dy_x + c_begin, sum_dy_x + c_end, static_cast<T>(0));
+          FOR_RANGE(int64_t, n, outer_range.begin(), outer_range.end()) {
+            const T* x_n = x + n * dims.channel;
+            const T* dy_n = dy + n * dims.channel;
+            for (int64_t c = c_begin; c < c_end; ++c) {
+              sum_dy[c] += dy_n[c];
+              sum_dy_x[c] += dy_n[c] * (x_n[c] - mean[c]);
+            }
+          }
+        } else {
+          FOR_RANGE(int64_t, c, c_begin, c_end) {
+            T lane_sum_dy[kWelfordLaneNum] = {0};
+            T lane_sum_dy_x[kWelfordLaneNum] = {0};
+            T tail_sum_dy = 0;
+            T tail_sum_dy_x = 0;
+            const T mean_c = mean[c];
+            const int64_t lane_end = dims.inner / kWelfordLaneNum * kWelfordLaneNum;
+            FOR_RANGE(int64_t, n, outer_range.begin(), outer_range.end()) {
+              const T* x_i = x + (n * dims.channel + c) * dims.inner;
+              const T* dy_i = dy + (n * dims.channel + c) * dims.inner;
+              for (int64_t j = 0; j < lane_end; j += kWelfordLaneNum) {
+                for (int64_t l = 0; l < kWelfordLaneNum; ++l) {
+                  lane_sum_dy[l] += dy_i[j + l];
+                  lane_sum_dy_x[l] += dy_i[j + l] * (x_i[j + l] - mean_c);
+                }
+              }
+              for (int64_t j = lane_end; j < dims.inner; ++j) {
+                tail_sum_dy += dy_i[j];
+                tail_sum_dy_x += dy_i[j] * (x_i[j] - mean_c);
+              }
+            }
+            for (int64_t l = 0; l < kWelfordLaneNum; ++l) {
+              tail_sum_dy += lane_sum_dy[l];
+              tail_sum_dy_x += lane_sum_dy_x[l];
+            }
+            sum_dy[c] = tail_sum_dy;
+            sum_dy_x[c] = tail_sum_dy_x;
+          }
+        }
+      },
+      [&](int64_t c, T sum_dy, T sum_dy_x, int64_t) {
+        beta_diff[c] += sum_dy;
+        gamma_diff[c] += sum_dy_x;
+      });
+  const T inv_m = static_cast<T>(1) / static_cast<T>(dims.outer * dims.inner);
+  // dx = dy * scale[c] + x * x_coeff[c] + shift[c], one fused pass over x and dy
+  std::vector<T> scale(dims.channel);
+  std::vector<T> x_coeff(dims.channel);
+  std::vector<T> shift(dims.channel);
+  FOR_RANGE(int64_t, c, 0, dims.channel) {
+    gamma_diff[c] *= inv_variance[c];
+    scale.at(c) = gamma[c] * inv_variance[c];
+    x_coeff.at(c) = -scale.at(c) * inv_variance[c] * gamma_diff[c] * inv_m;
+    shift.at(c) = -scale.at(c) * beta_diff[c] * inv_m - mean[c] * x_coeff.at(c);
+  }
+  const auto Apply = [&](const T* dy_p, const T* x_p, T* dx_p, int64_t len, const T* a,
+                         const T* b, const T* d) {
+    for (int64_t j = 0; j < len; ++j) { dx_p[j] = dy_p[j] * a[j] + x_p[j] * b[j] + d[j]; }
+  };
+  if (dims.inner == 1) {
+    MultiThreadLoopInRange(dims.outer, std::max<int64_t>(kCpuParallelGrainSize / dims.channel, 1),
+                           [&](int64_t begin, int64_t end) {
+                             FOR_RANGE(int64_t, n, begin, end) {
+                               const int64_t offset = n * dims.channel;
+                               Apply(dy + offset, x + offset, dx + offset, dims.channel,
+                                     scale.data(), x_coeff.data(), shift.data());
+                             }
+                           });
+  } else {
+    MultiThreadLoopInRange(dims.outer * dims.channel,
+                           std::max<int64_t>(kCpuParallelGrainSize / dims.inner, 1),
+                           [&](int64_t begin, int64_t end) {
+                             FOR_RANGE(int64_t, i, begin, end) {
+                               const int64_t c = i % dims.channel;
+                               const T a = scale.at(c);
+                               const T b = x_coeff.at(c);
+                               const T d = shift.at(c);
+                               const T* dy_i = dy + i * dims.inner;
+                               const T* x_i = x + i * dims.inner;
+                               T* dx_i = dx + i * dims.inner;
+                               for (int64_t j = 0; j < dims.inner; ++j) {
+                                 dx_i[j] = dy_i[j] * a + x_i[j] * b + d;
+                               }
+                             }
+                           });
+  }
+}
+
+}  // namespace
+
+template<typename T>
+class NormalizationInferenceCpuKernel final : public user_op::OpKernel {
+ public:
+  NormalizationInferenceCpuKernel() = default;
+  ~NormalizationInferenceCpuKernel() override = default;
+
+ private:
+  void Compute(user_op::KernelComputeContext* ctx) const override {
+    CHECK(!ctx->Attr<bool>("training"));
+    const auto* x = ctx->Tensor4ArgNameAndIndex("x", 0);
+    auto* y = ctx->Tensor4ArgNameAndIndex("y", 0);
+    const auto* gamma = ctx->Tensor4ArgNameAndIndex("gamma", 0);
+    const auto* beta = ctx->Tensor4ArgNameAndIndex("beta", 0);
+    const auto* moving_mean = ctx->Tensor4ArgNameAndIndex("moving_mean", 0);
+    const auto* moving_variance = ctx->Tensor4ArgNameAndIndex("moving_variance", 0);
+    CHECK_EQ(x->shape(), y->shape());
+    const BnCpuDims dims(x->shape(), ctx->Attr<int32_t>("axis"));
+    if (dims.elem_cnt() == 0) { return; }
+    BnCpuForwardInference<T>(dims, x->dptr<T>(), gamma->dptr<T>(), beta->dptr<T>(),
+                             moving_mean->dptr<T>(), moving_variance->dptr<T>(),
+                             ctx->Attr<float>("epsilon"), y->mut_dptr<T>());
+  }
+
+  bool AlwaysComputeWhenAllOutputsEmpty() const override { return false; }
+};
+
+template<typename T>
+class NormalizationTrainCpuKernel final : public user_op::OpKernel {
+ public:
+  NormalizationTrainCpuKernel() = default;
+  ~NormalizationTrainCpuKernel() override = default;
+
+ private:
+  void Compute(user_op::KernelComputeContext* ctx) const override {
+    CHECK(ctx->Attr<bool>("training"));
+    const auto* x = ctx->Tensor4ArgNameAndIndex("x", 0);
+    auto* y = ctx->Tensor4ArgNameAndIndex("y", 0);
+    const auto* gamma = ctx->Tensor4ArgNameAndIndex("gamma", 0);
+    const auto* beta = ctx->Tensor4ArgNameAndIndex("beta", 0);
+    auto* moving_mean = ctx->Tensor4ArgNameAndIndex("moving_mean", 0);
+    auto* moving_variance = ctx->Tensor4ArgNameAndIndex("moving_variance", 0);
+    auto* mean = ctx->Tensor4ArgNameAndIndex("mean", 0);
+    auto* inv_variance = ctx->Tensor4ArgNameAndIndex("inv_variance", 0);
+    auto* tmp_buffer = ctx->Tensor4ArgNameAndIndex("tmp_buffer", 0);
+    CHECK_EQ(x->shape(), y->shape());
+    const BnCpuDims dims(x->shape(), ctx->Attr<int32_t>("axis"));
+    if (dims.elem_cnt() == 0) { return; }
+    BnCpuForwardTraining<T>(dims, x->dptr<T>(), gamma->dptr<T>(), beta->dptr<T>(),
+                            ctx->Attr<float>("epsilon"), ctx->Attr<float>("momentum"),
+                            tmp_buffer->mut_dptr<T>(), moving_mean->mut_dptr<T>(),
+                            moving_variance->mut_dptr<T>(), mean->mut_dptr<T>(),
+                            inv_variance->mut_dptr<T>(), y->mut_dptr<T>());
+  }
+
+  bool AlwaysComputeWhenAllOutputsEmpty() const override { return false; }
+};
+
+template<typename T>
+class NormalizationGradCpuKernel final : public user_op::OpKernel {
+ public:
+  NormalizationGradCpuKernel() = default;
+  ~NormalizationGradCpuKernel() override = default;
+
+ private:
+  void Compute(user_op::KernelComputeContext* ctx) const override {
+    const auto* x = ctx->Tensor4ArgNameAndIndex("x", 0);
+    auto* dx = ctx->Tensor4ArgNameAndIndex("dx", 0);
+    const auto* dy = ctx->Tensor4ArgNameAndIndex("dy", 0);
+    const auto* gamma = ctx->Tensor4ArgNameAndIndex("gamma", 0);
+    auto* gamma_diff = ctx->Tensor4ArgNameAndIndex("gamma_diff", 0);
+    auto* beta_diff = ctx->Tensor4ArgNameAndIndex("beta_diff", 0);
+    const auto* mean = ctx->Tensor4ArgNameAndIndex("mean", 0);
+    const auto* inv_variance = ctx->Tensor4ArgNameAndIndex("inv_variance", 0);
+    auto* tmp_buffer = ctx->Tensor4ArgNameAndIndex("tmp_buffer", 0);
+    CHECK_EQ(dy->shape(), x->shape());
+    CHECK_EQ(dx->shape(), x->shape());
+    const BnCpuDims dims(x->shape(), ctx->Attr<int32_t>("axis"));
+    if (dims.elem_cnt() == 0) { return; }
+    BnCpuBackward<T>(dims, x->dptr<T>(), dy->dptr<T>(), gamma->dptr<T>(), mean->dptr<T>(),
+                     inv_variance->dptr<T>(), tmp_buffer->mut_dptr<T>(),
+                     gamma_diff->mut_dptr<T>(), beta_diff->mut_dptr<T>(), dx->mut_dptr<T>());
+  }
+
+  bool AlwaysComputeWhenAllOutputsEmpty() const override { return false; }
+};
+
+#define REGISTER_BN_INFERENCE_CPU_KERNEL(dtype)                                      \
+  REGISTER_USER_KERNEL("normalization")                                              \
+      .SetCreateFn<NormalizationInferenceCpuKernel<dtype>>()                         \
+      .SetIsMatchedHob((user_op::HobDeviceTag() == "cpu")                            \
+                       & (user_op::HobDataType("y", 0) == GetDataType<dtype>::value) \
+                       & (user_op::HobAttr<bool>("training") == false));
+
+#define REGISTER_BN_TRAIN_CPU_KERNEL(dtype)                                              \
+  REGISTER_USER_KERNEL("normalization")                                                  \
+      .SetCreateFn<NormalizationTrainCpuKernel<dtype>>()                                 \
+      .SetIsMatchedHob((user_op::HobDeviceTag() == "cpu")                                \
+                       & (user_op::HobDataType("y", 0) == GetDataType<dtype>::value)     \
+                       & (user_op::HobAttr<bool>("training") == true))                   \
+      .SetInferTmpSizeFn([](user_op::InferContext* ctx) {                                \
+        const auto* x = ctx->TensorDesc4ArgNameAndIndex("x", 0);                         \
+        return InferBnCpuTmpSize(x->shape(), ctx->Attr<int32_t>("axis"), x->data_type()); \
+      });
+
+#define REGISTER_BN_GRAD_CPU_KERNEL(dtype)                                                 \
+  REGISTER_USER_KERNEL("normalization_grad")                                               \
+      .SetCreateFn<NormalizationGradCpuKernel<dtype>>()                                    \
+      .SetIsMatchedHob((user_op::HobDeviceTag() == "cpu")                                  \
+                       & (user_op::HobDataType("dx", 0) == GetDataType<dtype>::value))     \
+      .SetInferTmpSizeFn([](user_op::InferContext* ctx) {                                  \
+        const auto* dy = ctx->TensorDesc4ArgNameAndIndex("dy", 0);                         \
+        return InferBnCpuTmpSize(dy->shape(), ctx->Attr<int32_t>("axis"), dy->data_type()); \
+      });
+
+REGISTER_BN_INFERENCE_CPU_KERNEL(float)
+REGISTER_BN_INFERENCE_CPU_KERNEL(double)
+REGISTER_BN_TRAIN_CPU_KERNEL(float)
+REGISTER_BN_TRAIN_CPU_KERNEL(double)
+REGISTER_BN_GRAD_CPU_KERNEL(float)
+REGISTER_BN_GRAD_CPU_KERNEL(double)
+
+}  // namespace oneflow
@@ -15,6 +15,7 @@ limitations under the License.
 */
 #include "oneflow/user/kernels/softmax_cross_entropy_kernel.h"
 #include "oneflow/core/kernel/kernel_util.cuh"
+#include "oneflow/core/thread/thread_manager.h"
 
 namespace oneflow {
 namespace user_op {
@@ -23,25 +24,36 @@ template<typename T>
 struct CrossEntropyKernelUtil<DeviceType::kCPU, T> {
   static void ComputeEntropy(DeviceCtx* ctx, const int64_t num_instances, const int64_t num_classes,
                              const T* x, const T* labels, T* y) {
-    FOR_RANGE(int64_t, i, 0, num_instances) {
-      T tmp = 0;
-      FOR_RANGE(int64_t, j, 0, num_classes) {
-        T label = labels[i * num_classes + j];
-        T prob = x[i * num_classes + j];
-        // tmp -= label * SafeLog(prob);
-        tmp -= label * logf((prob > 1e-20) ? prob : 1e-20);
+    if (num_classes == 0) { return; }
+    const int64_t grain = std::max<int64_t>(kCpuParallelGrainSize / num_classes, 1);
+    MultiThreadLoopInRange(num_instances, grain, [&](int64_t begin, int64_t end) {
+      FOR_RANGE(int64_t, i, begin, end) {
+        const T* x_row = x + i * num_classes;
+        const T* label_row = labels + i * num_classes;
+        T tmp = 0;
+        FOR_RANGE(int64_t, j, 0, num_classes) {
+          // tmp -= label * SafeLog(prob);
+          tmp -= label_row[j] * logf((x_row[j] > 1e-20) ? x_row[j] : 1e-20);
+        }
+        y[i] = tmp;
       }
-      y[i] = tmp;
-    }
+    });
   }
 
   static void ComputeDiffWithSoftmax(DeviceCtx* ctx, const int64_t elem_cnt,
                                      const int64_t num_classes, const T* prob, const T* labels,
                                      const T* dy, T* dx) {
-    FOR_RANGE(int64_t, i, 0, elem_cnt) {
-      const int32_t row_id = i / num_classes;
-      dx[i] = dy[row_id] * (prob[i] - labels[i]);
-    }
+    if (num_classes == 0) { return; }
+    const int64_t grain = std::max<int64_t>(kCpuParallelGrainSize / num_classes, 1);
+    MultiThreadLoopInRange(elem_cnt / num_classes, grain, [&](int64_t begin, int64_t end) {
+      FOR_RANGE(int64_t, i, begin, end) {
+        const int64_t offset = i * num_classes;
+        const T dy_i = dy[i];
+        for (int64_t j = offset; j < offset + num_classes; ++j) {
+          dx[j] = dy_i * (prob[j] - labels[j]);
+        }
+      }
+    });
   }
 };
 
@@ -14,8 +14,10 @@ See the License for the specific language governing permissions and
 limitations under the License.
 */
 #include "oneflow/user/kernels/softmax_kernel_util.h"
+#include "oneflow/core/common/cpu_isa.h"
 #include "oneflow/core/kernel/kernel_util.cuh"
 #include "oneflow/core/ndarray/ndarray_util.h"
+#include "oneflow/core/thread/thread_manager.h"
 
 namespace oneflow {
 
@@ -110,6 +112,142 @@ void SoftmaxKernelUtil<device_type, T>::ComputeDiff(DeviceCtx* ctx, const int64_
   NdarrayUtil<device_type, T>::InplaceMul(ctx, Var({n * w}, dx), Val({n * w}, out));
 }
 
+namespace {
+
+// independent accumulators per row, a 512 bit vector of float
+constexpr int64_t kSoftmaxCpuLaneNum = 16;
+
+// Cephes style expf, unlike std::exp it is inlined and vectorized in the row loops. Results that
+// would be denormal are flushed to 0.
+inline float SoftmaxExp(float x) {
+  const float clamped = std::min(std::max(x, -87.33654f), 88.0f);
+  const float n = std::floor(clamped * 1.44269504088896341f + 0.5f);
+  const float r = clamped - n * 0.693359375f + n * 2.12194440e-4f;
+  float p = 1.9875691500e-4f;
+  p = p * r + 1.3981999507e-3f;
+  p = p * r + 8.3334519073e-3f;
+  p = p * r + 4.1665795894e-2f;
+  p = p * r + 1.6666665459e-1f;
+  p = p * r + 5.0000001201e-1f;
+  p = p * r * r + r + 1.0f;
+  const int32_t scale_bits = (static_cast<int32_t>(n) + 127) << 23;
+  float scale;
+  std::memcpy(&scale, &scale_bits, sizeof(float));
+  return x < -87.33654f ? 0.0f : p * scale;
+}
+
+inline double SoftmaxExp(double x) { return std::exp(x); }
+
+// folds v into a running max and a running sum of exp(x - max) with a single exp
+template<typename T>
+inline void OnlineMaxSumUpdate(const T v, T* max, T* sum) {
+  const T diff = v - *max;
+  const T exp_neg_abs_diff = SoftmaxExp(diff > T(0) ? -diff : diff);
+  *sum = diff > T(0) ? *sum * exp_neg_abs_diff + T(1) : *sum + exp_neg_abs_diff;
+  *max = diff > T(0) ? v : *max;
+}
+
+// One pass over x for the max and the sum, one pass writing y. The lanes start at the lowest
+// finite value rather than -inf, so that masked -inf inputs never compute inf - inf.
+#define DEFINE_SOFTMAX_CPU_ROW_FUNCS(suffix, target)                                               \
+  template<typename T>                                                                             \
+  target void SoftmaxRow##suffix(const int64_t w, const T* x, T* y) {                              \
+    T lane_max[kSoftmaxCpuLaneNum];                                                                \
+    T lane_sum[kSoftmaxCpuLaneNum];                                                                \
+    std::fill(lane_max, lane_max + kSoftmaxCpuLaneNum, GetMinVal<T>());                            \
+    std::fill(lane_sum, lane_sum + kSoftmaxCpuLaneNum, GetZeroVal<T>());                           \
+    int64_t i = 0;                                                                                 \
+    for (; i + kSoftmaxCpuLaneNum <= w; i += kSoftmaxCpuLaneNum) {                                 \
+      for (int64_t l = 0; l < kSoftmaxCpuLaneNum; ++l) {                                           \
+        OnlineMaxSumUpdate(x[i + l], &lane_max[l], &lane_sum[l]);                                  \
+      }                                                                                            \
+    }                                                                                              \
+    for (int64_t l = 0; i + l < w; ++l) {                                                          \
+      OnlineMaxSumUpdate(x[i + l], &lane_max[l], &lane_sum[l]);                                    \
+    }                                                                                              \
+    T row_max = lane_max[0];                                                                       \
+    for (int64_t l = 1; l < kSoftmaxCpuLaneNum; ++l) { row_max = std::max(row_max, lane_max[l]); } \
+    T row_sum = GetZeroVal<T>();                                                                   \
+    for (int64_t l = 0; l < kSoftmaxCpuLaneNum; ++l) {                                             \
+      row_sum += lane_sum[l] * SoftmaxExp(lane_max[l] - row_max);                                  \
+    }                                                                                              \
+    const T inv_row_sum = T(1) / row_sum;                                                          \
+    for (int64_t j = 0; j < w; ++j) { y[j] = SoftmaxExp(x[j] - row_max) * inv_row_sum; }           \
+  }                                                                                                \
+                                                                                                   \
+  template<typename T>                                                                             \
+  target void SoftmaxGradRow##suffix(const int64_t w, const T* dy, const T* y, T* dx) {            \
+    T lane_dot[kSoftmaxCpuLaneNum];                                                                \
+    std::fill(lane_dot, lane_dot + kSoftmaxCpuLaneNum, GetZeroVal<T>());                           \
+    int64_t i = 0;                                                                                 \
+    for (; i + kSoftmaxCpuLaneNum <= w; i += kSoftmaxCpuLaneNum) {                                 \
+      for (int64_t l = 0; l < kSoftmaxCpuLaneNum; ++l) { lane_dot[l] += dy[i + l] * y[i + l]; }    \
+    }                                                                                              \
+    for (int64_t l = 0; i + l < w; ++l) { lane_dot[l] += dy[i + l] * y[i + l]; }                   \
+    T dot = GetZeroVal<T>();                                                                       \
+    for (int64_t l = 0; l < kSoftmaxCpuLaneNum; ++l) { dot += lane_dot[l]; }                       \
+    for (int64_t j = 0; j < w; ++j) { dx[j] = (dy[j] - dot) * y[j]; }                              \
+  }
+
+DEFINE_SOFTMAX_CPU_ROW_FUNCS(Scalar, )
+#if OF_CPU_ISA_DISPATCH_ENABLED
+DEFINE_SOFTMAX_CPU_ROW_FUNCS(Avx2, OF_CPU_TARGET_AVX2)
+DEFINE_SOFTMAX_CPU_ROW_FUNCS(Avx512, OF_CPU_TARGET_AVX512)
+#endif
+#undef DEFINE_SOFTMAX_CPU_ROW_FUNCS
+
+template<typename T>
+void SoftmaxRow(const int64_t w, const T* x, T* y) {
+#if OF_CPU_ISA_DISPATCH_ENABLED
+  switch (GetCpuIsa()) {
+    case CpuIsa::kAvx512: return SoftmaxRowAvx512(w, x, y);
+    case CpuIsa::kAvx2: return SoftmaxRowAvx2(w, x, y);
+    default: break;
+  }
+#endif
+  SoftmaxRowScalar(w, x, y);
+}
+
+template<typename T>
+void SoftmaxGradRow(const int64_t w, const T* dy, const T* y, T* dx) {
+#if OF_CPU_ISA_DISPATCH_ENABLED
+  switch (GetCpuIsa()) {
+    case CpuIsa::kAvx512: return SoftmaxGradRowAvx512(w, dy, y, dx);
+    case CpuIsa::kAvx2: return SoftmaxGradRowAvx2(w, dy, y, dx);
+    default: break;
+  }
+#endif
+  SoftmaxGradRowScalar(w, dy, y, dx);
+}
+
+}  // namespace
+
+template<typename T>
+void SoftmaxKernelUtil<DeviceType::kCPU, T>::ComputeProb(DeviceCtx* ctx, const int64_t n,
+                                                         const int64_t w, const T* in, T* prob,
+                                                         void* temp_storage,
+                                                         const size_t temp_storage_bytes) {
+  MultiThreadLoopInRange(n, std::max<int64_t>(kCpuParallelGrainSize / std::max<int64_t>(w, 1), 1),
+                         [&](int64_t begin, int64_t end) {
+                           FOR_RANGE(int64_t, i, begin, end) {
+                             SoftmaxRow(w, in + i * w, prob + i * w);
+                           }
+                         });
+}
+
+template<typename T>
+void SoftmaxKernelUtil<DeviceType::kCPU, T>::ComputeDiff(DeviceCtx* ctx, const int64_t n,
+                                                         const int64_t w, const T* dy,
+                                                         const T* out, T* dx, void* temp_storage,
+                                                         const size_t temp_storage_bytes) {
+  MultiThreadLoopInRange(n, std::max<int64_t>(kCpuParallelGrainSize / std::max<int64_t>(w, 1), 1),
+                         [&](int64_t begin, int64_t end) {
+                           FOR_RANGE(int64_t, i, begin, end) {
+                             SoftmaxGradRow(w, dy + i * w, out + i * w, dx + i * w);
+                           }
+                         });
+}
+
 #define INSTANTIATE_SOFTMAX_KERNEL_UTIL(device_type, data_type) \
   template struct SoftmaxKernelUtil<device_type, data_type>;
 #ifdef WITH_CUDA
@@ -30,6 +30,17 @@ struct SoftmaxKernelUtil {
                           void* temp_storage, size_t temp_storage_bytes);
 };
 
+// Fused row by row with an online max and sum, the temp storage is empty.
+template<typename T>
+struct SoftmaxKernelUtil<DeviceType::kCPU, T> {
+  static size_t GetComputeProbTempStorageSizeInBytes(int64_t n, int64_t w) { return 0; }
+  static size_t GetComputeDiffTempStorageSizeInBytes(int64_t n, int64_t w) { return 0; }
+  static void ComputeProb(DeviceCtx* ctx, int64_t n, int64_t w, const T* in, T* prob,
+                          void* temp_storage, size_t temp_storage_bytes);
+  static void ComputeDiff(DeviceCtx* ctx, int64_t n, int64_t w, const T* dy, const T* out, T* dx,
+                          void* temp_storage, size_t temp_storage_bytes);
+};
+
 }  // namespace oneflow
 
 #endif  // ONEFLOW_USER_KERNELS_SOFTMAX_KERNEL_UTIL_H_
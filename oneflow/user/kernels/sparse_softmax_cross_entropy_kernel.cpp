@@ -41,7 +41,8 @@ class SparseSoftmaxCrossEntropyKernel final : public user_op::OpKernel {
     const int64_t depth = ctx->Attr<int64_t>("depth");
     SoftmaxKernelUtil<device_type, T>::ComputeProb(
         ctx->device_ctx(), num_instances, num_classes, prediction->dptr<T>(), prob->mut_dptr<T>(),
-        tmp_buffer->mut_dptr(), tmp_buffer->shape().elem_cnt());
+        tmp_buffer == nullptr ? nullptr : tmp_buffer->mut_dptr(),
+        tmp_buffer == nullptr ? 0 : tmp_buffer->shape().elem_cnt());
     SparseCrossEntropyKernelUtil<device_type, T, K>::ComputeEntropy(
         ctx->device_ctx(), num_instances, num_classes, depth, lower_bound, prob->dptr<T>(),
         label->dptr<K>(), out->mut_dptr<T>());
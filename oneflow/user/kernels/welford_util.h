@@ -0,0 +1,94 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#ifndef ONEFLOW_USER_KERNELS_WELFORD_UTIL_H_
+#define ONEFLOW_USER_KERNELS_WELFORD_UTIL_H_
+
+#include "oneflow/core/common/util.h"
+
+namespace oneflow {
+
+// Running mean and sum of squared deviations (m2) of count values, the variance is m2 / count.
+template<typename T>
+struct WelfordState {
+  T mean = 0;
+  T m2 = 0;
+  T count = 0;
+
+  void Update(T x) {
+    count += 1;
+    const T delta = x - mean;
+    mean += delta / count;
+    m2 += delta * (x - mean);
+  }
+
+  // Chan's parallel update
+  void Merge(T other_mean, T other_m2, T other_count) {
+    if (other_count == 0) { return; }
+    const T new_count = count + other_count;
+    const T delta = other_mean - mean;
+    mean += delta * other_count / new_count;
+    m2 += other_m2 + delta * delta * count * other_count / new_count;
+    count = new_count;
+  }
+};
+
+// lanes of independent states, so that the loop over contiguous values vectorizes
+constexpr int64_t kWelfordLaneNum = 8;
+
+// Adds n contiguous values to state in a single pass.
+template<typename T>
+void WelfordUpdate(const T* x, int64_t n, WelfordState<T>* state) {
+  T lane_mean[kWelfordLaneNum] = {0};
+  T lane_m2[kWelfordLaneNum] = {0};
+  const int64_t step_num = n / kWelfordLaneNum;
+  FOR_RANGE(int64_t, s, 0, step_num) {
+    const T* x_s = x + s * kWelfordLaneNum;
+    const T inv_cnt = static_cast<T>(1) / static_cast<T>(s + 1);
+    for (int64_t l = 0; l < kWelfordLaneNum; ++l) {
+      const T delta = x_s[l] - lane_mean[l];
+      lane_mean[l] += delta * inv_cnt;
+      lane_m2[l] += delta * (x_s[l] - lane_mean[l]);
+    }
+  }
+  if (step_num > 0) {
+    for (int64_t l = 0; l < kWelfordLaneNum; ++l) {
+      state->Merge(lane_mean[l], lane_m2[l], static_cast<T>(step_num));
+    }
+  }
+  for (int64_t i = step_num * kWelfordLaneNum; i < n; ++i) { state->Update(x[i]); }
+}
+
+// Adds row_num rows of col_num values to the per column states held in mean[] and m2[], which
+// are empty on entry. The loop runs over the columns, so it vectorizes for strided data as well.
+template<typename T>
+void WelfordUpdateColumns(const T* x, int64_t row_num, int64_t col_num, int64_t row_stride,
+                          T* mean, T* m2) {
+  std::fill(mean, mean + col_num, static_cast<T>(0));
+  std::fill(m2, m2 + col_num, static_cast<T>(0));
+  FOR_RANGE(int64_t, i, 0, row_num) {
+    const T* x_i = x + i * row_stride;
+    const T inv_cnt = static_cast<T>(1) / static_cast<T>(i + 1);
+    for (int64_t j = 0; j < col_num; ++j) {
+      const T delta = x_i[j] - mean[j];
+      mean[j] += delta * inv_cnt;
+      m2[j] += delta * (x_i[j] - mean[j]);
+    }
+  }
+}
+
+}  // namespace oneflow
+
+#endif  // ONEFLOW_USER_KERNELS_WELFORD_UTIL_H_
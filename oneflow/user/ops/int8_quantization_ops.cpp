@@ -0,0 +1,204 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include "oneflow/core/framework/framework.h"
+#include "oneflow/user/ops/nn_util.h"
+
+namespace oneflow {
+
+namespace {
+
+Maybe<void> CheckBiasInput(user_op::InferContext* ctx, int64_t num_channels) {
+  const user_op::TensorDesc* bias = ctx->TensorDesc4ArgNameAndIndex("bias", 0);
+  if (bias != nullptr) {
+    CHECK_EQ_OR_RETURN(bias->data_type(), DataType::kFloat);
+    CHECK_EQ_OR_RETURN(bias->shape(), Shape({num_channels}));
+  }
+  return Maybe<void>::Ok();
+}
+
+Maybe<void> CheckAbsMaxInput(user_op::InferContext* ctx, const std::string& arg_name) {
+  const user_op::TensorDesc* absmax = ctx->TensorDesc4ArgNameAndIndex(arg_name, 0);
+  if (absmax != nullptr) {
+    CHECK_EQ_OR_RETURN(absmax->data_type(), DataType::kFloat);
+    CHECK_EQ_OR_RETURN(absmax->shape(), Shape({1}));
+  }
+  return Maybe<void>::Ok();
+}
+
+// the weight and the optional bias, split along the output channels by the sbp signatures
+std::vector<user_op::OpArg> ChannelArgs(user_op::SbpContext* ctx, const std::string& weight_name) {
+  std::vector<user_op::OpArg> channel_args{user_op::OpArg(weight_name, 0)};
+  if (ctx->user_op_conf().has_input("bias", 0)) {
+    channel_args.emplace_back(user_op::OpArg("bias", 0));
+  }
+  return channel_args;
+}
+
+// the optional absmax input, broadcast by every sbp signature
+std::vector<user_op::OpArg> AbsMaxArgs(user_op::SbpContext* ctx, const std::string& arg_name) {
+  std::vector<user_op::OpArg> absmax_args;
+  if (ctx->user_op_conf().has_input(arg_name, 0)) {
+    absmax_args.emplace_back(user_op::OpArg(arg_name, 0));
+  }
+  return absmax_args;
+}
+
+}  // namespace
+
+// absmax = max(absmax, max|in|), absmax is a variable recording the range of in over the batches
+// of a calibration job
+REGISTER_USER_OP("int8_calibrate_absmax")
+    .Input("in")
+    .Input("absmax")
+    .SetTensorDescInferFn([](user_op::InferContext* ctx) -> Maybe<void> {
+      CHECK_EQ_OR_RETURN(*ctx->Dtype4ArgNameAndIndex("in", 0), DataType::kFloat);
+      JUST(CheckAbsMaxInput(ctx, "absmax"));
+      return Maybe<void>::Ok();
+    })
+    .SetBatchAxisInferFn(user_op::BatchAxisInferFnUtil::NaiveInferBatchAxis)
+    .SetInputArgModifyFn([](user_op::GetInputArgModifier GetInputArgModifierFn,
+                            const user_op::UserOpConfWrapper&) {
+      user_op::InputArgModifier* absmax_modifier = GetInputArgModifierFn("absmax", 0);
+      CHECK(absmax_modifier != nullptr);
+      absmax_modifier->set_is_mutable(true);
+      user_op::InputArgModifier* in_modifier = GetInputArgModifierFn("in", 0);
+      CHECK(in_modifier != nullptr);
+      in_modifier->set_requires_grad(false);
+    })
+    .SetGetSbpFn([](user_op::SbpContext* ctx) -> Maybe<void> {
+      ctx->NewBuilder().Broadcast(ctx->inputs()).Build();
+      return Maybe<void>::Ok();
+    });
+
+// out = a * dequantize(quantize(b))(T) + bias, a is float [m, k] and b is the float weight [n, k],
+// quantized per row once by the kernel. a is quantized per tensor, with the scale of a_absmax
+// recorded by int8_calibrate_absmax if it is given and not 0, else on the fly.
+REGISTER_USER_OP("int8_matmul")
+    .Input("a")
+    .Input("b")
+    .OptionalInput("bias")
+    .OptionalInput("a_absmax")
+    .Output("out")
+    .Attr<bool>("fuse_relu", UserOpAttrType::kAtBool, false)
+    .SetTensorDescInferFn([](user_op::InferContext* ctx) -> Maybe<void> {
+      const user_op::TensorDesc* a = ctx->TensorDesc4ArgNameAndIndex("a", 0);
+      const user_op::TensorDesc* b = ctx->TensorDesc4ArgNameAndIndex("b", 0);
+      CHECK_EQ_OR_RETURN(a->data_type(), DataType::kFloat);
+      CHECK_EQ_OR_RETURN(b->data_type(), DataType::kFloat);
+      CHECK_EQ_OR_RETURN(a->shape().NumAxes(), 2);
+      CHECK_EQ_OR_RETURN(b->shape().NumAxes(), 2);
+      CHECK_EQ_OR_RETURN(a->shape().At(1), b->shape().At(1));
+      const int64_t n = b->shape().At(0);
+      JUST(CheckBiasInput(ctx, n));
+      JUST(CheckAbsMaxInput(ctx, "a_absmax"));
+      user_op::TensorDesc* out = ctx->TensorDesc4ArgNameAndIndex("out", 0);
+      *out = *a;
+      out->mut_shape()->Set(1, n);
+      return Maybe<void>::Ok();
+    })
+    .SetBatchAxisInferFn([](user_op::BatchAxisContext* ctx) -> Maybe<void> {
+      const OptInt64* a_batch_axis = ctx->BatchAxis4ArgNameAndIndex("a", 0);
+      if (a_batch_axis->has_value() && a_batch_axis->value() == 0) {
+        *ctx->BatchAxis4ArgNameAndIndex("out", 0) = *a_batch_axis;
+      } else {
+        ctx->BatchAxis4ArgNameAndIndex("out", 0)->clear_value();
+      }
+      return Maybe<void>::Ok();
+    })
+    .SetGetSbpFn([](user_op::SbpContext* ctx) -> Maybe<void> {
+      const std::vector<user_op::OpArg> channel_args = ChannelArgs(ctx, "b");
+      ctx->NewBuilder()
+          .Split(user_op::OpArg("a", 0), 0)
+          .Broadcast(channel_args)
+          .Broadcast(AbsMaxArgs(ctx, "a_absmax"))
+          .Split(ctx->outputs(), 0)
+          .Build();
+      ctx->NewBuilder()
+          .Broadcast(user_op::OpArg("a", 0))
+          .Split(channel_args, 0)
+          .Broadcast(AbsMaxArgs(ctx, "a_absmax"))
+          .Split(ctx->outputs(), 1)
+          .Build();
+      return Maybe<void>::Ok();
+    });
+
+// conv2d with the float weight quantized per output channel once by the kernel, in is quantized
+// per tensor like a of int8_matmul, with in_absmax. Only groups == 1 is supported.
+REGISTER_USER_OP("int8_conv2d")
+    .Input("in")
+    .Input("weight")
+    .OptionalInput("bias")
+    .OptionalInput("in_absmax")
+    .Output("out")
+    .Attr("filters", UserOpAttrType::kAtInt32)
+    .Attr("padding_before", UserOpAttrType::kAtListInt32)
+    .Attr("data_format", UserOpAttrType::kAtString)
+    .Attr("kernel_size", UserOpAttrType::kAtListInt32)
+    .Attr("strides", UserOpAttrType::kAtListInt32)
+    .Attr("dilation_rate", UserOpAttrType::kAtListInt32)
+    .Attr<bool>("fuse_relu", UserOpAttrType::kAtBool, false)
+    .SetTensorDescInferFn([](user_op::InferContext* ctx) -> Maybe<void> {
+      const user_op::TensorDesc* in = ctx->TensorDesc4ArgNameAndIndex("in", 0);
+      const user_op::TensorDesc* weight = ctx->TensorDesc4ArgNameAndIndex("weight", 0);
+      CHECK_EQ_OR_RETURN(in->data_type(), DataType::kFloat);
+      CHECK_EQ_OR_RETURN(weight->data_type(), DataType::kFloat);
+      CHECK_EQ_OR_RETURN(in->shape().NumAxes(), 4);
+      const auto& data_format = ctx->Attr<std::string>("data_format");
+      const auto& padding_before = ctx->Attr<std::vector<int32_t>>("padding_before");
+      const auto& kernel_size = ctx->Attr<std::vector<int32_t>>("kernel_size");
+      const auto& strides = ctx->Attr<std::vector<int32_t>>("strides");
+      const auto& dilation_rate = ctx->Attr<std::vector<int32_t>>("dilation_rate");
+      CHECK_EQ_OR_RETURN(padding_before.size(), 2);
+      CHECK_EQ_OR_RETURN(kernel_size.size(), 2);
+      CHECK_EQ_OR_RETURN(strides.size(), 2);
+      CHECK_EQ_OR_RETURN(dilation_rate.size(), 2);
+      const int32_t filters = ctx->Attr<int32_t>("filters");
+      const size_t idx_offset = IdxOffset(data_format);
+      const size_t c_dim = data_format == "channels_first" ? 1 : 3;
+
+      DimVector weight_shape(in->shape().dim_vec());
+      weight_shape.at(0) = filters;
+      FOR_RANGE(size_t, i, 0, 2) { weight_shape.at(idx_offset + i) = kernel_size.at(i); }
+      CHECK_EQ_OR_RETURN(weight->shape(), Shape(weight_shape));
+      JUST(CheckBiasInput(ctx, filters));
+      JUST(CheckAbsMaxInput(ctx, "in_absmax"));
+
+      DimVector out_shape(in->shape().dim_vec());
+      out_shape.at(c_dim) = filters;
+      FOR_RANGE(size_t, i, 0, 2) {
+        CalcConvOut(in->shape().At(idx_offset + i), kernel_size.at(i), dilation_rate.at(i),
+                    strides.at(i), padding_before.at(i), &out_shape.at(idx_offset + i));
+      }
+      user_op::TensorDesc* out = ctx->TensorDesc4ArgNameAndIndex("out", 0);
+      *out = *in;
+      *out->mut_shape() = Shape(out_shape);
+      return Maybe<void>::Ok();
+    })
+    .SetBatchAxisInferFn([](user_op::BatchAxisContext* ctx) -> Maybe<void> {
+      *ctx->BatchAxis4ArgNameAndIndex("out", 0) = *ctx->BatchAxis4ArgNameAndIndex("in", 0);
+      return Maybe<void>::Ok();
+    })
+    .SetGetSbpFn([](user_op::SbpContext* ctx) -> Maybe<void> {
+      ctx->NewBuilder()
+          .Split(user_op::OpArg("in", 0), 0)
+          .Broadcast(ChannelArgs(ctx, "weight"))
+          .Broadcast(AbsMaxArgs(ctx, "in_absmax"))
+          .Split(ctx->outputs(), 0)
+          .Build();
+      return Maybe<void>::Ok();
+    });
+
+}  // namespace oneflow